@@ -0,0 +1,233 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_BENCH_HPP_
+#define TYCHO_BENCH_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace tycho::bench {
+struct result_t {
+    std::string name;
+    std::size_t size{0};
+    std::size_t threads{1};
+    uint64_t ops{0};
+    double seconds{0.0};
+    double p50{0.0}, p90{0.0}, p99{0.0}, max{0.0};     // sampled ns per call
+
+    auto ops_per_sec() const noexcept {
+        return seconds > 0.0 ? double(ops) / seconds : 0.0;
+    }
+
+    auto mb_per_sec() const noexcept {
+        return ops_per_sec() * double(size) / 1048576.0;
+    }
+};
+
+struct options_t {
+    std::chrono::milliseconds period{200};
+    std::chrono::milliseconds warmup{50};
+    uint64_t iterations{0};     // per worker, 0 to run for period
+    std::size_t sample{16};     // time one call in sample, 0 to disable
+    bool pin{false};            // pin workers to cpus by index
+};
+
+inline auto cpus() noexcept -> std::size_t {
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+inline auto pin(std::size_t thread) noexcept {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(thread % cpus(), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    return false;
+#endif
+}
+
+// keep a result the compiler could otherwise drop as unused
+template<typename T>
+inline void keep(const T& value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+// nearest rank of a sorted list
+inline auto percentile(const std::vector<double>& sorted, double rank) noexcept {
+    if(sorted.empty())
+        return 0.0;
+    const auto pos = std::size_t(rank * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(pos, sorted.size() - 1)];
+}
+
+// run op(thread) on each of threads workers after a warmup, for a period
+// or a fixed number of iterations per worker. Sampled calls are timed one
+// at a time for percentiles, so their figures include clock overhead.
+template<typename Op>
+inline auto run(std::string_view name, std::size_t size, std::size_t threads, Op op, const options_t& options) {
+    using clock_t = std::chrono::steady_clock;
+    std::atomic<uint64_t> total{0};
+    std::atomic<std::size_t> ready{0};
+    std::atomic<int> phase{0};
+    clock_t::time_point warm{}, until{};
+    std::vector<std::vector<double>> samples(threads);
+    if(options.sample)
+        for(auto& list : samples)
+            list.reserve(65536);
+
+    auto worker = [&](std::size_t thread) {
+        if(options.pin)
+            pin(thread);
+        while(phase.load(std::memory_order_acquire) < 1)
+            std::this_thread::yield();
+        while(clock_t::now() < warm)
+            op(thread);
+        ++ready;
+        while(phase.load(std::memory_order_acquire) < 2)
+            std::this_thread::yield();
+
+        auto& list = samples[thread];
+        uint64_t count = 0;
+        for(;;) {
+            if(options.sample && !(count % options.sample) && list.size() < list.capacity()) {
+                const auto start = clock_t::now();
+                op(thread);
+                const std::chrono::duration<double, std::nano> spent = clock_t::now() - start;
+                list.push_back(spent.count());
+            }
+            else
+                op(thread);
+            ++count;
+            if(options.iterations) {
+                if(count >= options.iterations)
+                    break;
+            }
+            else if(!(count & 15) && clock_t::now() >= until)
+                break;
+        }
+        total += count;
+    };
+
+    std::vector<std::thread> pool;
+    for(std::size_t thread = 0; thread < threads; ++thread)
+        pool.emplace_back(worker, thread);
+    warm = clock_t::now() + options.warmup;
+    phase.store(1, std::memory_order_release);
+    while(ready.load(std::memory_order_acquire) < threads)
+        std::this_thread::yield();
+    const auto start = clock_t::now();
+    until = start + options.period;
+    phase.store(2, std::memory_order_release);
+    for(auto& thread : pool)
+        thread.join();
+    const std::chrono::duration<double> elapsed = clock_t::now() - start;
+
+    result_t result{std::string(name), size, threads, total.load(), elapsed.count()};
+    std::vector<double> merged;
+    for(auto& list : samples)
+        merged.insert(merged.end(), list.begin(), list.end());
+    std::sort(merged.begin(), merged.end());
+    result.p50 = percentile(merged, 0.50);
+    result.p90 = percentile(merged, 0.90);
+    result.p99 = percentile(merged, 0.99);
+    result.max = merged.empty() ? 0.0 : merged.back();
+    return result;
+}
+
+template<typename Op>
+inline auto run(std::string_view name, std::size_t size, std::size_t threads, Op op, std::chrono::milliseconds period = std::chrono::milliseconds(200)) {
+    options_t options;
+    options.period = period;
+    return run(name, size, threads, std::move(op), options);
+}
+
+// one json object per line, for collecting runs over time
+inline void report(const result_t& result, std::FILE *out = stdout) {
+    std::fprintf(out, "{\"bench\":\"%s\",\"size\":%zu,\"threads\":%zu,\"ops\":%llu,\"seconds\":%.6f,\"ops_per_sec\":%.1f,\"mb_per_sec\":%.2f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+        result.name.c_str(), result.size, result.threads, static_cast<unsigned long long>(result.ops), result.seconds, result.ops_per_sec(), result.mb_per_sec(), result.p50, result.p90, result.p99, result.max);
+    std::fflush(out);
+}
+
+// powers of two up to max, including max
+inline auto thread_counts(std::size_t max = 0) {
+    if(!max)
+        max = cpus();
+    std::vector<std::size_t> list;
+    for(std::size_t count = 1; count < max; count *= 2)
+        list.push_back(count);
+    list.push_back(max);
+    return list;
+}
+
+inline auto matches(std::string_view name, std::string_view filter) noexcept {
+    return filter.empty() || name.find(filter) != std::string_view::npos;
+}
+
+struct args_t {
+    std::string_view filter;
+    std::vector<std::size_t> threads;
+    options_t options;
+};
+
+// [--pin] [--warmup=msecs] [--iterations=count] [--sample=every]
+// [filter [max-threads [msecs]]]
+inline auto parse(int argc, char **argv) {
+    args_t args;
+    std::size_t max = 0;
+    auto pos = 0;
+    for(auto arg = 1; arg < argc; ++arg) {
+        const std::string_view text(argv[arg]);
+        const auto *value = std::strchr(argv[arg], '=');
+        const auto number = value ? std::strtoull(value + 1, nullptr, 10) : 0ULL;
+        if(text == "--pin")
+            args.options.pin = true;
+        else if(text.substr(0, 9) == "--warmup=")
+            args.options.warmup = std::chrono::milliseconds(number);
+        else if(text.substr(0, 13) == "--iterations=")
+            args.options.iterations = number;
+        else if(text.substr(0, 9) == "--sample=")
+            args.options.sample = std::size_t(number);
+        else {
+            switch(pos++) {
+            case 0:
+                args.filter = text;
+                break;
+            case 1:
+                max = std::size_t(std::strtoul(argv[arg], nullptr, 10));
+                break;
+            case 2:
+                args.options.period = std::chrono::milliseconds(std::strtoul(argv[arg], nullptr, 10));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    args.threads = thread_counts(max);
+    return args;
+}
+} // end namespace
+#endif
@@ -0,0 +1,111 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#include "bench.hpp"
+#include "tasks.hpp"
+#include "atomics.hpp"
+#include "memory.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace tycho;
+
+namespace {
+bench::options_t options;
+
+struct alignas(64) flag_t {
+    std::atomic<uint64_t> done{0};
+    uint64_t sent{0};
+};
+
+// dispatch to the queue thread and wait for the task to run
+void bench_dispatch(std::size_t threads) {
+    task_queue queue;
+    queue.startup();
+    auto flags = std::make_unique<flag_t[]>(threads);
+    bench::report(bench::run("task_dispatch", 0, threads, [&](std::size_t thread) {
+        auto& flag = flags[thread];
+        ++flag.sent;
+        queue.dispatch([&flag] {
+            flag.done.fetch_add(1, std::memory_order_release);
+        });
+        while(flag.done.load(std::memory_order_acquire) != flag.sent)
+            std::this_thread::yield();
+    }, options));
+    queue.shutdown();
+}
+
+// posting without waiting, bounded so the backlog cannot grow unchecked
+void bench_post(std::size_t threads) {
+    task_queue queue;
+    queue.startup();
+    bench::report(bench::run("task_post", 0, threads, [&](std::size_t) {
+        queue.dispatch([]{}, 4096);
+    }, options));
+    queue.shutdown();
+}
+
+void bench_timers(std::size_t threads) {
+    timer_queue timers;
+    bench::report(bench::run("timer_arm_cancel", 0, threads, [&](std::size_t) {
+        const auto id = timers.at(std::chrono::steady_clock::now() + std::chrono::hours(1), []{});
+        timers.cancel(id);
+    }, options));
+    timers.shutdown();
+}
+
+template<typename Atomic>
+void bench_atomic(const char *name, std::size_t threads) {
+    auto shared = std::make_unique<Atomic>();
+    bench::report(bench::run(name, sizeof(uint64_t), threads, [&](std::size_t thread) {
+        uint64_t item = thread;
+        if(shared->push(item))
+            shared->pull(item);
+    }, options));
+}
+
+struct pager_t {
+    mempager pager;
+    std::size_t count{0};
+};
+
+// pages are kept on reset, so this is the steady state bump allocator
+void bench_pager(std::size_t threads) {
+    std::vector<std::unique_ptr<pager_t>> pagers;
+    for(std::size_t thread = 0; thread < threads; ++thread)
+        pagers.push_back(std::make_unique<pager_t>());
+    bench::report(bench::run("mempager_alloc", 64, threads, [&](std::size_t thread) {
+        auto& local = *pagers[thread];
+        const auto *mem = local.pager.alloc(64);
+        bench::keep(mem);
+        if(!mem || ++local.count % 1024 == 0)
+            local.pager.reset();
+    }, options));
+}
+} // end anon namespace
+
+// usage: bench_core [--pin] [--warmup=msecs] [filter [max-threads [msecs]]]
+auto main(int argc, char **argv) -> int {
+    const auto args = bench::parse(argc, argv);
+    options = args.options;
+    for(auto count : args.threads) {
+        if(bench::matches("task_dispatch", args.filter))
+            bench_dispatch(count);
+        if(bench::matches("task_post", args.filter))
+            bench_post(count);
+        if(bench::matches("timer", args.filter))
+            bench_timers(count);
+        // stack_t and buffer_t are not safe for mixed concurrent use
+        if(count == 1 && bench::matches("atomic_stack", args.filter))
+            bench_atomic<atomics::stack_t<uint64_t, 1024>>("atomic_stack", count);
+        if(count == 1 && bench::matches("atomic_buffer", args.filter))
+            bench_atomic<atomics::buffer_t<uint64_t, 1024>>("atomic_buffer", count);
+        if(bench::matches("atomic_ring", args.filter))
+            bench_atomic<atomics::ring_t<uint64_t, 1024>>("atomic_ring", count);
+        if(bench::matches("atomic_linked_stack", args.filter))
+            bench_atomic<atomics::linked_stack_t<uint64_t>>("atomic_linked_stack", count);
+        if(bench::matches("mempager", args.filter))
+            bench_pager(count);
+    }
+}
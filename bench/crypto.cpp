@@ -0,0 +1,140 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#include "bench.hpp"
+#include "digest.hpp"
+#include "cipher.hpp"
+#include "sign.hpp"
+#include "bignum.hpp"
+#include "random.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tycho;
+using namespace tycho::crypto;
+
+namespace {
+const std::size_t sizes[] = {16, 256, 4096, 65536, 1048576, 16777216};
+bench::options_t options;
+
+struct buffers_t {
+    explicit buffers_t(std::size_t size) : in(size), out(size + 64) {
+        rand(in.data(), in.size());
+    }
+
+    std::vector<uint8_t> in, out;
+};
+
+auto make_buffers(std::size_t threads, std::size_t size) {
+    std::vector<std::unique_ptr<buffers_t>> list;
+    for(std::size_t thread = 0; thread < threads; ++thread)
+        list.push_back(std::make_unique<buffers_t>(size));
+    return list;
+}
+
+void bench_digest(std::size_t threads, std::size_t size) {
+    auto bufs = make_buffers(threads, size);
+    bench::report(bench::run("digest_sha256", size, threads, [&](std::size_t thread) {
+        digest_t md(EVP_sha256());
+        md.update(bufs[thread]->in.data(), size);
+        md.finish();
+    }, options));
+}
+
+void bench_hmac(std::size_t threads, std::size_t size) {
+    auto bufs = make_buffers(threads, size);
+    const hmac_t keyed("benchmark key");
+    std::vector<hmac_t> macs(threads, keyed);
+    bench::report(bench::run("hmac_sha256", size, threads, [&](std::size_t thread) {
+        macs[thread].mac(bufs[thread]->in.data(), size, bufs[thread]->out.data());
+    }, options));
+}
+
+void bench_cipher(const char *name, const EVP_CIPHER *algo, std::size_t threads, std::size_t size) {
+    auto bufs = make_buffers(threads, size);
+    const keyphrase_t key("benchmark key", nosalt, algo);
+    std::vector<encrypt_t> sealers;
+    std::vector<decrypt_t> openers;
+    for(std::size_t thread = 0; thread < threads; ++thread) {
+        sealers.emplace_back(key);
+        openers.emplace_back(key);
+    }
+    bench::report(bench::run(std::string("encrypt_") + name, size, threads, [&](std::size_t thread) {
+        uint8_t tag[16];
+        auto& buf = *bufs[thread];
+        auto& sealer = sealers[thread];
+        sealer.reset(key.iv());
+        auto used = sealer.update(buf.in.data(), buf.out.data(), size);
+        sealer.finish(buf.out.data() + used, tag);
+    }, options));
+    bench::report(bench::run(std::string("decrypt_") + name, size, threads, [&](std::size_t thread) {
+        uint8_t tag[16]{};
+        auto& buf = *bufs[thread];
+        auto& opener = openers[thread];
+        opener.reset(key.iv());
+        opener.update(buf.out.data(), buf.in.data(), size & ~std::size_t(15));
+        opener.finish(buf.in.data(), tag);
+    }, options));
+}
+
+void bench_sign(std::size_t threads) {
+    auto key = EVP_EC_gen("P-256");
+    uint8_t msg[32]{};
+    rand(msg, sizeof(msg));
+    bench::report(bench::run("sign_p256", sizeof(msg), threads, [&](std::size_t) {
+        sign_t signer(key, EVP_sha256());
+        EVP_PKEY_up_ref(key);
+        signer.update(msg, sizeof(msg));
+        signer.finish();
+    }, options));
+
+    sign_t signer(key, EVP_sha256());
+    EVP_PKEY_up_ref(key);
+    signer.update(msg, sizeof(msg));
+    signer.finish();
+    const std::string sig(signer.view());
+    bench::report(bench::run("verify_p256", sizeof(msg), threads, [&](std::size_t) {
+        verify_t checker(key, EVP_sha256());
+        EVP_PKEY_up_ref(key);
+        checker.update(msg, sizeof(msg));
+        checker.finish(reinterpret_cast<const uint8_t *>(sig.data()), sig.size());
+    }, options));
+    EVP_PKEY_free(key);
+}
+
+void bench_bignum(std::size_t threads) {
+    auto mod = bignum_t::make_rand(2048, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ODD);
+    auto base = bignum_t::make_rand(2047);
+    auto exp = bignum_t::make_rand(2048);
+    bench::report(bench::run("bignum_pow_2048", 256, threads, [&](std::size_t) {
+        const auto result = mod_exp(base, exp, mod);
+    }, options));
+}
+} // end anon namespace
+
+// usage: bench_crypto [--pin] [--warmup=msecs] [filter [max-threads [msecs]]]
+auto main(int argc, char **argv) -> int {
+    const auto args = bench::parse(argc, argv);
+    const auto filter = args.filter;
+    const auto& threads = args.threads;
+    options = args.options;
+
+    for(auto count : threads) {
+        for(auto size : sizes) {
+            if(bench::matches("digest", filter))
+                bench_digest(count, size);
+            if(bench::matches("hmac", filter))
+                bench_hmac(count, size);
+            if(bench::matches("cbc", filter))
+                bench_cipher("aes256_cbc", EVP_aes_256_cbc(), count, size);
+            if(bench::matches("gcm", filter))
+                bench_cipher("aes256_gcm", EVP_aes_256_gcm(), count, size);
+        }
+        if(bench::matches("sign", filter) || bench::matches("verify", filter))
+            bench_sign(count);
+        if(bench::matches("bignum", filter))
+            bench_bignum(count);
+    }
+}
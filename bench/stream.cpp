@@ -0,0 +1,124 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#include "bench.hpp"
+#include "socket.hpp"
+#include "stream.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace tycho;
+
+namespace {
+const std::size_t sizes[] = {64, 1024, 16384, 262144};
+bench::options_t options;
+address_t host("127.0.0.1", 9796);
+
+// a loopback peer that echoes streams opened with 'e' and drains others
+class peer_t final {
+public:
+    peer_t() : listener_(host, SOCK_STREAM) {
+        listener_.reuse(true);
+        listener_.listen();
+        if(listener_.err())
+            throw std::system_error(listener_.err(), std::generic_category(), "Bench cannot listen");
+        thread_ = std::thread([this] {
+            while(running_) {
+                if(!(listener_.wait(POLLIN, 100) & POLLIN))
+                    continue;
+                listener_.accept([this](int so, const struct sockaddr *) {
+                    sessions_.emplace_back(&peer_t::serve, so);
+                    return true;
+                });
+            }
+        });
+    }
+
+    peer_t(const peer_t&) = delete;
+    auto operator=(const peer_t&) -> auto& = delete;
+
+    ~peer_t() {
+        running_ = false;
+        thread_.join();
+        for(auto& session : sessions_)
+            session.join();
+    }
+
+private:
+    Socket listener_;
+    std::thread thread_;
+    std::vector<std::thread> sessions_;
+    std::atomic<bool> running_{true};
+
+    static void serve(int so) {
+        auto buf = std::make_unique<char[]>(65536);
+        char mode{0};
+        auto echo = ::recv(so, &mode, 1, 0) == 1 && mode == 'e';
+        for(;;) {
+            const auto got = ::recv(so, buf.get(), 65536, 0);
+            if(got <= 0)
+                break;
+            for(ssize_t sent = 0; echo && sent < got;) {
+                const auto out = ::send(so, buf.get() + sent, std::size_t(got - sent), 0);
+                if(out <= 0)
+                    break;
+                sent += out;
+            }
+        }
+        ::close(so);
+    }
+};
+
+auto make_streams(std::size_t threads, char mode) {
+    std::vector<std::unique_ptr<tcpstream>> list;
+    for(std::size_t thread = 0; thread < threads; ++thread) {
+        auto stream = std::make_unique<tcpstream>(host.data(), 65536);
+        stream->put(mode);
+        stream->flush();
+        list.push_back(std::move(stream));
+    }
+    return list;
+}
+
+void bench_write(std::size_t threads, std::size_t size) {
+    auto streams = make_streams(threads, 'w');
+    const std::vector<char> data(size, 'x');
+    bench::report(bench::run("stream_write", size, threads, [&](std::size_t thread) {
+        auto& stream = *streams[thread];
+        stream.write(data.data(), std::streamsize(size));
+        stream.flush();
+    }, options));
+}
+
+// round trip of one small message
+void bench_echo(std::size_t threads) {
+    auto streams = make_streams(threads, 'e');
+    bench::report(bench::run("stream_echo", 64, threads, [&](std::size_t thread) {
+        char msg[64]{};
+        auto& stream = *streams[thread];
+        stream.write(msg, sizeof(msg));
+        stream.flush();
+        stream.read(msg, sizeof(msg));
+    }, options));
+}
+} // end anon namespace
+
+// usage: bench_stream [--pin] [--warmup=msecs] [filter [max-threads [msecs]]]
+auto main(int argc, char **argv) -> int {
+    const auto args = bench::parse(argc, argv);
+    options = args.options;
+    Socket::startup();
+    {
+        const peer_t peer;
+        for(auto count : args.threads) {
+            for(auto size : sizes) {
+                if(bench::matches("stream_write", args.filter))
+                    bench_write(count, size);
+            }
+            if(bench::matches("stream_echo", args.filter))
+                bench_echo(count);
+        }
+    }
+    Socket::shutdown();
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#include "bench.hpp"
+#include "encoding.hpp"
+#include "serial.hpp"
+#include "strings.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tycho;
+
+namespace {
+const std::size_t sizes[] = {16, 256, 4096, 65536, 1048576};
+const std::string line = R"(alpha,beta,"gamma delta",epsilon,zeta,eta,theta,'iota kappa',lambda,mu,nu,xi,omicron,pi,rho,sigma)";
+bench::options_t options;
+
+auto make_data(std::size_t size) {
+    std::vector<uint8_t> data(size);
+    for(std::size_t pos = 0; pos < size; ++pos)
+        data[pos] = uint8_t(pos * 131 + 7);
+    return data;
+}
+
+void bench_encode(std::size_t threads, std::size_t size) {
+    const auto data = make_data(size);
+    std::vector<std::unique_ptr<char[]>> out;
+    const auto max = size * 2 + 8;
+    for(std::size_t thread = 0; thread < threads; ++thread)
+        out.push_back(std::make_unique<char[]>(max));
+    bench::report(bench::run("to_b64", size, threads, [&](std::size_t thread) {
+        bench::keep(to_b64(data.data(), size, out[thread].get(), max));
+    }, options));
+    bench::report(bench::run("to_hex", size, threads, [&](std::size_t thread) {
+        bench::keep(to_hex(data.data(), size, out[thread].get(), max));
+    }, options));
+}
+
+void bench_crc(std::size_t threads, std::size_t size) {
+    const auto data = make_data(size);
+    bench::report(bench::run("crc32", size, threads, [&](std::size_t) {
+        bench::keep(crc32(data.data(), size));
+    }, options));
+}
+
+void bench_split(std::size_t threads) {
+    bench::report(bench::run("split", line.size(), threads, [&](std::size_t) {
+        bench::keep(split(line, ","));
+    }, options));
+    bench::report(bench::run("split_view", line.size(), threads, [&](std::size_t) {
+        for(const auto field : split_view(line, ","))
+            bench::keep(field);
+    }, options));
+    bench::report(bench::run("tokenize", line.size(), threads, [&](std::size_t) {
+        bench::keep(tokenize(line, ","));
+    }, options));
+}
+} // end anon namespace
+
+// usage: bench_strings [--pin] [--warmup=msecs] [filter [max-threads [msecs]]]
+auto main(int argc, char **argv) -> int {
+    const auto args = bench::parse(argc, argv);
+    options = args.options;
+    for(auto count : args.threads) {
+        for(auto size : sizes) {
+            if(bench::matches("b64", args.filter) || bench::matches("hex", args.filter))
+                bench_encode(count, size);
+            if(bench::matches("crc32", args.filter))
+                bench_crc(count, size);
+        }
+        if(bench::matches("split", args.filter) || bench::matches("tokenize", args.filter))
+            bench_split(count);
+    }
+}
@@ -11,6 +11,11 @@
 #include <stdexcept>
 #include <cstdint>
 #include <type_traits>
+#include <memory>
+#include <new>
+#include <initializer_list>
+#include <utility>
+#include <cstring>
 
 namespace tycho {
 namespace crypto {
@@ -173,6 +178,335 @@ public:
     }
 };
 
+// Allocator adapter whose argumentless construct default-initializes, so
+// resize on a trivial slice leaves new elements unset for a later read.
+template<typename T, typename Alloc = std::allocator<T>>
+class uninit_allocator : public Alloc {
+public:
+    using traits = std::allocator_traits<Alloc>;
+
+    template<typename U>
+    struct rebind {
+        using other = uninit_allocator<U, typename traits::template rebind_alloc<U>>;
+    };
+
+    using Alloc::Alloc;
+    uninit_allocator() = default;
+
+    template<typename U, typename A>
+    uninit_allocator(const uninit_allocator<U, A>& other) noexcept : Alloc(other) {} // NOLINT
+
+    template<typename U>
+    void construct(U *ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new(static_cast<void *>(ptr)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *ptr, Args&&... args) {
+        traits::construct(static_cast<Alloc&>(*this), ptr, std::forward<Args>(args)...);
+    }
+};
+
+// Slice holding up to N elements inline before falling back to the heap
+template<typename T, std::size_t N = 8>
+class small_slice final {
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_slice() noexcept = default;
+
+    small_slice(std::initializer_list<T> list) {
+        reserve(list.size());
+        for(const auto& item : list)
+            emplace_back(item);
+    }
+
+    template <typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+    small_slice(Iterator first, Iterator last) {
+        while(first != last)
+            emplace_back(*first++);
+    }
+
+    explicit small_slice(size_type count, const T& value = T()) {
+        resize(count, value);
+    }
+
+    small_slice(const small_slice& other) {
+        reserve(other.size_);
+        std::uninitialized_copy(other.begin(), other.end(), data_);
+        size_ = other.size_;
+    }
+
+    small_slice(small_slice&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        take(other);
+    }
+
+    ~small_slice() {
+        clear();
+        release();
+    }
+
+    auto operator=(const small_slice& other) -> auto& {
+        if(this != &other) {
+            clear();
+            reserve(other.size_);
+            std::uninitialized_copy(other.begin(), other.end(), data_);
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    auto operator=(small_slice&& other) noexcept(std::is_nothrow_move_constructible_v<T>) -> auto& {
+        if(this != &other) {
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    operator bool() const noexcept {
+        return size_ > 0;
+    }
+
+    auto operator!() const noexcept {
+        return size_ == 0;
+    }
+
+    auto operator*() const noexcept -> const T* {
+        return data_;
+    }
+
+    auto operator*() noexcept -> T* {
+        return data_;
+    }
+
+    auto operator[](size_type index) noexcept -> T& {
+        return data_[index];
+    }
+
+    auto operator[](size_type index) const noexcept -> const T& {
+        return data_[index];
+    }
+
+    auto operator==(const small_slice& other) const {
+        return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+    }
+
+    auto operator!=(const small_slice& other) const {
+        return !(*this == other);
+    }
+
+    auto at(size_type index) -> T& {
+        if(index >= size_)
+            throw std::out_of_range("Index out of range");
+        return data_[index];
+    }
+
+    auto at(size_type index) const -> const T& {
+        if(index >= size_)
+            throw std::out_of_range("Index out of range");
+        return data_[index];
+    }
+
+    auto front() -> T& {
+        return at(0);
+    }
+
+    auto back() -> T& {
+        if(!size_)
+            throw std::out_of_range("Slice is empty");
+        return data_[size_ - 1];
+    }
+
+    auto data() noexcept -> T* {
+        return data_;
+    }
+
+    auto data() const noexcept -> const T* {
+        return data_;
+    }
+
+    auto size() const noexcept {
+        return size_;
+    }
+
+    auto capacity() const noexcept {
+        return capacity_;
+    }
+
+    auto empty() const noexcept {
+        return size_ == 0;
+    }
+
+    auto is_inline() const noexcept {
+        return data_ == local();
+    }
+
+    auto begin() noexcept -> iterator {
+        return data_;
+    }
+
+    auto end() noexcept -> iterator {
+        return data_ + size_;
+    }
+
+    auto begin() const noexcept -> const_iterator {
+        return data_;
+    }
+
+    auto end() const noexcept -> const_iterator {
+        return data_ + size_;
+    }
+
+    void reserve(size_type count) {
+        if(count <= capacity_)
+            return;
+
+        auto mem = std::allocator<T>().allocate(count);
+        if constexpr(std::is_trivially_copyable_v<T>) {
+            if(size_)
+                memcpy(static_cast<void *>(mem), data_, size_ * sizeof(T)); // FlawFinder: ignore
+        }
+        else {
+            std::uninitialized_move(data_, data_ + size_, mem);
+            std::destroy(data_, data_ + size_);
+        }
+        release();
+        data_ = mem;
+        capacity_ = count;
+    }
+
+    // args may refer into the slice, so growing builds the item first
+    template <typename... Args>
+    auto emplace_back(Args&&... args) -> T& {
+        if(size_ == capacity_) {
+            T item(std::forward<Args>(args)...);
+            grow(size_ + 1);
+            auto ptr = ::new(static_cast<void *>(data_ + size_)) T(std::move(item));
+            ++size_;
+            return *ptr;
+        }
+        auto ptr = ::new(static_cast<void *>(data_ + size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *ptr;
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back() {
+        if(!size_)
+            throw std::out_of_range("Slice is empty");
+        std::destroy_at(data_ + --size_);
+    }
+
+    void resize(size_type count) {
+        resize(count, T());
+    }
+
+    void resize(size_type count, const T& value) {
+        if(count < size_) {
+            std::destroy(data_ + count, data_ + size_);
+            size_ = count;
+            return;
+        }
+        if(count > capacity_) {
+            const T fill(value);
+            reserve(count);
+            std::uninitialized_fill(data_ + size_, data_ + count, fill);
+        }
+        else
+            std::uninitialized_fill(data_ + size_, data_ + count, value);
+        size_ = count;
+    }
+
+    // grow or shrink without initializing new elements, for read/recv
+    template <typename U = T, std::enable_if_t<std::is_trivial_v<U>, int> = 0>
+    void resize_uninitialized(size_type count) {
+        if(count > capacity_)
+            grow(count);
+        size_ = count;
+    }
+
+    // extend by count unset elements and return where they start
+    template <typename U = T, std::enable_if_t<std::is_trivial_v<U>, int> = 0>
+    auto append_uninit(size_type count) -> T* {
+        resize_uninitialized(size_ + count);
+        return data_ + size_ - count;
+    }
+
+    void clear() noexcept {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    auto find(const T& value) const {
+        return std::find(begin(), end(), value);
+    }
+
+    auto contains(const T& value) const {
+        return find(value) != end();
+    }
+
+    template <typename Func>
+    void each(Func func) {
+        for(auto& element : *this)
+            func(element);
+    }
+
+private:
+    static_assert(N > 0, "small_slice needs inline capacity");
+
+    alignas(T) unsigned char inline_[sizeof(T) * N]{};
+    T *data_{local()};
+    size_type size_{0}, capacity_{N};
+
+    auto local() noexcept -> T* {
+        return reinterpret_cast<T *>(inline_);
+    }
+
+    auto local() const noexcept -> const T* {
+        return reinterpret_cast<const T *>(inline_);
+    }
+
+    void grow(size_type need) {
+        reserve(std::max(need, capacity_ * 2));
+    }
+
+    void release() noexcept {
+        if(data_ != local())
+            std::allocator<T>().deallocate(data_, capacity_);
+        data_ = local();
+        capacity_ = N;
+    }
+
+    void take(small_slice& other) {
+        if(other.data_ != other.local()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.data_ = other.local();
+            other.capacity_ = N;
+            other.size_ = 0;
+            return;
+        }
+        std::uninitialized_move(other.begin(), other.end(), data_);
+        size_ = other.size_;
+        other.clear();
+    }
+};
+
 template<typename T>
 class span {
 public:
@@ -242,7 +576,214 @@ private:
     size_type size_{0};
 };
 
+// Owned storage aligned to Align with capacity padded to a whole multiple
+// of Align bytes, so vector kernels may read or write full blocks past the
+// logical end without a scalar tail loop.
+template<typename T, std::size_t Align = 64>
+class aligned_buffer final {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr auto alignment = Align;
+
+    aligned_buffer() noexcept = default;
+
+    explicit aligned_buffer(size_type size) {
+        resize(size);
+    }
+
+    aligned_buffer(const T *from, size_type size) {
+        resize(size);
+        if(size)
+            memcpy(data_, from, size * sizeof(T));  // FlawFinder: ignore
+    }
+
+    aligned_buffer(const aligned_buffer& other) : aligned_buffer(other.data_, other.size_) {}
+
+    aligned_buffer(aligned_buffer&& other) noexcept :
+    data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), capacity_(std::exchange(other.capacity_, 0)) {}
+
+    ~aligned_buffer() {
+        release();
+    }
+
+    auto operator=(const aligned_buffer& other) -> auto& {
+        if(this != &other) {
+            resize(other.size_);
+            if(size_)
+                memcpy(data_, other.data_, size_ * sizeof(T));  // FlawFinder: ignore
+        }
+        return *this;
+    }
+
+    auto operator=(aligned_buffer&& other) noexcept -> auto& {
+        if(this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+        }
+        return *this;
+    }
+
+    auto operator[](size_type index) noexcept -> T& {
+        return data_[index];
+    }
+
+    auto operator[](size_type index) const noexcept -> const T& {
+        return data_[index];
+    }
+
+    auto at(size_type index) -> T& {
+        if(index >= size_)
+            throw std::out_of_range("Index out of range");
+        return data_[index];
+    }
+
+    auto data() noexcept -> T* {
+        return assumed(data_);
+    }
+
+    auto data() const noexcept -> const T* {
+        return assumed(data_);
+    }
+
+    auto size() const noexcept {
+        return size_;
+    }
+
+    auto size_bytes() const noexcept {
+        return size_ * sizeof(T);
+    }
+
+    // elements that may be touched, including the padded tail
+    auto capacity() const noexcept {
+        return capacity_;
+    }
+
+    auto empty() const noexcept {
+        return size_ == 0;
+    }
+
+    auto begin() noexcept -> iterator {
+        return data_;
+    }
+
+    auto end() noexcept -> iterator {
+        return data_ + size_;
+    }
+
+    auto begin() const noexcept -> const_iterator {
+        return data_;
+    }
+
+    auto end() const noexcept -> const_iterator {
+        return data_ + size_;
+    }
+
+    // existing elements are kept, new ones and the tail are left unset
+    void reserve(size_type count) {
+        if(count <= capacity_)
+            return;
+        const auto bytes = padded(count * sizeof(T));
+        auto mem = static_cast<T *>(::operator new(bytes, std::align_val_t(Align)));
+        if(size_)
+            memcpy(mem, data_, size_ * sizeof(T));  // FlawFinder: ignore
+        release();
+        data_ = mem;
+        capacity_ = bytes / sizeof(T);
+    }
+
+    void resize(size_type count) {
+        reserve(count);
+        size_ = count;
+    }
+
+    void clear() noexcept {
+        size_ = 0;
+    }
+
+    // zero everything from the logical end through the padded tail
+    void zero_tail() noexcept {
+        if(capacity_ > size_)
+            memset(data_ + size_, 0, (capacity_ - size_) * sizeof(T));
+    }
+
+    static constexpr auto padded(size_type bytes) noexcept -> size_type {
+        return (bytes + Align - 1) / Align * Align;
+    }
+
+private:
+    static_assert(std::is_trivial_v<T>, "T must be Trivial type");
+    static_assert(Align >= alignof(T) && (Align & (Align - 1)) == 0, "Align must be a power of two");
+    static_assert(Align % sizeof(T) == 0, "Align must be a multiple of the element size");
+
+    T *data_{nullptr};
+    size_type size_{0}, capacity_{0};
+
+    void release() noexcept {
+        if(data_)
+            ::operator delete(data_, std::align_val_t(Align));
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    template<typename P>
+    static auto assumed(P *ptr) noexcept -> P* {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<P *>(__builtin_assume_aligned(ptr, Align));
+#else
+        return ptr;
+#endif
+    }
+};
+
+// Span whose data is known to be Align aligned, checked on construction
+template<typename T, std::size_t Align = 64>
+class aligned_span : public span<T> {
+public:
+    using size_type = typename span<T>::size_type;
+
+    static constexpr auto alignment = Align;
+
+    aligned_span(T *ptr, size_type size) : span<T>(check(ptr), size) {}
+
+    template<typename U, std::enable_if_t<std::is_same_v<std::remove_const_t<T>, U>, int> = 0>
+    explicit aligned_span(aligned_buffer<U, Align>& buffer) noexcept :
+    span<T>(buffer.data(), buffer.size()), padded_(buffer.capacity()) {}
+
+    template<typename U, std::enable_if_t<std::is_same_v<T, const U>, int> = 0>
+    explicit aligned_span(const aligned_buffer<U, Align>& buffer) noexcept :
+    span<T>(buffer.data(), buffer.size()), padded_(buffer.capacity()) {}
+
+    auto data() const noexcept -> T* {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<T *>(__builtin_assume_aligned(span<T>::data(), Align));
+#else
+        return span<T>::data();
+#endif
+    }
+
+    // readable elements including padding, equal to size() unless from a buffer
+    auto padded() const noexcept {
+        return padded_ ? padded_ : this->size();
+    }
+
+private:
+    size_type padded_{0};
+
+    static auto check(T *ptr) -> T* {
+        if(reinterpret_cast<uintptr_t>(ptr) % Align)
+            throw std::invalid_argument("Span is not aligned");
+        return ptr;
+    }
+};
+
 using byteslice_t = slice<uint8_t>;
+using bytebuffer_t = slice<uint8_t, uninit_allocator<uint8_t>>;
 
 template<typename T, std::size_t S>
 constexpr auto make_span(T(&arr)[S]) {
@@ -7,6 +7,9 @@
 #include <atomic>
 #include <optional>
 #include <type_traits>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
 
 namespace tycho::atomics {
 template<typename T = unsigned>
@@ -36,7 +39,7 @@ public:
     }
 
     operator T() const noexcept {
-        return seq_.fetch_add(1);
+        return seq_.load(std::memory_order_relaxed);
     }
 
     void set(const T v) noexcept {
@@ -53,6 +56,70 @@ private:
     mutable std::atomic<T> seq_{0};
 };
 
+// Striped counter for statistics written often and read rarely
+template<typename T = uint64_t, std::size_t N = 16>
+class counter_t final {
+public:
+    counter_t() noexcept = default;
+    counter_t(const counter_t&) = delete;
+    auto operator=(const counter_t&) -> auto& = delete;
+
+    operator T() const noexcept {
+        return load();
+    }
+
+    auto operator++() noexcept -> auto& {
+        add(1);
+        return *this;
+    }
+
+    auto operator+=(T value) noexcept -> auto& {
+        add(value);
+        return *this;
+    }
+
+    void add(T value = 1) noexcept {
+        cells_[slot()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    auto load() const noexcept {
+        T total{0};
+        for(const auto& cell : cells_)
+            total += cell.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    // sum and zero every cell, for interval reporting
+    auto exchange() noexcept {
+        T total{0};
+        for(auto& cell : cells_)
+            total += cell.value.exchange(0, std::memory_order_relaxed);
+        return total;
+    }
+
+    void reset() noexcept {
+        for(auto& cell : cells_)
+            cell.value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static_assert(std::is_integral_v<T>, "T must be integral");
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Cell count must be power of 2");
+
+    struct alignas(64) cell_t final {
+        std::atomic<T> value{0};
+    };
+
+    cell_t cells_[N];
+
+    // each thread is assigned a cell the first time it counts
+    static auto slot() noexcept -> std::size_t {
+        static std::atomic<std::size_t> next{0};
+        thread_local const auto self = next.fetch_add(1, std::memory_order_relaxed);
+        return self & (N - 1);
+    }
+};
+
 class once_t final {
 public:
     once_t() = default;
@@ -101,9 +168,9 @@ public:
         auto count = count_.load();
         if(count < 0)
             return std::size_t(0);
-        if(count > S)
+        if(std::size_t(count) > S)
             return S;
-        return count;
+        return std::size_t(count);
     }
 
     auto empty() const noexcept {
@@ -111,12 +178,12 @@ public:
     }
 
     auto full() const noexcept {
-        return count_.load() >= S;
+        return count_.load() >= int(S);
     }
 
     auto push(const T& item) noexcept {
         const auto count = count_.fetch_add(1);
-        if(count >= S) {
+        if(count >= int(S)) {
             count_.fetch_sub(1);
             return false;
         }
@@ -215,7 +282,7 @@ public:
         if(++head >= S)
             head -= S;
 
-        tail_.store(tail, std::memory_order_release);
+        head_.store(head, std::memory_order_release);
         return true;
     }
 
@@ -229,8 +296,8 @@ public:
         if(++head >= S)
             head -= S;
 
-        tail_.store(tail, std::memory_order_release);
-        return head;
+        head_.store(head, std::memory_order_release);
+        return item;
     }
 
 private:
@@ -239,5 +306,327 @@ private:
     std::atomic<unsigned> head_{0U}, tail_{0U};
     T data_[S];
 };
+
+// Bounded multi-producer multi-consumer ring using per-slot sequences
+template<typename T, std::size_t S>
+class ring_t final {
+public:
+    ring_t() noexcept {
+        for(std::size_t pos = 0; pos < S; ++pos)
+            slots_[pos].seq.store(pos, std::memory_order_relaxed);
+    }
+
+    ring_t(const ring_t&) = delete;
+    auto operator=(const ring_t&) -> auto& = delete;
+
+    operator bool() const noexcept {
+        return !empty();
+    }
+
+    auto operator!() const noexcept {
+        return empty();
+    }
+
+    auto operator*() noexcept {
+        return pop();
+    }
+
+    auto operator<=(const T& item) noexcept {
+        return push(item);
+    }
+
+    auto empty() const noexcept {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    auto full() const noexcept {
+        return size() >= S;
+    }
+
+    auto size() const noexcept -> std::size_t {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    auto push(const T& item) noexcept {
+        return try_push_n(&item, 1) == 1;
+    }
+
+    auto push(T&& item) noexcept {
+        return try_push_n(std::make_move_iterator(&item), 1) == 1;
+    }
+
+    auto pull(T& item) noexcept {
+        return try_pop_n(&item, 1) == 1;
+    }
+
+    auto pop() noexcept -> std::optional<T> {
+        T item;
+        if(try_pop_n(&item, 1) != 1)
+            return {};
+        return item;
+    }
+
+    // claim up to count free slots with one cas, returns slots filled
+    template<typename Iter>
+    auto try_push_n(Iter from, std::size_t count) noexcept -> std::size_t {
+        auto pos = tail_.load(std::memory_order_relaxed);
+        for(;;) {
+            const auto avail = ready(pos, count, 0);
+            if(!avail) {
+                if(slots_[pos & mask].seq.load(std::memory_order_acquire) < pos + 0)
+                    return std::size_t(0);
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if(tail_.compare_exchange_weak(pos, pos + avail, std::memory_order_relaxed)) {
+                for(std::size_t off = 0; off < avail; ++off, ++from) {
+                    auto& slot = slots_[(pos + off) & mask];
+                    slot.data = *from;
+                    slot.seq.store(pos + off + 1, std::memory_order_release);
+                }
+                return avail;
+            }
+        }
+    }
+
+    // claim up to count filled slots with one cas, returns slots taken
+    template<typename Iter>
+    auto try_pop_n(Iter to, std::size_t count) noexcept -> std::size_t {
+        auto pos = head_.load(std::memory_order_relaxed);
+        for(;;) {
+            const auto avail = ready(pos, count, 1);
+            if(!avail) {
+                if(slots_[pos & mask].seq.load(std::memory_order_acquire) < pos + 1)
+                    return std::size_t(0);
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if(head_.compare_exchange_weak(pos, pos + avail, std::memory_order_relaxed)) {
+                for(std::size_t off = 0; off < avail; ++off, ++to) {
+                    auto& slot = slots_[(pos + off) & mask];
+                    *to = std::move(slot.data);
+                    slot.seq.store(pos + off + S, std::memory_order_release);
+                }
+                return avail;
+            }
+        }
+    }
+
+    auto is_lock_free() const noexcept {
+        return head_.is_lock_free();
+    }
+
+private:
+    static_assert(S > 2 && (S & (S - 1)) == 0, "Ring size must be power of 2");
+    static_assert(std::is_nothrow_copy_assignable_v<T> || std::is_nothrow_move_assignable_v<T>, "T must assign without throwing");
+
+    static constexpr std::size_t mask = S - 1;
+    static constexpr std::size_t cache_line = 64;
+
+    struct slot_t final {
+        std::atomic<std::size_t> seq{0};
+        T data{};
+    };
+
+    alignas(cache_line) std::atomic<std::size_t> head_{0};
+    alignas(cache_line) std::atomic<std::size_t> tail_{0};
+    slot_t slots_[S];
+
+    // count of consecutive slots from pos whose sequence matches expected
+    auto ready(std::size_t pos, std::size_t count, std::size_t offset) const noexcept -> std::size_t {
+        std::size_t avail = 0;
+        while(avail < count && avail < S) {
+            const auto expect = pos + avail + offset;
+            if(slots_[(pos + avail) & mask].seq.load(std::memory_order_acquire) != expect)
+                break;
+            ++avail;
+        }
+        return avail;
+    }
+};
+
+// Unbounded lock-free stack, nodes are recycled thru an internal freelist
+template<typename T>
+class linked_stack_t final {
+public:
+    linked_stack_t() = default;
+    linked_stack_t(const linked_stack_t&) = delete;
+    auto operator=(const linked_stack_t&) -> auto& = delete;
+
+    explicit linked_stack_t(std::size_t count) {
+        reserve(count);
+    }
+
+    ~linked_stack_t() {
+        for(auto& chunk : chunks_)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    operator bool() const noexcept {
+        return !empty();
+    }
+
+    auto operator!() const noexcept {
+        return empty();
+    }
+
+    auto operator*() {
+        return pop();
+    }
+
+    auto operator<=(const T& item) {
+        return push(item);
+    }
+
+    auto empty() const noexcept {
+        return index(head_.load(std::memory_order_acquire)) == 0;
+    }
+
+    auto size() const noexcept -> std::size_t {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    auto capacity() const noexcept -> std::size_t {
+        const auto used = next_.load(std::memory_order_relaxed);
+        return used > limit ? limit : std::size_t(used);
+    }
+
+    auto push(const T& item) {
+        const auto node = acquire();
+        if(!node)
+            return false;
+        at(node).data = item;
+        link(head_, node);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    auto push(T&& item) {
+        const auto node = acquire();
+        if(!node)
+            return false;
+        at(node).data = std::move(item);
+        link(head_, node);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    auto pull(T& item) {
+        const auto node = unlink(head_);
+        if(!node)
+            return false;
+        item = std::move(at(node).data);
+        count_.fetch_sub(1, std::memory_order_relaxed);
+        link(free_, node);
+        return true;
+    }
+
+    auto pop() -> std::optional<T> {
+        const auto node = unlink(head_);
+        if(!node)
+            return {};
+        std::optional<T> item(std::move(at(node).data));
+        count_.fetch_sub(1, std::memory_order_relaxed);
+        link(free_, node);
+        return item;
+    }
+
+    // pre-allocate nodes onto the freelist before a burst
+    void reserve(std::size_t count) {
+        while(count--) {
+            const auto node = allocate();
+            if(!node)
+                return;
+            link(free_, node);
+        }
+    }
+
+    auto is_lock_free() const noexcept {
+        return head_.is_lock_free();
+    }
+
+private:
+    static constexpr std::size_t first = 64;
+    static constexpr std::size_t chunks = 26;
+    static constexpr std::size_t limit = first * ((std::size_t(1) << chunks) - 1);
+
+    struct node_t final {
+        T data{};
+        std::atomic<uint32_t> next{0};
+    };
+
+    // heads are an index and an aba tag packed into one lock-free word
+    std::atomic<uint64_t> head_{0}, free_{0};
+    std::atomic<uint64_t> next_{0};
+    std::atomic<std::size_t> count_{0};
+    std::atomic<node_t *> chunks_[chunks]{};
+
+    static constexpr auto index(uint64_t head) noexcept {
+        return uint32_t(head & 0xffffffffU);
+    }
+
+    static constexpr auto tagged(uint64_t head, uint32_t node) noexcept -> uint64_t {
+        return (((head >> 32) + 1) << 32) | node;
+    }
+
+    static constexpr auto chunk(std::size_t pos) noexcept -> std::size_t {
+        std::size_t slot = 0, group = pos / first + 1;
+        while(group >>= 1)
+            ++slot;
+        return slot;
+    }
+
+    auto at(uint32_t node) const noexcept -> node_t& {
+        const std::size_t pos = node - 1;
+        const auto slot = chunk(pos);
+        const auto base = first * ((std::size_t(1) << slot) - 1);
+        return chunks_[slot].load(std::memory_order_acquire)[pos - base];
+    }
+
+    auto allocate() -> uint32_t {
+        const auto pos = next_.fetch_add(1, std::memory_order_relaxed);
+        if(pos >= limit)
+            return 0;
+
+        const auto slot = chunk(pos);
+        if(!chunks_[slot].load(std::memory_order_acquire)) {
+            node_t *expected = nullptr;
+            auto mem = new node_t[first << slot];
+            if(!chunks_[slot].compare_exchange_strong(expected, mem, std::memory_order_acq_rel))
+                delete[] mem;
+        }
+        return uint32_t(pos + 1);
+    }
+
+    auto acquire() -> uint32_t {
+        const auto node = unlink(free_);
+        if(node)
+            return node;
+        return allocate();
+    }
+
+    void link(std::atomic<uint64_t>& head, uint32_t node) noexcept {
+        auto old = head.load(std::memory_order_relaxed);
+        for(;;) {
+            at(node).next.store(index(old), std::memory_order_relaxed);
+            if(head.compare_exchange_weak(old, tagged(old, node), std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    auto unlink(std::atomic<uint64_t>& head) noexcept -> uint32_t {
+        auto old = head.load(std::memory_order_acquire);
+        for(;;) {
+            const auto node = index(old);
+            if(!node)
+                return 0;
+            const auto next = at(node).next.load(std::memory_order_relaxed);
+            if(head.compare_exchange_weak(old, tagged(old, next), std::memory_order_acquire, std::memory_order_acquire))
+                return node;
+        }
+    }
+};
 } // end namespace
 #endif
@@ -7,6 +7,9 @@
 #include <string>
 #include <utility>
 #include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <memory>
 #include <openssl/bn.h>
 
 namespace tycho::crypto {
@@ -15,13 +18,13 @@ using key_t = std::pair<const uint8_t *, std::size_t>;
 class bignum_t final {
 public:
     bignum_t() noexcept :
-    ctx_(BN_CTX_new()), num_(BN_new()) {}
+    num_(BN_new()) {}
 
     explicit bignum_t(BIGNUM *bn) noexcept :
-    ctx_(BN_CTX_new()), num_(bn) {}
+    num_(bn) {}
 
     explicit bignum_t(long value) noexcept :
-    ctx_(BN_CTX_new()), num_(BN_new()) {
+    num_(BN_new()) {
         if(value < 0) {
             BN_set_word(num_, -value);
             BN_set_negative(num_, 1);
@@ -31,18 +34,17 @@ public:
     }
 
     bignum_t(bignum_t&& from) noexcept :
-    ctx_(from.ctx_), num_(from.num_) {
+    num_(from.num_) {
         from.reset();
     }
 
     bignum_t(const bignum_t& copy) noexcept :
-    ctx_(BN_CTX_new()), num_(BN_dup(copy.num_)) {}
+    num_(BN_dup(copy.num_)) {}
 
     explicit bignum_t(const key_t& key) noexcept :
-    ctx_(BN_CTX_new()), num_(BN_bin2bn(key.first, int(key.second), nullptr)) {}
+    num_(BN_bin2bn(key.first, int(key.second), nullptr)) {}
 
-    explicit bignum_t(const std::string& text) noexcept :
-    ctx_(BN_CTX_new()) {
+    explicit bignum_t(const std::string& text) noexcept {
         BN_dec2bn(&num_, text.c_str());
         if(!num_)
             num_ = BN_new();
@@ -50,8 +52,6 @@ public:
 
     ~bignum_t() {
         release();
-        if(ctx_)
-            BN_CTX_free(ctx_);
     }
 
     operator BIGNUM *() const noexcept {
@@ -75,10 +75,10 @@ public:
     }
 
     auto operator=(bignum_t&& from) noexcept -> auto& {
+        if(&from == this)
+            return *this;
+
         release();
-        if(ctx_)
-            BN_CTX_free(ctx_);
-        ctx_ = from.ctx_;
         num_ = from.num_;
         from.reset();
         return *this;
@@ -88,16 +88,14 @@ public:
         if(&copy == this)
             return *this;
 
-        release();
-        if(ctx_)
-            BN_CTX_free(ctx_);
-        num_ = BN_dup(copy.num_);
-        ctx_ = BN_CTX_new();
+        if(!BN_copy(num_, copy.num_)) {
+            release();
+            num_ = BN_dup(copy.num_);
+        }
         return *this;
     }
 
     auto operator=(long value) noexcept -> auto& {
-        release();
         if(value < 0) {
             BN_set_word(num_, -value);
             BN_set_negative(num_, 1);
@@ -161,8 +159,7 @@ public:
     }
 
     auto operator+=(const bignum_t& add) const noexcept -> auto& {
-        const bignum_t tmp(*this);
-        BN_add(num_, tmp.num_, add.num_);
+        BN_add(num_, num_, add.num_);
         return *this;
     }
 
@@ -184,8 +181,7 @@ public:
     }
 
     auto operator-=(const bignum_t& sub) const noexcept -> auto& {
-        const bignum_t tmp(*this);
-        BN_sub(num_, tmp.num_, sub.num_);
+        BN_sub(num_, num_, sub.num_);
         return *this;
     }
 
@@ -196,7 +192,7 @@ public:
 
     auto operator*(const bignum_t& mul) const noexcept {
         bignum_t result;
-        BN_mul(result.num_, num_, mul.num_, mul.ctx_);
+        BN_mul(result.num_, num_, mul.num_, context());
         return result;
     }
 
@@ -207,8 +203,7 @@ public:
     }
 
     auto operator*=(const bignum_t& mul) const noexcept -> auto& {
-        const bignum_t tmp(*this);
-        BN_mul(num_, tmp.num_, mul.num_, mul.ctx_);
+        BN_mul(num_, num_, mul.num_, context());
         return *this;
     }
 
@@ -219,7 +214,7 @@ public:
 
     auto operator/(const bignum_t& div) const noexcept {
         bignum_t result;
-        BN_div(result.num_, nullptr, num_, div.num_, div.ctx_);
+        BN_div(result.num_, nullptr, num_, div.num_, context());
         return result;
     }
 
@@ -230,8 +225,7 @@ public:
     }
 
     auto operator/=(const bignum_t& div) const noexcept -> auto& {
-        const bignum_t tmp(*this);
-        BN_div(num_, nullptr, tmp.num_, div.num_, div.ctx_);
+        BN_div(num_, nullptr, num_, div.num_, context());
         return *this;
     }
 
@@ -242,7 +236,7 @@ public:
 
     auto operator%(const bignum_t& mod) const noexcept {
         bignum_t result;
-        BN_div(nullptr, result.num_, num_, mod.num_, mod.ctx_);
+        BN_div(nullptr, result.num_, num_, mod.num_, context());
         return result;
     }
 
@@ -253,8 +247,7 @@ public:
     }
 
     auto operator%=(const bignum_t& mod) const noexcept -> auto& {
-        const bignum_t tmp(*this);
-        BN_div(nullptr, num_, tmp.num_, mod.num_, mod.ctx_);
+        BN_div(nullptr, num_, num_, mod.num_, context());
         return *this;
     }
 
@@ -314,24 +307,24 @@ public:
     auto operator^(long exp) const noexcept {
         bignum_t result(*this);
         const bignum_t exponent(exp);
-        BN_exp(result.num_, num_, exponent.num_, exponent.ctx_);
+        BN_exp(result.num_, num_, exponent.num_, context());
         return result;
     }
 
     auto operator^(const bignum_t& exp) const noexcept {
         bignum_t result(*this);
-        BN_exp(result.num_, num_, exp.num_, exp.ctx_);
+        BN_exp(result.num_, num_, exp.num_, context());
         return result;
     }
 
     auto operator^=(const bignum_t& exp) const noexcept -> auto& {
-        BN_exp(num_, num_, exp.num_, exp.ctx_);
+        BN_exp(num_, num_, exp.num_, context());
         return *this;
     }
 
     auto operator^=(long exp) const noexcept -> auto& {
         const bignum_t exponent(exp);
-        BN_exp(num_, num_, exponent.num_, exponent.ctx_);
+        BN_exp(num_, num_, exponent.num_, context());
         return *this;
     }
 
@@ -372,6 +365,22 @@ public:
         BN_clear(num_);
     }
 
+    // secret values, such as private exponents, take constant time paths
+    auto consttime() noexcept -> auto& {
+        BN_set_flags(num_, BN_FLG_CONSTTIME);
+        return *this;
+    }
+
+    auto is_consttime() const noexcept -> bool {
+        return BN_get_flags(num_, BN_FLG_CONSTTIME) != 0;
+    }
+
+    // scratch context shared by all bignum arithmetic on this thread
+    static auto context() noexcept -> BN_CTX * {
+        thread_local const std::unique_ptr<BN_CTX, void (*)(BN_CTX *)> ctx(BN_CTX_new(), &BN_CTX_free);
+        return ctx.get();
+    }
+
     static auto make_rand(int bits, int top = BN_RAND_TOP_ANY, int bottom = BN_RAND_BOTTOM_ANY) noexcept {
         bignum_t result;
         BN_rand(result.num_, bits, top, bottom);
@@ -380,7 +389,7 @@ public:
 
     static auto make_priv(int bits, int strength, int top = BN_RAND_TOP_ANY, int bottom = BN_RAND_BOTTOM_ANY) noexcept {
         bignum_t result;
-        BN_priv_rand_ex(result.num_, bits, top, bottom, strength, result.ctx_);
+        BN_priv_rand_ex(result.num_, bits, top, bottom, strength, context());
         return result;
     }
 
@@ -391,9 +400,9 @@ private:
     friend auto pow(const bignum_t& base, const bignum_t& exp) noexcept -> bignum_t;
     friend auto sqr(const bignum_t& bn) noexcept -> bignum_t;
     friend auto gcd(const bignum_t& a, const bignum_t& b) noexcept -> bignum_t;
+    friend class montgomery_t;
 
     void reset() {
-        ctx_ = BN_CTX_new();
         num_ = BN_new();
     }
 
@@ -412,7 +421,6 @@ private:
         }
     }
 
-    BN_CTX *ctx_{nullptr};
     BIGNUM *num_{nullptr};
 };
 
@@ -439,21 +447,91 @@ inline auto abs(const bignum_t& bn) noexcept -> bignum_t {
 
 inline auto pow(const bignum_t& base, const bignum_t& exp) noexcept -> bignum_t {
     bignum_t result;
-    BN_exp(result.num_, base.num_, exp.num_, base.ctx_);
+    BN_exp(result.num_, base.num_, exp.num_, bignum_t::context());
     return result;
 }
 
 inline auto sqr(const bignum_t& bn) noexcept -> bignum_t {
     bignum_t result;
-    BN_sqr(result.num_, bn.num_, bn.ctx_);
+    BN_sqr(result.num_, bn.num_, bignum_t::context());
     return result;
 }
 
 inline auto gcd(const bignum_t& a, const bignum_t& b) noexcept -> bignum_t {
     bignum_t result;
-    BN_gcd(result.num_, a.num_, b.num_, a.ctx_);
+    BN_gcd(result.num_, a.num_, b.num_, bignum_t::context());
     return result;
 }
+
+// Montgomery form of an odd modulus, set up once for repeated modular
+// exponentiation. Exponents flagged consttime use the constant time
+// ladder. An even modulus falls back to plain modular exponentiation.
+class montgomery_t final {
+public:
+    explicit montgomery_t(const bignum_t& mod) noexcept : mod_(mod) {
+        if(BN_is_odd(mod_.num_)) {
+            mont_ = BN_MONT_CTX_new();
+            if(mont_ && !BN_MONT_CTX_set(mont_, mod_.num_, bignum_t::context())) {
+                BN_MONT_CTX_free(mont_);
+                mont_ = nullptr;
+            }
+        }
+    }
+
+    montgomery_t(const montgomery_t&) = delete;
+    auto operator=(const montgomery_t&) -> auto& = delete;
+
+    ~montgomery_t() {
+        if(mont_)
+            BN_MONT_CTX_free(mont_);
+    }
+
+    operator bool() const noexcept {
+        return !BN_is_zero(mod_.num_);
+    }
+
+    auto operator!() const noexcept {
+        return BN_is_zero(mod_.num_);
+    }
+
+    auto modulus() const noexcept -> const bignum_t& {
+        return mod_;
+    }
+
+    // base ^ exp mod m
+    auto pow(const bignum_t& base, const bignum_t& exp) const noexcept {
+        bignum_t result;
+        auto ctx = bignum_t::context();
+        if(!mont_)
+            BN_mod_exp(result.num_, base.num_, exp.num_, mod_.num_, ctx);
+        else if(exp.is_consttime() || base.is_consttime())
+            BN_mod_exp_mont_consttime(result.num_, base.num_, exp.num_, mod_.num_, ctx, mont_);
+        else
+            BN_mod_exp_mont(result.num_, base.num_, exp.num_, mod_.num_, ctx, mont_);
+        return result;
+    }
+
+private:
+    bignum_t mod_;
+    BN_MONT_CTX *mont_{nullptr};
+};
+
+// modular exponentiation keeping montgomery setups of recent moduli, most
+// recently used first so the least recently used is evicted
+inline auto mod_exp(const bignum_t& base, const bignum_t& exp, const bignum_t& mod) -> bignum_t {
+    constexpr std::size_t cached = 8;
+    thread_local std::vector<std::unique_ptr<montgomery_t>> recent;
+    for(auto pos = recent.begin(); pos != recent.end(); ++pos) {
+        if((*pos)->modulus() == mod) {
+            std::rotate(recent.begin(), pos, pos + 1);
+            return recent.front()->pow(base, exp);
+        }
+    }
+    if(recent.size() >= cached)
+        recent.pop_back();
+    recent.insert(recent.begin(), std::make_unique<montgomery_t>(mod));
+    return recent.front()->pow(base, exp);
+}
 } // end namespace
 
 inline auto operator<<(std::ostream& out, const tycho::crypto::bignum_t& bn) -> std::ostream& {
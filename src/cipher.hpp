@@ -9,8 +9,14 @@
 #include <stdexcept>
 #include <cstring>
 #include <cstdint>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <openssl/evp.h>
 
+#include "tasks.hpp"
+
 namespace tycho::crypto {
 using key_t = std::pair<const uint8_t *, std::size_t>;
 
@@ -147,6 +153,12 @@ private:
     std::size_t size_{0U};
 };
 
+// one piece of a gathered cipher input
+struct cipher_part {
+    const void *data{nullptr};
+    std::size_t size{0};
+};
+
 inline auto get_tag_size(const EVP_CIPHER *algo) -> std::size_t {
     if(algo) {
         auto nid = EVP_CIPHER_nid(algo);
@@ -165,6 +177,8 @@ public:
             ctx_ = other.ctx_;
             algo_ = other.algo_;
             tag_ = other.tag_;
+            done_ = other.done_;
+            verified_ = other.verified_;
             other.ctx_ = nullptr;
         }
     }
@@ -205,6 +219,8 @@ public:
             ctx_ = other.ctx_;
             algo_ = other.algo_;
             tag_ = other.tag_;
+            done_ = other.done_;
+            verified_ = other.verified_;
             other.ctx_ = nullptr;
         }
         return *this;
@@ -223,6 +239,7 @@ public:
         }
 
         ctx_ = EVP_CIPHER_CTX_new();
+        done_ = false;
         if(!ctx_)
             return *this;
 
@@ -234,6 +251,7 @@ public:
 
         if(!EVP_DecryptInit_ex(ctx_, tag_ ? nullptr : algo_, nullptr, key.data(), key.iv())) {
             EVP_CIPHER_CTX_free(ctx_);
+            ctx_ = nullptr;
             return *this;
         }
 
@@ -242,11 +260,11 @@ public:
     }
 
     operator bool() const noexcept {
-        return ctx_ != nullptr;
+        return ctx_ != nullptr && !done_;
     }
 
     auto operator!() const noexcept {
-        return ctx_ == nullptr;
+        return ctx_ == nullptr || done_;
     }
 
     auto size() const noexcept {
@@ -265,10 +283,33 @@ public:
         return tag_;
     }
 
+    auto ivsize() const noexcept -> std::size_t {
+        return tag_ ? 12 : std::size_t(EVP_CIPHER_iv_length(algo_));
+    }
+
+    // padding and tag were valid for the last finished message
+    auto verified() const noexcept {
+        return verified_;
+    }
+
+    // start a new message under the same key, keeping the context
+    auto reset(const uint8_t *iv) noexcept {
+        if(!ctx_ || !EVP_DecryptInit_ex(ctx_, nullptr, nullptr, nullptr, iv))
+            return false;
+        done_ = verified_ = false;
+        return true;
+    }
+
+    // additional authenticated data, given before any update
+    auto aad(const uint8_t *data, std::size_t size) noexcept {
+        auto used = 0;
+        return ctx_ && !done_ && tag_ && EVP_DecryptUpdate(ctx_, nullptr, &used, data, int(size)) == 1;
+    }
+
     auto update(const uint8_t *in, uint8_t *out, std::size_t size) noexcept {
         auto used = 0;
 
-        if(!ctx_)
+        if(!ctx_ || done_)
             return std::size_t(0);
 
         if(!EVP_DecryptUpdate(ctx_, out, &used, in, int(size)))
@@ -277,20 +318,38 @@ public:
         return std::size_t(used);
     }
 
+    auto update(uint8_t *data, std::size_t size) noexcept {
+        return update(data, data, size);
+    }
+
+    // gathered input into one output, returns total bytes written
+    auto update(const cipher_part *list, std::size_t count, uint8_t *out) noexcept {
+        std::size_t total = 0;
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            if(!list[pos].size)
+                continue;
+            auto used = 0;
+            if(!ctx_ || done_ || !EVP_DecryptUpdate(ctx_, out + total, &used, static_cast<const uint8_t *>(list[pos].data), int(list[pos].size)))
+                return std::size_t(0);
+            total += std::size_t(used);
+        }
+        return total;
+    }
+
     auto finish(uint8_t *out, const uint8_t *tag) noexcept {
         auto used = 0;
 
-        if(!ctx_)
+        if(!ctx_ || done_)
             return std::size_t(0);
 
         if(tag_ && tag)
             EVP_CIPHER_CTX_ctrl(ctx_, EVP_CTRL_GCM_SET_TAG, int(tag_), const_cast<uint8_t *>(tag));
 
-        if(!EVP_DecryptFinal_ex(ctx_, out, &used))
+        verified_ = EVP_DecryptFinal_ex(ctx_, out, &used) == 1;
+        if(!verified_)
             used = 0;
 
-        EVP_CIPHER_CTX_free(ctx_);
-        ctx_ = nullptr;
+        done_ = true;
         return std::size_t(used);
     }
 
@@ -298,6 +357,8 @@ private:
     EVP_CIPHER_CTX *ctx_{nullptr};
     const EVP_CIPHER *algo_{nullptr};
     std::size_t tag_{0};
+    bool done_{false};
+    bool verified_{false};
 };
 
 class encrypt_t final {
@@ -309,6 +370,8 @@ public:
             ctx_ = other.ctx_;
             algo_ = other.algo_;
             tag_ = other.tag_;
+            done_ = other.done_;
+            sealed_ = other.sealed_;
             other.ctx_ = nullptr;
         }
     }
@@ -332,6 +395,7 @@ public:
 
         if(!EVP_EncryptInit_ex(ctx_, tag_ ? nullptr : algo_, nullptr, key.data(), key.iv())) {
             EVP_CIPHER_CTX_free(ctx_);
+            ctx_ = nullptr;
             return;
         }
         EVP_CIPHER_CTX_set_key_length(ctx_, EVP_MAX_KEY_LENGTH);
@@ -353,6 +417,8 @@ public:
             ctx_ = other.ctx_;
             algo_ = other.algo_;
             tag_ = other.tag_;
+            done_ = other.done_;
+            sealed_ = other.sealed_;
             other.ctx_ = nullptr;
         }
         return *this;
@@ -371,6 +437,7 @@ public:
         }
 
         ctx_ = EVP_CIPHER_CTX_new();
+        done_ = sealed_ = false;
         if(!ctx_)
             return *this;
 
@@ -382,6 +449,7 @@ public:
 
         if(!EVP_EncryptInit_ex(ctx_, tag_ ? nullptr : algo_, nullptr, key.data(), key.iv())) {
             EVP_CIPHER_CTX_free(ctx_);
+            ctx_ = nullptr;
             return *this;
         }
 
@@ -390,11 +458,11 @@ public:
     }
 
     operator bool() const noexcept {
-        return ctx_ != nullptr;
+        return ctx_ != nullptr && !done_;
     }
 
     auto operator!() const noexcept {
-        return ctx_ == nullptr;
+        return ctx_ == nullptr || done_;
     }
 
     auto size() const noexcept {
@@ -413,10 +481,33 @@ public:
         return tag_;
     }
 
+    auto ivsize() const noexcept -> std::size_t {
+        return tag_ ? 12 : std::size_t(EVP_CIPHER_iv_length(algo_));
+    }
+
+    // final block and tag were produced for the last finished message
+    auto sealed() const noexcept {
+        return sealed_;
+    }
+
+    // start a new message under the same key, keeping the context
+    auto reset(const uint8_t *iv) noexcept {
+        if(!ctx_ || !EVP_EncryptInit_ex(ctx_, nullptr, nullptr, nullptr, iv))
+            return false;
+        done_ = sealed_ = false;
+        return true;
+    }
+
+    // additional authenticated data, given before any update
+    auto aad(const uint8_t *data, std::size_t size) noexcept {
+        auto used = 0;
+        return ctx_ && !done_ && tag_ && EVP_EncryptUpdate(ctx_, nullptr, &used, data, int(size)) == 1;
+    }
+
     auto update(const uint8_t *in, uint8_t *out, std::size_t size) noexcept {
         auto used = 0;
 
-        if(!ctx_)
+        if(!ctx_ || done_)
             return std::size_t(0);
 
         if(!EVP_EncryptUpdate(ctx_, out, &used, in, int(size)))
@@ -425,20 +516,38 @@ public:
         return std::size_t(used);
     }
 
+    auto update(uint8_t *data, std::size_t size) noexcept {
+        return update(data, data, size);
+    }
+
+    // gathered input into one output, returns total bytes written
+    auto update(const cipher_part *list, std::size_t count, uint8_t *out) noexcept {
+        std::size_t total = 0;
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            if(!list[pos].size)
+                continue;
+            auto used = 0;
+            if(!ctx_ || done_ || !EVP_EncryptUpdate(ctx_, out + total, &used, static_cast<const uint8_t *>(list[pos].data), int(list[pos].size)))
+                return std::size_t(0);
+            total += std::size_t(used);
+        }
+        return total;
+    }
+
     auto finish(uint8_t *out, uint8_t *tag = nullptr) noexcept {
         auto used = 0;
 
-        if(!ctx_)
+        if(!ctx_ || done_)
             return std::size_t(0);
 
-        if(!EVP_EncryptFinal_ex(ctx_, out, &used))
+        sealed_ = EVP_EncryptFinal_ex(ctx_, out, &used) == 1;
+        if(!sealed_)
             used = 0;
 
-        if(tag_ && tag)
-            EVP_CIPHER_CTX_ctrl(ctx_, EVP_CTRL_GCM_GET_TAG, int(tag_), tag);
+        if(sealed_ && tag_ && tag)
+            sealed_ = EVP_CIPHER_CTX_ctrl(ctx_, EVP_CTRL_GCM_GET_TAG, int(tag_), tag) == 1;
 
-        EVP_CIPHER_CTX_free(ctx_);
-        ctx_ = nullptr;
+        done_ = true;
         return std::size_t(used);
     }
 
@@ -446,6 +555,139 @@ private:
     EVP_CIPHER_CTX *ctx_{nullptr};
     const EVP_CIPHER *algo_{nullptr};
     std::size_t tag_{0};
+    bool done_{false};
+    bool sealed_{false};
+};
+
+// Framed gcm for large payloads split into independently sealed chunks:
+// "TGCM" | le32 chunk | le64 size | 12 byte base nonce, then each chunk as
+// ciphertext | 16 byte tag. Chunk nonces are the base with le64 index xored
+// into the last eight bytes, and the header is the aad of every chunk, so
+// chunks cannot be moved between files, reordered, or truncated. Offsets
+// follow from the header, which allows decrypting any one chunk alone. An
+// empty payload is sealed as one empty chunk, so every file has a tag.
+class gcm_chunks final {
+public:
+    static constexpr std::size_t header_size = 28;
+    static constexpr std::size_t tag_size = 16;
+
+    static constexpr auto sealed_size(std::size_t size, std::size_t chunk = 262144) noexcept {
+        return chunk ? header_size + size + count(size, chunk) * tag_size : 0;
+    }
+
+    // an empty payload is still one empty tagged chunk
+    static constexpr auto count(std::size_t size, std::size_t chunk) noexcept -> std::size_t {
+        return chunk ? std::max(std::size_t(1), (size + chunk - 1) / chunk) : 0;
+    }
+
+    // plaintext size from a sealed header, 0 if not a valid header
+    static auto plain_size(const uint8_t *in, std::size_t size) noexcept -> std::size_t {
+        std::size_t chunk{0}, plain{0};
+        if(!parse(in, size, chunk, plain) || size < sealed_size(plain, chunk))
+            return 0;
+        return plain;
+    }
+
+    static auto chunks(const uint8_t *in, std::size_t size) noexcept -> std::size_t {
+        std::size_t chunk{0}, plain{0};
+        return parse(in, size, chunk, plain) ? count(plain, chunk) : 0;
+    }
+
+    // nonce is the 12 byte base, out holds sealed_size(size, chunk)
+    static auto seal(const keyphrase_t& key, const uint8_t *nonce, const uint8_t *in, std::size_t size, uint8_t *out, std::size_t chunk = 262144, std::size_t threads = 0) -> std::size_t {
+        if(get_tag_size(key.cipher()) != tag_size || !chunk || chunk > UINT32_MAX)
+            return 0;
+        memcpy(out, "TGCM", 4);
+        encode(out + 4, chunk, 4);
+        encode(out + 8, size, 8);
+        memcpy(out + 16, nonce, 12);
+        auto ok = each_chunk<encrypt_t>(key, count(size, chunk), threads, [&](encrypt_t& sealer, std::size_t index) {
+            uint8_t iv[12], tail[16];
+            const auto offset = index * chunk;
+            const auto len = std::min(chunk, size - offset);
+            auto to = out + header_size + index * (chunk + tag_size);
+            make_nonce(out, index, iv);
+            return sealer.reset(iv) && sealer.aad(out, header_size) &&
+                (!len || sealer.update(in + offset, to, len) == len) &&
+                (sealer.finish(tail, to + len), sealer.sealed());
+        });
+        return ok ? sealed_size(size, chunk) : 0;
+    }
+
+    // decrypt and verify every chunk, out holds plain_size bytes
+    static auto open(const keyphrase_t& key, const uint8_t *in, std::size_t size, uint8_t *out, std::size_t threads = 0) -> bool {
+        std::size_t chunk{0}, plain{0};
+        if(get_tag_size(key.cipher()) != tag_size || !parse(in, size, chunk, plain) || size != sealed_size(plain, chunk))
+            return false;
+        return each_chunk<decrypt_t>(key, count(plain, chunk), threads, [&](decrypt_t& opener, std::size_t index) {
+            open_with(opener, in, chunk, plain, index, out + index * chunk);
+            return opener.verified();
+        });
+    }
+
+    // decrypt one chunk into out, returns its size or 0 when it fails
+    static auto open_chunk(const keyphrase_t& key, const uint8_t *in, std::size_t size, std::size_t index, uint8_t *out) -> std::size_t {
+        std::size_t chunk{0}, plain{0};
+        if(get_tag_size(key.cipher()) != tag_size || !parse(in, size, chunk, plain) || size < sealed_size(plain, chunk) || index >= count(plain, chunk))
+            return 0;
+        decrypt_t opener(key);
+        return open_with(opener, in, chunk, plain, index, out);
+    }
+
+private:
+    static void encode(uint8_t *to, uint64_t value, std::size_t bytes) noexcept {
+        for(std::size_t pos = 0; pos < bytes; ++pos)
+            to[pos] = uint8_t(value >> (pos * 8));
+    }
+
+    static auto decode(const uint8_t *from, std::size_t bytes) noexcept -> uint64_t {
+        uint64_t value = 0;
+        for(std::size_t pos = bytes; pos > 0; --pos)
+            value = (value << 8) | from[pos - 1];
+        return value;
+    }
+
+    static auto parse(const uint8_t *in, std::size_t size, std::size_t& chunk, std::size_t& plain) noexcept -> bool {
+        if(!in || size < header_size || memcmp(in, "TGCM", 4) != 0)
+            return false;
+        chunk = std::size_t(decode(in + 4, 4));
+        plain = std::size_t(decode(in + 8, 8));
+        return chunk > 0 && plain <= size;
+    }
+
+    // chunks claimed by up to threads workers, each keeping one context
+    // that is rekeyed with reset for every chunk it takes
+    template<typename Context, typename Func>
+    static auto each_chunk(const keyphrase_t& key, std::size_t total, std::size_t threads, Func func) -> bool {
+        if(!threads)
+            threads = std::max(1U, std::thread::hardware_concurrency());
+        std::atomic<std::size_t> next{0};
+        return parallel_jobs(std::min(threads, total), threads, [&](std::size_t) {
+            Context context(key);
+            for(auto index = next.fetch_add(1); index < total; index = next.fetch_add(1)) {
+                if(!func(context, index))
+                    return false;
+            }
+            return true;
+        });
+    }
+
+    static auto open_with(decrypt_t& opener, const uint8_t *in, std::size_t chunk, std::size_t plain, std::size_t index, uint8_t *out) -> std::size_t {
+        uint8_t iv[12], tail[16];
+        const auto len = std::min(chunk, plain - index * chunk);
+        auto from = in + header_size + index * (chunk + tag_size);
+        make_nonce(in, index, iv);
+        if(!opener.reset(iv) || !opener.aad(in, header_size) || (len && opener.update(from, out, len) != len))
+            return std::size_t(0);
+        opener.finish(tail, from + len);
+        return opener.verified() ? len : 0;
+    }
+
+    static void make_nonce(const uint8_t *header, std::size_t index, uint8_t *iv) noexcept {
+        memcpy(iv, header + 16, 12);
+        for(std::size_t pos = 0; pos < 8; ++pos)
+            iv[4 + pos] ^= uint8_t(uint64_t(index) >> (pos * 8));
+    }
 };
 } // end namespace
 #endif
@@ -66,6 +66,18 @@ inline auto iso_string(const std::time_t& current) {
     return iso_string(local_time(current));
 }
 
+// iso_string kept per thread and only formatted again when the second
+// changes, for stamping many records at once
+inline auto iso_cached(const std::time_t& current) -> const std::string& {
+    thread_local std::time_t last{-1};
+    thread_local std::string text;
+    if(current != last) {
+        text = iso_string(current);
+        last = current;
+    }
+    return text;
+}
+
 inline auto iso_date(const std::tm& current) {
     return iso_string(current).substr(0, 10);
 }
@@ -4,10 +4,34 @@
 #ifndef TYCHO_DIGEST_HPP_
 #define TYCHO_DIGEST_HPP_
 
+#include "tasks.hpp"
+#include "filesystem.hpp"
+
 #include <string_view>
 #include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <string>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
+#if OPENSSL_API_LEVEL >= 30000
+#include <openssl/params.h>
+#endif
+
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 namespace tycho::crypto {
 class digest_t final {
@@ -125,6 +149,203 @@ private:
     uint8_t data_[EVP_MAX_MD_SIZE]{};
 };
 
+// Keyed hmac context. The key schedule is computed once, and reset or mac
+// start each new message from the keyed state without rekeying. Copies
+// clone the keyed state, so one template can be shared out to threads.
+class hmac_t final {
+public:
+#if OPENSSL_API_LEVEL >= 30000
+    using ctx_t = EVP_MAC_CTX;
+#else
+    using ctx_t = HMAC_CTX;
+#endif
+
+    explicit hmac_t(const std::string_view& key, const EVP_MD *md = EVP_sha256()) noexcept {
+#if OPENSSL_API_LEVEL >= 30000
+        auto mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+        if(mac)
+            ctx_ = EVP_MAC_CTX_new(mac);
+        EVP_MAC_free(mac);
+        OSSL_PARAM params[2] = {
+            OSSL_PARAM_construct_utf8_string("digest", const_cast<char *>(EVP_MD_get0_name(md)), 0),
+            OSSL_PARAM_construct_end(),
+        };
+        if(ctx_ && EVP_MAC_init(ctx_, reinterpret_cast<const uint8_t *>(key.data()), key.size(), params) != 1)
+            release();
+#else
+        ctx_ = HMAC_CTX_new();
+        if(ctx_ && !HMAC_Init_ex(ctx_, key.data(), int(key.size()), md, nullptr))
+            release();
+#endif
+    }
+
+    hmac_t(const hmac_t& from) noexcept : size_(from.size_) {
+        if(from.ctx_)
+            ctx_ = clone(from.ctx_);
+        if(!ctx_)
+            size_ = 0;
+        if(size_)
+            memcpy(data_, from.data_, size_);   // FlawFinder: size valid
+    }
+
+    hmac_t(hmac_t&& from) noexcept : ctx_(from.ctx_), size_(from.size_) {
+        if(size_)
+            memcpy(data_, from.data_, size_);   // FlawFinder: size valid
+        from.ctx_ = nullptr;
+        from.size_ = 0;
+    }
+
+    ~hmac_t() {
+        release();
+    }
+
+    auto operator=(const hmac_t& from) noexcept -> auto& {
+        if(this == &from)
+            return *this;
+        release();
+        size_ = 0;
+        if(from.ctx_)
+            ctx_ = clone(from.ctx_);
+        if(ctx_)
+            size_ = from.size_;
+        if(size_)
+            memcpy(data_, from.data_, size_);   // FlawFinder: size valid
+        return *this;
+    }
+
+    auto operator=(hmac_t&& from) noexcept -> auto& {
+        if(this == &from)
+            return *this;
+        release();
+        ctx_ = from.ctx_;
+        size_ = from.size_;
+        if(size_)
+            memcpy(data_, from.data_, size_);   // FlawFinder: size valid
+        from.ctx_ = nullptr;
+        from.size_ = 0;
+        return *this;
+    }
+
+    operator bool() const noexcept {
+        return ctx_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return ctx_ == nullptr;
+    }
+
+    auto size() const noexcept {
+        return size_;
+    }
+
+    auto data() const noexcept {
+        return data_;
+    }
+
+    auto view() const {
+        return std::string_view(reinterpret_cast<const char *>(&data_), size_);
+    }
+
+    auto update(const uint8_t *cp, std::size_t size) noexcept {
+#if OPENSSL_API_LEVEL >= 30000
+        return !ctx_ || size_ ? false : EVP_MAC_update(ctx_, cp, size) == 1;
+#else
+        return !ctx_ || size_ ? false : HMAC_Update(ctx_, cp, size) == 1;
+#endif
+    }
+
+    auto update(const char *cp, std::size_t size) noexcept {
+        return update(reinterpret_cast<const uint8_t *>(cp), size);
+    }
+
+    auto update(const std::string_view& view) noexcept {
+        return update(view.data(), view.size());
+    }
+
+    auto finish() noexcept {
+        if(!ctx_ || size_)
+            return false;
+        size_ = unsigned(final(data_));
+        return size_ != 0;
+    }
+
+    // begin a new message with the same key
+    auto reset() noexcept {
+        size_ = 0;
+#if OPENSSL_API_LEVEL >= 30000
+        return ctx_ && EVP_MAC_init(ctx_, nullptr, 0, nullptr) == 1;
+#else
+        return ctx_ && HMAC_Init_ex(ctx_, nullptr, 0, nullptr, nullptr) == 1;
+#endif
+    }
+
+    // mac one whole message into out, leaving the context reset
+    auto mac(const uint8_t *msg, std::size_t size, uint8_t *out) noexcept -> std::size_t {
+        if(!reset() || !update(msg, size))
+            return 0;
+        auto result = final(out);
+        reset();
+        return result;
+    }
+
+    auto mac(const std::string_view& msg, uint8_t *out) noexcept {
+        return mac(reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), out);
+    }
+
+    // mac many messages with one key, out receives count results in order
+    auto mac(const std::string_view *list, std::size_t count, uint8_t *out) noexcept -> std::size_t {
+        std::size_t offset = 0;
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            auto result = mac(list[pos], out + offset);
+            if(!result)
+                return pos;
+            offset += result;
+        }
+        return count;
+    }
+
+private:
+    ctx_t *ctx_{nullptr};
+    unsigned size_{0};
+    uint8_t data_[EVP_MAX_MD_SIZE]{};
+
+    void release() noexcept {
+#if OPENSSL_API_LEVEL >= 30000
+        EVP_MAC_CTX_free(ctx_);
+#else
+        HMAC_CTX_free(ctx_);
+#endif
+        ctx_ = nullptr;
+    }
+
+    static auto clone(ctx_t *from) noexcept -> ctx_t * {
+#if OPENSSL_API_LEVEL >= 30000
+        return EVP_MAC_CTX_dup(from);
+#else
+        auto ctx = HMAC_CTX_new();
+        if(ctx && !HMAC_CTX_copy(ctx, from)) {
+            HMAC_CTX_free(ctx);
+            ctx = nullptr;
+        }
+        return ctx;
+#endif
+    }
+
+    auto final(uint8_t *out) noexcept -> std::size_t {
+#if OPENSSL_API_LEVEL >= 30000
+        std::size_t olen{0};
+        if(EVP_MAC_final(ctx_, out, &olen, EVP_MAX_MD_SIZE) != 1)
+            olen = 0;
+        return olen;
+#else
+        unsigned olen{0};
+        if(!HMAC_Final(ctx_, out, &olen))
+            olen = 0;
+        return olen;
+#endif
+    }
+};
+
 #if OPENSSL_API_LEVEL >= 30000
 inline auto hmac(const std::string_view& key, const uint8_t *msg, std::size_t size, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
     unsigned olen{0};
@@ -183,6 +404,279 @@ inline auto digest_size(const EVP_MD *md = EVP_sha256()) {
     return std::size_t(sz);
 }
 
+// hash many independent messages, out receives count digests in order
+inline auto digest(const std::string_view *list, std::size_t count, uint8_t *out, const EVP_MD *md = EVP_sha256(), std::size_t threads = 1) {
+    const auto size = digest_size(md);
+    if(!size)
+        return std::size_t(0);
+    constexpr std::size_t batch = 64;
+    const auto batches = (count + batch - 1) / batch;
+    auto result = parallel_jobs(batches, threads, [&](std::size_t index) {
+        auto ctx = EVP_MD_CTX_create();
+        if(!ctx)
+            return false;
+        auto ok = true;
+        const auto last = std::min(count, (index + 1) * batch);
+        for(auto pos = index * batch; ok && pos < last; ++pos) {
+            unsigned olen{0};
+            ok = EVP_DigestInit_ex(ctx, md, nullptr) == 1 &&
+                EVP_DigestUpdate(ctx, list[pos].data(), list[pos].size()) == 1 &&
+                EVP_DigestFinal_ex(ctx, out + pos * size, &olen) == 1;
+        }
+        EVP_MD_CTX_destroy(ctx);
+        return ok;
+    });
+    return result ? count : std::size_t(0);
+}
+
+// little endian fields of the tree digest leaf and root headers
+inline void tree_encode(uint8_t *to, uint64_t value) noexcept {
+    for(auto pos = 0; pos < 8; ++pos)
+        to[pos] = uint8_t(value >> (pos * 8));
+}
+
+// leaf of a tree digest, H(0x00 | le64 index | chunk)
+inline auto tree_leaf(uint64_t index, const uint8_t *data, std::size_t len, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+    uint8_t prefix[9]{0};
+    unsigned olen{0};
+    tree_encode(prefix + 1, index);
+    auto ctx = EVP_MD_CTX_create();
+    if(!ctx)
+        return false;
+    auto result = EVP_DigestInit_ex(ctx, md, nullptr) == 1 &&
+        EVP_DigestUpdate(ctx, prefix, sizeof(prefix)) == 1 &&
+        (!len || EVP_DigestUpdate(ctx, data, len) == 1) &&
+        EVP_DigestFinal_ex(ctx, out, &olen) == 1;
+    EVP_MD_CTX_destroy(ctx);
+    return result;
+}
+
+// root of a tree digest, H(0x01 | le64 total size | le64 chunk size | leaves...)
+inline auto tree_root(uint64_t size, uint64_t chunk, const std::vector<uint8_t>& leaves, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+    uint8_t header[17]{1};
+    tree_encode(header + 1, size);
+    tree_encode(header + 9, chunk);
+    unsigned olen{0};
+    auto ctx = EVP_MD_CTX_create();
+    if(!ctx)
+        return std::size_t(0);
+    if(EVP_DigestInit_ex(ctx, md, nullptr) != 1 ||
+        EVP_DigestUpdate(ctx, header, sizeof(header)) != 1 ||
+        EVP_DigestUpdate(ctx, leaves.data(), leaves.size()) != 1 ||
+        EVP_DigestFinal_ex(ctx, out, &olen) != 1)
+        olen = 0;
+    EVP_MD_CTX_destroy(ctx);
+    return std::size_t(olen);
+}
+
+// Chunked tree hash for large data, leaves hashed in parallel on the
+// shared pool. The result depends on the chunk size but never on the
+// thread count. Leaves may be kept as a manifest to find which chunk of a
+// copy differs.
+inline auto tree_digest(const uint8_t *msg, std::size_t size, uint8_t *out, const EVP_MD *md = EVP_sha256(), std::size_t chunk = 1048576, std::size_t threads = 0, std::vector<uint8_t> *leaves = nullptr) {
+    const auto dsize = digest_size(md);
+    if(!dsize || !chunk)
+        return std::size_t(0);
+    const auto chunks = std::max(std::size_t(1), (size + chunk - 1) / chunk);
+    std::vector<uint8_t> local;
+    auto& manifest = leaves ? *leaves : local;
+    manifest.resize(chunks * dsize);
+
+    auto ok = parallel_jobs(chunks, threads, [&](std::size_t index) {
+        const auto offset = index * chunk;
+        const auto len = std::min(chunk, size - std::min(size, offset));
+        return tree_leaf(index, msg + offset, len, manifest.data() + index * dsize, md);
+    });
+    if(!ok)
+        return std::size_t(0);
+    return tree_root(size, chunk, manifest, out, md);
+}
+
+inline auto tree_digest(const std::string_view& msg, uint8_t *out, const EVP_MD *md = EVP_sha256(), std::size_t chunk = 1048576, std::size_t threads = 0) {
+    return tree_digest(reinterpret_cast<const uint8_t *>(msg.data()), msg.size(), out, md, chunk, threads);
+}
+
+// any mapped region with data and size, such as a process::map_t
+template<typename Region, typename = decltype(std::declval<const Region&>().data())>
+inline auto tree_digest(const Region& region, uint8_t *out, const EVP_MD *md = EVP_sha256(), std::size_t chunk = 1048576, std::size_t threads = 0) {
+    return tree_digest(static_cast<const uint8_t *>(static_cast<const void *>(region.data())), region.size(), out, md, chunk, threads);
+}
+
+// Descriptor from its current position to the end, which is where the
+// position is left. Regular files are mapped and hashed as one region,
+// anything else is read and hashed a chunk at a time.
+inline auto tree_digest(const fsys::fd_t& fd, uint8_t *out, const EVP_MD *md = EVP_sha256(), std::size_t chunk = 1048576, std::size_t threads = 0, std::vector<uint8_t> *leaves = nullptr) {
+    const auto dsize = digest_size(md);
+    if(!fd || !dsize || !chunk)
+        return std::size_t(0);
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+    struct stat ino{};
+    const auto from = ::lseek(*fd, 0, SEEK_CUR);
+    if(from >= 0 && !fstat(*fd, &ino) && S_ISREG(ino.st_mode) && ino.st_size > from) {
+        const auto size = std::size_t(ino.st_size);
+        auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, *fd, 0);
+        if(addr != MAP_FAILED) {
+            ::posix_madvise(addr, size, POSIX_MADV_WILLNEED);
+            const auto result = tree_digest(static_cast<const uint8_t *>(addr) + from, size - std::size_t(from), out, md, chunk, threads, leaves);
+            ::munmap(addr, size);
+            ::lseek(*fd, ino.st_size, SEEK_SET);
+            return result;
+        }
+    }
+#endif
+    std::vector<uint8_t> local;
+    auto& manifest = leaves ? *leaves : local;
+    manifest.clear();
+    auto buffer = std::make_unique<uint8_t[]>(chunk);
+    uint64_t size = 0;
+    for(uint64_t index = 0;; ++index) {
+        std::size_t len = 0;
+        while(len < chunk) {
+            auto result = fd.read(buffer.get() + len, chunk - len);   // FlawFinder: ignore
+            if(result < 0 && errno == EINTR)
+                continue;
+            if(result < 0)
+                return std::size_t(0);
+            if(!result)
+                break;
+            len += std::size_t(result);
+        }
+        if(!len && index)
+            break;
+        manifest.resize(manifest.size() + dsize);
+        if(!tree_leaf(index, buffer.get(), len, manifest.data() + index * dsize, md))
+            return std::size_t(0);
+        size += len;
+        if(len < chunk)
+            break;
+    }
+    return tree_root(size, chunk, manifest, out, md);
+}
+
+// Feed a file from its current position to the end in large pieces, the
+// position being left at the end. Regular files are mapped and read
+// sequentially, anything else is read double-buffered so the next read runs
+// on the shared pool while the previous block is hashed.
+template<typename Update>
+inline auto digest_feed(int fd, Update update) {
+    constexpr std::size_t block = 1048576;
+    if(fd < 0)
+        return false;
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+    struct stat ino{};
+    const auto from = ::lseek(fd, 0, SEEK_CUR);
+    if(from >= 0 && !fstat(fd, &ino) && S_ISREG(ino.st_mode) && ino.st_size > from) {
+        const auto size = std::size_t(ino.st_size);
+        auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr != MAP_FAILED) {
+            ::posix_madvise(addr, size, POSIX_MADV_SEQUENTIAL);
+            auto data = static_cast<const uint8_t *>(addr);
+            auto ok = true;
+            for(auto pos = std::size_t(from); ok && pos < size; pos += block)
+                ok = update(data + pos, std::min(block, size - pos));
+            ::munmap(addr, size);
+            ::lseek(fd, ino.st_size, SEEK_SET);
+            return ok;
+        }
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    auto fill = [fd](uint8_t *to) -> ssize_t {
+        ssize_t total = 0;
+        while(std::size_t(total) < block) {
+            auto result = ::read(fd, to + total, block - std::size_t(total));
+            if(result < 0 && errno == EINTR)
+                continue;
+            if(result < 0)
+                return -1;
+            if(!result)
+                break;
+            total += result;
+        }
+        return total;
+    };
+#else
+    auto fill = [fd](uint8_t *to) -> ssize_t {
+        return ::_read(fd, to, unsigned(block));
+    };
+#endif
+    std::unique_ptr<uint8_t[]> buffers[2]{std::make_unique<uint8_t[]>(block), std::make_unique<uint8_t[]>(block)};
+    auto current = fill(buffers[0].get());
+    for(std::size_t side = 0; current > 0; side ^= 1) {
+        ssize_t ahead = 0;
+        auto ok = true;
+        parallel_jobs(2, 2, [&](std::size_t index) {
+            if(index)
+                ahead = fill(buffers[side ^ 1].get());
+            else
+                ok = update(buffers[side].get(), std::size_t(current));
+            return true;
+        });
+        current = ahead;
+        if(!ok)
+            return false;
+    }
+    return current == 0;
+}
+
+inline auto digest_file(int fd, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+    unsigned olen{0};
+    auto ctx = EVP_MD_CTX_create();
+    if(!ctx)
+        return std::size_t(0);
+    if(EVP_DigestInit_ex(ctx, md, nullptr) != 1 || !digest_feed(fd, [ctx](const uint8_t *data, std::size_t size) {
+        return EVP_DigestUpdate(ctx, data, size) == 1;
+    }) || EVP_DigestFinal_ex(ctx, out, &olen) != 1)
+        olen = 0;
+    EVP_MD_CTX_destroy(ctx);
+    return std::size_t(olen);
+}
+
+inline auto hmac_file(const std::string_view& key, int fd, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+    hmac_t mac(key, md);
+    if(!mac || !digest_feed(fd, [&mac](const uint8_t *data, std::size_t size) {
+        return mac.update(data, size);
+    }) || !mac.finish())
+        return std::size_t(0);
+    memcpy(out, mac.data(), mac.size());        // FlawFinder: size valid
+    return std::size_t(mac.size());
+}
+
+inline auto digest_file(const std::string& path, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
+    auto fd = ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if(fd < 0)
+        return std::size_t(0);
+    auto result = digest_file(fd, out, md);
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
+    ::_close(fd);
+#else
+    ::close(fd);
+#endif
+    return result;
+}
+
+inline auto hmac_file(const std::string_view& key, const std::string& path, uint8_t *out, const EVP_MD *md = EVP_sha256()) {
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
+    auto fd = ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if(fd < 0)
+        return std::size_t(0);
+    auto result = hmac_file(key, fd, out, md);
+#if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
+    ::_close(fd);
+#else
+    ::close(fd);
+#endif
+    return result;
+}
+
 inline auto digest_id(const char *name) {
     return EVP_get_digestbyname(name);
 }
@@ -7,48 +7,24 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <ostream>
+#include <algorithm>
 #include <utility>
 #include <array>
 #include <cstring>
 #include <cstdint>
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace tycho::crypto {
 using key_t = std::pair<const uint8_t *, std::size_t>;
 } // end namespace
 
 namespace tycho {
-inline auto to_b64(const uint8_t *data, std::size_t size) {
-    constexpr std::array<char, 64> base64_chars = {
-        'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P',
-        'Q','R','S','T','U','V','W','X','Y','Z','a','b','c','d','e','f',
-        'g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v',
-        'w','x','y','z','0','1','2','3','4','5','6','7','8','9','+','/'
-    };
-
-    std::string out;
-
-    for (std::size_t i = 0; i < size; i += 3) {
-        uint32_t c = 0;
-        for (std::size_t j = 0; j < 3; ++j) {
-            c <<= 8;
-            if(i + j < size)
-                c |= uint32_t(data[i + j]);
-        }
-        out += base64_chars[(c >> 18) & 0x3F];
-        out += base64_chars[(c >> 12) & 0x3F];
-        if(i < (size - 1))
-            out += base64_chars[(c >> 6) & 0x3F];
-        if(i < (size - 2))
-            out += base64_chars[c & 0x3F];
-    }
-
-    if (size % 3 == 1)
-        out += "==";
-    else if (size % 3 == 2)
-        out += '=';
-    return out;
-}
-
 constexpr auto base64_index(char c) {
     if (c >= 'A' && c <= 'Z')
         return c - 'A';
@@ -68,6 +44,39 @@ constexpr auto base64_index(char c) {
     return -1;
 }
 
+// rfc 4648 url and filename safe alphabet
+constexpr auto base64url_index(char c) {
+    if (c == '-')
+        return 62;
+
+    if (c == '_')
+        return 63;
+
+    if (c == '+' || c == '/')
+        return -1;
+
+    return base64_index(c);
+}
+
+constexpr const char *base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr const char *base64url_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr auto base64_table(bool url) {
+    std::array<int8_t, 256> table{};
+    for(std::size_t pos = 0; pos < table.size(); ++pos) {
+        const auto ch = char(pos);
+        table[pos] = int8_t(url ? base64url_index(ch) : base64_index(ch));
+    }
+    return table;
+}
+
+// encoded length of size bytes, unpadded leaves off the trailing '='
+constexpr auto encoded_b64(std::size_t size, bool pad = true) {
+    if(pad)
+        return ((size + 2) / 3) * 4;
+    return (size / 3) * 4 + (size % 3 ? size % 3 + 1 : 0);
+}
+
 inline auto size_b64(std::string_view from) {
     auto size = from.size();
     if(!size)
@@ -78,81 +87,643 @@ inline auto size_b64(std::string_view from) {
         --size;
     auto out = ((size / 4) * 3) + 3;
 
+    // size is the index of the last char, a lone trailing char has no byte
     switch(size % 4) {
     case 0:
-        return out;
+        return out - 3;
     case 1:
         return out - 2;
     case 2:
         return out - 1;
     default:
-        return std::size_t(0);
+        return out;
     }
 }
 
-inline auto from_b64(std::string_view from, uint8_t *to, std::size_t max) {
-    auto out = size_b64(from);
+// Bulk kernels take whole blocks only and report how much input they
+// consumed, leaving the tail and any invalid characters to the scalar
+// code. They are picked once at first use from what the cpu supports.
+struct b64_kernels final {
+    using encode_t = std::size_t (*)(const uint8_t *, std::size_t, char *, bool);
+    using decode_t = std::size_t (*)(const char *, std::size_t, uint8_t *, std::size_t, bool);
 
-    if(out > max)
-        return std::size_t(0);
+    encode_t encode{nullptr};
+    decode_t decode{nullptr};
+};
 
-    uint32_t val = 0;
-    std::size_t bits = 0, count = 0;
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("ssse3"))) inline auto b64_encode_ssse3(const uint8_t *in, std::size_t size, char *out, bool url) -> std::size_t {
+    const auto lut = url ?
+        _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0) :
+        _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    const auto spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    std::size_t pos = 0;
+
+    // 12 bytes are used from each 16 loaded
+    for(; pos + 16 <= size; pos += 12) {
+        auto data = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos)), spread);
+        const auto hi = _mm_mulhi_epu16(_mm_and_si128(data, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        const auto lo = _mm_mullo_epi16(_mm_and_si128(data, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        data = _mm_or_si128(hi, lo);
+        auto index = _mm_subs_epu8(data, _mm_set1_epi8(51));
+        index = _mm_or_si128(index, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), data), _mm_set1_epi8(13)));
+        data = _mm_add_epi8(data, _mm_shuffle_epi8(lut, index));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), data);
+        out += 16;
+    }
+    return pos;
+}
+
+__attribute__((target("avx2"))) inline auto b64_encode_avx2(const uint8_t *in, std::size_t size, char *out, bool url) -> std::size_t {
+    const auto lut = url ?
+        _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0,
+                         'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0) :
+        _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                         'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    const auto spread = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    std::size_t pos = 0;
+
+    // each lane takes 12 bytes, the upper loaded from 12 bytes on
+    for(; pos + 28 <= size; pos += 24) {
+        const auto lower = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos));
+        const auto upper = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos + 12));
+        auto data = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lower), upper, 1), spread);
+        const auto hi = _mm256_mulhi_epu16(_mm256_and_si256(data, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        const auto lo = _mm256_mullo_epi16(_mm256_and_si256(data, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        data = _mm256_or_si256(hi, lo);
+        auto index = _mm256_subs_epu8(data, _mm256_set1_epi8(51));
+        index = _mm256_or_si256(index, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), data), _mm256_set1_epi8(13)));
+        data = _mm256_add_epi8(data, _mm256_shuffle_epi8(lut, index));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), data);
+        out += 32;
+    }
+    return pos;
+}
+
+// url input is mapped onto the standard alphabet once '+' and '/' are
+// ruled out, so both share the one range check
+__attribute__((target("ssse3"))) inline auto b64_decode_ssse3(const char *in, std::size_t size, uint8_t *out, std::size_t room, bool url) -> std::size_t {
+    const auto lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const auto lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const auto lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const auto mask = _mm_set1_epi8(0x2f);
+    const auto pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    std::size_t pos = 0;
+
+    // 16 bytes are stored for each 12 decoded
+    for(; pos + 16 <= size && (pos / 4) * 3 + 16 <= room; pos += 16) {
+        auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos));
+        if(url) {
+            const auto bad = _mm_or_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('+')), _mm_cmpeq_epi8(data, _mm_set1_epi8('/')));
+            if(_mm_movemask_epi8(bad))
+                break;
+            data = _mm_sub_epi8(data, _mm_and_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('-')), _mm_set1_epi8('-' - '+')));
+            data = _mm_sub_epi8(data, _mm_and_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('_')), _mm_set1_epi8('_' - '/')));
+        }
+        const auto hi_nibbles = _mm_and_si128(_mm_srli_epi32(data, 4), mask);
+        const auto lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(data, mask));
+        const auto hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+            break;
+        const auto roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(data, mask), hi_nibbles));
+        data = _mm_add_epi8(data, roll);
+        data = _mm_maddubs_epi16(data, _mm_set1_epi32(0x01400140));
+        data = _mm_madd_epi16(data, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + (pos / 4) * 3), _mm_shuffle_epi8(data, pack));
+    }
+    return pos;
+}
+
+__attribute__((target("avx2"))) inline auto b64_decode_avx2(const char *in, std::size_t size, uint8_t *out, std::size_t room, bool url) -> std::size_t {
+    const auto lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                                         0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const auto lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const auto lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                           0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const auto mask = _mm256_set1_epi8(0x2f);
+    const auto pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                       2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const auto lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    std::size_t pos = 0;
 
-    for (const auto &ch : from) {
-        if(count >= out)
+    // 32 bytes are stored for each 24 decoded
+    for(; pos + 32 <= size && (pos / 4) * 3 + 32 <= room; pos += 32) {
+        auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + pos));
+        if(url) {
+            const auto bad = _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('+')), _mm256_cmpeq_epi8(data, _mm256_set1_epi8('/')));
+            if(_mm256_movemask_epi8(bad))
+                break;
+            data = _mm256_sub_epi8(data, _mm256_and_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('-')), _mm256_set1_epi8('-' - '+')));
+            data = _mm256_sub_epi8(data, _mm256_and_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('_')), _mm256_set1_epi8('_' - '/')));
+        }
+        const auto hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(data, 4), mask);
+        const auto lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(data, mask));
+        const auto hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        if(!_mm256_testz_si256(lo, hi))
+            break;
+        const auto roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(data, mask), hi_nibbles));
+        data = _mm256_add_epi8(data, roll);
+        data = _mm256_maddubs_epi16(data, _mm256_set1_epi32(0x01400140));
+        data = _mm256_madd_epi16(data, _mm256_set1_epi32(0x00011000));
+        data = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(data, pack), lanes);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + (pos / 4) * 3), data);
+    }
+    return pos;
+}
+
+inline auto b64_simd() -> const b64_kernels& {
+    static const b64_kernels kernels = [] {
+        b64_kernels found;
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2")) {
+            found.encode = &b64_encode_avx2;
+            found.decode = &b64_decode_avx2;
+        }
+        else if(__builtin_cpu_supports("ssse3")) {
+            found.encode = &b64_encode_ssse3;
+            found.decode = &b64_decode_ssse3;
+        }
+        return found;
+    }();
+    return kernels;
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline auto b64_encode_neon(const uint8_t *in, std::size_t size, char *out, bool url) -> std::size_t {
+    const auto chars = reinterpret_cast<const uint8_t *>(url ? base64url_chars : base64_chars);
+    const uint8x16x4_t lut = {{vld1q_u8(chars), vld1q_u8(chars + 16), vld1q_u8(chars + 32), vld1q_u8(chars + 48)}};
+    const auto low6 = vdupq_n_u8(0x3f);
+    std::size_t pos = 0;
+
+    for(; pos + 48 <= size; pos += 48) {
+        const auto data = vld3q_u8(in + pos);
+        uint8x16x4_t index;
+        index.val[0] = vshrq_n_u8(data.val[0], 2);
+        index.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(data.val[0], 4), vshrq_n_u8(data.val[1], 4)), low6);
+        index.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(data.val[1], 2), vshrq_n_u8(data.val[2], 6)), low6);
+        index.val[3] = vandq_u8(data.val[2], low6);
+        for(auto& value : index.val)
+            value = vqtbl4q_u8(lut, value);
+        vst4q_u8(reinterpret_cast<uint8_t *>(out), index);
+        out += 64;
+    }
+    return pos;
+}
+
+// table entries are offset by one so any zero lane marks an invalid char
+inline auto b64_decode_neon(const char *in, std::size_t size, uint8_t *out, std::size_t room, bool url) -> std::size_t {
+    static const auto tables = [] {
+        std::array<std::array<uint8_t, 128>, 2> result{};
+        for(std::size_t pos = 0; pos < 128; ++pos) {
+            result[0][pos] = uint8_t(base64_index(char(pos)) + 1);
+            result[1][pos] = uint8_t(base64url_index(char(pos)) + 1);
+        }
+        return result;
+    }();
+    const auto table = tables[url ? 1 : 0].data();
+    const uint8x16x4_t lower = {{vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48)}};
+    const uint8x16x4_t upper = {{vld1q_u8(table + 64), vld1q_u8(table + 80), vld1q_u8(table + 96), vld1q_u8(table + 112)}};
+    const auto one = vdupq_n_u8(1), top = vdupq_n_u8(64);
+    std::size_t pos = 0;
+
+    for(; pos + 64 <= size && (pos / 4) * 3 + 48 <= room; pos += 64) {
+        auto data = vld4q_u8(reinterpret_cast<const uint8_t *>(in + pos));
+        auto valid = vdupq_n_u8(0xff);
+        for(auto& value : data.val) {
+            value = vorrq_u8(vqtbl4q_u8(lower, value), vqtbl4q_u8(upper, vsubq_u8(value, top)));
+            valid = vminq_u8(valid, value);
+            value = vsubq_u8(value, one);
+        }
+        if(!vminvq_u8(valid))
             break;
-        auto index = base64_index(ch);
-        if (index >= 0) {
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(data.val[0], 2), vshrq_n_u8(data.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(data.val[1], 4), vshrq_n_u8(data.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(data.val[2], 6), data.val[3]);
+        vst3q_u8(out + (pos / 4) * 3, bytes);
+    }
+    return pos;
+}
+
+inline auto b64_simd() -> const b64_kernels& {
+    static const b64_kernels kernels{&b64_encode_neon, &b64_decode_neon};
+    return kernels;
+}
+#else
+inline auto b64_simd() -> const b64_kernels& {
+    static const b64_kernels kernels{};
+    return kernels;
+}
+#endif
+
+// writes encoded_b64(size, pad) chars, without a nul byte
+inline auto b64_encode(const uint8_t *data, std::size_t size, char *out, bool url = false, bool pad = true) {
+    const auto start = out;
+    const auto chars = url ? base64url_chars : base64_chars;
+    std::size_t pos = 0;
+    if(size >= 64) {
+        const auto& kernels = b64_simd();
+        if(kernels.encode) {
+            pos = kernels.encode(data, size, out, url);
+            out += (pos / 3) * 4;
+        }
+    }
+
+    for(; pos + 3 <= size; pos += 3) {
+        const auto c = (uint32_t(data[pos]) << 16) | (uint32_t(data[pos + 1]) << 8) | uint32_t(data[pos + 2]);
+        out[0] = chars[(c >> 18) & 0x3f];
+        out[1] = chars[(c >> 12) & 0x3f];
+        out[2] = chars[(c >> 6) & 0x3f];
+        out[3] = chars[c & 0x3f];
+        out += 4;
+    }
+
+    const auto tail = size - pos;
+    if(tail) {
+        auto c = uint32_t(data[pos]) << 16;
+        if(tail > 1)
+            c |= uint32_t(data[pos + 1]) << 8;
+        *(out++) = chars[(c >> 18) & 0x3f];
+        *(out++) = chars[(c >> 12) & 0x3f];
+        if(tail > 1)
+            *(out++) = chars[(c >> 6) & 0x3f];
+        else if(pad)
+            *(out++) = '=';
+        if(pad)
+            *(out++) = '=';
+    }
+    return std::size_t(out - start);
+}
+
+// characters outside the alphabet are skipped, as are padding and line
+// breaks, and decoding stops once the expected size is reached
+inline auto b64_decode(std::string_view from, uint8_t *to, std::size_t max, bool url = false) {
+    static constexpr auto standard = base64_table(false);
+    static constexpr auto urlsafe = base64_table(true);
+    const auto& table = url ? urlsafe : standard;
+    const auto& kernels = b64_simd();
+    const auto text = from.data();
+    const auto size = from.size();
+    const auto out = std::min(size_b64(from), max);
+
+    uint32_t val = 0;
+    std::size_t bits = 0, count = 0, pos = 0;
+    while(pos < size && count < out) {
+        if(!bits && kernels.decode && size - pos >= 64) {
+            const auto used = kernels.decode(text + pos, size - pos, to + count, max - count, url);
+            pos += used;
+            count += (used / 4) * 3;
+        }
+
+        // whole quads while nothing is carried
+        while(!bits && pos + 4 <= size && count + 3 <= out) {
+            const auto a = table[uint8_t(text[pos])], b = table[uint8_t(text[pos + 1])];
+            const auto c = table[uint8_t(text[pos + 2])], d = table[uint8_t(text[pos + 3])];
+            if((a | b | c | d) < 0)
+                break;
+            const auto quad = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+            to[count++] = uint8_t(quad >> 16);
+            to[count++] = uint8_t(quad >> 8);
+            to[count++] = uint8_t(quad);
+            pos += 4;
+        }
+
+        // up to and past the next char outside a whole quad
+        while(pos < size && count < out) {
+            const auto index = table[uint8_t(text[pos++])];
+            if(index < 0) {
+                if(!bits)
+                    break;
+                continue;
+            }
             val = (val << 6) | uint32_t(index);
             bits += 6;
-            if (bits >= 8) {
-                to[count++] = (val >> (bits - 8));
+            if(bits >= 8) {
+                to[count++] = uint8_t(val >> (bits - 8));
                 bits -= 8;
+                if(!bits)
+                    break;
             }
         }
     }
     return count;
 }
 
-inline auto to_hex(const uint8_t *from, std::size_t size) {
+inline auto to_b64(const uint8_t *data, std::size_t size) {
     std::string out;
-    out.resize(size * 2);
-    auto hex = out.data();
+    out.resize(encoded_b64(size));
+    b64_encode(data, size, out.data());
+    return out;
+}
+
+// into a caller buffer, returning chars written or 0 if max is too small
+inline auto to_b64(const uint8_t *data, std::size_t size, char *out, std::size_t max) {
+    if(encoded_b64(size) > max)
+        return std::size_t(0);
+    return b64_encode(data, size, out);
+}
 
-    for(auto pos = std::size_t(0); pos < size; ++pos) {
-        snprintf(hex, 3, "%02x", from[pos]);
-        hex += 2;
+// rfc 4648 url safe form, unpadded as it is used in jwt and urls
+inline auto to_b64url(const uint8_t *data, std::size_t size, bool pad = false) {
+    std::string out;
+    out.resize(encoded_b64(size, pad));
+    b64_encode(data, size, out.data(), true, pad);
+    return out;
+}
+
+inline auto to_b64url(const uint8_t *data, std::size_t size, char *out, std::size_t max, bool pad = false) {
+    if(encoded_b64(size, pad) > max)
+        return std::size_t(0);
+    return b64_encode(data, size, out, true, pad);
+}
+
+// streamed in blocks through a small stack buffer, fitting omemstream
+inline auto to_b64(const uint8_t *data, std::size_t size, std::ostream& out, bool url = false, bool pad = true) -> std::ostream& {
+    std::array<char, 4096> buf{};
+    constexpr std::size_t block = (4096 / 4) * 3;
+    while(size > block && out.good()) {
+        out.write(buf.data(), std::streamsize(b64_encode(data, block, buf.data(), url)));
+        data += block;
+        size -= block;
+    }
+    return out.write(buf.data(), std::streamsize(b64_encode(data, size, buf.data(), url, pad)));
+}
+
+inline auto from_b64(std::string_view from, uint8_t *to, std::size_t max) {
+    if(size_b64(from) > max)
+        return std::size_t(0);
+    return b64_decode(from, to, max);
+}
+
+// padding is optional
+inline auto from_b64url(std::string_view from, uint8_t *to, std::size_t max) {
+    if(size_b64(from) > max)
+        return std::size_t(0);
+    return b64_decode(from, to, max, true);
+}
+
+constexpr const char *hex_chars = "0123456789abcdef";
+constexpr const char *hex_upper = "0123456789ABCDEF";
+
+constexpr auto hex_index(char c) {
+    if(c >= '0' && c <= '9')
+        return c - '0';
+
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+// As with base64, bulk kernels do whole blocks and report input used. A
+// decode block with any invalid char is left to the scalar code.
+struct hex_kernels final {
+    using encode_t = std::size_t (*)(const uint8_t *, std::size_t, char *, bool);
+    using decode_t = std::size_t (*)(const char *, std::size_t, uint8_t *);
+
+    encode_t encode{nullptr};
+    decode_t decode{nullptr};
+};
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("ssse3"))) inline auto hex_encode_ssse3(const uint8_t *in, std::size_t size, char *out, bool upper) -> std::size_t {
+    const auto lut = _mm_loadu_si128(reinterpret_cast<const __m128i *>(upper ? hex_upper : hex_chars));
+    const auto mask = _mm_set1_epi8(0x0f);
+    std::size_t pos = 0;
+
+    for(; pos + 16 <= size; pos += 16) {
+        const auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos));
+        const auto hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(data, 4), mask));
+        const auto lo = _mm_shuffle_epi8(lut, _mm_and_si128(data, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + pos * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + pos * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return pos;
+}
+
+__attribute__((target("avx2"))) inline auto hex_encode_avx2(const uint8_t *in, std::size_t size, char *out, bool upper) -> std::size_t {
+    const auto lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(upper ? hex_upper : hex_chars)));
+    const auto mask = _mm256_set1_epi8(0x0f);
+    std::size_t pos = 0;
+
+    // unpack works within lanes, so the halves are put back in order
+    for(; pos + 32 <= size; pos += 32) {
+        const auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + pos));
+        const auto hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(data, 4), mask));
+        const auto lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(data, mask));
+        const auto first = _mm256_unpacklo_epi8(hi, lo), second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + pos * 2), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + pos * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return pos;
+}
+
+// digits and folded letters are range checked apart, then nibble pairs
+// are merged by multiply add and packed down to bytes
+__attribute__((target("ssse3"))) inline auto hex_nibbles_ssse3(__m128i data, int& valid) -> __m128i {
+    const auto digit = _mm_sub_epi8(data, _mm_set1_epi8('0'));
+    const auto alpha = _mm_sub_epi8(_mm_or_si128(data, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const auto is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    const auto is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    valid &= _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3"))) inline auto hex_decode_ssse3(const char *in, std::size_t size, uint8_t *out) -> std::size_t {
+    const auto merge = _mm_set1_epi16(0x0110);
+    std::size_t pos = 0;
+
+    for(; pos + 32 <= size; pos += 32) {
+        int valid = 0xffff;
+        const auto first = hex_nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos)), valid);
+        const auto second = hex_nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos + 16)), valid);
+        if(valid != 0xffff)
+            break;
+        const auto bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, merge), _mm_maddubs_epi16(second, merge));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + pos / 2), bytes);
+    }
+    return pos;
+}
+
+inline auto hex_simd() -> const hex_kernels& {
+    static const hex_kernels kernels = [] {
+        hex_kernels found;
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("ssse3")) {
+            found.encode = &hex_encode_ssse3;
+            found.decode = &hex_decode_ssse3;
+        }
+        if(__builtin_cpu_supports("avx2"))
+            found.encode = &hex_encode_avx2;
+        return found;
+    }();
+    return kernels;
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline auto hex_encode_neon(const uint8_t *in, std::size_t size, char *out, bool upper) -> std::size_t {
+    const auto lut = vld1q_u8(reinterpret_cast<const uint8_t *>(upper ? hex_upper : hex_chars));
+    const auto mask = vdupq_n_u8(0x0f);
+    std::size_t pos = 0;
+
+    for(; pos + 16 <= size; pos += 16) {
+        const auto data = vld1q_u8(in + pos);
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(lut, vshrq_n_u8(data, 4));
+        chars.val[1] = vqtbl1q_u8(lut, vandq_u8(data, mask));
+        vst2q_u8(reinterpret_cast<uint8_t *>(out + pos * 2), chars);
     }
+    return pos;
+}
+
+inline auto hex_decode_neon(const char *in, std::size_t size, uint8_t *out) -> std::size_t {
+    std::size_t pos = 0;
+
+    for(; pos + 32 <= size; pos += 32) {
+        auto pairs = vld2q_u8(reinterpret_cast<const uint8_t *>(in + pos));
+        auto valid = vdupq_n_u8(0xff);
+        for(auto& data : pairs.val) {
+            const auto digit = vsubq_u8(data, vdupq_n_u8('0'));
+            const auto alpha = vsubq_u8(vorrq_u8(data, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+            const auto is_digit = vcltq_u8(digit, vdupq_n_u8(10));
+            const auto is_alpha = vcltq_u8(alpha, vdupq_n_u8(6));
+            valid = vandq_u8(valid, vorrq_u8(is_digit, is_alpha));
+            data = vorrq_u8(vandq_u8(is_digit, digit), vandq_u8(is_alpha, vaddq_u8(alpha, vdupq_n_u8(10))));
+        }
+        if(vminvq_u8(valid) != 0xff)
+            break;
+        vst1q_u8(out + pos / 2, vorrq_u8(vshlq_n_u8(pairs.val[0], 4), pairs.val[1]));
+    }
+    return pos;
+}
+
+inline auto hex_simd() -> const hex_kernels& {
+    static const hex_kernels kernels{&hex_encode_neon, &hex_decode_neon};
+    return kernels;
+}
+#else
+inline auto hex_simd() -> const hex_kernels& {
+    static const hex_kernels kernels{};
+    return kernels;
+}
+#endif
+
+// writes size * 2 chars, without a nul byte
+inline auto hex_encode(const uint8_t *from, std::size_t size, char *out, bool upper = false) {
+    const auto chars = upper ? hex_upper : hex_chars;
+    std::size_t pos = 0;
+    if(size >= 16) {
+        const auto& kernels = hex_simd();
+        if(kernels.encode)
+            pos = kernels.encode(from, size, out, upper);
+    }
+
+    for(; pos < size; ++pos) {
+        out[pos * 2] = chars[from[pos] >> 4];
+        out[pos * 2 + 1] = chars[from[pos] & 0x0f];
+    }
+    return size * 2;
+}
+
+inline auto to_hex(const uint8_t *from, std::size_t size, bool upper = false) {
+    std::string out;
+    out.resize(size * 2);
+    hex_encode(from, size, out.data(), upper);
     return out;
 }
 
-inline auto to_hex(const std::string_view str) {
-    return to_hex(reinterpret_cast<const uint8_t *>(str.data()), str.size());
+inline auto to_hex(const std::string_view str, bool upper = false) {
+    return to_hex(reinterpret_cast<const uint8_t *>(str.data()), str.size(), upper);
 }
 
-inline auto to_hex(const crypto::key_t& key) {
-    return to_hex(key.first, key.second);
+inline auto to_hex(const crypto::key_t& key, bool upper = false) {
+    return to_hex(key.first, key.second, upper);
+}
+
+// into a caller buffer, returning chars written or 0 if max is too small
+inline auto to_hex(const uint8_t *from, std::size_t size, char *out, std::size_t max, bool upper = false) {
+    if(size * 2 > max)
+        return std::size_t(0);
+    return hex_encode(from, size, out, upper);
 }
 
+inline auto to_hex(const crypto::key_t& key, char *out, std::size_t max, bool upper = false) {
+    return to_hex(key.first, key.second, out, max, upper);
+}
+
+inline auto to_hex(const uint8_t *from, std::size_t size, std::ostream& out, bool upper = false) -> std::ostream& {
+    std::array<char, 4096> buf{};
+    constexpr std::size_t block = 4096 / 2;
+    while(size && out.good()) {
+        const auto count = std::min(size, block);
+        out.write(buf.data(), std::streamsize(hex_encode(from, count, buf.data(), upper)));
+        from += count;
+        size -= count;
+    }
+    return out;
+}
+
+// decodes whole pairs, stopping at the first invalid one
 inline auto from_hex(std::string_view from, uint8_t *to, std::size_t size) {
-    auto hex = from.data();
-    auto max = size * 2;
-    if(from.size() <= max)
-        max = from.size();
-
-    for(auto pos = std::size_t(0); pos < max; pos += 2) {
-        char buf[3]{};
-        buf[0] = hex[pos];
-        buf[1] = hex[pos + 1];
-        buf[2] = 0;
-        char *end = nullptr;
-        auto value = strtoul(buf, &end, 16);
-        if(*end != 0)
-            return pos / 2;
-        *(to++) = uint8_t(value);
-    }
-    return max / 2;
+    static constexpr auto table = [] {
+        std::array<int8_t, 256> result{};
+        for(std::size_t pos = 0; pos < result.size(); ++pos)
+            result[pos] = int8_t(hex_index(char(pos)));
+        return result;
+    }();
+    const auto hex = from.data();
+    const auto max = std::min(from.size() / 2, size);
+    std::size_t pos = 0;
+    if(max >= 16) {
+        const auto& kernels = hex_simd();
+        if(kernels.decode)
+            pos = kernels.decode(hex, max * 2, to) / 2;
+    }
+
+    for(; pos < max; ++pos) {
+        const auto hi = table[uint8_t(hex[pos * 2])], lo = table[uint8_t(hex[pos * 2 + 1])];
+        if((hi | lo) < 0)
+            return pos;
+        to[pos] = uint8_t((hi << 4) | lo);
+    }
+    return max;
+}
+
+// For secrets, timing depends only on the length. The text has to be
+// exactly size bytes of hex, otherwise the output is cleared and 0 is
+// returned.
+inline auto from_hex_consttime(std::string_view from, uint8_t *to, std::size_t size) {
+    if(from.size() != size * 2)
+        return std::size_t(0);
+
+    // all ones when value is within 0 to span, else 0
+    const auto within = [](int value, int span) {
+        return ~((value | (span - value)) >> 8);
+    };
+
+    const auto nibble = [&within](char ch, int& bad) {
+        const auto code = int(uint8_t(ch));
+        const auto digit = code - '0', alpha = (code | 0x20) - 'a';
+        const auto is_digit = within(digit, 9), is_alpha = within(alpha, 5);
+        bad |= ~(is_digit | is_alpha) & 1;
+        return (digit & is_digit) | ((alpha + 10) & is_alpha);
+    };
+
+    int bad = 0;
+    for(std::size_t pos = 0; pos < size; ++pos) {
+        const auto hi = nibble(from[pos * 2], bad);
+        const auto lo = nibble(from[pos * 2 + 1], bad);
+        to[pos] = uint8_t((hi << 4) | lo);
+    }
+
+    if(bad) {
+        memset(to, 0, size);
+        return std::size_t(0);
+    }
+    return size;
 }
 } // end namespace
 
@@ -4,25 +4,43 @@
 #ifndef TYCHO_FILESYSTEM_HPP_
 #define TYCHO_FILESYSTEM_HPP_
 
+#include "tasks.hpp"
+
 #include <filesystem>
 #include <type_traits>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <sys/types.h>
 #include <fcntl.h>
 
 #ifndef _MSC_VER
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #else
 #include <BaseTsd.h>
 using ssize_t = SSIZE_T;
 #endif
 
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/syscall.h>
+#elif !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+#include <dirent.h>
+#endif
+
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
 extern "C" {
 #include <io.h>
@@ -310,6 +328,112 @@ inline auto scan_file(const fsys::path& path, Func proc) {
     return count;
 }
 
+// Lines of a memory range as views, without their newline, as getline
+// would split them. Stops early when proc returns false or stop is set.
+template <typename Func>
+inline auto scan_range(const char *data, std::size_t size, Func& proc, std::atomic<bool> *stop = nullptr) {
+    std::size_t count{0};
+    const auto end = data + size;
+    while(data < end) {
+        if(stop && stop->load(std::memory_order_relaxed))
+            break;
+        auto next = static_cast<const char *>(std::memchr(data, '\n', std::size_t(end - data)));
+        if(!next)
+            next = end;
+        if(!proc(std::string_view(data, std::size_t(next - data)))) {
+            if(stop)
+                *stop = true;
+            break;
+        }
+        ++count;
+        data = next + 1;
+    }
+    return count;
+}
+
+// Split on newline boundaries so each thread scans whole lines; with
+// threads proc must be thread safe and lines are not seen in order.
+template <typename Func>
+inline auto scan_view(std::string_view text, Func proc, std::size_t threads = 1) {
+    if(threads < 2 || text.size() < threads * 65536)
+        return scan_range(text.data(), text.size(), proc);
+
+    std::vector<std::size_t> bounds{0};
+    for(std::size_t part = 1; part < threads; ++part) {
+        auto pos = std::max(bounds.back(), text.size() * part / threads);
+        pos = text.find('\n', pos);
+        if(pos == std::string_view::npos)
+            break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(text.size());
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> total{0};
+    parallel_jobs(bounds.size() - 1, threads, [&](std::size_t part) {
+        total += scan_range(text.data() + bounds[part], bounds[part + 1] - bounds[part], proc, &stop);
+        return true;
+    });
+    return total.load();
+}
+
+// Zero copy scan of a file, mapped where it is a regular file, else read
+// in large blocks. Views are only valid during the call to proc.
+template <typename Func>
+inline auto scan_lines(const fsys::path& path, Func proc, std::size_t threads = 1) {
+    const fsys::fd_t fd(path, fsys::mode::rd);
+    if(!fd)
+        return std::size_t(0);
+
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+    // procfs and the like report no size, so they are read instead
+    struct stat info{};
+    if(!::fstat(fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0) {
+        const auto size = std::size_t(info.st_size);
+        auto map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map != MAP_FAILED) {
+            ::posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+            auto count = scan_view(std::string_view(static_cast<const char *>(map), size), proc, threads);
+            ::munmap(map, size);
+            return count;
+        }
+    }
+#endif
+
+    // a partial line is carried to the front and the buffer grows to fit
+    std::vector<char> buf(1024 * 1024);
+    std::size_t count{0}, kept{0};
+    for(;;) {
+        if(kept == buf.size())
+            buf.resize(buf.size() * 2);
+        auto len = fd.read(buf.data() + kept, buf.size() - kept); // FlawFinder: ignore
+        if(len <= 0)
+            break;
+        const auto used = kept + std::size_t(len);
+        const auto last = std::string_view(buf.data(), used).rfind('\n');
+        if(last == std::string_view::npos) {
+            kept = used;
+            continue;
+        }
+        const auto whole = last + 1;
+        auto stopped = false;
+        auto check = [&proc, &stopped](std::string_view line) {
+            if(proc(line))
+                return true;
+            stopped = true;
+            return false;
+        };
+        count += scan_range(buf.data(), whole, check);
+        if(stopped)
+            return count;
+        kept = used - whole;
+        std::memmove(buf.data(), buf.data() + whole, kept);
+    }
+    if(kept)
+        count += scan_range(buf.data(), kept, proc);
+    return count;
+}
+
 #if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
 template <typename Func>
 inline auto scan_file(std::FILE *file, Func proc, std::size_t size = 0) {
@@ -396,6 +520,208 @@ inline auto scan_recursive(const fsys::path& path, Func proc) {
     return std::count_if(begin(dir), end(dir), proc);
 }
 
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+// type of a directory entry when d_type does not say, without following links
+inline auto file_type_at(int dirfd, const char *name) noexcept {
+#if defined(STATX_TYPE)
+    struct statx info{};
+    if(::statx(dirfd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_TYPE, &info))
+        return fsys::file_type::unknown;
+    const auto mode = mode_t(info.stx_mode);
+#else
+    struct stat info{};
+    if(::fstatat(dirfd, name, &info, AT_SYMLINK_NOFOLLOW))
+        return fsys::file_type::unknown;
+    const auto mode = info.st_mode;
+#endif
+    if(S_ISREG(mode))
+        return fsys::file_type::regular;
+    if(S_ISDIR(mode))
+        return fsys::file_type::directory;
+    if(S_ISLNK(mode))
+        return fsys::file_type::symlink;
+    if(S_ISFIFO(mode))
+        return fsys::file_type::fifo;
+    if(S_ISSOCK(mode))
+        return fsys::file_type::socket;
+    if(S_ISCHR(mode))
+        return fsys::file_type::character;
+    if(S_ISBLK(mode))
+        return fsys::file_type::block;
+    return fsys::file_type::unknown;
+}
+
+inline auto file_type_at(int dirfd, const char *name, unsigned char type) noexcept {
+    switch(type) {
+    case DT_REG:
+        return fsys::file_type::regular;
+    case DT_DIR:
+        return fsys::file_type::directory;
+    case DT_LNK:
+        return fsys::file_type::symlink;
+    case DT_FIFO:
+        return fsys::file_type::fifo;
+    case DT_SOCK:
+        return fsys::file_type::socket;
+    case DT_CHR:
+        return fsys::file_type::character;
+    case DT_BLK:
+        return fsys::file_type::block;
+    default:
+        return file_type_at(dirfd, name);
+    }
+}
+#endif
+
+enum class walk_t : uint8_t {next, prune, stop};
+
+// Entry as seen by scan_tree, only valid during the callback
+struct walk_entry final {
+    const std::string& dir;
+    std::string_view name;
+    fsys::file_type type{fsys::file_type::unknown};
+    std::size_t depth{0};
+
+    auto path() const {
+        return fsys::path(dir) / name;
+    }
+
+    auto is_dir() const noexcept {
+        return type == fsys::file_type::directory;
+    }
+};
+
+// Parallel walk of a tree, directories are scanned concurrently on the
+// shared pool from a shared depth first stack. Once the stack holds limit
+// directories a thread keeps new ones to itself, which bounds memory on
+// very wide trees. Symlinks are reported and not followed. proc is called
+// from many threads and returns prune to skip a directory or stop to end
+// the walk. Returns the count of entries seen.
+template <typename Func>
+inline auto scan_tree(const fsys::path& root, Func proc, std::size_t threads = 0, std::size_t limit = 4096) {
+    struct dir_t final {
+        std::string path;
+        std::size_t depth{0};
+    };
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<dir_t> shared{dir_t{root.string(), 0}};
+    std::size_t busy{0};
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> seen{0};
+
+    // list one directory, handing subdirectories to the stack or keeping them
+    const auto scan = [&](const dir_t& dir, std::vector<dir_t>& local) {
+        const auto found = [&](std::string_view name, fsys::file_type type) {
+            if(stop.load(std::memory_order_relaxed))
+                return false;
+            ++seen;
+            const walk_entry entry{dir.path, name, type, dir.depth};
+            const walk_t action = proc(entry);
+            if(action == walk_t::stop) {
+                stop = true;
+                return false;
+            }
+            if(action == walk_t::next && type == fsys::file_type::directory) {
+                auto path = dir.path;
+                if(path.empty() || path.back() != '/')
+                    path += '/';
+                path.append(name);
+                const std::unique_lock guard(lock);
+                if(shared.size() < limit) {
+                    shared.push_back(dir_t{std::move(path), dir.depth + 1});
+                    wake.notify_one();
+                    return true;
+                }
+                local.push_back(dir_t{std::move(path), dir.depth + 1});
+            }
+            return true;
+        };
+
+#if defined(__linux__)
+        const int fd = ::open(dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); // FlawFinder: ignore
+        if(fd < 0)
+            return;
+
+        // linux_dirent64 records, with d_type saving a stat per entry
+        alignas(8) char buf[32768];
+        for(;;) {
+            const auto len = ::syscall(SYS_getdents64, fd, buf, sizeof(buf));
+            if(len <= 0)
+                break;
+            for(long pos = 0; pos < len;) {
+                const auto record = reinterpret_cast<const struct dirent64 *>(buf + pos);
+                pos += record->d_reclen;
+                const std::string_view name(record->d_name);
+                if(name == "." || name == "..")
+                    continue;
+                if(!found(name, file_type_at(fd, record->d_name, record->d_type))) {
+                    ::close(fd);
+                    return;
+                }
+            }
+        }
+        ::close(fd);
+#elif !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+        auto handle = ::opendir(dir.path.c_str());
+        if(!handle)
+            return;
+        while(const auto *record = ::readdir(handle)) {   // NOLINT
+            const std::string_view name(record->d_name);
+            if(name == "." || name == "..")
+                continue;
+            if(!found(name, file_type_at(::dirfd(handle), record->d_name, record->d_type)))
+                break;
+        }
+        ::closedir(handle);
+#else
+        std::error_code ec;
+        for(auto it = fsys::directory_iterator(dir.path, fsys::directory_options::skip_permission_denied, ec); !ec && it != fsys::directory_iterator(); it.increment(ec)) {
+            const auto name = it->path().filename().string();
+            if(!found(name, it->symlink_status(ec).type()))
+                return;
+        }
+#endif
+    };
+
+    const auto count = threads ? threads : std::max(1U, std::thread::hardware_concurrency());
+    const auto worker = [&] {
+        std::vector<dir_t> local;
+        std::unique_lock guard(lock);
+        for(;;) {
+            wake.wait(guard, [&] {
+                return !shared.empty() || !busy || stop;
+            });
+            if(shared.empty() || stop)
+                break;
+            auto dir = std::move(shared.back());
+            shared.pop_back();
+            ++busy;
+            guard.unlock();
+            scan(dir, local);
+            while(!local.empty() && !stop) {
+                dir = std::move(local.back());
+                local.pop_back();
+                scan(dir, local);
+            }
+            local.clear();
+            guard.lock();
+            --busy;
+            if(!busy && shared.empty())
+                wake.notify_all();
+        }
+        wake.notify_all();
+    };
+
+    // workers that start after the walk has finished return at once
+    parallel_jobs(count, count, [&worker](std::size_t) {
+        worker();
+        return true;
+    });
+    return seen.load();
+}
+
 inline auto to_string(const fsys::path& path) {
     return std::string{path.string()};
 }
@@ -0,0 +1,491 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_HASHMAP_HPP_
+#define TYCHO_HASHMAP_HPP_
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace tycho {
+namespace hashing {
+constexpr uint64_t secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+// 64x64 -> 128 multiply folded back to 64 bits
+inline auto mum(uint64_t& lo, uint64_t& hi) noexcept {
+#if defined(__SIZEOF_INT128__)
+    const auto product = static_cast<unsigned __int128>(lo) * hi;
+    lo = uint64_t(product);
+    hi = uint64_t(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    lo = _umul128(lo, hi, &hi);
+#else
+    const uint64_t ha = lo >> 32, hb = hi >> 32, la = uint32_t(lo), lb = uint32_t(hi);
+    const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const uint64_t t = rl + (rm0 << 32);
+    auto carry = uint64_t(t < rl);
+    lo = t + (rm1 << 32);
+    carry += uint64_t(lo < t);
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline auto mix(uint64_t lo, uint64_t hi) noexcept {
+    mum(lo, hi);
+    return lo ^ hi;
+}
+
+inline auto read64(const uint8_t *mem) noexcept {
+    uint64_t value{};
+    memcpy(&value, mem, sizeof(value)); // FlawFinder: ignore
+    return value;
+}
+
+inline auto read32(const uint8_t *mem) noexcept {
+    uint32_t value{};
+    memcpy(&value, mem, sizeof(value)); // FlawFinder: ignore
+    return uint64_t(value);
+}
+} // end namespace
+
+// wyhash style hash, three independent 64 bit lanes for long keys
+inline auto mem_hash(const void *data, std::size_t size, uint64_t seed = 0) noexcept -> uint64_t {
+    using namespace hashing;
+    auto mem = static_cast<const uint8_t *>(data);
+    uint64_t lo{0}, hi{0};
+    seed ^= mix(seed ^ secret[0], secret[1]);
+    if(size <= 16) {
+        if(size >= 4) {
+            const auto shift = (size >> 3) << 2;
+            lo = (read32(mem) << 32) | read32(mem + shift);
+            hi = (read32(mem + size - 4) << 32) | read32(mem + size - 4 - shift);
+        }
+        else if(size > 0)
+            lo = (uint64_t(mem[0]) << 16) | (uint64_t(mem[size >> 1]) << 8) | mem[size - 1];
+    }
+    else {
+        auto remains = size;
+        if(remains > 48) {
+            auto lane1 = seed, lane2 = seed;
+            do {
+                seed = mix(read64(mem) ^ secret[1], read64(mem + 8) ^ seed);
+                lane1 = mix(read64(mem + 16) ^ secret[2], read64(mem + 24) ^ lane1);
+                lane2 = mix(read64(mem + 32) ^ secret[3], read64(mem + 40) ^ lane2);
+                mem += 48;
+                remains -= 48;
+            } while(remains > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        while(remains > 16) {
+            seed = mix(read64(mem) ^ secret[1], read64(mem + 8) ^ seed);
+            mem += 16;
+            remains -= 16;
+        }
+        lo = read64(mem + remains - 16);
+        hi = read64(mem + remains - 8);
+    }
+    lo ^= secret[1];
+    hi ^= seed;
+    mum(lo, hi);
+    return mix(lo ^ secret[0] ^ size, hi ^ secret[1]);
+}
+
+inline auto mem_hash(std::string_view str, uint64_t seed = 0) noexcept {
+    return mem_hash(str.data(), str.size(), seed);
+}
+
+// spread an integer or weak std::hash result over all bits
+constexpr auto hash_mix(uint64_t value) noexcept {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    return value ^ (value >> 33);
+}
+
+template<typename Key, typename = void>
+struct flat_hash {
+    auto operator()(const Key& key) const noexcept(noexcept(std::hash<Key>{}(key))) -> uint64_t {
+        return hash_mix(uint64_t(std::hash<Key>{}(key)));
+    }
+};
+
+template<typename Key>
+struct flat_hash<Key, std::enable_if_t<std::is_integral_v<Key> || std::is_enum_v<Key>>> {
+    constexpr auto operator()(Key key) const noexcept -> uint64_t {
+        return hash_mix(uint64_t(key));
+    }
+};
+
+// strings hash by content, so any string_view-like key can be looked up
+template<typename Key>
+struct flat_hash<Key, std::enable_if_t<std::is_same_v<Key, std::string> || std::is_same_v<Key, std::string_view>>> {
+    using is_transparent = void;
+
+    auto operator()(std::string_view key) const noexcept -> uint64_t {
+        return mem_hash(key);
+    }
+};
+
+// Open addressing map with linear probing and backward shift deletion.
+// Entries live in one array next to a byte of tag per slot, so a lookup
+// touches one or two cache lines rather than chasing bucket nodes. Any
+// insert or erase may move entries and invalidates iterators.
+template<typename Key, typename T, typename Hash = flat_hash<Key>, typename KeyEqual = std::equal_to<>>
+class flat_map final {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = std::size_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using map_type = std::conditional_t<Const, const flat_map, flat_map>;
+        using value_type = std::conditional_t<Const, const flat_map::value_type, flat_map::value_type>;
+
+        basic_iterator(map_type *map, size_type index) noexcept : map_(map), index_(index) {
+            skip();
+        }
+
+        template<bool Other, std::enable_if_t<Const && !Other, int> = 0>
+        basic_iterator(const basic_iterator<Other>& other) noexcept : map_(other.map_), index_(other.index_) {} // NOLINT
+
+        auto operator*() const noexcept -> value_type& {
+            return map_->slots_[index_].value;
+        }
+
+        auto operator->() const noexcept -> value_type * {
+            return &map_->slots_[index_].value;
+        }
+
+        auto operator++() noexcept -> auto& {
+            ++index_;
+            skip();
+            return *this;
+        }
+
+        auto operator==(const basic_iterator& other) const noexcept {
+            return index_ == other.index_;
+        }
+
+        auto operator!=(const basic_iterator& other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class flat_map;
+        template<bool> friend class basic_iterator;
+
+        map_type *map_{nullptr};
+        size_type index_{0};
+
+        void skip() noexcept {
+            while(index_ < map_->capacity() && !map_->tags_[index_])
+                ++index_;
+        }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    flat_map() = default;
+
+    flat_map(std::initializer_list<value_type> list) {
+        reserve(list.size());
+        for(const auto& item : list)
+            insert(item);
+    }
+
+    flat_map(const flat_map& other) : hash_(other.hash_), equal_(other.equal_) {
+        reserve(other.size_);
+        for(const auto& item : other)
+            insert(item);
+    }
+
+    flat_map(flat_map&& other) noexcept :
+    slots_(std::move(other.slots_)), tags_(std::move(other.tags_)), mask_(other.mask_), size_(other.size_), hash_(other.hash_), equal_(other.equal_) {
+        other.mask_ = other.size_ = 0;
+    }
+
+    ~flat_map() {
+        clear();
+    }
+
+    auto operator=(const flat_map& other) -> auto& {
+        if(this != &other) {
+            flat_map copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    auto operator=(flat_map&& other) noexcept -> auto& {
+        if(this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    template<typename K>
+    auto operator[](K&& key) -> T& {
+        return try_emplace(std::forward<K>(key)).first->second;
+    }
+
+    template<typename K>
+    auto at(const K& key) -> T& {
+        auto index = locate(key, hash_(key));
+        if(index == npos)
+            throw std::out_of_range("Key not found");
+        return slots_[index].value.second;
+    }
+
+    template<typename K>
+    auto at(const K& key) const -> const T& {
+        auto index = locate(key, hash_(key));
+        if(index == npos)
+            throw std::out_of_range("Key not found");
+        return slots_[index].value.second;
+    }
+
+    template<typename K>
+    auto find(const K& key) -> iterator {
+        auto index = locate(key, hash_(key));
+        return index == npos ? end() : iterator(this, index);
+    }
+
+    template<typename K>
+    auto find(const K& key) const -> const_iterator {
+        auto index = locate(key, hash_(key));
+        return index == npos ? end() : const_iterator(this, index);
+    }
+
+    template<typename K>
+    auto contains(const K& key) const {
+        return locate(key, hash_(key)) != npos;
+    }
+
+    template<typename K>
+    auto count(const K& key) const -> size_type {
+        return contains(key) ? 1 : 0;
+    }
+
+    template<typename K, typename... Args>
+    auto try_emplace(K&& key, Args&&... args) -> std::pair<iterator, bool> {
+        const auto hash = hash_(key);
+        auto index = locate(key, hash);
+        if(index != npos)
+            return {iterator(this, index), false};
+        reserve(size_ + 1);
+        index = vacant(hash);
+        new(&slots_[index].value) value_type(std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        tags_[index] = tag(hash);
+        ++size_;
+        return {iterator(this, index), true};
+    }
+
+    auto insert(const value_type& value) {
+        return try_emplace(value.first, value.second);
+    }
+
+    auto insert(value_type&& value) {
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    template<typename K, typename V>
+    auto insert_or_assign(K&& key, V&& value) {
+        auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+        if(!result.second)
+            result.first->second = std::forward<V>(value);
+        return result;
+    }
+
+    template<typename K, typename V>
+    auto emplace(K&& key, V&& value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    template<typename K>
+    auto erase(const K& key) -> size_type {
+        auto index = locate(key, hash_(key));
+        if(index == npos)
+            return 0;
+        remove(index);
+        return 1;
+    }
+
+    // a shifted entry may be offered to pred twice, never skipped
+    template<typename Pred>
+    auto erase_if(Pred pred) -> size_type {
+        size_type removed = 0;
+        for(size_type index = 0; index < capacity(); ++index) {
+            while(tags_[index] && pred(std::as_const(slots_[index].value))) {
+                remove(index);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    void reserve(size_type count) {
+        auto cap = capacity();
+        if(count * 8 <= cap * 7)
+            return;
+        if(!cap)
+            cap = 16;
+        while(count * 8 > cap * 7)
+            cap <<= 1;
+        rehash(cap);
+    }
+
+    void clear() noexcept {
+        for(size_type index = 0; index < capacity(); ++index) {
+            if(tags_[index]) {
+                slots_[index].value.~value_type();
+                tags_[index] = 0;
+            }
+        }
+        size_ = 0;
+    }
+
+    void swap(flat_map& other) noexcept {
+        std::swap(slots_, other.slots_);
+        std::swap(tags_, other.tags_);
+        std::swap(mask_, other.mask_);
+        std::swap(size_, other.size_);
+        std::swap(hash_, other.hash_);
+        std::swap(equal_, other.equal_);
+    }
+
+    auto size() const noexcept {
+        return size_;
+    }
+
+    auto empty() const noexcept {
+        return size_ == 0;
+    }
+
+    auto capacity() const noexcept -> size_type {
+        return slots_ ? mask_ + 1 : 0;
+    }
+
+    auto load_factor() const noexcept {
+        return capacity() ? float(size_) / float(capacity()) : 0.0F;
+    }
+
+    auto begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    auto end() noexcept {
+        return iterator(this, capacity());
+    }
+
+    auto begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    auto end() const noexcept {
+        return const_iterator(this, capacity());
+    }
+
+private:
+    union slot_t {
+        slot_t() noexcept {}    // NOLINT
+        ~slot_t() {}            // NOLINT
+        value_type value;
+    };
+
+    static constexpr size_type npos = ~size_type(0);
+
+    std::unique_ptr<slot_t[]> slots_;
+    std::unique_ptr<uint8_t[]> tags_;
+    size_type mask_{0}, size_{0};
+    Hash hash_{};
+    KeyEqual equal_{};
+
+    // top bits of the hash with the high bit set, zero marks an empty slot
+    static constexpr auto tag(uint64_t hash) noexcept {
+        return uint8_t((hash >> 57) | 0x80);
+    }
+
+    template<typename K>
+    auto locate(const K& key, uint64_t hash) const -> size_type {
+        if(!size_)
+            return npos;
+        const auto want = tag(hash);
+        for(auto index = size_type(hash) & mask_;; index = (index + 1) & mask_) {
+            const auto have = tags_[index];
+            if(!have)
+                return npos;
+            if(have == want && equal_(slots_[index].value.first, key))
+                return index;
+        }
+    }
+
+    auto vacant(uint64_t hash) const noexcept -> size_type {
+        auto index = size_type(hash) & mask_;
+        while(tags_[index])
+            index = (index + 1) & mask_;
+        return index;
+    }
+
+    void remove(size_type hole) {
+        slots_[hole].value.~value_type();
+        tags_[hole] = 0;
+        --size_;
+
+        // pull later entries of the probe run back so lookups never see a gap
+        for(auto next = (hole + 1) & mask_; tags_[next]; next = (next + 1) & mask_) {
+            const auto home = size_type(hash_(slots_[next].value.first)) & mask_;
+            if(((next - home) & mask_) < ((next - hole) & mask_))
+                continue;
+            new(&slots_[hole].value) value_type(std::move(slots_[next].value));
+            tags_[hole] = tags_[next];
+            slots_[next].value.~value_type();
+            tags_[next] = 0;
+            hole = next;
+        }
+    }
+
+    void rehash(size_type cap) {
+        auto slots = std::make_unique<slot_t[]>(cap);
+        auto tags = std::make_unique<uint8_t[]>(cap);
+        const auto old = capacity();
+        std::swap(slots, slots_);
+        std::swap(tags, tags_);
+        mask_ = cap - 1;
+        for(size_type index = 0; index < old; ++index) {
+            if(!tags[index])
+                continue;
+            auto& value = slots[index].value;
+            const auto hash = hash_(value.first);
+            const auto to = vacant(hash);
+            new(&slots_[to].value) value_type(std::move(value));
+            tags_[to] = tag(hash);
+            value.~value_type();
+        }
+    }
+};
+} // end namespace
+#endif
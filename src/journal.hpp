@@ -0,0 +1,199 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_JOURNAL_HPP_
+#define TYCHO_JOURNAL_HPP_
+
+#include "process.hpp"
+
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sys/file.h>
+
+namespace tycho {
+// Append only log of records in a mapped file, with one writer and any
+// number of readers in this or other processes. The whole limit is mapped
+// once, so record views stay valid while the file grows underneath. A
+// record only counts once the committed length in the file header covers
+// it, so a crash mid append leaves the log at its last commit.
+class mapped_log final {
+public:
+    static constexpr std::size_t header_size = 4096;
+    static constexpr std::size_t grow_size = 1024 * 1024;
+    static constexpr uint64_t magic = 0x31474f4c4f484354ULL;   // "TCHOLOG1"
+
+    explicit mapped_log(const std::string& path, bool writer = true, std::size_t limit = std::size_t(1) << 30) :
+    limit_(std::max(limit, header_size + grow_size)), writer_(writer) {
+        fd_ = ::open(path.c_str(), writer ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0640); // FlawFinder: ignore
+        if(fd_ < 0 || (writer && ::flock(fd_, LOCK_EX | LOCK_NB))) {
+            close();
+            return;
+        }
+
+        struct stat ino{};
+        fstat(fd_, &ino);
+        extent_ = std::size_t(ino.st_size);
+        if(writer && extent_ < header_size) {
+            if(::ftruncate(fd_, off_t(header_size + grow_size))) {
+                close();
+                return;
+            }
+            extent_ = header_size + grow_size;
+        }
+
+        map_.set(fd_, limit_, writer, false);
+        if(!map_ || extent_ < header_size) {
+            close();
+            return;
+        }
+
+        auto base = static_cast<uint8_t *>(map_.data());
+        if(writer && !ino.st_size)
+            memcpy(base, &magic, sizeof(magic));
+        else if(memcmp(base, &magic, sizeof(magic)) != 0) {
+            close();
+            return;
+        }
+        base_ = base + header_size;
+        tail_ = committed();
+        if(!writer)
+            map_.advise(process::advice_t::sequential, header_size);
+    }
+
+    mapped_log(const mapped_log&) = delete;
+    auto operator=(const mapped_log&) -> auto& = delete;
+
+    ~mapped_log() {
+        close();
+    }
+
+    explicit operator bool() const noexcept {
+        return base_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return base_ == nullptr;
+    }
+
+    // bytes of record data visible to readers
+    auto committed() const noexcept -> uint64_t {
+        return base_ ? length().load(std::memory_order_acquire) : 0;
+    }
+
+    // space for one record, written in place and then committed, or
+    // nullptr when the limit is reached; only one may be open at a time
+    auto reserve(std::size_t size) -> void * {
+        if(!writer_ || !base_)
+            return nullptr;
+        const auto need = record_size(size);
+        if(tail_ + need > limit_ - header_size)
+            return nullptr;
+        if(header_size + tail_ + need > extent_) {
+            auto extent = std::min(std::max(extent_ * 2, header_size + tail_ + need + grow_size), limit_);
+            if(::ftruncate(fd_, off_t(extent)))
+                return nullptr;
+            extent_ = extent;
+        }
+        reserved_ = size;
+        return base_ + tail_ + sizeof(uint64_t);
+    }
+
+    // size may be less than reserved, publishing the record to readers
+    auto commit(std::size_t size) noexcept {
+        if(!writer_ || !base_ || size > reserved_)
+            return false;
+        const uint64_t prefix = size;
+        memcpy(base_ + tail_, &prefix, sizeof(prefix));
+        tail_ += record_size(size);
+        reserved_ = 0;
+        length().store(tail_, std::memory_order_release);
+        return true;
+    }
+
+    auto append(const void *data, std::size_t size) {
+        auto to = reserve(size);
+        if(!to)
+            return false;
+        memcpy(to, data, size);
+        return commit(size);
+    }
+
+    auto append(std::string_view text) {
+        return append(text.data(), text.size());
+    }
+
+    // records from an offset, until proc returns false, giving the offset
+    // to resume from once more is committed. The map spans the whole limit
+    // while the file may be shorter, so only the committed range backed by
+    // the file is touched, and a record running past it stops the scan.
+    template<typename Func>
+    auto scan(Func proc, uint64_t from = 0) const -> uint64_t {
+        const auto end = readable();
+        while(from < end && end - from >= sizeof(uint64_t)) {
+            uint64_t size{0};
+            memcpy(&size, base_ + from, sizeof(size));
+            if(size > end - from - sizeof(size) || record_size(std::size_t(size)) > end - from)
+                break;
+            if(!proc(std::string_view(reinterpret_cast<const char *>(base_ + from + sizeof(size)), std::size_t(size))))
+                break;
+            from += record_size(std::size_t(size));
+        }
+        return from;
+    }
+
+    // make what is committed durable, data before the header that covers it
+    auto sync(bool wait = true) noexcept {
+        if(!writer_ || !base_)
+            return false;
+        return map_.sync(header_size, std::size_t(tail_), wait) && map_.sync(0, header_size, wait);
+    }
+
+    auto limit() const noexcept {
+        return limit_;
+    }
+
+private:
+    process::map_t map_;
+    std::size_t limit_;
+    std::size_t extent_{0};
+    std::size_t reserved_{0};
+    uint64_t tail_{0};
+    uint8_t *base_{nullptr};
+    int fd_{-1};
+    bool writer_;
+
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free, "Committed length must be a lock-free word");
+
+    // records are a length prefix and data, padded to eight bytes
+    static constexpr auto record_size(std::size_t size) noexcept -> uint64_t {
+        return sizeof(uint64_t) + ((size + 7) & ~std::size_t(7));
+    }
+
+    // committed bytes also within the file, so a bad header cannot fault
+    auto readable() const noexcept -> uint64_t {
+        struct stat ino{};
+        const auto end = std::min(committed(), uint64_t(limit_ - header_size));
+        if(!base_ || fstat(fd_, &ino) || uint64_t(ino.st_size) < header_size)
+            return 0;
+        return std::min(end, uint64_t(ino.st_size) - header_size);
+    }
+
+    auto length() const noexcept -> std::atomic<uint64_t>& {
+        return *reinterpret_cast<std::atomic<uint64_t> *>(static_cast<uint8_t *>(map_.data()) + sizeof(uint64_t));
+    }
+
+    void close() noexcept {
+        base_ = nullptr;
+        if(fd_ > -1)
+            ::close(fd_);
+        fd_ = -1;
+    }
+};
+} // end namespace
+#endif
+#endif
@@ -4,11 +4,18 @@
 #ifndef TYCHO_KEYFILE_HPP_
 #define TYCHO_KEYFILE_HPP_
 
+#include "sync.hpp"
+
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <cstdint>
 
 namespace tycho {
 class keyfile {
@@ -65,6 +72,10 @@ public:
         return *this;
     }
 
+    auto try_load(const std::string& path) -> bool {
+        return ptr_ && ptr_->load(path);
+    }
+
     auto load(const std::string& id, const std::initializer_list<std::pair<std::string,std::string>>& list) -> auto& {
         auto& group = ptr_->fetch(id);
         for(const auto& [key, value] : list)
@@ -220,6 +231,224 @@ private:
     std::shared_ptr<data> ptr_;
 };
 
+// Immutable compiled form of a keyfile. All names and values share one
+// arena, sections and the keys within each are sorted, and lookups take
+// string_view without allocating. Records hold arena offsets so copies
+// stay valid.
+class keyfile_snapshot final {
+public:
+    class section_t final {
+    public:
+        section_t() noexcept = default;
+
+        explicit operator bool() const noexcept {
+            return owner_ != nullptr;
+        }
+
+        auto operator!() const noexcept {
+            return owner_ == nullptr;
+        }
+
+        auto size() const noexcept {
+            return std::size_t(count_);
+        }
+
+        auto empty() const noexcept {
+            return count_ == 0;
+        }
+
+        auto name() const noexcept {
+            return owner_ ? owner_->view(owner_->sections_[index_].name) : std::string_view();
+        }
+
+        auto key(std::size_t pos) const noexcept {
+            return owner_->view(owner_->entries_[first_ + pos].key);
+        }
+
+        auto value(std::size_t pos) const noexcept {
+            return owner_->view(owner_->entries_[first_ + pos].value);
+        }
+
+        auto contains(std::string_view key) const noexcept {
+            return find(key) != npos;
+        }
+
+        auto get(std::string_view key, std::string_view or_else = {}) const noexcept {
+            const auto pos = find(key);
+            return pos == npos ? or_else : value(pos);
+        }
+
+    private:
+        friend class keyfile_snapshot;
+
+        static constexpr auto npos = std::size_t(-1);
+
+        const keyfile_snapshot *owner_{nullptr};
+        uint32_t index_{0}, first_{0}, count_{0};
+
+        section_t(const keyfile_snapshot *owner, uint32_t index) noexcept :
+        owner_(owner), index_(index), first_(owner->sections_[index].first), count_(owner->sections_[index].count) {}
+
+        auto find(std::string_view key) const noexcept -> std::size_t {
+            if(!owner_)
+                return npos;
+            const auto begin = owner_->entries_.begin() + first_;
+            const auto end = begin + count_;
+            auto it = std::lower_bound(begin, end, key, [this](const entry_t& entry, std::string_view id) {
+                return owner_->view(entry.key) < id;
+            });
+            if(it == end || owner_->view(it->key) != key)
+                return npos;
+            return std::size_t(it - begin);
+        }
+    };
+
+    keyfile_snapshot() = default;
+
+    explicit keyfile_snapshot(const keyfile& keys) {
+        if(keys.empty())
+            return;
+
+        std::vector<std::pair<std::string_view, const keyfile::keys *>> groups;
+        std::size_t arena = 0, total = 0;
+        for(const auto& [id, group] : keys) {
+            groups.emplace_back(id, &group);
+            arena += id.size();
+            total += group.size();
+            for(const auto& [key, value] : group)
+                arena += key.size() + value.size();
+        }
+        std::sort(groups.begin(), groups.end());
+        arena_.reserve(arena);
+        sections_.reserve(groups.size());
+        entries_.reserve(total);
+
+        std::vector<std::pair<std::string_view, std::string_view>> items;
+        for(const auto& [id, group] : groups) {
+            sections_.push_back(section_rec{store(id), uint32_t(entries_.size()), uint32_t(group->size())});
+            items.assign(group->begin(), group->end());
+            std::sort(items.begin(), items.end());
+            for(const auto& [key, value] : items)
+                entries_.push_back(entry_t{store(key), store(value)});
+        }
+    }
+
+    explicit keyfile_snapshot(const std::initializer_list<std::string>& paths) :
+    keyfile_snapshot(keyfile(paths)) {}
+
+    auto size() const noexcept {
+        return sections_.size();
+    }
+
+    auto empty() const noexcept {
+        return sections_.empty();
+    }
+
+    auto bytes() const noexcept {
+        return arena_.size();
+    }
+
+    auto contains(std::string_view id) const noexcept {
+        return !!section(id);
+    }
+
+    auto section(std::string_view id) const noexcept -> section_t {
+        auto it = std::lower_bound(sections_.begin(), sections_.end(), id, [this](const section_rec& rec, std::string_view name) {
+            return view(rec.name) < name;
+        });
+        if(it == sections_.end() || view(it->name) != id)
+            return {};
+        return {this, uint32_t(it - sections_.begin())};
+    }
+
+    auto operator[](std::string_view id) const noexcept {
+        return section(id);
+    }
+
+    auto get(std::string_view id, std::string_view key, std::string_view or_else = {}) const noexcept {
+        return section(id).get(key, or_else);
+    }
+
+    auto at(std::size_t pos) const noexcept -> section_t {
+        return {this, uint32_t(pos)};
+    }
+
+private:
+    struct span_t final {
+        uint32_t offset{0}, size{0};
+    };
+
+    struct section_rec final {
+        span_t name;
+        uint32_t first{0}, count{0};
+    };
+
+    struct entry_t final {
+        span_t key, value;
+    };
+
+    std::vector<char> arena_;
+    std::vector<section_rec> sections_;
+    std::vector<entry_t> entries_;
+
+    auto view(span_t span) const noexcept -> std::string_view {
+        return std::string_view(arena_.data() + span.offset, span.size);
+    }
+
+    auto store(std::string_view text) -> span_t {
+        const span_t span{uint32_t(arena_.size()), uint32_t(text.size())};
+        arena_.insert(arena_.end(), text.begin(), text.end());
+        return span;
+    }
+};
+
+// Hot reloaded configuration. Readers take the current snapshot through
+// rcu without locking, and a reload publishes a new one once every path
+// has been read, leaving the old one in place if any could not be.
+class keyfile_config final {
+public:
+    using snapshot_t = rcu_ptr<keyfile_snapshot>;
+
+    keyfile_config() = default;
+
+    explicit keyfile_config(std::vector<std::string> paths) :
+    paths_(std::move(paths)) {
+        reload();
+    }
+
+    keyfile_config(const keyfile_config&) = delete;
+    auto operator=(const keyfile_config&) -> auto& = delete;
+
+    auto reload() -> bool {
+        keyfile keys;
+        for(const auto& path : paths_) {
+            if(!keys.try_load(path))
+                return false;
+        }
+        current_.store(keyfile_snapshot(keys));
+        ++generation_;
+        return true;
+    }
+
+    auto reload(std::vector<std::string> paths) -> bool {
+        paths_ = std::move(paths);
+        return reload();
+    }
+
+    auto get() const {
+        return snapshot_t(current_);
+    }
+
+    auto generation() const noexcept {
+        return generation_.load();
+    }
+
+private:
+    std::vector<std::string> paths_;
+    rcu_sync<keyfile_snapshot> current_;
+    std::atomic<unsigned> generation_{0};
+};
+
 inline auto key_or(const keyfile::keys& keys, const std::string& id, const std::string& or_else = "") {
     try {
         return keys.at(id);
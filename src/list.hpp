@@ -5,21 +5,26 @@
 #define TYCHO_LIST_HPP_
 
 #include <list>
+#include <memory>
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 namespace tycho {
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>>
 class slist {
 public:
     using reference = T&;
     using const_reference = const T&;
     using size_type = std::size_t;
+    using allocator_type = Alloc;
 
     struct node_t final {
         T data;
         node_t* next{nullptr};
-        explicit node_t(const T& value) : data(value), next(nullptr) {}
+
+        template <typename... Args>
+        explicit node_t(std::in_place_t, Args&&... args) : data(std::forward<Args>(args)...) {}
     };
 
     class iterator {
@@ -67,15 +72,53 @@ public:
     };
 
     slist() = default;
-    slist(const std::initializer_list<T>& list) {
+    explicit slist(const Alloc& alloc) : alloc_(alloc) {}
+
+    slist(const std::initializer_list<T>& list, const Alloc& alloc = Alloc()) : alloc_(alloc) {
         for(const auto& item : list)
             push_back(item);
     }
 
+    slist(const slist& other) : alloc_(node_traits::select_on_container_copy_construction(other.alloc_)) {
+        for(const auto& item : other)
+            push_back(item);
+    }
+
+    slist(slist&& other) noexcept :
+    alloc_(std::move(other.alloc_)), head_(other.head_), tail_(other.tail_), size_(other.size_) {
+        other.head_ = other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
     ~slist() {
         clear();
     }
 
+    auto operator=(const slist& other) -> auto& {
+        if(this != &other) {
+            clear();
+            for(const auto& item : other)
+                push_back(item);
+        }
+        return *this;
+    }
+
+    // steals the nodes unless allocators differ and stay with the list
+    auto operator=(slist&& other) noexcept(node_traits::propagate_on_container_move_assignment::value || node_traits::is_always_equal::value) -> auto& {
+        if(this != &other) {
+            clear();
+            if constexpr(node_traits::propagate_on_container_move_assignment::value) {
+                alloc_ = std::move(other.alloc_);
+                head_ = std::exchange(other.head_, nullptr);
+                tail_ = std::exchange(other.tail_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+            }
+            else
+                splice(other);
+        }
+        return *this;
+    }
+
     operator bool() {
         return !empty();
     }
@@ -85,23 +128,11 @@ public:
     }
 
     void push_front(const T& value) {
-        auto node = new node_t(value);
-        node->next = head_;
-        head_ = node;
-        ++size_;
-        if(!tail_)
-            tail_ = head_;
+        link_front(make(value));
     }
 
     void push_back(const T& value) {
-        if(head_ == nullptr)
-            push_front(value);
-        else {
-            auto node = new node_t(value);
-            tail_->next = node;
-            tail_ = node;
-            ++size_;
-        }
+        link_back(make(value));
     }
 
     auto push(const T& value) {
@@ -124,9 +155,9 @@ public:
         if(head_ == nullptr)
             throw std::runtime_error("List is empty");
 
-        auto copy = head_->data;
+        auto copy = std::move(head_->data);
         auto next = head_->next;
-        delete head_;
+        drop(head_);
         head_ = next;
         --size_;
         if(!head_)
@@ -150,19 +181,44 @@ public:
         return size_;
     }
 
+    auto get_allocator() const {
+        return Alloc(alloc_);
+    }
+
     void clear() {
         node_t* current = head_;
         node_t* next = nullptr;
 
         while(current != nullptr) {
             next = current->next;
-            delete current;
+            drop(current);
             current = next;
         }
         head_ = tail_ = nullptr;
         size_ = 0;
     }
 
+    // move all of other to our tail, O(1) when allocators are equal
+    void splice(slist& other) {
+        if(&other == this || other.empty())
+            return;
+
+        if(!(alloc_ == other.alloc_)) {
+            while(!other.empty())
+                emplace_back(other.pop());
+            return;
+        }
+
+        if(tail_)
+            tail_->next = other.head_;
+        else
+            head_ = other.head_;
+        tail_ = other.tail_;
+        size_ += other.size_;
+        other.head_ = other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
     auto begin() {
         return iterator(head_);
     }
@@ -185,24 +241,12 @@ public:
 
     template <typename... Args>
     void emplace_front(Args&&... args) {
-        auto node = new node_t(T(std::forward<Args>(args)...));
-        node->next = head_;
-        head_ = node;
-        if(!tail_)
-            tail_ = node;
-        ++size_;
+        link_front(make(std::forward<Args>(args)...));
     }
 
     template <typename... Args>
     void emplace_back(Args&&... args) {
-        auto node = new node_t(T(std::forward<Args>(args)...));
-        if(tail_) {
-            tail_->next = node;
-            tail_ = node;
-        }
-        else
-            head_ = tail_ = node;
-        ++size_;
+        link_back(make(std::forward<Args>(args)...));
     }
 
     template <typename Func>
@@ -213,14 +257,235 @@ public:
 
     template <typename Predicate>
     auto filter_if(Predicate pred) const {
-        slist<T> result;
+        slist result(alloc_);
         std::copy_if(this->begin(), this->end(), std::front_inserter(result), pred);
         return result;
     }
 
 private:
+    using node_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<node_t>;
+    using node_traits = std::allocator_traits<node_alloc>;
+
+    node_alloc alloc_{};
     node_t *head_{nullptr}, *tail_{nullptr};
     size_type size_{0};
+
+    template <typename... Args>
+    auto make(Args&&... args) -> node_t * {
+        auto node = node_traits::allocate(alloc_, 1);
+        try {
+            node_traits::construct(alloc_, node, std::in_place, std::forward<Args>(args)...);
+        }
+        catch(...) {
+            node_traits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void drop(node_t *node) {
+        node_traits::destroy(alloc_, node);
+        node_traits::deallocate(alloc_, node, 1);
+    }
+
+    void link_front(node_t *node) noexcept {
+        node->next = head_;
+        head_ = node;
+        if(!tail_)
+            tail_ = node;
+        ++size_;
+    }
+
+    void link_back(node_t *node) noexcept {
+        if(tail_)
+            tail_->next = node;
+        else
+            head_ = node;
+        tail_ = node;
+        ++size_;
+    }
+};
+
+// Link embedded in a user object so it can sit on an intrusive_slist
+template <typename T>
+struct slist_hook {
+    T *next{nullptr};
+};
+
+// List of objects it does not own, linking through a member hook so no
+// node is ever allocated. An object is on at most one list per hook.
+template <typename T, slist_hook<T> T::*Hook = &T::hook>
+class intrusive_slist {
+public:
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+
+    class iterator {
+    public:
+        explicit iterator(T *node) : current_(node) {}
+
+        auto operator*() const -> auto& {
+            return *current_;
+        }
+
+        auto operator->() const {
+            return current_;
+        }
+
+        auto operator++() -> auto& {
+            if(current_)
+                current_ = (current_->*Hook).next;
+            return *this;
+        }
+
+        auto operator!=(const iterator& other) const {
+            return current_ != other.current_;
+        }
+
+    private:
+        T *current_{nullptr};
+    };
+
+    intrusive_slist() = default;
+    intrusive_slist(const intrusive_slist&) = delete;
+    auto operator=(const intrusive_slist&) -> auto& = delete;
+
+    intrusive_slist(intrusive_slist&& other) noexcept {
+        splice(other);
+    }
+
+    auto operator=(intrusive_slist&& other) noexcept -> auto& {
+        if(this != &other) {
+            clear();
+            splice(other);
+        }
+        return *this;
+    }
+
+    ~intrusive_slist() {
+        clear();
+    }
+
+    operator bool() const {
+        return !empty();
+    }
+
+    auto operator!() const {
+        return empty();
+    }
+
+    void push_front(T& obj) noexcept {
+        (obj.*Hook).next = head_;
+        head_ = &obj;
+        if(!tail_)
+            tail_ = head_;
+        ++size_;
+    }
+
+    void push_back(T& obj) noexcept {
+        (obj.*Hook).next = nullptr;
+        if(tail_)
+            (tail_->*Hook).next = &obj;
+        else
+            head_ = &obj;
+        tail_ = &obj;
+        ++size_;
+    }
+
+    auto push(T& obj) noexcept {
+        push_front(obj);
+    }
+
+    auto front() -> T& {
+        if(head_ != nullptr)
+            return *head_;
+        throw std::runtime_error("List is empty");
+    }
+
+    auto back() -> T& {
+        if(tail_ != nullptr)
+            return *tail_;
+        throw std::runtime_error("List is empty");
+    }
+
+    // unlinks and returns the head, nullptr if empty
+    auto pop() noexcept -> T * {
+        auto obj = head_;
+        if(!obj)
+            return nullptr;
+        head_ = (obj->*Hook).next;
+        (obj->*Hook).next = nullptr;
+        --size_;
+        if(!head_)
+            tail_ = nullptr;
+        return obj;
+    }
+
+    // unlink one object, O(n) since the list is singly linked
+    auto remove(T& obj) noexcept {
+        T *prior{nullptr};
+        for(auto current = head_; current; current = (current->*Hook).next) {
+            if(current != &obj) {
+                prior = current;
+                continue;
+            }
+            if(prior)
+                (prior->*Hook).next = (obj.*Hook).next;
+            else
+                head_ = (obj.*Hook).next;
+            if(tail_ == &obj)
+                tail_ = prior;
+            (obj.*Hook).next = nullptr;
+            --size_;
+            return true;
+        }
+        return false;
+    }
+
+    void splice(intrusive_slist& other) noexcept {
+        if(&other == this || other.empty())
+            return;
+        if(tail_)
+            (tail_->*Hook).next = other.head_;
+        else
+            head_ = other.head_;
+        tail_ = other.tail_;
+        size_ += other.size_;
+        other.head_ = other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
+    auto empty() const noexcept {
+        return head_ == nullptr;
+    }
+
+    auto size() const noexcept {
+        return size_;
+    }
+
+    // unlinks everything, objects themselves are left alone
+    void clear() noexcept {
+        while(pop()) {}
+    }
+
+    auto begin() const {
+        return iterator(head_);
+    }
+
+    auto end() const {
+        return iterator(nullptr);
+    }
+
+    template <typename Func>
+    void each(Func func) {
+        for(auto& element : *this)
+            func(element);
+    }
+
+private:
+    T *head_{nullptr}, *tail_{nullptr};
+    size_type size_{0};
 };
 } // end namespace
 #endif
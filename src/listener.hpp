@@ -0,0 +1,153 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_LISTENER_HPP_
+#define TYCHO_LISTENER_HPP_
+
+#include "socket.hpp"
+
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <system_error>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace tycho {
+struct listener_options {
+    int backlog{SOMAXCONN};
+    bool nodelay{true};
+    int defer_accept{0};        // seconds, 0 to disable
+    int fastopen{0};            // pending syn queue, 0 to disable
+    int busy_poll{0};           // usecs, 0 to disable
+    bool affinity{false};       // pin shard threads and steer by cpu
+};
+
+// Sharded tcp listener with one acceptor thread per shard. Where the
+// platform has SO_REUSEPORT each shard has its own listening socket so
+// the kernel spreads new connections; otherwise shards share one socket.
+class listener final {
+public:
+    using acceptor_t = std::function<bool(int, const struct sockaddr *)>;
+
+    using options_t = listener_options;
+
+    explicit listener(const address_t& addr, std::size_t shards = 0, const options_t& options = options_t{}) :
+    options_(options), shards_(shards ? shards : std::max(1U, std::thread::hardware_concurrency())) {
+#if defined(SO_REUSEPORT)
+        const auto count = shards_;
+#else
+        const std::size_t count = 1;
+#endif
+        for(std::size_t shard = 0; shard < count; ++shard) {
+            Socket so(addr, SOCK_STREAM);
+            if(!so)
+                throw std::system_error(so.err(), std::generic_category(), "Listener cannot bind socket");
+            configure(so, shard);
+            if(count < shards_)
+                so.blocking(false);     // shared, so a lost race is not a stall
+            so.listen(options_.backlog);
+            if(!so)
+                throw std::system_error(so.err(), std::generic_category(), "Listener cannot listen");
+            sockets_.push_back(std::move(so));
+        }
+    }
+
+    listener(const listener&) = delete;
+    auto operator=(const listener&) -> auto& = delete;
+
+    ~listener() {
+        stop();
+    }
+
+    // acceptor runs on shard threads and owns the accepted descriptor,
+    // returning false to have it closed
+    void start(acceptor_t acceptor) {
+        if(running_.exchange(true))
+            return;
+        acceptor_ = std::move(acceptor);
+        for(std::size_t shard = 0; shard < shards_; ++shard)
+            threads_.emplace_back(&listener::serve, this, shard);
+    }
+
+    void stop() {
+        running_ = false;
+        for(auto& thread : threads_) {
+            if(thread.joinable())
+                thread.join();
+        }
+        threads_.clear();
+    }
+
+    auto size() const noexcept {
+        return sockets_.size();
+    }
+
+    auto shards() const noexcept {
+        return shards_;
+    }
+
+    auto operator[](std::size_t index) const -> const Socket& {
+        return sockets_.at(index);
+    }
+
+    auto accepted() const noexcept {
+        return accepted_.load();
+    }
+
+    auto running() const noexcept {
+        return running_.load();
+    }
+
+private:
+    options_t options_;
+    std::size_t shards_;
+    std::vector<Socket> sockets_;
+    std::vector<std::thread> threads_;
+    acceptor_t acceptor_;
+    std::atomic<bool> running_{false};
+    std::atomic<std::size_t> accepted_{0};
+
+    // options are set before listen, being best effort where unsupported
+    void configure(Socket& so, std::size_t shard) noexcept {
+        if(options_.nodelay)
+            so.nodelay(true);
+        if(options_.defer_accept)
+            so.defer_accept(options_.defer_accept);
+        if(options_.fastopen)
+            so.fastopen(options_.fastopen);
+        if(options_.busy_poll)
+            so.busy_poll(options_.busy_poll);
+        if(options_.affinity)
+            so.incoming_cpu(int(shard % cpus()));
+    }
+
+    static auto cpus() noexcept -> std::size_t {
+        return std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // bounded waits so stop is seen without closing the sockets
+    void serve(std::size_t shard) {
+#if defined(__linux__)
+        if(options_.affinity) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(shard % cpus(), &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+#endif
+        const auto& so = sockets_[shard % sockets_.size()];
+        while(running_) {
+            if(!(so.wait(POLLIN, 100) & POLLIN))
+                continue;
+            if(so.accept(acceptor_))
+                ++accepted_;
+        }
+    }
+};
+} // end namespace
+#endif
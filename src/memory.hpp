@@ -9,19 +9,37 @@
 #include <type_traits>
 #include <stdexcept>
 #include <memory>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <new>
 #include <iostream>
 #include <string_view>
 #include <utility>
+#include <vector>
+#include <algorithm>
 #include <cstring>
 #include <cstdint>
 #include <cstddef>
 #include <cstdlib>
 #include <climits>
 
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
 #if __has_include(<unistd.h>)
 #include <unistd.h>
 #endif
 
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#endif
+
+#if defined(__linux__) && __has_include(<sys/syscall.h>)
+#include <sys/syscall.h>
+#endif
+
 namespace tycho {
 namespace crypto {
 using key_t = std::pair<const uint8_t *, std::size_t>;
@@ -38,41 +56,43 @@ public:
     using element_type = T;
 
     shared_array() = default;
-    shared_array(const shared_array& other) = default;
+
+    shared_array(const shared_array& other) noexcept :
+    block_(other.block_), array_(other.array_), size_(other.size_) {
+        if(block_)
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
 
     explicit shared_array(size_type size) :
-    array_(std::make_shared<T>(size)), size_(size) {}
+    block_(create(size)), array_(payload(block_)), size_(size) {}
 
     shared_array(size_type size, const T& init) :
-    array_(std::make_shared<T>(size)), size_(size) {
+    block_(create(size)), array_(payload(block_)), size_(size) {
         auto pos = size_type(0);
-        auto ptr = get();
         while(pos < size)
-            ptr[pos++] = init;
+            array_[pos++] = init;
     }
 
     template<typename U = T, std::enable_if_t<sizeof(U) == 1, int> = 0>
     explicit shared_array(const crypto::key_t& key) :
-    array_(key.second ? std::make_shared<T>(uint32_t(key.second / sizeof(T))) : nullptr), size_(key.second / sizeof(T)) {
-        if(size_)
-            memcpy(array_.get(), key.first, key.second); // FlawFinder: ignore
-    }
+    shared_array(reinterpret_cast<const T *>(key.first), size_type(key.second / sizeof(T))) {}
 
     shared_array(const T* from, size_type size) :
-    array_(size ? std::make_shared<T>(size) : nullptr), size_(size) {
+    block_(create(size)), array_(payload(block_)), size_(size) {
         if(size)
-            memcpy(array_.get(), from, sizeof(T) * size);   // FlawFinder: ignore
+            memcpy(array_, from, sizeof(T) * size);   // FlawFinder: ignore
     }
 
     shared_array(shared_array&& other) noexcept :
-    array_(std::move(other.array_)), size_(other.size_) {
+    block_(other.block_), array_(other.array_), size_(other.size_) {
+        other.block_ = nullptr;
+        other.array_ = nullptr;
         other.size_ = 0;
     }
 
     // finalize shared data
     ~shared_array() {
-        if(!empty() && count() == 1)
-            zero();
+        release();
     }
 
     operator crypto::key_t() const noexcept {
@@ -91,10 +111,26 @@ public:
         return size_ == 0;
     }
 
+    auto operator=(const shared_array& other) noexcept -> auto& {
+        if(this != &other) {
+            if(other.block_)
+                other.block_->refs.fetch_add(1, std::memory_order_relaxed);
+            release();
+            block_ = other.block_;
+            array_ = other.array_;
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
     auto operator=(shared_array&& other) noexcept -> auto& {
         if(this != &other) {
-            array_ = std::move(other.array_);
+            release();
+            block_ = other.block_;
+            array_ = other.array_;
             size_ = other.size_;
+            other.block_ = nullptr;
+            other.array_ = nullptr;
             other.size_ = 0;
         }
         return *this;
@@ -103,7 +139,7 @@ public:
     auto operator[](size_type index) -> T& {
         if(index >= size_)
             throw std::out_of_range("Index is out of range");
-        return array_.get()[index];
+        return array_[index];
     }
 
     auto operator[](size_type index) const -> const T& {
@@ -113,11 +149,11 @@ public:
     }
 
     auto operator *() noexcept -> uint8_t * {
-        return reinterpret_cast<uint8_t>(array_.get());
+        return reinterpret_cast<uint8_t *>(array_);
     }
 
     auto operator *() const noexcept -> const uint8_t * {
-        return reinterpret_cast<uint8_t>(array_.get());
+        return reinterpret_cast<const uint8_t *>(array_);
     }
 
     auto operator()() {
@@ -135,17 +171,17 @@ public:
     auto get() -> T* {
         if(!size_)
             throw std::out_of_range("Cannot return empty object");
-        return array_.get();
+        return array_;
     }
 
     auto get() const -> const T* {
         if(!size_)
             throw std::out_of_range("Cannot return empty object");
-        return array_.get();
+        return array_;
     }
 
     auto key() const -> crypto::key_t {
-        return std::make_pair(reinterpret_cast<uint8_t*>(array_.get()), size_bytes());
+        return std::make_pair(reinterpret_cast<const uint8_t*>(array_), size_bytes());
     }
 
     auto empty() const noexcept {
@@ -161,28 +197,28 @@ public:
     }
 
     auto view() const {
-        return size_ ? std::string_view(reinterpret_cast<const char *>(&array_[0]), size_ * sizeof(T)) : std::string_view();
+        return size_ ? std::string_view(reinterpret_cast<const char *>(array_), size_ * sizeof(T)) : std::string_view();
     }
 
-    auto count() const {
-        return array_.use_count();
+    auto count() const noexcept -> std::size_t {
+        return block_ ? block_->refs.load(std::memory_order_relaxed) : 0;
     }
 
     auto hash() const {
-        return std::hash(array_);
+        return std::hash<const T *>{}(array_);
     }
 
     auto zero() noexcept {
         if(size_)
-            memset(array_.get(), 0, sizeof(T) * size_);
+            memset(array_, 0, sizeof(T) * size_);
     }
 
     auto to_hex() const {
-        return to_hex(get(), size_bytes());
+        return tycho::to_hex(reinterpret_cast<const uint8_t *>(get()), size_bytes());
     }
 
     auto to_b64() const {
-        return to_b64(get(), size_bytes());
+        return tycho::to_b64(reinterpret_cast<const uint8_t *>(get()), size_bytes());
     }
 
     auto begin() const {
@@ -205,6 +241,16 @@ public:
         return std::find(begin(), end(), value) != end();
     }
 
+    // view into the same buffer, shares ownership and copies nothing
+    auto slice(size_type pos, size_type count = 0) const {
+        if(pos > size_ || count > size_ - pos)
+            throw std::out_of_range("Invalid slice range");
+        shared_array result(*this);
+        result.array_ += pos;
+        result.size_ = count ? count : size_ - pos;
+        return result;
+    }
+
     auto subarray(size_type pos, size_t count = 0) const {
         if(pos + count > size_)
             throw std::out_of_range("Invalid subarray range");
@@ -239,10 +285,43 @@ public:
 private:
     static_assert(std::is_trivial_v<T>, "T must be Trivial type");
 
-    std::shared_ptr<T> array_;
+    // count and payload share one cache aligned allocation
+    struct alignas(64) block_t final {
+        std::atomic<std::size_t> refs{1};
+        size_type size{0};
+    };
+
+    block_t *block_{nullptr};
+    T *array_{nullptr};
     size_type size_{0};
+
+    static auto create(size_type size) -> block_t * {
+        if(!size)
+            return nullptr;
+        auto mem = ::operator new(sizeof(block_t) + sizeof(T) * size, std::align_val_t(alignof(block_t)));
+        auto block = new(mem) block_t;
+        block->size = size;
+        return block;
+    }
+
+    static auto payload(block_t *block) noexcept -> T * {
+        return block ? reinterpret_cast<T *>(block + 1) : nullptr;
+    }
+
+    void release() noexcept {
+        if(block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            memset(payload(block_), 0, sizeof(T) * block_->size);
+            block_->~block_t();
+            ::operator delete(block_, std::align_val_t(alignof(block_t)));
+        }
+        block_ = nullptr;
+        array_ = nullptr;
+        size_ = 0;
+    }
 };
 
+class mempager;
+
 class imemstream : protected std::streambuf, public std::istream {
 public:
     imemstream() = delete;
@@ -250,10 +329,10 @@ public:
     auto operator=(const imemstream&) -> auto& = delete;
 
     imemstream(const uint8_t *data, std::size_t size) :
-    std::istream(static_cast<std::streambuf *>(this)), pos(data), count(size) {}
+    std::istream(static_cast<std::streambuf *>(this)), pos(data), count(size), start(data), total(size) {}
 
     explicit imemstream(const char *cp) :
-    std::istream(static_cast<std::streambuf *>(this)), pos(reinterpret_cast<const uint8_t *>(cp)), count(::strlen(cp)) {} // FlawFinder: ignore
+    imemstream(reinterpret_cast<const uint8_t *>(cp), ::strlen(cp)) {} // FlawFinder: ignore
 
     auto size() const noexcept {
         return count;
@@ -268,8 +347,13 @@ public:
     }
 
 protected:
+    using off_type = std::streambuf::off_type;
+    using pos_type = std::streambuf::pos_type;
+
     const uint8_t *pos{nullptr};
     std::size_t count{0};
+    const uint8_t *start{nullptr};
+    std::size_t total{0};
 
     auto underflow() -> int override {
         if(!count || !pos)
@@ -283,22 +367,64 @@ protected:
         --count;
         return *(pos++);
     }
+
+    auto xsgetn(char *data, std::streamsize size) -> std::streamsize override {
+        if(size <= 0 || !pos)
+            return 0;
+        const auto len = std::min(std::size_t(size), count);
+        memcpy(data, pos, len); // FlawFinder: ignore
+        pos += len;
+        count -= len;
+        return std::streamsize(len);
+    }
+
+    auto showmanyc() -> std::streamsize override {
+        return count ? std::streamsize(count) : -1;
+    }
+
+    auto seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) -> pos_type override {
+        if(!(which & std::ios_base::in) || !start)
+            return pos_type(off_type(-1));
+        off_type from = 0;
+        if(dir == std::ios_base::cur)
+            from = off_type(total - count);
+        else if(dir == std::ios_base::end)
+            from = off_type(total);
+        from += off;
+        if(from < 0 || std::size_t(from) > total)
+            return pos_type(off_type(-1));
+        pos = start + from;
+        count = total - std::size_t(from);
+        return pos_type(from);
+    }
+
+    auto seekpos(pos_type at, std::ios_base::openmode which) -> pos_type override {
+        return seekoff(off_type(at), std::ios_base::beg, which);
+    }
 };
 
+// Fixed buffer writer, or one that grows into a pager or vector. Seeking
+// back moves the write position and so truncates what follows it.
 class omemstream : protected std::streambuf, public std::ostream {
 public:
     omemstream() = delete;
     omemstream(const omemstream&) = delete;
     auto operator=(const omemstream&) -> auto& = delete;
 
+    // with flag the buffer is kept nul terminated, so one byte is reserved
     omemstream(uint8_t *data, std::size_t size, bool flag = false) :
     std::ostream(static_cast<std::streambuf *>(this)), base(data), limit(size), zero(flag) {
         if(flag && size) {
             *base = 0;
-            ++count;
+            --limit;
         }
     }
 
+    explicit omemstream(std::vector<uint8_t>& vector) :
+    std::ostream(static_cast<std::streambuf *>(this)), base(vector.data()), count(vector.size()), limit(vector.capacity()), vector_(&vector) {}
+
+    explicit omemstream(mempager& pager, std::size_t size = 256, bool flag = false);
+
     auto size() const noexcept {
         return count;
     }
@@ -312,23 +438,90 @@ public:
     }
 
 protected:
+    using off_type = std::streambuf::off_type;
+    using pos_type = std::streambuf::pos_type;
+
     uint8_t *base{nullptr};
     std::size_t count{0}, limit{0};
     bool zero{false};
 
     auto overflow(int ch) -> int override {
-        if(ch == EOF || count >= limit || !base)
+        if(ch == EOF)
             return EOF;
+        const auto byte = uint8_t(ch);
+        return put(&byte, 1) ? ch : EOF;
+    }
+
+    auto xsputn(const char *data, std::streamsize size) -> std::streamsize override {
+        if(size <= 0)
+            return 0;
+        return std::streamsize(put(reinterpret_cast<const uint8_t *>(data), std::size_t(size)));
+    }
+
+    auto seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) -> pos_type override {
+        if(!(which & std::ios_base::out))
+            return pos_type(off_type(-1));
+        if(dir != std::ios_base::beg)
+            off += off_type(count);
+        if(off < 0 || std::size_t(off) > count)
+            return pos_type(off_type(-1));
+        count = std::size_t(off);
+        if(vector_)
+            vector_->resize(count);
+        else if(zero && base)
+            base[count] = 0;
+        return pos_type(off);
+    }
+
+    auto seekpos(pos_type at, std::ios_base::openmode which) -> pos_type override {
+        return seekoff(off_type(at), std::ios_base::beg, which);
+    }
+
+private:
+    std::vector<uint8_t> *vector_{nullptr};
+    mempager *pager_{nullptr};
+
+    auto put(const uint8_t *data, std::size_t size) -> std::size_t {
+        if(vector_) {
+            vector_->insert(vector_->end(), data, data + size);
+            base = vector_->data();
+            count = vector_->size();
+            limit = vector_->capacity();
+            return size;
+        }
 
-        base[count++] = uint8_t(ch);
+        if(count + size > limit && pager_)
+            grow(count + size);
+        if(!base)
+            return 0;
+        size = std::min(size, limit - count);
+        memcpy(base + count, data, size); // FlawFinder: ignore
+        count += size;
         if(zero)
             base[count] = 0;
-        return ch;
+        return size;
     }
+
+    inline void grow(std::size_t need);
 };
 
 class mempager {
 public:
+    // checkpoint of pager state that can later be rewound to
+    struct mark_t final {
+        const void *page{nullptr};
+        unsigned used{0};
+    };
+
+    // how pages are mapped, nodes is a bitmask of numa nodes to bind to
+    struct policy_t final {
+        bool huge{false};
+        bool interleave{false};
+        unsigned long nodes{0};
+    };
+
+    static constexpr std::size_t huge_size = std::size_t(2) * 1024 * 1024;
+
     mempager(const mempager&) = delete;
     auto operator=(const mempager&) -> auto& = delete;
 
@@ -338,9 +531,18 @@ public:
             align_ = aligned_cache();
     }
 
+    // mapped pages, huge pages round the page size up to 2 MiB
+    mempager(std::size_t size, const policy_t& policy) noexcept :
+    size_(size), align_(aligned_page()), policy_(policy) {
+        if(policy_.huge)
+            size_ = round(size_ ? size_ : huge_size, huge_size);
+        else
+            size_ = round(size_ ? size_ : align_, align_);
+    }
+
     mempager(mempager&& move) noexcept :
-    size_(move.size_), align_(move.align_), count_(move.count_), current_(move.current_) {
-        move.current_ = nullptr;
+    size_(move.size_), align_(move.align_), count_(move.count_), policy_(move.policy_), current_(move.current_), free_(move.free_) {
+        move.current_ = move.free_ = nullptr;
         move.count_ = 0;
     }
 
@@ -352,11 +554,14 @@ public:
         if(&move == this)
             return *this;
 
+        clear();
         size_ = move.size_;
         align_ = move.align_;
         count_ = move.count_;
+        policy_ = move.policy_;
         current_ = move.current_;
-        move.current_ = nullptr;
+        free_ = move.free_;
+        move.current_ = move.free_ = nullptr;
         move.count_ = 0;
         return *this;
     }
@@ -370,20 +575,21 @@ public:
         while(size % sizeof(void *))
             ++size;
 
-        if(size > (size_ - sizeof(page_ptr)))
+        if(size > (size_ - sizeof(page_t)))
             return nullptr;
 
         if(!current_ || size > size_ - current_->used) {
-            page_ptr page{nullptr};
-            page_alloc(&page, size_, align_);
+            page_ptr page{free_};
+            if(page)
+                free_ = page->next;
+            else
+                page = page_alloc(size_);
             if(!page)
                 return nullptr;
 
             page->aligned = nullptr;    // To make dumb checkers happy
             page->used = sizeof(page_t);
-            page->next = current_;
-            ++count_;
-            current_ = page;
+            push(page);
         }
 
         uint8_t *mem = (reinterpret_cast<uint8_t *>(current_)) + current_->used;
@@ -391,6 +597,40 @@ public:
         return mem;
     }
 
+    // aligned allocation of any size, oversize requests get their own page
+    auto allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) -> void * {
+        if(align < sizeof(void *))
+            align = sizeof(void *);
+
+        auto mem = carve(size, align);
+        if(mem)
+            return mem;
+
+        page_ptr page{nullptr};
+        if(size + align + sizeof(page_t) <= size_) {
+            page = free_;
+            if(page)
+                free_ = page->next;
+            else
+                page = page_alloc(size_);
+            if(!page)
+                throw std::bad_alloc();
+            page->used = sizeof(page_t);
+            push(page);
+            return carve(size, align);
+        }
+
+        auto total = round(sizeof(page_t) + align + size, policy_.huge ? huge_size : align_);
+        page = page_alloc(total);
+        if(!page)
+            throw std::bad_alloc();
+        page->used = sizeof(page_t);
+        push(page);
+        mem = carve(size, align, total);
+        current_->used = unsigned(size_);   // treat as full for alloc()
+        return mem;
+    }
+
     auto dup(const std::string_view& str) -> char * {
         auto len = str.size();
         auto mem = static_cast<char *>(alloc(len + 1));
@@ -402,13 +642,65 @@ public:
     }
 
     void clear() noexcept {
-        page_ptr next{};
-        while(current_) {
-            next = current_->next;
-            ::free(current_); // NOLINT
+        reset();
+        trim();
+    }
+
+    auto mark() const noexcept {
+        mark_t mark;
+        if(current_) {
+            mark.page = current_;
+            mark.used = current_->used;
+        }
+        return mark;
+    }
+
+    // release everything allocated since mark, keeping pages for reuse
+    void rewind(const mark_t& mark) noexcept {
+        while(current_ && current_ != mark.page) {
+            auto next = current_->next;
+            current_->next = free_;
+            free_ = current_;
             current_ = next;
+            --count_;
+        }
+        if(current_)
+            current_->used = mark.used;
+    }
+
+    void reset() noexcept {
+        rewind(mark_t{});
+    }
+
+    // free pages kept from earlier rewinds
+    void trim() noexcept {
+        page_ptr next{};
+        while(free_) {
+            next = free_->next;
+            page_free(free_);
+            free_ = next;
+        }
+    }
+
+    // map and touch spare pages ahead of time so first use does not fault
+    auto prefault(std::size_t count) noexcept {
+        std::size_t total = 0;
+        while(total < count) {
+            auto page = page_alloc(size_);
+            if(!page)
+                break;
+            auto mem = reinterpret_cast<volatile uint8_t *>(page);
+            for(std::size_t offset = aligned_page(); offset < size_; offset += aligned_page())
+                mem[offset] = 0;
+            page->next = free_;
+            free_ = page;
+            ++total;
         }
-        count_ = 0;
+        return total;
+    }
+
+    auto policy() const noexcept {
+        return policy_;
     }
 
     auto empty() const noexcept {
@@ -467,13 +759,86 @@ protected:
 private:
     using page_ptr = struct page_t {
         page_t *next;
+        std::size_t bytes;
         union {
             [[maybe_unused]] void *aligned;
             unsigned used;
         };
     } *;
 
-    page_ptr current_{nullptr};
+    policy_t policy_{};
+    page_ptr current_{nullptr}, free_{nullptr};
+
+    static constexpr auto round(std::size_t size, std::size_t align) noexcept -> std::size_t {
+        return (size + align - 1) / align * align;
+    }
+
+    auto mapped() const noexcept {
+        return policy_.huge || policy_.nodes;
+    }
+
+    auto page_alloc(std::size_t size) noexcept -> page_ptr {
+        page_ptr page{nullptr};
+#if defined(MAP_ANONYMOUS)
+        if(mapped()) {
+            void *mem = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+            if(policy_.huge)
+                mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+            // no reserved huge pages, ask for transparent ones instead
+            if(mem == MAP_FAILED) {
+                mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#if defined(MADV_HUGEPAGE)
+                if(mem != MAP_FAILED && policy_.huge)
+                    ::madvise(mem, size, MADV_HUGEPAGE);
+#endif
+            }
+            if(mem == MAP_FAILED)
+                return nullptr;
+#if defined(SYS_mbind)
+            // MPOL_BIND and MPOL_INTERLEAVE, without needing numaif.h
+            if(policy_.nodes)
+                ::syscall(SYS_mbind, mem, size, policy_.interleave ? 3 : 2, &policy_.nodes, sizeof(policy_.nodes) * CHAR_BIT, 0);
+#endif
+            page = static_cast<page_ptr>(mem);
+        }
+        else
+#endif
+            page_alloc(&page, size, align_);
+        if(page)
+            page->bytes = size;
+        return page;
+    }
+
+    void page_free(page_ptr page) noexcept {
+#if defined(MAP_ANONYMOUS)
+        if(mapped()) {
+            ::munmap(page, page->bytes);
+            return;
+        }
+#endif
+        ::free(page); // NOLINT
+    }
+
+    void push(page_ptr page) noexcept {
+        page->next = current_;
+        ++count_;
+        current_ = page;
+    }
+
+    auto carve(std::size_t size, std::size_t align, std::size_t limit = 0) noexcept -> void * {
+        if(!current_)
+            return nullptr;
+        if(!limit)
+            limit = size_;
+        const auto base = reinterpret_cast<uintptr_t>(current_);
+        const auto start = (base + current_->used + align - 1) & ~(uintptr_t(align) - 1);
+        if(start + size - base > limit)
+            return nullptr;
+        current_->used = unsigned(start + size - base);
+        return reinterpret_cast<void *>(start);
+    }
 
     static void page_alloc(page_ptr *mem, std::size_t size, std::size_t align = 0) {
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
@@ -491,6 +856,305 @@ private:
     }
 };
 
+inline omemstream::omemstream(mempager& pager, std::size_t size, bool flag) :
+std::ostream(static_cast<std::streambuf *>(this)), zero(flag), pager_(&pager) {
+    grow(size ? size : 1);
+}
+
+// pager memory is never freed, outgrown buffers stay until the pager rewinds
+inline void omemstream::grow(std::size_t need) {
+    auto size = std::max(need, limit * 2);
+    auto mem = static_cast<uint8_t *>(pager_->allocate(size + (zero ? 1 : 0)));
+    if(count)
+        memcpy(mem, base, count); // FlawFinder: ignore
+    base = mem;
+    limit = size;
+    if(zero)
+        base[count] = 0;
+}
+
+// Stateful allocator drawing from a pager, deallocation is a no-op
+template<typename T>
+class mempager_allocator {
+public:
+    using value_type = T;
+
+    explicit mempager_allocator(mempager& pager) noexcept : pager_(&pager) {}
+
+    template<typename U>
+    mempager_allocator(const mempager_allocator<U>& other) noexcept : pager_(other.pager()) {} // NOLINT
+
+    auto allocate(std::size_t count) -> T * {
+        if(count > std::size_t(-1) / sizeof(T))
+            throw std::bad_alloc();
+        return static_cast<T *>(pager_->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate([[maybe_unused]] T *ptr, [[maybe_unused]] std::size_t count) noexcept {}
+
+    auto pager() const noexcept {
+        return pager_;
+    }
+
+    template<typename U>
+    auto operator==(const mempager_allocator<U>& other) const noexcept {
+        return pager_ == other.pager();
+    }
+
+    template<typename U>
+    auto operator!=(const mempager_allocator<U>& other) const noexcept {
+        return pager_ != other.pager();
+    }
+
+private:
+    mempager *pager_{nullptr};
+};
+
+#if __has_include(<memory_resource>)
+// Pager as a pmr memory resource, so pmr containers can use an arena
+class mempager_resource final : public std::pmr::memory_resource {
+public:
+    explicit mempager_resource(mempager& pager) noexcept : pager_(pager) {}
+    mempager_resource(const mempager_resource&) = delete;
+    auto operator=(const mempager_resource&) -> auto& = delete;
+
+    auto pager() const noexcept -> mempager& {
+        return pager_;
+    }
+
+private:
+    mempager& pager_;   // NOLINT
+
+    auto do_allocate(std::size_t size, std::size_t align) -> void * final {
+        return pager_.allocate(size, align);
+    }
+
+    void do_deallocate([[maybe_unused]] void *ptr, [[maybe_unused]] std::size_t size, [[maybe_unused]] std::size_t align) final {}
+
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool final {
+        return this == &other;
+    }
+};
+#endif
+
+// Rewinds a pager to where it was when the scope was entered
+class mempager_scope final {
+public:
+    explicit mempager_scope(mempager& pager) noexcept :
+    pager_(pager), mark_(pager.mark()) {}
+
+    mempager_scope(const mempager_scope&) = delete;
+    auto operator=(const mempager_scope&) -> auto& = delete;
+
+    ~mempager_scope() {
+        pager_.rewind(mark_);
+    }
+
+    auto operator*() const noexcept -> mempager& {
+        return pager_;
+    }
+
+    auto operator->() const noexcept {
+        return &pager_;
+    }
+
+private:
+    mempager& pager_;   // NOLINT
+    mempager::mark_t mark_;
+};
+
+// Per-thread scratch pager, not shared so no locking is needed
+inline auto local_pager() -> mempager& {
+    thread_local mempager pager(mempager::aligned_page(4096));
+    return pager;
+}
+
+// Fixed size slots carved from pager pages with an intrusive freelist.
+// With Stripes > 0 the pool is thread-safe and each thread frees into and
+// allocates from its own stripe first, spilling to a shared list.
+template<typename T, std::size_t Stripes = 0>
+class object_pool final {
+public:
+    struct stats_t final {
+        std::size_t live{0}, free{0}, pages{0};
+    };
+
+    class deleter final {
+    public:
+        explicit deleter(object_pool *pool = nullptr) noexcept : pool_(pool) {}
+
+        void operator()(T *obj) const {
+            if(pool_)
+                pool_->free(obj);
+        }
+
+    private:
+        object_pool *pool_{nullptr};
+    };
+
+    using pointer = std::unique_ptr<T, deleter>;
+
+    explicit object_pool(std::size_t page = 0) :
+    pager_(page ? page : mempager::aligned_page(sizeof(slot_t) * 16)) {}
+
+    object_pool(const object_pool&) = delete;
+    auto operator=(const object_pool&) -> auto& = delete;
+
+    // live objects must be freed first, pages are released unconditionally
+    ~object_pool() = default;
+
+    template<typename... Args>
+    auto make(Args&&... args) -> T * {
+        auto mem = allocate();
+        try {
+            return new(mem) T(std::forward<Args>(args)...);
+        }
+        catch(...) {
+            release(mem);
+            throw;
+        }
+    }
+
+    template<typename... Args>
+    auto make_unique(Args&&... args) {
+        return pointer(make(std::forward<Args>(args)...), deleter(this));
+    }
+
+    void free(T *obj) {
+        if(!obj)
+            return;
+        obj->~T();
+        release(obj);
+    }
+
+    // raw slot, may throw bad_alloc
+    auto allocate() -> void * {
+        slot_t *slot{nullptr};
+        if constexpr(Stripes == 0) {
+            slot = pop(free_, count_);
+            if(!slot)
+                slot = carve();
+        }
+        else {
+            auto& stripe = stripes_[index()];
+            {
+                const std::lock_guard lock(stripe.lock);
+                slot = pop(stripe.free, stripe.count);
+            }
+            if(!slot) {
+                const std::lock_guard lock(lock_);
+                slot = pop(free_, count_);
+                if(!slot)
+                    slot = carve();
+            }
+        }
+        ++live_;
+        return slot;
+    }
+
+    void release(void *mem) noexcept {
+        if(!mem)
+            return;
+
+        auto slot = static_cast<slot_t *>(mem);
+        --live_;
+        if constexpr(Stripes == 0)
+            push(free_, count_, slot);
+        else {
+            auto& stripe = stripes_[index()];
+            const std::lock_guard lock(stripe.lock);
+            push(stripe.free, stripe.count, slot);
+            if(stripe.count < spill)
+                return;
+
+            // hand half of the stripe back so other threads can reuse it
+            auto head = stripe.free;
+            auto tail = head;
+            for(std::size_t count = 1; count < spill / 2; ++count)
+                tail = tail->next;
+            stripe.free = tail->next;
+            stripe.count -= spill / 2;
+            const std::lock_guard shared(lock_);
+            tail->next = free_;
+            free_ = head;
+            count_ += spill / 2;
+        }
+    }
+
+    auto stats() const -> stats_t {
+        stats_t result;
+        result.live = live_;
+        if constexpr(Stripes == 0) {
+            result.free = count_;
+            result.pages = pager_.pages();
+        }
+        else {
+            for(auto& stripe : stripes_) {
+                const std::lock_guard lock(stripe.lock);
+                result.free += stripe.count;
+            }
+            const std::lock_guard lock(lock_);
+            result.free += count_;
+            result.pages = pager_.pages();
+        }
+        return result;
+    }
+
+    static constexpr auto slot_size() noexcept {
+        return sizeof(slot_t);
+    }
+
+private:
+    union slot_t {
+        slot_t *next;
+        alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    struct alignas(64) stripe_t final {
+        mutable std::mutex lock;
+        slot_t *free{nullptr};
+        std::size_t count{0};
+    };
+
+    static constexpr std::size_t spill = 64;
+
+    using live_t = std::conditional_t<Stripes == 0, std::size_t, std::atomic<std::size_t>>;
+    using stripes_t = std::conditional_t<Stripes == 0, std::array<stripe_t, 0>, std::array<stripe_t, Stripes>>;
+
+    mutable std::mutex lock_;
+    mempager pager_;
+    slot_t *free_{nullptr};
+    std::size_t count_{0};
+    live_t live_{0};
+    stripes_t stripes_;
+
+    auto carve() -> slot_t * {
+        return static_cast<slot_t *>(pager_.allocate(sizeof(slot_t), alignof(slot_t)));
+    }
+
+    static auto pop(slot_t *& list, std::size_t& count) noexcept -> slot_t * {
+        auto slot = list;
+        if(slot) {
+            list = slot->next;
+            --count;
+        }
+        return slot;
+    }
+
+    static void push(slot_t *& list, std::size_t& count, slot_t *slot) noexcept {
+        slot->next = list;
+        list = slot;
+        ++count;
+    }
+
+    // each thread is assigned a stripe the first time it touches a pool
+    static auto index() noexcept -> std::size_t {
+        static std::atomic<std::size_t> next{0};
+        thread_local const auto self = next.fetch_add(1, std::memory_order_relaxed);
+        return self % (Stripes ? Stripes : 1);
+    }
+};
+
 using bytearray_t = shared_array<uint8_t>;
 using chararray_t = shared_array<char>;
 using wordarray_t = shared_array<uint16_t>;
@@ -657,7 +1321,6 @@ inline void operator delete([[maybe_unused]] void *page, [[maybe_unused]] tycho:
 template <typename T>
 inline auto operator<<(std::ostream& out, const tycho::shared_array<T>& bin) -> std::ostream& {
     static_assert(std::is_trivial_v<T>, "T must be Trivial type");
-    out << bin.to_hex();
-    return out;
+    return tycho::to_hex(reinterpret_cast<const uint8_t *>(bin.get()), bin.size_bytes(), out);
 }
 #endif
@@ -0,0 +1,568 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_METRICS_HPP_
+#define TYCHO_METRICS_HPP_
+
+#include "atomics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace tycho::metrics {
+// Hooks in the library are compiled in with USE_METRICS. The metric types
+// may always be used directly, and hooks compiled out cost nothing. Since
+// the hooks are inline, USE_METRICS must be set the same way for every
+// translation unit of a program, and msvc checks this when linking.
+#ifdef  USE_METRICS
+constexpr bool enabled = true;
+#if defined(_MSC_VER)
+#pragma detect_mismatch("tycho_metrics", "on")
+#endif
+#else
+constexpr bool enabled = false;
+#if defined(_MSC_VER)
+#pragma detect_mismatch("tycho_metrics", "off")
+#endif
+#endif
+
+constexpr std::size_t shards = 16;
+constexpr std::size_t buckets = 48;
+
+// steady clock nanoseconds
+inline auto now() noexcept -> uint64_t {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// small sequential id of the calling thread, which also picks its shard
+inline auto thread_id() noexcept -> uint32_t {
+    static std::atomic<uint32_t> next{0};
+    static thread_local const auto id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+inline auto shard() noexcept -> std::size_t {
+    return thread_id() % shards;
+}
+
+enum class kind_t {counter, histogram};
+
+struct sample_t {
+    std::string name;
+    kind_t kind{kind_t::counter};
+    uint64_t count{0};
+    uint64_t total{0};              // nanoseconds for histograms
+    uint64_t p50{0}, p90{0}, p99{0}, max{0};
+
+    auto mean() const noexcept -> uint64_t {
+        return count ? total / count : 0;
+    }
+};
+
+class metric_t;
+
+// Named metrics add themselves here so a snapshot can find them
+class registry_t final {
+public:
+    registry_t() = default;
+    registry_t(const registry_t&) = delete;
+    auto operator=(const registry_t&) -> auto& = delete;
+
+    inline void add(metric_t *metric);
+    inline void remove(metric_t *metric) noexcept;
+    inline auto snapshot() const -> std::vector<sample_t>;
+    inline void clear() noexcept;
+
+    auto size() const {
+        const std::lock_guard lock(lock_);
+        return list_.size();
+    }
+
+private:
+    mutable std::mutex lock_;
+    std::vector<metric_t *> list_;
+};
+
+inline auto registry() -> registry_t& {
+    static registry_t metrics;
+    return metrics;
+}
+
+class metric_t {
+public:
+    metric_t(const metric_t&) = delete;
+    auto operator=(const metric_t&) -> auto& = delete;
+
+    virtual ~metric_t() = default;
+
+    auto name() const noexcept -> const std::string& {
+        return name_;
+    }
+
+    virtual auto sample() const -> sample_t = 0;
+    virtual void clear() noexcept = 0;
+
+protected:
+    explicit metric_t(std::string name) : name_(std::move(name)) {}
+
+    // called by final types once complete, an empty name is not listed
+    void enroll() {
+        registered_ = !name_.empty();
+        if(registered_)
+            registry().add(this);
+    }
+
+    void retire() noexcept {
+        if(registered_)
+            registry().remove(this);
+        registered_ = false;
+    }
+
+private:
+    std::string name_;
+    bool registered_{false};
+};
+
+// Relaxed counter spread over cache line shards by thread
+class counter_t final : public metric_t {
+public:
+    explicit counter_t(std::string name = "") : metric_t(std::move(name)) {
+        enroll();
+    }
+
+    ~counter_t() override {
+        retire();
+    }
+
+    void add(uint64_t count = 1) noexcept {
+        cells_.add(count);
+    }
+
+    auto operator++() noexcept -> auto& {
+        add();
+        return *this;
+    }
+
+    auto value() const noexcept {
+        return cells_.load();
+    }
+
+    auto sample() const -> sample_t override {
+        sample_t result;
+        result.name = name();
+        result.count = value();
+        return result;
+    }
+
+    void clear() noexcept override {
+        cells_.reset();
+    }
+
+private:
+    atomics::counter_t<uint64_t, shards> cells_;
+};
+
+// Power of two nanosecond buckets kept in one or more shards, so recording
+// is a few relaxed adds on a line the thread mostly has to itself, and
+// percentiles are bucket upper bounds.
+template<std::size_t Shards = shards>
+class latency_t {
+public:
+    void record(uint64_t nsec) noexcept {
+        auto& slot = slots_[pick()];
+        slot.counts[std::min(width(nsec), buckets - 1)].fetch_add(1, std::memory_order_relaxed);
+        slot.total.fetch_add(nsec, std::memory_order_relaxed);
+        auto max = slot.max.load(std::memory_order_relaxed);
+        while(nsec > max && !slot.max.compare_exchange_weak(max, nsec, std::memory_order_relaxed)) {}
+    }
+
+    template<typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> elapsed) noexcept {
+        const auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(uint64_t(std::max(decltype(nsec)(0), nsec)));
+    }
+
+    auto operator[](std::size_t pos) const noexcept -> uint64_t {
+        if(pos >= buckets)
+            return 0;
+        uint64_t sum = 0;
+        for(const auto& slot : slots_)
+            sum += slot.counts[pos].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    auto count() const noexcept {
+        uint64_t sum = 0;
+        for(std::size_t pos = 0; pos < buckets; ++pos)
+            sum += (*this)[pos];
+        return sum;
+    }
+
+    auto total() const noexcept {
+        uint64_t sum = 0;
+        for(const auto& slot : slots_)
+            sum += slot.total.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    auto mean() const noexcept -> uint64_t {
+        const auto samples = count();
+        return samples ? total() / samples : 0;
+    }
+
+    auto max() const noexcept {
+        uint64_t most = 0;
+        for(const auto& slot : slots_)
+            most = std::max(most, slot.max.load(std::memory_order_relaxed));
+        return most;
+    }
+
+    // upper bound in nanoseconds of the bucket holding fraction p
+    auto percentile(double p) const noexcept -> uint64_t {
+        uint64_t counts[buckets]{};
+        return rank(counts, gather(counts), p);
+    }
+
+    void clear() noexcept {
+        for(auto& slot : slots_) {
+            for(auto& bucket : slot.counts)
+                bucket.store(0, std::memory_order_relaxed);
+            slot.total.store(0, std::memory_order_relaxed);
+            slot.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr auto upper(std::size_t pos) noexcept -> uint64_t {
+        return pos ? (uint64_t(1) << pos) - 1 : 0;
+    }
+
+protected:
+    // one consistent copy of bucket counts, returning how many samples
+    auto gather(uint64_t (&counts)[buckets]) const noexcept -> uint64_t {
+        uint64_t samples = 0;
+        for(std::size_t pos = 0; pos < buckets; ++pos)
+            samples += (counts[pos] = (*this)[pos]);
+        return samples;
+    }
+
+    static auto rank(const uint64_t (&counts)[buckets], uint64_t samples, double p) noexcept -> uint64_t {
+        if(!samples)
+            return 0;
+        const auto target = std::max(uint64_t(1), uint64_t(std::ceil(double(samples) * std::min(std::max(p, 0.0), 1.0))));
+        uint64_t seen = 0;
+        for(std::size_t pos = 0; pos < buckets; ++pos) {
+            seen += counts[pos];
+            if(seen >= target)
+                return upper(pos);
+        }
+        return upper(buckets - 1);
+    }
+
+private:
+    static_assert(Shards > 0, "Shard count must be positive");
+
+    struct alignas(64) slot_t final {
+        std::atomic<uint64_t> counts[buckets]{};
+        std::atomic<uint64_t> total{0}, max{0};
+    };
+
+    slot_t slots_[Shards]{};
+
+    static auto pick() noexcept -> std::size_t {
+        if constexpr(Shards == 1)
+            return 0;
+        else
+            return thread_id() % Shards;
+    }
+
+    static auto width(uint64_t value) noexcept -> std::size_t {
+#if defined(__GNUC__) || defined(__clang__)
+        return value ? std::size_t(64 - __builtin_clzll(value)) : 0;
+#else
+        std::size_t bits = 0;
+        while(value) {
+            ++bits;
+            value >>= 1;
+        }
+        return bits;
+#endif
+    }
+};
+
+// Sharded latency histogram listed in the registry by name
+class histogram_t final : public metric_t, public latency_t<shards> {
+public:
+    explicit histogram_t(std::string name = "") : metric_t(std::move(name)) {
+        enroll();
+    }
+
+    ~histogram_t() override {
+        retire();
+    }
+
+    auto sample() const -> sample_t override {
+        uint64_t counts[buckets]{};
+        sample_t result;
+        result.name = name();
+        result.kind = kind_t::histogram;
+        result.count = gather(counts);
+        result.total = total();
+        result.p50 = rank(counts, result.count, 0.50);
+        result.p90 = rank(counts, result.count, 0.90);
+        result.p99 = rank(counts, result.count, 0.99);
+        result.max = max();
+        return result;
+    }
+
+    void clear() noexcept override {
+        latency_t::clear();
+    }
+};
+
+void registry_t::add(metric_t *metric) {
+    const std::lock_guard lock(lock_);
+    list_.push_back(metric);
+}
+
+void registry_t::remove(metric_t *metric) noexcept {
+    const std::lock_guard lock(lock_);
+    list_.erase(std::remove(list_.begin(), list_.end(), metric), list_.end());
+}
+
+auto registry_t::snapshot() const -> std::vector<sample_t> {
+    std::vector<sample_t> list;
+    const std::lock_guard lock(lock_);
+    list.reserve(list_.size());
+    for(const auto *metric : list_)
+        list.push_back(metric->sample());
+    return list;
+}
+
+void registry_t::clear() noexcept {
+    const std::lock_guard lock(lock_);
+    for(auto *metric : list_)
+        metric->clear();
+}
+
+inline auto snapshot() {
+    return registry().snapshot();
+}
+
+// one json object of every registered metric by name
+inline void report(std::ostream& out, const std::vector<sample_t>& list = snapshot()) {
+    out << '{';
+    auto sep = "";
+    for(const auto& item : list) {
+        out << sep << '"' << item.name << "\":";
+        sep = ",";
+        if(item.kind == kind_t::counter) {
+            out << item.count;
+            continue;
+        }
+        out << "{\"count\":" << item.count << ",\"mean_ns\":" << item.mean()
+            << ",\"p50_ns\":" << item.p50 << ",\"p90_ns\":" << item.p90
+            << ",\"p99_ns\":" << item.p99 << ",\"max_ns\":" << item.max << '}';
+    }
+    out << "}\n";
+}
+
+struct event_t final {
+    const char *name{nullptr};      // static text
+    uint64_t start{0};
+    uint64_t duration{0};
+    uint32_t thread{0};
+};
+
+// Bounded span recorder that writes chrome trace json, which perfetto
+// also reads. Spans are dropped when the ring is full or tracing is off.
+class tracer_t final {
+public:
+    static constexpr std::size_t ring_size = 16384;
+
+    tracer_t() : ring_(std::make_unique<atomics::ring_t<event_t, ring_size>>()) {}
+
+    tracer_t(const tracer_t&) = delete;
+    auto operator=(const tracer_t&) -> auto& = delete;
+
+    void start() noexcept {
+        active_.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() noexcept {
+        active_.store(false, std::memory_order_relaxed);
+    }
+
+    auto active() const noexcept {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+    auto dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    void record(const char *name, uint64_t start, uint64_t duration) noexcept {
+        if(!active())
+            return;
+        if(!ring_->push(event_t{name, start, duration, thread_id()}))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // drain recorded spans as complete events in microseconds
+    auto write(std::ostream& out) -> std::size_t {
+        std::size_t count = 0;
+        out << "{\"traceEvents\":[";
+        event_t event;
+        while(ring_->pull(event)) {
+            out << (count++ ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                << ",\"ts\":" << (event.start / 1000) << '.' << digits(event.start % 1000)
+                << ",\"dur\":" << (event.duration / 1000) << '.' << digits(event.duration % 1000) << '}';
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        return count;
+    }
+
+private:
+    std::unique_ptr<atomics::ring_t<event_t, ring_size>> ring_;
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> dropped_{0};
+
+    static auto digits(uint64_t value) -> std::string {
+        auto text = std::to_string(value);
+        return std::string(3 - text.size(), '0') + text;
+    }
+};
+
+inline auto tracer() -> tracer_t& {
+    static tracer_t spans;
+    return spans;
+}
+
+// Times a scope into a histogram and, while tracing, as a span
+class span_t final {
+public:
+    explicit span_t(const char *name, histogram_t *into = nullptr) noexcept :
+    name_(name), into_(into), start_(now()) {}
+
+    span_t(const span_t&) = delete;
+    auto operator=(const span_t&) -> auto& = delete;
+
+    ~span_t() {
+        const auto duration = now() - start_;
+        if(into_)
+            into_->record(duration);
+        tracer().record(name_, start_, duration);
+    }
+
+private:
+    const char *name_;
+    histogram_t *into_;
+    uint64_t start_;
+};
+
+// Task carrying the time it was queued. Queues always hold these so their
+// layout is the same with or without hooks, and only the stamp is skipped.
+template<typename Task>
+class stamped final {
+public:
+    stamped() noexcept = default;
+
+    stamped(std::nullptr_t) noexcept {}  // NOLINT
+
+    template<typename Func, typename F = std::decay_t<Func>, std::enable_if_t<!std::is_same_v<F, stamped> && std::is_constructible_v<Task, Func&&>, int> = 0>
+    stamped(Func&& func) : task_(std::forward<Func>(func)), since_(enabled ? now() : 0) {} // NOLINT
+
+    auto operator=(std::nullptr_t) noexcept -> auto& {
+        task_ = nullptr;
+        return *this;
+    }
+
+    void operator()() {
+        task_();
+    }
+
+    operator bool() const noexcept {
+        return bool(task_);
+    }
+
+    auto since() const noexcept {
+        return since_;
+    }
+
+private:
+    Task task_;
+    uint64_t since_{0};
+};
+
+template<typename Task>
+using queued_t = stamped<Task>;
+
+struct tasks_t final {
+    explicit tasks_t(const std::string& prefix) : wait(prefix + ".wait"), run(prefix + ".run"), name(prefix) {}
+
+    histogram_t wait, run;
+    std::string name;
+};
+
+// Metrics of library hot paths, built on first use by a compiled in hook
+struct library_t final {
+    tasks_t queue{"task_queue"}, pool{"task_pool"};
+    histogram_t timer_late{"timer_queue.late"}, timer_run{"timer_queue.run"};
+    counter_t stream_sync{"socket_stream.sync"}, stream_underflow{"socket_stream.underflow"};
+};
+
+inline auto library() -> library_t& {
+    static library_t metrics;
+    return metrics;
+}
+
+// run a queued task, timing its wait and run when hooks are compiled in
+template<typename Task>
+inline void run(Task& task, tasks_t library_t::*site) {
+    if constexpr(enabled) {
+        auto& into = library().*site;
+        const auto start = now();
+        into.wait.record(start - std::min(start, task.since()));
+        task();
+        const auto duration = now() - start;
+        into.run.record(duration);
+        tracer().record(into.name.c_str(), start, duration);
+    }
+    else
+        task();
+}
+
+// run a timer task, timing lateness against when it was set to expire
+template<typename Task, typename Clock, typename Duration>
+inline void fire(Task& task, const std::chrono::time_point<Clock, Duration>& expires) {
+    if constexpr(enabled) {
+        auto& into = library();
+        into.timer_late.record(Clock::now() - expires);
+        const auto start = now();
+        task();
+        const auto duration = now() - start;
+        into.timer_run.record(duration);
+        tracer().record("timer_queue", start, duration);
+    }
+    else
+        task();
+}
+
+inline void count(counter_t library_t::*site, uint64_t value = 1) noexcept {
+    if constexpr(enabled)
+        (library().*site).add(value);
+    else
+        (void)site, (void)value;
+}
+} // end namespace
+#endif
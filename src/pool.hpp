@@ -0,0 +1,274 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_POOL_HPP_
+#define TYCHO_POOL_HPP_
+
+#include "stream.hpp"
+#include "socket.hpp"
+#include "hashmap.hpp"
+#include "tasks.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <utility>
+
+namespace tycho {
+// Keep-alive pool of connected streams by remote address. Leases return
+// their stream when released, and returned streams are checked before
+// reuse. A secure_stream pool is one per tls setup, passed as a factory.
+// The pool must outlive any lease taken from it.
+template<typename Stream>
+class connection_pool final {
+public:
+    using stream_t = Stream;
+    using factory_t = std::function<std::unique_ptr<Stream>(const address_t&)>;
+    using duration_t = std::chrono::steady_clock::duration;
+
+    struct limits_t {
+        std::size_t max_idle{8};        // per address
+        std::size_t max_active{64};     // per address, idle included
+        duration_t idle_timeout{std::chrono::seconds(30)};
+    };
+
+    class lease_t final {
+    public:
+        lease_t() noexcept = default;
+        lease_t(const lease_t&) = delete;
+        auto operator=(const lease_t&) -> auto& = delete;
+
+        lease_t(lease_t&& other) noexcept :
+        pool_(other.pool_), key_(std::move(other.key_)), stream_(std::move(other.stream_)) {
+            other.pool_ = nullptr;
+        }
+
+        auto operator=(lease_t&& other) noexcept -> auto& {
+            if(this != &other) {
+                release();
+                pool_ = other.pool_;
+                key_ = std::move(other.key_);
+                stream_ = std::move(other.stream_);
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+
+        ~lease_t() {
+            release();
+        }
+
+        explicit operator bool() const noexcept {
+            return stream_ != nullptr;
+        }
+
+        auto operator!() const noexcept {
+            return stream_ == nullptr;
+        }
+
+        auto operator->() const noexcept {
+            return stream_.get();
+        }
+
+        auto operator*() const noexcept -> Stream& {
+            return *stream_;
+        }
+
+        // give the stream back to the pool for reuse
+        void release() {
+            if(pool_)
+                pool_->restore(key_, std::move(stream_));
+            pool_ = nullptr;
+        }
+
+        // drop a stream whose protocol state cannot be reused
+        void discard() {
+            stream_.reset();
+            release();
+        }
+
+    private:
+        friend class connection_pool;
+
+        lease_t(connection_pool *pool, std::string key, std::unique_ptr<Stream> stream) noexcept :
+        pool_(pool), key_(std::move(key)), stream_(std::move(stream)) {}
+
+        connection_pool *pool_{nullptr};
+        std::string key_;
+        std::unique_ptr<Stream> stream_;
+    };
+
+    explicit connection_pool(timer_queue& timers, const limits_t& limits = limits_t{}, factory_t factory = &make_stream) :
+    timers_(timers), limits_(limits), factory_(std::move(factory)) {
+        const auto period = std::max(std::chrono::duration_cast<timer_queue::period_t>(limits_.idle_timeout / 2), timer_queue::period_t(1));
+        timer_ = timers_.periodic(period, [this] {
+            expire();
+        });
+    }
+
+    connection_pool(const connection_pool&) = delete;
+    auto operator=(const connection_pool&) -> auto& = delete;
+
+    ~connection_pool() {
+        timers_.cancel(timer_);
+        const std::lock_guard lock(lock_);
+        hosts_.clear();
+    }
+
+    // reuse a healthy idle stream or connect a new one, an empty lease
+    // means max_active is reached; connect errors are thrown by the factory.
+    // Idle streams are taken as active under the lock, then polled and, if
+    // stale, closed outside it.
+    auto lease(const address_t& addr) -> lease_t {
+        auto key = make_key(addr);
+        for(;;) {
+            std::unique_ptr<Stream> stream;
+            {
+                const std::lock_guard lock(lock_);
+                auto& host = hosts_[key];
+                if(host.idle.empty())
+                    break;
+                stream = std::move(host.idle.back().stream);
+                host.idle.pop_back();
+                ++host.active;
+            }
+            if(healthy(*stream)) {
+                const std::lock_guard lock(lock_);
+                ++reused_;
+                return lease_t(this, std::move(key), std::move(stream));
+            }
+            stream.reset();
+            const std::lock_guard lock(lock_);
+            auto& host = hosts_[key];
+            --host.active;
+            --host.count;
+        }
+
+        std::unique_lock lock(lock_);
+        auto& host = hosts_[key];
+        if(host.count >= limits_.max_active)
+            return {};
+        ++host.count;
+        ++host.active;
+        ++connected_;
+        lock.unlock();
+        try {
+            return lease_t(this, key, factory_(addr));
+        }
+        catch(...) {
+            lock.lock();
+            auto& failed = hosts_[key];
+            --failed.count;
+            --failed.active;
+            throw;
+        }
+    }
+
+    auto idle(const address_t& addr) const {
+        const std::lock_guard lock(lock_);
+        auto host = hosts_.find(make_key(addr));
+        return host == hosts_.end() ? std::size_t(0) : host->second.idle.size();
+    }
+
+    auto active(const address_t& addr) const {
+        const std::lock_guard lock(lock_);
+        auto host = hosts_.find(make_key(addr));
+        return host == hosts_.end() ? std::size_t(0) : host->second.active;
+    }
+
+    auto reused() const {
+        const std::lock_guard lock(lock_);
+        return reused_;
+    }
+
+    auto connected() const {
+        const std::lock_guard lock(lock_);
+        return connected_;
+    }
+
+    // close idle streams past the idle timeout, run by the timer queue
+    void expire() {
+        std::vector<std::unique_ptr<Stream>> closing;
+        const auto now = std::chrono::steady_clock::now();
+        const std::lock_guard lock(lock_);
+        for(auto& [key, host] : hosts_) {
+            auto& idle = host.idle;
+            auto keep = std::stable_partition(idle.begin(), idle.end(), [&](const idle_t& item) {
+                return now - item.since >= limits_.idle_timeout;
+            });
+            for(auto it = idle.begin(); it != keep; ++it)
+                closing.push_back(std::move(it->stream));
+            host.count -= std::size_t(keep - idle.begin());
+            idle.erase(idle.begin(), keep);
+        }
+    }
+
+    void clear() {
+        const std::lock_guard lock(lock_);
+        for(auto& [key, host] : hosts_) {
+            host.count -= host.idle.size();
+            host.idle.clear();
+        }
+    }
+
+private:
+    struct idle_t final {
+        std::unique_ptr<Stream> stream;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct host_t final {
+        std::vector<idle_t> idle;
+        std::size_t count{0}, active{0};
+    };
+
+    mutable std::mutex lock_;
+    flat_map<std::string, host_t> hosts_;
+    timer_queue& timers_;
+    limits_t limits_;
+    factory_t factory_;
+    uint64_t timer_{0};
+    std::size_t reused_{0}, connected_{0};
+
+    static auto make_stream(const address_t& addr) -> std::unique_ptr<Stream> {
+        return std::make_unique<Stream>(addr.data());
+    }
+
+    static auto make_key(const address_t& addr) -> std::string {
+        return {reinterpret_cast<const char *>(addr.data()), std::size_t(addr.size())};
+    }
+
+    // an idle stream that became readable has either closed or sent
+    // unsolicited data, so it cannot be handed out again
+    static auto healthy(Stream& stream) -> bool {
+        if(!stream.is_open() || !stream.good() || stream.in_avail() || stream.out_pending())
+            return false;
+        return !stream.wait(0) && stream.is_open();
+    }
+
+    void restore(const std::string& key, std::unique_ptr<Stream> stream) {
+        try {
+            if(stream && stream->good() && stream->is_open())
+                stream->flush();
+        }
+        catch(...) {
+            stream.reset();
+        }
+        const std::lock_guard lock(lock_);
+        auto host = hosts_.find(key);
+        if(host == hosts_.end())
+            return;
+        auto& item = host->second;
+        --item.active;
+        if(!stream || !stream->good() || !stream->is_open() || item.idle.size() >= limits_.max_idle) {
+            --item.count;
+            return;
+        }
+        item.idle.push_back(idle_t{std::move(stream), std::chrono::steady_clock::now()});
+    }
+};
+} // end namespace
+#endif
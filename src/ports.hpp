@@ -0,0 +1,209 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_PORTS_HPP_
+#define TYCHO_PORTS_HPP_
+
+#include "serial.hpp"
+#include "reactor.hpp"
+
+#if __has_include(<termios.h>)
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <string_view>
+#include <cstring>
+
+namespace tycho {
+// Services many serial devices from one reactor thread. Each port reads
+// as much as is waiting into its own receive buffer and hands complete
+// frames to a receiver with the time they arrived. Without a framer a
+// frame is whatever one read returns, which follows the line_mode or
+// timed_mode set on the device. An attached device is non-blocking and
+// must not be read directly until detached.
+class serial_ports final {
+public:
+    using clock_t = std::chrono::steady_clock;
+    using time_point = clock_t::time_point;
+
+    // size of the next complete frame in pending input, or 0 for more
+    using framer_t = std::function<std::size_t(std::string_view)>;
+
+    // an empty frame reports the port was closed or failed and detached
+    using receiver_t = std::function<void(int, std::string_view, time_point)>;
+
+    explicit serial_ports(reactor& events, std::size_t buffer = 4096) noexcept :
+    events_(events), buffer_(std::max(buffer, std::size_t(64))) {}
+
+    serial_ports(const serial_ports&) = delete;
+    auto operator=(const serial_ports&) -> auto& = delete;
+
+    ~serial_ports() {
+        clear();
+    }
+
+    // port id is the device descriptor, -1 if it cannot be attached
+    auto attach(const serial_t& serial, receiver_t receiver, framer_t framer = {}) -> int {
+        const auto fd = serial.handle();
+        if(fd < 0 || !receiver)
+            return -1;
+
+        auto port = std::make_shared<port_t>(buffer_);
+        port->fd = fd;
+        port->flags = fcntl(fd, F_GETFL);
+        port->receiver = std::move(receiver);
+        port->framer = std::move(framer);
+        fcntl(fd, F_SETFL, port->flags | O_NONBLOCK);
+        const std::lock_guard lock(lock_);
+        if(!events_.add(fd, reactor::readable, [this, port](int, unsigned mask) {
+            service(*port, mask);
+        })) {
+            fcntl(fd, F_SETFL, port->flags);
+            return -1;
+        }
+        ports_.push_back(std::move(port));
+        return fd;
+    }
+
+    auto detach(int id) -> bool {
+        const std::lock_guard lock(lock_);
+        auto it = std::find_if(ports_.begin(), ports_.end(), [id](const auto& port) {
+            return port->fd == id;
+        });
+        if(it == ports_.end())
+            return false;
+        release(**it);
+        ports_.erase(it);
+        return true;
+    }
+
+    void clear() {
+        const std::lock_guard lock(lock_);
+        for(auto& port : ports_)
+            release(*port);
+        ports_.clear();
+    }
+
+    auto size() const {
+        const std::lock_guard lock(lock_);
+        return ports_.size();
+    }
+
+    // relaxed counts, safe to read from any thread while ports are served
+    auto reads() const noexcept {
+        return reads_.load(std::memory_order_relaxed);
+    }
+
+    auto frames() const noexcept {
+        return frames_.load(std::memory_order_relaxed);
+    }
+
+    // frames ending in a delimiter, which is kept in the frame
+    static auto line_framer(char eol = '\n') -> framer_t {
+        return [eol](std::string_view pending) -> std::size_t {
+            const auto found = pending.find(eol);
+            return found == std::string_view::npos ? 0 : found + 1;
+        };
+    }
+
+    static auto fixed_framer(std::size_t size) -> framer_t {
+        return [size](std::string_view pending) -> std::size_t {
+            return pending.size() >= size ? size : 0;
+        };
+    }
+
+private:
+    struct port_t final {
+        explicit port_t(std::size_t size) : data(size) {}
+
+        int fd{-1}, flags{0};
+        std::atomic<bool> attached{true};
+        std::vector<char> data;
+        std::size_t used{0};
+        receiver_t receiver;
+        framer_t framer;
+    };
+
+    reactor& events_;
+    std::size_t buffer_;
+    mutable std::mutex lock_;
+    std::vector<std::shared_ptr<port_t>> ports_;
+    std::atomic<std::size_t> reads_{0}, frames_{0};
+
+    void release(port_t& port) {
+        events_.remove(port.fd);
+        if(port.attached)
+            fcntl(port.fd, F_SETFL, port.flags);
+        port.attached = false;
+    }
+
+    void service(port_t& port, unsigned mask) {
+        if(!port.attached)
+            return;
+
+        for(;;) {
+            const auto room = port.data.size() - port.used;
+            const auto count = ::read(port.fd, port.data.data() + port.used, room); // FlawFinder: ignore
+            if(count < 0 && errno == EINTR)
+                continue;
+            if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && !(mask & reactor::failed))
+                return;
+            if(count <= 0) {
+                closed(port);
+                return;
+            }
+
+            reads_.fetch_add(1, std::memory_order_relaxed);
+            const auto when = clock_t::now();
+            if(!port.framer) {
+                deliver(port, std::string_view(port.data.data(), std::size_t(count)), when);
+                if(!port.attached || std::size_t(count) < room)
+                    return;
+                continue;
+            }
+
+            port.used += std::size_t(count);
+            split(port, when);
+            if(!port.attached || std::size_t(count) < room)
+                return;
+        }
+    }
+
+    // a full buffer with no frame in it is handed over as is
+    void split(port_t& port, time_point when) {
+        std::size_t pos = 0;
+        while(port.attached && pos < port.used) {
+            const auto size = port.framer(std::string_view(port.data.data() + pos, port.used - pos));
+            if(!size || size > port.used - pos)
+                break;
+            deliver(port, std::string_view(port.data.data() + pos, size), when);
+            pos += size;
+        }
+        if(!pos && port.used == port.data.size()) {
+            deliver(port, std::string_view(port.data.data(), port.used), when);
+            pos = port.used;
+        }
+        if(pos) {
+            port.used -= pos;
+            memmove(port.data.data(), port.data.data() + pos, port.used);
+        }
+    }
+
+    void deliver(port_t& port, std::string_view frame, time_point when) {
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        port.receiver(port.fd, frame, when);
+    }
+
+    void closed(port_t& port) {
+        auto receiver = port.receiver;
+        detach(port.fd);
+        receiver(port.fd, std::string_view(), clock_t::now());
+    }
+};
+} // end namespace
+#endif
+#endif
@@ -5,10 +5,21 @@
 #define TYCHO_PRINT_HPP_
 
 #include "encoding.hpp"
+#include "atomics.hpp"
+#include "datetime.hpp"
 
 #include <iostream>
 #include <string_view>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
 #include <cstdlib>
 #include <cstdio>
 
@@ -16,6 +27,14 @@
 #include <unistd.h>
 #endif
 
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#endif
+#include <cerrno>
+#include <cstring>
+
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
 #ifndef quick_exit
 #define quick_exit(x) ::exit(x)         // NOLINT
@@ -42,6 +61,301 @@ constexpr auto LOG_PERROR = 0;
 constexpr auto LOG_PID = 0;
 #endif
 
+namespace tycho {
+enum class log_policy : uint8_t {drop, block};
+
+struct log_record final {
+    std::string msg;
+    const char *type{""};
+    const char *label{""};
+    std::time_t when{0};
+    int priority{-1};
+    bool show{false};
+};
+
+// Emits formatted records to syslog, the notify callback, and stderr.
+// Until started this happens in the calling thread, and after start a
+// background writer drains a bounded ring in batches, so callers only
+// pay for formatting and one queue slot.
+class log_writer final {
+public:
+    using notify_t = void (*)(const std::string&, const char *type);
+
+    static constexpr std::size_t ring_size = 4096;
+    static constexpr std::size_t batch_size = 64;
+
+    log_writer() = default;
+    log_writer(const log_writer&) = delete;
+    auto operator=(const log_writer&) -> auto& = delete;
+
+    ~log_writer() {
+        stop();
+    }
+
+    void notify(notify_t notify) noexcept {
+        notify_.store(notify);
+    }
+
+    auto dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    auto running() const noexcept {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    void start(log_policy policy = log_policy::drop, bool stamp = true) {
+        const std::lock_guard control(control_);
+        if(running_.load())
+            return;
+        if(!ring_)
+            ring_ = std::make_unique<atomics::ring_t<log_record, ring_size>>();
+        policy_ = policy;
+        stamp_ = stamp;
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread(&log_writer::drain, this);
+    }
+
+    // writes out anything still queued before returning, a record racing
+    // the stop may be held until the next start
+    void stop() {
+        const std::lock_guard control(control_);
+        if(!running_.exchange(false))
+            return;
+        wake();
+        thread_.join();
+        while(flush()) {}
+    }
+
+    // priority below 0 skips syslog
+    void emit(int priority, const char *type, const char *label, bool show, std::string msg) {
+        if(running_.load(std::memory_order_acquire)) {
+            log_record rec{std::move(msg), type, label, std::time(nullptr), priority, show};
+            while(!ring_->push(std::move(rec))) {
+                if(policy_ == log_policy::drop) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                wake();
+                std::this_thread::yield();
+            }
+            if(idle_.load())
+                wake();
+            return;
+        }
+
+        const std::lock_guard lock(output_);
+#ifdef  USE_SYSLOG
+        if(priority >= 0)
+            ::syslog(priority, "%s", msg.c_str());
+#endif
+        notify_.load()(msg, type);
+        if(show)
+            std::cerr << label << ": " << msg << '\n';
+    }
+
+private:
+    static void ignore(const std::string& str, const char *type) {}
+
+    std::unique_ptr<atomics::ring_t<log_record, ring_size>> ring_;
+    std::atomic<notify_t> notify_{&ignore};
+    std::atomic<bool> running_{false}, idle_{false};
+    std::atomic<std::size_t> dropped_{0};
+    log_policy policy_{log_policy::drop};
+    bool stamp_{true};
+    std::mutex control_, output_, wait_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+    std::string text_;
+
+    void wake() {
+        const std::lock_guard lock(wait_);
+        wakeup_.notify_one();
+    }
+
+    // a wakeup missed between the idle flag and the wait only costs the
+    // bounded wait, never a record
+    void drain() {
+        while(running_.load(std::memory_order_acquire)) {
+            if(flush())
+                continue;
+            std::unique_lock lock(wait_);
+            idle_.store(true);
+            if(ring_->empty() && running_.load())
+                wakeup_.wait_for(lock, std::chrono::milliseconds(50));
+            idle_.store(false);
+        }
+    }
+
+    auto flush() -> std::size_t {
+        log_record batch[batch_size];
+        const auto count = ring_->try_pop_n(batch, batch_size);
+        if(!count)
+            return 0;
+
+        std::string& text = text_;
+        text.clear();
+        const auto notify = notify_.load();
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            auto& rec = batch[pos];
+#ifdef  USE_SYSLOG
+            if(rec.priority >= 0)
+                ::syslog(rec.priority, "%s", rec.msg.c_str());
+#endif
+            notify(rec.msg, rec.type);
+            if(!rec.show)
+                continue;
+            if(stamp_)
+                text.append(iso_cached(rec.when)).push_back(' ');
+            text.append(rec.label).append(": ").append(rec.msg).push_back('\n');
+        }
+
+        const std::lock_guard lock(output_);
+        if(!text.empty()) {
+            std::cerr.write(text.data(), std::streamsize(text.size()));
+            std::cerr.flush();
+        }
+        return count;
+    }
+};
+
+// Buffered output to a raw descriptor that print formats straight into,
+// written out with one system call when full, on flush, or when closed.
+// A sink is not thread safe, and output larger than the buffer is sent
+// along with what is buffered in a single writev.
+class fd_sink final {
+public:
+    explicit fd_sink(int fd = 1, std::size_t size = 65536) :
+    fd_(fd), size_(std::max(size, std::size_t(256))), buffer_(new char[size_]) {}
+
+    fd_sink(const fd_sink&) = delete;
+    auto operator=(const fd_sink&) -> auto& = delete;
+
+    ~fd_sink() {
+        flush();
+    }
+
+    explicit operator bool() const noexcept {
+        return err_ == 0;
+    }
+
+    auto operator!() const noexcept {
+        return err_ != 0;
+    }
+
+    auto fd() const noexcept {
+        return fd_;
+    }
+
+    auto err() const noexcept {
+        return err_;
+    }
+
+    auto size() const noexcept {
+        return used_;
+    }
+
+    auto capacity() const noexcept {
+        return size_;
+    }
+
+    auto put(char ch) -> bool {
+        if(used_ >= size_ && !flush())
+            return false;
+        buffer_[used_++] = ch;
+        return true;
+    }
+
+    auto write(const char *data, std::size_t size) -> bool {
+        if(size <= size_ - used_) {
+            memcpy(buffer_.get() + used_, data, size);
+            used_ += size;
+            return true;
+        }
+        if(size < size_) {
+            if(!flush())
+                return false;
+            memcpy(buffer_.get(), data, size);
+            used_ = size;
+            return true;
+        }
+        const auto pending = used_;
+        used_ = 0;
+        return send(buffer_.get(), pending, data, size);
+    }
+
+    auto write(std::string_view text) -> bool {
+        return write(text.data(), text.size());
+    }
+
+    // format is called with the free space and returns the size it needs,
+    // being tried again in an empty buffer or a scratch string if short
+    template<typename Func>
+    auto emit(Func format) -> bool {
+        auto need = format(buffer_.get() + used_, size_ - used_);
+        if(need <= size_ - used_) {
+            used_ += need;
+            return true;
+        }
+        if(need <= size_) {
+            if(!flush())
+                return false;
+            used_ = format(buffer_.get(), size_);
+            return true;
+        }
+        std::string text(need, 0);
+        format(text.data(), need);
+        return write(text.data(), need);
+    }
+
+    auto flush() -> bool {
+        const auto pending = used_;
+        used_ = 0;
+        return send(buffer_.get(), pending, nullptr, 0);
+    }
+
+private:
+    int fd_;
+    std::size_t size_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t used_{0};
+    int err_{0};
+
+    auto send(const char *head, std::size_t head_size, const char *tail, std::size_t tail_size) -> bool {
+        while(head_size + tail_size) {
+#if defined(_WIN32)
+            if(!head_size) {
+                head = tail;
+                head_size = tail_size;
+                tail_size = 0;
+            }
+            const auto result = ::_write(fd_, head, unsigned(std::min(head_size, std::size_t(INT32_MAX))));
+#else
+            struct iovec vec[2] = {
+                {const_cast<char *>(head), head_size},
+                {const_cast<char *>(tail), tail_size},
+            };
+            const auto result = ::writev(fd_, head_size ? vec : vec + 1, head_size ? 2 : 1);
+#endif
+            if(result < 0) {
+                if(errno == EINTR)
+                    continue;
+                err_ = errno;
+                return false;
+            }
+            auto sent = std::size_t(result);
+            const auto skip = std::min(sent, head_size);
+            head += skip;
+            head_size -= skip;
+            sent -= skip;
+            tail += sent;
+            tail_size -= sent;
+        }
+        return true;
+    }
+};
+} // end namespace
+
 #if __cplusplus < 202002L
 #include <fmt/ranges.h>
 #include <fmt/format.h>
@@ -96,6 +410,20 @@ constexpr void println(FILE *fp, format_string<Args...> fmt, Args&&... args) {
     fprintf(fp, "%s\n", format(fmt, std::forward<Args>(args)...).c_str());
 }
 
+// args are only read, so a retry forwarding them again is safe
+template<class... Args>
+void print(fd_sink& sink, format_string<Args...> fmt, Args&&... args) {
+    sink.emit([&](char *to, std::size_t max) {
+        return std::size_t(fmt::format_to_n(to, max, fmt, std::forward<Args>(args)...).size);
+    });
+}
+
+template<class... Args>
+void println(fd_sink& sink, format_string<Args...> fmt, Args&&... args) {
+    print(sink, fmt, std::forward<Args>(args)...);
+    sink.put('\n');
+}
+
 template<class... Args>
 [[noreturn]] constexpr void die(int code, format_string<Args...> fmt, Args&&... args) {
     std::cerr << format(fmt, std::forward<Args>(args)...);
@@ -110,7 +438,7 @@ template<class... Args>
 
 class system_logger final {
 public:
-    using notify_t = void (*)(const std::string&, const char *type);
+    using notify_t = log_writer::notify_t;
 
     system_logger() = default;
     system_logger(const system_logger&) = delete;
@@ -121,10 +449,7 @@ public:
 #ifndef NDEBUG
         if(level <= logging_) {
             try {
-                auto msg = format(fmt, std::forward<Args>(args)...);
-                const std::lock_guard lock(locking_);
-                print(std::cerr, "debug: {}\n", msg);
-                notify_(msg, "debug");
+                writer_.emit(-1, "debug", "debug", true, format(fmt, std::forward<Args>(args)...));
             }
             catch(const std::exception& e) {
                 print(std::cerr, "debug: {}\n", e.what());
@@ -136,83 +461,57 @@ public:
 
     template<class... Args>
     void info(format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_INFO, "%s", msg.c_str());
-#endif
-        notify_(msg, "info");
-        if(logging_ > 1)
-            print(std::cerr, "info: {}\n", msg);
+        writer_.emit(LOG_INFO, "info", "info", logging_ > 1, format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void notice(format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_NOTICE, "%s", msg.c_str());
-#endif
-        notify_(msg, "notice");
-        if(logging_ > 0)
-            print(std::cerr, "notice: {}\n", msg);
+        writer_.emit(LOG_NOTICE, "notice", "notice", logging_ > 0, format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void warn(format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_WARNING, "%s", msg.c_str());
-#endif
-        notify_(msg, "warning");
-        if(logging_)
-            print(std::cerr, "warn: {}\n", msg);
+        writer_.emit(LOG_WARNING, "warning", "warn", logging_ > 0, format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void error(format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_ERR, "%s", msg.c_str());
-#endif
-        notify_(msg, "error");
-        if(logging_)
-            print(std::cerr, "error: {}\n", msg);
+        writer_.emit(LOG_ERR, "error", "error", logging_ > 0, format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     [[noreturn]] void fail(int exit_code, format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_CRIT, "%s", msg.c_str());
-#endif
-        notify_(msg, "fatal");
-        if(logging_)
-            print(std::cerr, "fail: {}\n", msg);
+        writer_.stop();
+        writer_.emit(LOG_CRIT, "fatal", "fail", logging_ > 0, format(fmt, std::forward<Args>(args)...));
         std::cerr << std::ends;
         ::exit(exit_code);
     }
 
     template<class... Args>
     [[noreturn]] void crit(int exit_code, format_string<Args...> fmt, Args&&... args) {
-        auto msg = format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_CRIT, "%s", msg.c_str());
-#endif
-        notify_(msg, "fatal");
-        if(logging_)
-            print(std::cerr, "crit: {}\n", msg);
+        writer_.stop();
+        writer_.emit(LOG_CRIT, "fatal", "crit", logging_ > 0, format(fmt, std::forward<Args>(args)...));
         std::cerr << std::ends;
         quick_exit(exit_code);
     }
 
     void set(unsigned level, notify_t notify = [](const std::string& str, const char *type){}) {
         logging_ = level;
-        notify_ = notify;
+        writer_.notify(notify);
+    }
+
+    // hand records to a background writer, a full ring either drops the
+    // record or has the caller wait for room, as set by policy
+    void start(log_policy policy = log_policy::drop, bool stamp = true) {
+        writer_.start(policy, stamp);
+    }
+
+    void stop() {
+        writer_.stop();
+    }
+
+    auto dropped() const noexcept {
+        return writer_.dropped();
     }
 
 #ifdef  USE_SYSLOG
@@ -231,9 +530,8 @@ public:
 #endif
 
 private:
-    std::mutex locking_;
+    log_writer writer_;
     unsigned logging_{1};
-    notify_t notify_{[](const std::string& str, const char *type){}};
 };
 
 // cppcheck-suppress constParameterPointer
@@ -275,6 +573,19 @@ constexpr void println(FILE *fp, std::format_string<Args...> fmt, Args&&... args
     fprintf(fp, "%s\n", std::format(fmt, std::forward<Args>(args)...).c_str());
 }
 
+template<class... Args>
+void print(fd_sink& sink, std::format_string<Args...> fmt, Args&&... args) {
+    sink.emit([&](char *to, std::size_t max) {
+        return std::size_t(std::format_to_n(to, std::ptrdiff_t(max), fmt, std::forward<Args>(args)...).size);
+    });
+}
+
+template<class... Args>
+void println(fd_sink& sink, std::format_string<Args...> fmt, Args&&... args) {
+    print(sink, fmt, std::forward<Args>(args)...);
+    sink.put('\n');
+}
+
 template<class... Args>
 [[noreturn]] constexpr void die(int code, std::format_string<Args...> fmt, Args&&... args) {
     std::cerr << std::format(fmt, std::forward<Args>(args)...);
@@ -289,7 +600,7 @@ template<class... Args>
 
 class system_logger final {
 public:
-    using notify_t = void (*)(const std::string&, const char *type);
+    using notify_t = log_writer::notify_t;
 
     system_logger() = default;
     system_logger(const system_logger&) = delete;
@@ -300,10 +611,7 @@ public:
 #ifndef NDEBUG
         if(level <= logging_) {
             try {
-                auto msg = std::format(fmt, std::forward<Args>(args)...);
-                const std::lock_guard lock(locking_);
-                print(std::cerr, "debug: {}\n", msg);
-                notify_(msg, "debug");
+                writer_.emit(-1, "debug", "debug", true, std::format(fmt, std::forward<Args>(args)...));
             }
             catch(const std::exception& e) {
                 print(std::cerr, "debug: {}\n", e.what());
@@ -315,83 +623,57 @@ public:
 
     template<class... Args>
     void info(std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_INFO, "%s", msg.c_str());
-#endif
-        notify_(msg, "info");
-        if(logging_ > 1)
-            print(std::cerr, "info: {}\n", msg);
+        writer_.emit(LOG_INFO, "info", "info", logging_ > 1, std::format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void notice(std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_NOTICE, "%s", msg.c_str());
-#endif
-        notify_(msg, "notice");
-        if(logging_ > 0)
-            print(std::cerr, "notice: {}\n", msg);
+        writer_.emit(LOG_NOTICE, "notice", "notice", logging_ > 0, std::format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void warn(std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_WARNING, "%s", msg.c_str());
-#endif
-        notify_(msg, "warning");
-        if(logging_)
-            print(std::cerr, "warn: {}\n", msg);
+        writer_.emit(LOG_WARNING, "warning", "warn", logging_ > 0, std::format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     void error(std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_ERR, "%s", msg.c_str());
-#endif
-        notify_(msg, "error");
-        if(logging_)
-            print(std::cerr, "error: {}\n", msg);
+        writer_.emit(LOG_ERR, "error", "error", logging_ > 0, std::format(fmt, std::forward<Args>(args)...));
     }
 
     template<class... Args>
     [[noreturn]] void fail(int exit_code, std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_CRIT, "%s", msg.c_str());
-#endif
-        notify_(msg, "fatal");
-        if(logging_)
-            print(std::cerr, "fail: {}\n", msg);
+        writer_.stop();
+        writer_.emit(LOG_CRIT, "fatal", "fail", logging_ > 0, std::format(fmt, std::forward<Args>(args)...));
         std::cerr << std::ends;
         ::exit(exit_code);
     }
 
     template<class... Args>
     [[noreturn]] void crit(int exit_code, std::format_string<Args...> fmt, Args&&... args) {
-        auto msg = std::format(fmt, std::forward<Args>(args)...);
-        const std::lock_guard lock(locking_);
-#ifdef  USE_SYSLOG
-        ::syslog(LOG_CRIT, "%s", msg.c_str());
-#endif
-        notify_(msg, "fatal");
-        if(logging_)
-            print(std::cerr, "crit: {}\n", msg);
+        writer_.stop();
+        writer_.emit(LOG_CRIT, "fatal", "crit", logging_ > 0, std::format(fmt, std::forward<Args>(args)...));
         std::cerr << std::ends;
         quick_exit(exit_code);
     }
 
     void set(unsigned level, notify_t notify = [](const std::string& str, const char *type){}) {
         logging_ = level;
-        notify_ = notify;
+        writer_.notify(notify);
+    }
+
+    // hand records to a background writer, a full ring either drops the
+    // record or has the caller wait for room, as set by policy
+    void start(log_policy policy = log_policy::drop, bool stamp = true) {
+        writer_.start(policy, stamp);
+    }
+
+    void stop() {
+        writer_.stop();
+    }
+
+    auto dropped() const noexcept {
+        return writer_.dropped();
     }
 
 #ifdef  USE_SYSLOG
@@ -410,9 +692,8 @@ public:
 #endif
 
 private:
-    std::mutex locking_;
+    log_writer writer_;
     unsigned logging_{1};
-    notify_t notify_{[](const std::string& str, const char *type){}};
 };
 
 // cppcheck-suppress constParameterPointer
@@ -4,6 +4,8 @@
 #ifndef TYCHO_PROCESS_HPP_
 #define TYCHO_PROCESS_HPP_
 
+#include "atomics.hpp"
+
 #include <fstream>
 #include <memory>
 #include <string_view>
@@ -15,6 +17,7 @@
 #include <stdexcept>
 #include <functional>
 #include <type_traits>
+#include <algorithm>
 
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
 #if _WIN32_WINNT < 0x0600 && !defined(_MSC_VER)
@@ -45,10 +48,21 @@
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <spawn.h>
+#include <cerrno>
+#include <climits>
+#include <chrono>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 #ifndef RTLD_GLOBAL
 #define RTLD_GLOBAL 0
 #endif
+
+extern char **environ;      // NOLINT
 #endif
 
 #ifdef __FreeBSD__
@@ -591,13 +605,17 @@ private:
     handle_t handle_{invalid_handle()};
 };
 
+enum class advice_t {normal, sequential, random, willneed, dontneed, hugepage};
+
 class map_t final {
 public:
     map_t() = default;
     map_t(const map_t&) = delete;
     auto operator=(const map_t&) -> auto& = delete;
 
-    map_t(handle_t fd, std::size_t size, bool rw = true, bool priv = false, off_t offset = 0) noexcept : addr_(::mmap(nullptr, size, (rw) ? PROT_READ | PROT_WRITE : PROT_READ, (priv) ? MAP_PRIVATE : MAP_SHARED, fd, offset)), size_(size) {}
+    map_t(handle_t fd, std::size_t size, bool rw = true, bool priv = false, off_t offset = 0, bool populate = false) noexcept {
+        set(fd, size, rw, priv, offset, populate);
+    }
 
     ~map_t() {
         if(addr_ != MAP_FAILED)
@@ -647,6 +665,13 @@ public:
         return (addr_ == MAP_FAILED) ? false : ::msync(addr_, size_, (wait)? MS_SYNC : MS_ASYNC) == 0;
     }
 
+    // pages holding part of the range are synced
+    auto sync(std::size_t pos, std::size_t size, bool wait = false) noexcept {
+        if(addr_ == MAP_FAILED || !range(pos, size))
+            return false;
+        return ::msync(static_cast<uint8_t *>(addr_) + pos, size, (wait) ? MS_SYNC : MS_ASYNC) == 0;
+    }
+
     auto lock() noexcept {
         return (addr_ == MAP_FAILED) ? false : ::mlock(addr_, size_) == 0;
     }
@@ -655,11 +680,76 @@ public:
         return (addr_ == MAP_FAILED) ? false : ::munlock(addr_, size_) == 0;
     }
 
-    auto set(handle_t fd, std::size_t size, bool rw = true, bool priv = false, off_t offset = 0) noexcept {
+    // a size of 0 advises to the end of the map, hugepage is linux only
+    auto advise(advice_t advice, std::size_t pos = 0, std::size_t size = 0) noexcept {
+        if(addr_ == MAP_FAILED || !range(pos, size))
+            return false;
+        int flag = MADV_NORMAL;
+        switch(advice) {
+        case advice_t::sequential:
+            flag = MADV_SEQUENTIAL;
+            break;
+        case advice_t::random:
+            flag = MADV_RANDOM;
+            break;
+        case advice_t::willneed:
+            flag = MADV_WILLNEED;
+            break;
+        case advice_t::dontneed:
+            flag = MADV_DONTNEED;
+            break;
+        case advice_t::hugepage:
+#ifdef  MADV_HUGEPAGE
+            flag = MADV_HUGEPAGE;
+            break;
+#else
+            return false;
+#endif
+        default:
+            break;
+        }
+        return ::madvise(static_cast<uint8_t *>(addr_) + pos, size, flag) == 0;
+    }
+
+    auto prefetch(std::size_t pos = 0, std::size_t size = 0) noexcept {
+        return advise(advice_t::willneed, pos, size);
+    }
+
+    // the map may move, so pointers into it must be taken again after
+    auto resize(std::size_t size) noexcept {
+        if(addr_ == MAP_FAILED || !size)
+            return false;
+        if(size == size_)
+            return true;
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+        auto addr = ::mremap(addr_, size_, size, MREMAP_MAYMOVE);
+#else
+        auto addr = ::mmap(nullptr, size, prot_, flags_, fd_, offset_);
+        if(addr != MAP_FAILED)
+            munmap(addr_, size_);
+#endif
+        if(addr == MAP_FAILED)
+            return false;
+        addr_ = addr;
+        size_ = size;
+        return true;
+    }
+
+    auto set(handle_t fd, std::size_t size, bool rw = true, bool priv = false, off_t offset = 0, bool populate = false) noexcept -> void * {
         if(addr_ != MAP_FAILED)
             munmap(addr_, size_);
 
-        addr_ = ::mmap(nullptr, size, (rw) ? PROT_READ | PROT_WRITE : PROT_READ, (priv) ? MAP_PRIVATE : MAP_SHARED, fd, offset);
+        fd_ = fd;
+        offset_ = offset;
+        prot_ = (rw) ? PROT_READ | PROT_WRITE : PROT_READ;
+        flags_ = (priv) ? MAP_PRIVATE : MAP_SHARED;
+#ifdef  MAP_POPULATE
+        addr_ = ::mmap(nullptr, size, prot_, flags_ | ((populate) ? MAP_POPULATE : 0), fd, offset);
+#else
+        addr_ = ::mmap(nullptr, size, prot_, flags_, fd, offset);
+        if(populate && addr_ != MAP_FAILED)
+            ::madvise(addr_, size, MADV_WILLNEED);
+#endif
         size_ = size;
         return addr_;
     }
@@ -667,6 +757,21 @@ public:
 private:
     void *addr_{MAP_FAILED};
     std::size_t size_{0};
+    handle_t fd_{-1};
+    off_t offset_{0};
+    int prot_{PROT_READ}, flags_{MAP_SHARED};
+
+    // widen pos down to a page boundary, keeping the end in the map
+    auto range(std::size_t& pos, std::size_t& size) const noexcept -> bool {
+        if(pos >= size_)
+            return false;
+        if(!size || size > size_ - pos)
+            size = size_ - pos;
+        const auto offset = pos % std::size_t(sysconf(_SC_PAGESIZE));
+        pos -= offset;
+        size += offset;
+        return true;
+    }
 };
 
 inline auto page_size() noexcept -> off_t {
@@ -735,24 +840,123 @@ inline auto stop(id_t pid) noexcept {
     return !kill(pid, SIGTERM);
 }
 
-inline auto spawn(const std::string& path, char *const *argv) {
-    const id_t child = fork();
-    if(!child) {
-        // FlawFinder: ignore
-        execvp(path.c_str(), argv);
-        ::_exit(-1);
+// Children are started with posix_spawn, which uses vfork or clone where
+// the platform has them, so launch cost does not grow with our own heap.
+enum : unsigned {
+    pipe_input = 0x01,
+    pipe_output = 0x02,
+    pipe_error = 0x04,
+    merge_error = 0x08,     // stderr to the output pipe
+    new_session = 0x10,
+};
+
+// A launched child, with the parent ends of any pipes or -1 if not piped
+struct child_t final {
+    id_t pid{-1};
+    handle_t input{-1}, output{-1}, error{-1};
+    int err{0};
+
+    explicit operator bool() const noexcept {
+        return pid > 0;
     }
-    return wait(child);
+
+    auto operator!() const noexcept {
+        return pid < 1;
+    }
+
+    void close() noexcept {
+        for(auto fd : {&input, &output, &error}) {
+            if(*fd > -1)
+                ::close(*fd);
+            *fd = -1;
+        }
+    }
+};
+
+inline auto make_pipe(handle_t fds[2]) noexcept {
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if(::pipe(fds))
+        return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
 }
 
-inline auto spawn(const std::string& path, char *const *argv, char *const *env) {
-    const id_t child = fork();
-    if(!child) {
-        // FlawFinder: ignore
-        execvpe(path.c_str(), argv, env);
-        ::_exit(-1);
+// path is searched like execvp, no shell is involved, and env defaults to
+// our own environment
+inline auto launch(const std::string& path, char *const *argv, char *const *env = nullptr, unsigned flags = 0) noexcept -> child_t {
+    child_t child;
+    handle_t fds[3][2] = {{-1, -1}, {-1, -1}, {-1, -1}};
+    const unsigned wanted[3] = {pipe_input, pipe_output, pipe_error};
+    const auto cleanup = [&fds] {
+        for(auto& pair : fds) {
+            for(auto fd : pair) {
+                if(fd > -1)
+                    ::close(fd);
+            }
+        }
+    };
+
+    for(auto pos = 0U; pos < 3U; ++pos) {
+        if((flags & wanted[pos]) && !make_pipe(fds[pos])) {
+            child.err = errno;
+            cleanup();
+            return child;
+        }
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+    if(fds[0][0] > -1)
+        posix_spawn_file_actions_adddup2(&actions, fds[0][0], 0);
+    if(fds[1][1] > -1)
+        posix_spawn_file_actions_adddup2(&actions, fds[1][1], 1);
+    if(fds[2][1] > -1)
+        posix_spawn_file_actions_adddup2(&actions, fds[2][1], 2);
+    else if((flags & merge_error) && fds[1][1] > -1)
+        posix_spawn_file_actions_adddup2(&actions, fds[1][1], 2);
+
+    if(flags & new_session) {
+#if defined(POSIX_SPAWN_SETSID)
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#else
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+#endif
     }
-    return wait(child);
+
+    pid_t pid{-1};
+    // FlawFinder: ignore
+    child.err = posix_spawnp(&pid, path.c_str(), &actions, &attr, argv, env ? env : environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if(child.err) {
+        cleanup();
+        return child;
+    }
+
+    child.pid = pid;
+    child.input = fds[0][1];
+    child.output = fds[1][0];
+    child.error = fds[2][0];
+    fds[0][1] = fds[1][0] = fds[2][0] = -1;
+    cleanup();
+    return child;
+}
+
+inline auto spawn(const std::string& path, char *const *argv) {
+    const auto child = launch(path, argv);
+    return child ? wait(child.pid) : -1;
+}
+
+inline auto spawn(const std::string& path, char *const *argv, char *const *env) {
+    const auto child = launch(path, argv, env);
+    return child ? wait(child.pid) : -1;
 }
 
 inline auto exec(const std::string& path, char *const *argv) {
@@ -766,26 +970,17 @@ inline auto exec(const std::string& path, char *const *argv, char *const *env) {
 }
 
 inline auto async(const std::string& path, char *const *argv) -> id_t {
-    const id_t child = fork();
-    if(!child) {
-        // FlawFinder: ignore
-        execvp(path.c_str(), argv);
-        ::_exit(-1);
-    }
-    return child;
+    return launch(path, argv).pid;
 }
 
 inline auto async(const std::string& path, char *const *argv, char *const *env) -> id_t {
-    const id_t child = fork();
-    if(!child) {
-        // FlawFinder: ignore
-        execvpe(path.c_str(), argv, env);
-        ::_exit(-1);
-    }
-    return child;
+    return launch(path, argv, env).pid;
 }
 
 inline auto detach(const std::string& path, char *const *argv) -> id_t {
+#if defined(POSIX_SPAWN_SETSID)
+    return launch(path, argv, nullptr, new_session).pid;
+#else
     const id_t child = fork();
     if(!child) {
 #if defined(SIGTSTP) && defined(TIOCNOTTY)
@@ -819,9 +1014,13 @@ inline auto detach(const std::string& path, char *const *argv) -> id_t {
         ::_exit(-1);
     }
     return child;
+#endif
 }
 
 inline auto detach(const std::string& path, char *const *argv, char *const *env) -> id_t {
+#if defined(POSIX_SPAWN_SETSID)
+    return launch(path, argv, env, new_session).pid;
+#else
     const id_t child = fork();
     if(!child) {
 #if defined(SIGTSTP) && defined(TIOCNOTTY)
@@ -856,6 +1055,7 @@ inline auto detach(const std::string& path, char *const *argv, char *const *env)
         ::_exit(-1);
     }
     return child;
+#endif
 }
 
 inline auto id() noexcept -> id_t {
@@ -942,6 +1142,157 @@ inline auto send_fifo(std::string id, const T& data) noexcept {
     close(fd);
     return result;
 }
+
+// Named shared memory ring of trivially copyable messages from any number
+// of sender processes to one receiver, which creates and owns the name.
+// Messages only pass through ring slots while the receiver is busy, and
+// an idle receiver sleeps on a shared futex that senders wake only when
+// it is waiting, so steady traffic makes no system calls.
+template<typename T, std::size_t S = 1024>
+class channel_t final {
+public:
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>, "T must be trivially copyable");
+
+    explicit channel_t(const std::string& id, bool receiver = false) noexcept : name_(shm_name(id)), receiver_(receiver) {
+        const auto fd = shm_open(name_.c_str(), receiver ? O_RDWR | O_CREAT : O_RDWR, 0660);
+        if(fd < 0)
+            return;
+        if(receiver && ::ftruncate(fd, off_t(sizeof(shared_t)))) {
+            ::close(fd);
+            return;
+        }
+        struct stat ino{};
+        if(fstat(fd, &ino) || std::size_t(ino.st_size) < sizeof(shared_t)) {
+            ::close(fd);
+            return;
+        }
+        map_.set(fd, sizeof(shared_t));
+        ::close(fd);
+        if(!map_)
+            return;
+        if(receiver) {
+            shared_ = ::new(map_.data()) shared_t();
+            shared_->magic.store(magic(), std::memory_order_release);
+        }
+        else {
+            auto shared = static_cast<shared_t *>(map_.data());
+            if(shared->magic.load(std::memory_order_acquire) == magic())
+                shared_ = shared;
+        }
+    }
+
+    channel_t(const channel_t&) = delete;
+    auto operator=(const channel_t&) -> auto& = delete;
+
+    ~channel_t() {
+        if(receiver_ && shared_) {
+            shared_->magic.store(0, std::memory_order_release);
+            shm_unlink(name_.c_str());
+        }
+    }
+
+    explicit operator bool() const noexcept {
+        return shared_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return shared_ == nullptr;
+    }
+
+    // false if the ring is full or the receiver has gone
+    auto send(const T& data) noexcept {
+        if(!shared_ || shared_->magic.load(std::memory_order_relaxed) != magic() || !shared_->ring.push(data))
+            return false;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(shared_->sleeping.exchange(0)) {
+            shared_->signal.fetch_add(1);
+            wake(shared_->signal);
+        }
+        return true;
+    }
+
+    // timeout in milliseconds, negative waits until a message arrives
+    auto receive(T& data, int timeout = -1) noexcept {
+        if(!shared_)
+            return false;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout < 0 ? 0 : timeout);
+        for(;;) {
+            if(shared_->ring.pull(data))
+                return true;
+            const auto now = std::chrono::steady_clock::now();
+            if(timeout >= 0 && now >= until)
+                return false;
+            const auto signal = shared_->signal.load();
+            shared_->sleeping.store(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(!shared_->ring.empty()) {
+                shared_->sleeping.store(0);
+                continue;
+            }
+            park(shared_->signal, signal, timeout < 0 ? -1 : std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count());
+        }
+    }
+
+    auto size() const noexcept {
+        return shared_ ? shared_->ring.size() : std::size_t(0);
+    }
+
+private:
+    struct shared_t final {
+        std::atomic<uint64_t> magic{0};
+        std::atomic<uint32_t> sleeping{0}, signal{0};
+        atomics::ring_t<T, S> ring;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<std::size_t>::is_always_lock_free, "Shared atomics must be lock-free");
+
+    map_t map_;
+    shared_t *shared_{nullptr};
+    std::string name_;
+    bool receiver_{false};
+
+    // tells apart channels of other message layouts under one name
+    static constexpr auto magic() noexcept -> uint64_t {
+        return 0x5459434800000000ULL ^ (uint64_t(sizeof(T)) << 16) ^ uint64_t(S);
+    }
+
+    static auto shm_name(std::string id) {
+        if(!id.empty() && id[0] == '/')
+            id = id.substr(1);
+        std::replace(id.begin(), id.end(), '/', '-');
+        return "/" + id + ".channel";
+    }
+
+    static void park(std::atomic<uint32_t>& word, uint32_t expected, long long msecs) noexcept {
+#if defined(__linux__)
+        struct timespec ts{};
+        ts.tv_sec = time_t(msecs / 1000);
+        ts.tv_nsec = long(msecs % 1000) * 1000000L;
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, msecs < 0 ? nullptr : &ts, nullptr, 0);
+#else
+        if(word.load() == expected)
+            std::this_thread::sleep_for(std::chrono::milliseconds(msecs < 0 || msecs > 1 ? 1 : msecs));
+#endif
+    }
+
+    static void wake(std::atomic<uint32_t>& word) noexcept {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)word;
+#endif
+    }
+};
+
+template<typename T, std::size_t S = 1024>
+inline void make_channel(const std::string& id, std::function<bool(T&)> cmd) noexcept {
+    channel_t<T, S> channel(id, true);
+    if(!channel)
+        return;
+
+    T buf{};
+    while(channel.receive(buf) && cmd(buf)) {}
+}
 #endif
 
 [[noreturn]] inline auto exit(int code) {
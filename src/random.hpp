@@ -12,8 +12,15 @@
 #include <utility>
 #include <cstring>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <openssl/rand.h>
 
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+#include <pthread.h>
+#define USE_ATFORK
+#endif
+
 namespace tycho::crypto {
 using key_t = std::pair<const uint8_t *, std::size_t>;
 
@@ -27,16 +34,81 @@ inline constexpr auto sha512_key = 512UL;
 inline constexpr auto aes128_key = 128UL;
 inline constexpr auto aes256_key = 256UL;
 
+// Per-thread block of csprng output so small requests are a copy rather
+// than a call into the rng. Served bytes are wiped from the block, large
+// requests bypass it, and a fork discards the blocks a child inherits.
+class rand_buffer final {
+public:
+    static constexpr std::size_t block = 4096;
+    static constexpr std::size_t direct = 256;
+
+    rand_buffer(const rand_buffer&) = delete;
+    auto operator=(const rand_buffer&) -> auto& = delete;
+
+    ~rand_buffer() {
+        memset(data_, 0, sizeof(data_));
+    }
+
+    static auto local() noexcept -> rand_buffer& {
+        thread_local rand_buffer buffer;
+        return buffer;
+    }
+
+    auto fill(uint8_t *to, std::size_t size) noexcept {
+        if(size >= direct)
+            return ::RAND_bytes(to, int(size)) == 1;
+        const auto forks = generation().load(std::memory_order_relaxed);
+        if(forks != forks_ || block - pos_ < size) {
+            if(::RAND_bytes(data_, int(block)) != 1)
+                return false;
+            pos_ = 0;
+            forks_ = forks;
+        }
+        memcpy(to, data_ + pos_, size);         // FlawFinder: ignore
+        memset(data_ + pos_, 0, size);
+        pos_ += size;
+        return true;
+    }
+
+    // drop buffered output, as after a reseed of the system generator
+    void discard() noexcept {
+        memset(data_, 0, sizeof(data_));
+        pos_ = block;
+    }
+
+private:
+    uint8_t data_[block]{0};
+    std::size_t pos_{block};
+    unsigned forks_{0};
+
+    rand_buffer() noexcept {
+#ifdef USE_ATFORK
+        static std::once_flag once;
+        std::call_once(once, [] {
+            pthread_atfork(nullptr, nullptr, [] {
+                generation().fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+#endif
+        forks_ = generation().load(std::memory_order_relaxed);
+    }
+
+    static auto generation() noexcept -> std::atomic<unsigned>& {
+        static std::atomic<unsigned> forks{0};
+        return forks;
+    }
+};
+
 template <typename T>
-inline void rand(T& data) {
+inline auto rand(T& data) {
     static_assert(std::is_trivial_v<T>, "T must be Trivial type");
 
     auto ptr = reinterpret_cast<uint8_t *>(&data);
-    ::RAND_bytes(ptr, int(sizeof(data)));
+    return rand_buffer::local().fill(ptr, sizeof(data));
 }
 
-inline void rand(uint8_t *ptr, std::size_t size) {
-    ::RAND_bytes(ptr, int(size));
+inline auto rand(uint8_t *ptr, std::size_t size) {
+    return rand_buffer::local().fill(ptr, size);
 }
 
 template <typename T>
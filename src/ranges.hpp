@@ -7,6 +7,13 @@
 #include <algorithm>
 #include <iterator>
 #include <numeric>
+#include <type_traits>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 namespace tycho::ranges {
 template<typename Predicate>
@@ -52,7 +59,7 @@ auto copy(const Container& container, std::size_t pos, std::size_t count) {
         return result;
     if(pos + count >= container.size())
         count = container.size() - pos;
-    std::copy_n(std::advance(container.begin(), pos), count, std::back_inserter(result));
+    std::copy_n(std::next(container.begin(), std::ptrdiff_t(pos)), count, std::back_inserter(result));
     return result;
 }
 
@@ -114,5 +121,590 @@ template<typename Container, typename Range>
 auto operator|(const Container& container, const Range& range) {
     return range(container);
 }
+
+// Lazy views hold a reference to the container they start from, which
+// must outlive the pipeline, and produce elements only as iterated.
+struct view_base {};
+
+template<typename Range>
+using view_iter_t = decltype(std::declval<const Range&>().begin());
+
+template<typename Range>
+using view_ref_t = decltype(*std::declval<view_iter_t<Range>&>());
+
+template<typename Range, typename = void>
+struct has_size : std::false_type {};
+
+template<typename Range>
+struct has_size<Range, std::void_t<decltype(std::declval<const Range&>().size())>> : std::true_type {};
+
+template<typename Container, typename = void>
+struct has_reserve : std::false_type {};
+
+template<typename Container>
+struct has_reserve<Container, std::void_t<decltype(std::declval<Container&>().reserve(std::size_t(0)))>> : std::true_type {};
+
+template<typename Container>
+class ref_view : public view_base {
+public:
+    explicit ref_view(const Container& container) noexcept : container_(&container) {}
+
+    auto begin() const {
+        return container_->begin();
+    }
+
+    auto end() const {
+        return container_->end();
+    }
+
+    auto size() const -> decltype(std::declval<const Container&>().size()) {
+        return container_->size();
+    }
+
+private:
+    const Container *container_;
+};
+
+template<typename Range>
+auto as_view(const Range& range) {
+    if constexpr(std::is_base_of_v<view_base, Range>)
+        return range;
+    else
+        return ref_view<Range>(range);
+}
+
+template<typename Range, typename Predicate>
+class filter_view : public view_base {
+public:
+    using base_t = view_iter_t<Range>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using reference = view_ref_t<Range>;
+        using value_type = std::decay_t<reference>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(base_t it, base_t end, const Predicate *pred) : it_(it), end_(end), pred_(pred) {
+            skip();
+        }
+
+        auto operator*() const -> reference {
+            return *it_;
+        }
+
+        auto operator++() -> iterator& {
+            ++it_;
+            skip();
+            return *this;
+        }
+
+        auto operator++(int) -> iterator {
+            auto prior = *this;
+            ++*this;
+            return prior;
+        }
+
+        auto operator==(const iterator& other) const {
+            return it_ == other.it_;
+        }
+
+        auto operator!=(const iterator& other) const {
+            return it_ != other.it_;
+        }
+
+    private:
+        base_t it_{}, end_{};
+        const Predicate *pred_{nullptr};
+
+        void skip() {
+            while(it_ != end_ && !std::invoke(*pred_, *it_))
+                ++it_;
+        }
+    };
+
+    filter_view(Range range, Predicate pred) : range_(std::move(range)), pred_(std::move(pred)) {}
+
+    auto begin() const {
+        return iterator(range_.begin(), range_.end(), &pred_);
+    }
+
+    auto end() const {
+        return iterator(range_.end(), range_.end(), &pred_);
+    }
+
+private:
+    Range range_;
+    Predicate pred_;
+};
+
+template<typename Range, typename Func>
+class transform_view : public view_base {
+public:
+    using base_t = view_iter_t<Range>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using reference = std::invoke_result_t<const Func&, view_ref_t<Range>>;
+        using value_type = std::decay_t<reference>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(base_t it, const Func *func) : it_(it), func_(func) {}
+
+        auto operator*() const -> reference {
+            return std::invoke(*func_, *it_);
+        }
+
+        auto operator++() -> iterator& {
+            ++it_;
+            return *this;
+        }
+
+        auto operator++(int) -> iterator {
+            auto prior = *this;
+            ++it_;
+            return prior;
+        }
+
+        auto operator==(const iterator& other) const {
+            return it_ == other.it_;
+        }
+
+        auto operator!=(const iterator& other) const {
+            return it_ != other.it_;
+        }
+
+    private:
+        base_t it_{};
+        const Func *func_{nullptr};
+    };
+
+    transform_view(Range range, Func func) : range_(std::move(range)), func_(std::move(func)) {}
+
+    auto begin() const {
+        return iterator(range_.begin(), &func_);
+    }
+
+    auto end() const {
+        return iterator(range_.end(), &func_);
+    }
+
+    template<typename R = Range, std::enable_if_t<has_size<R>::value, int> = 0>
+    auto size() const {
+        return range_.size();
+    }
+
+private:
+    Range range_;
+    Func func_;
+};
+
+template<typename Range>
+class take_view : public view_base {
+public:
+    using base_t = view_iter_t<Range>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using reference = view_ref_t<Range>;
+        using value_type = std::decay_t<reference>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(base_t it, std::size_t left) : it_(it), left_(left) {}
+
+        auto operator*() const -> reference {
+            return *it_;
+        }
+
+        auto operator++() -> iterator& {
+            ++it_;
+            --left_;
+            return *this;
+        }
+
+        auto operator++(int) -> iterator {
+            auto prior = *this;
+            ++*this;
+            return prior;
+        }
+
+        // either running out of count or of the range ends the view
+        auto operator==(const iterator& other) const {
+            return left_ == other.left_ || it_ == other.it_;
+        }
+
+        auto operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        base_t it_{};
+        std::size_t left_{0};
+    };
+
+    take_view(Range range, std::size_t count) : range_(std::move(range)), count_(count) {}
+
+    auto begin() const {
+        return iterator(range_.begin(), count_);
+    }
+
+    auto end() const {
+        return iterator(range_.end(), 0);
+    }
+
+    template<typename R = Range, std::enable_if_t<has_size<R>::value, int> = 0>
+    auto size() const {
+        return std::min(std::size_t(range_.size()), count_);
+    }
+
+private:
+    Range range_;
+    std::size_t count_;
+};
+
+template<typename Range>
+class drop_view : public view_base {
+public:
+    drop_view(Range range, std::size_t count) : range_(std::move(range)), count_(count) {}
+
+    auto begin() const {
+        auto it = range_.begin();
+        const auto end = range_.end();
+        for(std::size_t count = 0; count < count_ && it != end; ++count)
+            ++it;
+        return it;
+    }
+
+    auto end() const {
+        return range_.end();
+    }
+
+    template<typename R = Range, std::enable_if_t<has_size<R>::value, int> = 0>
+    auto size() const {
+        const auto size = std::size_t(range_.size());
+        return size > count_ ? size - count_ : std::size_t(0);
+    }
+
+private:
+    Range range_;
+    std::size_t count_;
+};
+
+template<typename First, typename Second>
+class join_view : public view_base {
+public:
+    using first_t = view_iter_t<First>;
+    using second_t = view_iter_t<Second>;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::common_type_t<std::decay_t<view_ref_t<First>>, std::decay_t<view_ref_t<Second>>>;
+        using reference = value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(first_t first, first_t last, second_t second) : first_(first), last_(last), second_(second) {}
+
+        auto operator*() const -> reference {
+            if(first_ != last_)
+                return *first_;
+            return *second_;
+        }
+
+        auto operator++() -> iterator& {
+            if(first_ != last_)
+                ++first_;
+            else
+                ++second_;
+            return *this;
+        }
+
+        auto operator++(int) -> iterator {
+            auto prior = *this;
+            ++*this;
+            return prior;
+        }
+
+        auto operator==(const iterator& other) const {
+            return first_ == other.first_ && second_ == other.second_;
+        }
+
+        auto operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        first_t first_{}, last_{};
+        second_t second_{};
+    };
+
+    join_view(First first, Second second) : first_(std::move(first)), second_(std::move(second)) {}
+
+    auto begin() const {
+        return iterator(first_.begin(), first_.end(), second_.begin());
+    }
+
+    auto end() const {
+        return iterator(first_.end(), first_.end(), second_.end());
+    }
+
+    template<typename F = First, typename S = Second, std::enable_if_t<has_size<F>::value && has_size<S>::value, int> = 0>
+    auto size() const {
+        return std::size_t(first_.size()) + std::size_t(second_.size());
+    }
+
+private:
+    First first_;
+    Second second_;
+};
+
+template<typename Predicate>
+class filter_adaptor {
+public:
+    explicit filter_adaptor(Predicate pred) : pred_(std::move(pred)) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        return filter_view<decltype(as_view(range)), Predicate>(as_view(range), pred_);
+    }
+
+private:
+    Predicate pred_;
+};
+
+template<typename Func>
+class transform_adaptor {
+public:
+    explicit transform_adaptor(Func func) : func_(std::move(func)) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        return transform_view<decltype(as_view(range)), Func>(as_view(range), func_);
+    }
+
+private:
+    Func func_;
+};
+
+class take_adaptor {
+public:
+    explicit take_adaptor(std::size_t count) noexcept : count_(count) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        return take_view<decltype(as_view(range))>(as_view(range), count_);
+    }
+
+private:
+    std::size_t count_;
+};
+
+class drop_adaptor {
+public:
+    explicit drop_adaptor(std::size_t count) noexcept : count_(count) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        return drop_view<decltype(as_view(range))>(as_view(range), count_);
+    }
+
+private:
+    std::size_t count_;
+};
+
+class slice_adaptor {
+public:
+    slice_adaptor(std::size_t pos, std::size_t count) noexcept : pos_(pos), count_(count) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        using drop_t = drop_view<decltype(as_view(range))>;
+        return take_view<drop_t>(drop_t(as_view(range), pos_), count_);
+    }
+
+private:
+    std::size_t pos_, count_;
+};
+
+template<typename Second>
+class join_adaptor {
+public:
+    explicit join_adaptor(const Second& second) : second_(as_view(second)) {}
+
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        return join_view<decltype(as_view(range)), decltype(as_view(std::declval<const Second&>()))>(as_view(range), second_);
+    }
+
+private:
+    decltype(as_view(std::declval<const Second&>())) second_;
+};
+
+// terminal stage, reserving once when the view size is known
+template<typename Container = void>
+class collect {
+public:
+    template<typename Range>
+    auto operator()(const Range& range) const {
+        using result_t = std::conditional_t<std::is_void_v<Container>, std::vector<std::decay_t<view_ref_t<Range>>>, Container>;
+        result_t result{};
+        if constexpr(has_size<Range>::value && has_reserve<result_t>::value)
+            result.reserve(std::size_t(range.size()));
+        for(auto it = range.begin(); it != range.end(); ++it)
+            result.insert(result.end(), *it);
+        return result;
+    }
+};
+
+namespace views {
+template<typename Predicate>
+auto filter(Predicate pred) {
+    return filter_adaptor<Predicate>(std::move(pred));
+}
+
+template<typename Func>
+auto transform(Func func) {
+    return transform_adaptor<Func>(std::move(func));
+}
+
+inline auto take(std::size_t count) {
+    return take_adaptor(count);
+}
+
+inline auto drop(std::size_t count) {
+    return drop_adaptor(count);
+}
+
+inline auto slice(std::size_t pos, std::size_t count) {
+    return slice_adaptor(pos, count);
+}
+
+template<typename Second>
+auto join(const Second& second) {
+    return join_adaptor<Second>(second);
+}
+
+template<typename Range>
+auto all(const Range& range) {
+    return as_view(range);
+}
+} // end namespace
+
+// Parallel stages split a random access range into contiguous chunks
+// given to an executor with a dispatch member, such as task_pool. The
+// caller runs the last chunk and waits, so it must not be one of the
+// executor's own workers. Refused dispatches are run inline.
+class chunk_group final {
+public:
+    explicit chunk_group(std::size_t count) noexcept : pending_(count) {}
+    chunk_group(const chunk_group&) = delete;
+    auto operator=(const chunk_group&) -> auto& = delete;
+
+    template<typename Func>
+    void run(Func& func, std::size_t chunk) noexcept {
+        try {
+            func(chunk);
+        }
+        catch(...) {
+            const std::lock_guard lock(lock_);
+            if(!error_)
+                error_ = std::current_exception();
+        }
+        const std::lock_guard lock(lock_);
+        if(--pending_ == 0)
+            done_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock lock(lock_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        if(error_)
+            std::rethrow_exception(error_);
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable done_;
+    std::size_t pending_;
+    std::exception_ptr error_;
+};
+
+template<typename Executor, typename Func>
+void parallel_chunks(Executor& exec, std::size_t chunks, Func func) {
+    if(chunks < 2) {
+        if(chunks)
+            func(std::size_t(0));
+        return;
+    }
+
+    chunk_group group(chunks);
+    for(std::size_t chunk = 0; chunk + 1 < chunks; ++chunk) {
+        if(!exec.dispatch([&group, &func, chunk] { group.run(func, chunk); }))
+            group.run(func, chunk);
+    }
+    group.run(func, chunks - 1);
+    group.wait();
+}
+
+inline auto parallel_count(std::size_t size, std::size_t chunks) noexcept {
+    if(!chunks)
+        chunks = std::max(1U, std::thread::hardware_concurrency());
+    return std::min(size, chunks);
+}
+
+template<typename Executor, typename Container, typename Func>
+void parallel_each(Executor& exec, Container& container, Func func, std::size_t chunks = 0) {
+    const auto size = std::size_t(std::distance(container.begin(), container.end()));
+    chunks = parallel_count(size, chunks);
+    parallel_chunks(exec, chunks, [&](std::size_t chunk) {
+        auto it = container.begin() + std::ptrdiff_t(size * chunk / chunks);
+        const auto last = container.begin() + std::ptrdiff_t(size * (chunk + 1) / chunks);
+        for(; it != last; ++it)
+            func(*it);
+    });
+}
+
+// each chunk folds its elements into a copy of identity with func, and
+// init is then combined with the partials in range order. identity must
+// leave combine unchanged, and combine must be associative.
+template<typename Executor, typename Container, typename T, typename Func, typename Combine>
+auto parallel_fold(Executor& exec, const Container& container, T init, Func func, Combine combine, std::size_t chunks = 0, const T& identity = T{}) -> T {
+    const auto size = std::size_t(std::distance(container.begin(), container.end()));
+    chunks = parallel_count(size, chunks);
+    std::vector<T> partials(chunks, identity);
+    parallel_chunks(exec, chunks, [&](std::size_t chunk) {
+        auto it = container.begin() + std::ptrdiff_t(size * chunk / chunks);
+        const auto last = container.begin() + std::ptrdiff_t(size * (chunk + 1) / chunks);
+        auto& partial = partials[chunk];
+        for(; it != last; ++it)
+            partial = func(std::move(partial), *it);
+    });
+    for(auto& partial : partials)
+        init = combine(std::move(init), std::move(partial));
+    return init;
+}
+
+template<typename Executor, typename Container, typename T, typename Func>
+auto parallel_fold(Executor& exec, const Container& container, T init, Func func) -> T {
+    return parallel_fold(exec, container, std::move(init), func, func);
+}
+
+// unlike make, func is called for each element
+template<typename Container, typename Executor, typename Func>
+auto parallel_make(Executor& exec, std::size_t size, Func func, std::size_t chunks = 0) {
+    Container result(size);
+    parallel_each(exec, result, [&func](auto& item) { item = func(); }, chunks);
+    return result;
+}
 } // end namespace
 #endif
@@ -0,0 +1,440 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_REACTOR_HPP_
+#define TYCHO_REACTOR_HPP_
+
+#include "socket.hpp"
+#include "hashmap.hpp"
+
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <system_error>
+#include <type_traits>
+#include <cerrno>
+
+#if defined(__linux__)
+#define USE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define USE_KQUEUE
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace tycho {
+// Readiness event loop for many descriptors. Handlers run on the thread
+// that waits, or are posted to an executor such as a task_queue or pool.
+// Uses epoll on Linux, kqueue on BSD and macOS, and poll elsewhere. Any
+// thread may add, modify, remove, or stop, but ready events are gathered
+// into one shared list, so only one thread at a time may wait or run.
+class reactor final {
+public:
+    using handler_t = std::function<void(int, unsigned)>;
+
+    static constexpr unsigned readable = 0x01;
+    static constexpr unsigned writable = 0x02;
+    static constexpr unsigned hangup = 0x04;
+    static constexpr unsigned failed = 0x08;
+
+    reactor() {
+#if defined(USE_EPOLL)
+        queue_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_[0] = wake_[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(queue_ == -1 || wake_[0] == -1)
+            fail();
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wake_[0];
+        epoll_ctl(queue_, EPOLL_CTL_ADD, wake_[0], &event);
+#elif defined(USE_KQUEUE)
+        queue_ = kqueue();
+        if(queue_ == -1 || ::pipe(wake_) == -1)
+            fail();
+        nonblocking(wake_[0]);
+        nonblocking(wake_[1]);
+        struct kevent change{};
+        EV_SET(&change, wake_[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+        kevent(queue_, &change, 1, nullptr, 0, nullptr);
+#elif !defined(USE_CLOSESOCKET)
+        if(::pipe(wake_) == -1)
+            fail();
+        nonblocking(wake_[0]);
+        nonblocking(wake_[1]);
+#endif
+    }
+
+    reactor(const reactor&) = delete;
+    auto operator=(const reactor&) -> auto& = delete;
+
+    ~reactor() {
+        if(queue_ != -1)
+            release(queue_);
+        if(wake_[0] != -1)
+            release(wake_[0]);
+        if(wake_[1] != -1 && wake_[1] != wake_[0])
+            release(wake_[1]);
+    }
+
+    // oneshot disarms after each event until modify re-arms it
+    auto add(int fd, unsigned events, handler_t handler, bool oneshot = false) -> bool {
+        if(fd < 0 || !handler)
+            return false;
+
+        const std::lock_guard lock(lock_);
+        if(entries_.contains(fd))
+            return false;
+        if(!control(fd, events, oneshot, true))
+            return false;
+        entries_.try_emplace(fd, std::make_shared<entry_t>(entry_t{std::move(handler), events, oneshot}));
+        changed();
+        return true;
+    }
+
+    auto add(const Socket& sock, unsigned events, handler_t handler, bool oneshot = false) {
+        return add(int(*sock), events, std::move(handler), oneshot);
+    }
+
+    auto modify(int fd, unsigned events) -> bool {
+        const std::lock_guard lock(lock_);
+        auto it = entries_.find(fd);
+        if(it == entries_.end() || !control(fd, events, it->second->oneshot, false))
+            return false;
+        it->second->events = events;
+        changed();
+        return true;
+    }
+
+    auto modify(const Socket& sock, unsigned events) {
+        return modify(int(*sock), events);
+    }
+
+    // handlers already handed to an executor may still run once
+    auto remove(int fd) -> bool {
+        const std::lock_guard lock(lock_);
+        if(!entries_.erase(fd))
+            return false;
+#if defined(USE_EPOLL)
+        epoll_ctl(queue_, EPOLL_CTL_DEL, fd, nullptr);
+#elif defined(USE_KQUEUE)
+        struct kevent changes[2]{};
+        EV_SET(&changes[0], fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+        EV_SET(&changes[1], fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+        for(auto& change : changes)
+            kevent(queue_, &change, 1, nullptr, 0, nullptr);
+#endif
+        changed();
+        return true;
+    }
+
+    auto remove(const Socket& sock) {
+        return remove(int(*sock));
+    }
+
+    auto contains(int fd) const {
+        const std::lock_guard lock(lock_);
+        return entries_.contains(fd);
+    }
+
+    auto size() const {
+        const std::lock_guard lock(lock_);
+        return entries_.size();
+    }
+
+    // wait once and call handlers inline, returns how many fired; only one
+    // thread may wait at a time, since ready events share one buffer
+    auto wait(int timeout = -1) -> std::size_t {
+        return fire(timeout, [](std::shared_ptr<entry_t>&& entry, int fd, unsigned events) {
+            entry->handler(fd, events);
+        });
+    }
+
+    // wait once and post each handler to exec.dispatch, which shares the
+    // entry rather than copying its handler
+    template<typename Exec, std::enable_if_t<!std::is_arithmetic_v<Exec>, int> = 0>
+    auto wait(Exec& exec, int timeout = -1) -> std::size_t {
+        return fire(timeout, [&exec](std::shared_ptr<entry_t>&& entry, int fd, unsigned events) {
+            exec.dispatch([entry = std::move(entry), fd, events] {
+                entry->handler(fd, events);
+            });
+        });
+    }
+
+    void run() {
+        stop_ = false;
+        while(!stop_)
+            wait(slice());
+    }
+
+    template<typename Exec>
+    void run(Exec& exec) {
+        stop_ = false;
+        while(!stop_)
+            wait(exec, slice());
+    }
+
+    // may be called from any thread, including a handler
+    void stop() noexcept {
+        stop_ = true;
+        notify();
+    }
+
+    auto stopped() const noexcept {
+        return stop_.load();
+    }
+
+private:
+    struct entry_t final {
+        handler_t handler;
+        unsigned events{0};
+        bool oneshot{false};
+    };
+
+    mutable std::mutex lock_;
+    flat_map<int, std::shared_ptr<entry_t>> entries_;
+    std::vector<std::pair<int, unsigned>> ready_; // owned by the one waiter
+    std::atomic<bool> stop_{false};
+    int queue_{-1};
+    int wake_[2]{-1, -1};
+#if !defined(USE_EPOLL) && !defined(USE_KQUEUE)
+    std::vector<struct pollfd> fds_;
+    bool dirty_{true};
+#endif
+
+    [[noreturn]] static void fail() {
+        throw std::system_error(errno, std::generic_category(), "Reactor cannot create event queue");
+    }
+
+    static void nonblocking(int fd) noexcept {
+#if defined(USE_CLOSESOCKET)
+        u_long opt = 1;
+        ioctlsocket(SOCKET(fd), FIONBIO, &opt);
+#else
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+    }
+
+    static void release(int fd) noexcept {
+#if defined(USE_CLOSESOCKET)
+        ::closesocket(SOCKET(fd));
+#else
+        ::close(fd);
+#endif
+    }
+
+    // without a wake descriptor, bound waits so stop and changes are seen
+    auto slice() const noexcept -> int {
+        return wake_[0] == -1 ? 100 : -1;
+    }
+
+    void notify() const noexcept {
+        if(wake_[1] == -1)
+            return;
+#if defined(USE_CLOSESOCKET)
+        return;
+#elif defined(USE_EPOLL)
+        const uint64_t one = 1;
+        [[maybe_unused]] auto result = ::write(wake_[1], &one, sizeof(one));
+#else
+        const char one = 1;
+        [[maybe_unused]] auto result = ::write(wake_[1], &one, sizeof(one));
+#endif
+    }
+
+    void drain() const noexcept {
+#if !defined(USE_CLOSESOCKET)
+        uint64_t buf[8];
+        while(::read(wake_[0], buf, sizeof(buf)) > 0) {}
+#endif
+    }
+
+    void changed() noexcept {
+#if !defined(USE_EPOLL) && !defined(USE_KQUEUE)
+        dirty_ = true;
+        notify();
+#endif
+    }
+
+    auto control(int fd, unsigned events, bool oneshot, bool adding) -> bool {
+#if defined(USE_EPOLL)
+        struct epoll_event event{};
+        event.data.fd = fd;
+        if(events & readable)
+            event.events |= EPOLLIN | EPOLLRDHUP;
+        if(events & writable)
+            event.events |= EPOLLOUT;
+        if(oneshot)
+            event.events |= EPOLLONESHOT;
+        return epoll_ctl(queue_, adding ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == 0;
+#elif defined(USE_KQUEUE)
+        const unsigned short flags = EV_ADD | EV_ENABLE | (oneshot ? EV_ONESHOT : 0);
+        struct kevent change{};
+        auto result = true;
+        if(events & readable) {
+            EV_SET(&change, fd, EVFILT_READ, flags, 0, 0, nullptr);
+            result = kevent(queue_, &change, 1, nullptr, 0, nullptr) == 0;
+        }
+        else if(!adding) {
+            EV_SET(&change, fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+            kevent(queue_, &change, 1, nullptr, 0, nullptr);
+        }
+        if(events & writable) {
+            EV_SET(&change, fd, EVFILT_WRITE, flags, 0, 0, nullptr);
+            result = result && kevent(queue_, &change, 1, nullptr, 0, nullptr) == 0;
+        }
+        else if(!adding) {
+            EV_SET(&change, fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+            kevent(queue_, &change, 1, nullptr, 0, nullptr);
+        }
+        return result;
+#else
+        static_cast<void>(fd);
+        static_cast<void>(events);
+        static_cast<void>(oneshot);
+        static_cast<void>(adding);
+        return true;
+#endif
+    }
+
+#if !defined(USE_EPOLL) && !defined(USE_KQUEUE)
+    // windows pollfd holds a SOCKET, so fill fields rather than brace init
+    void watch(int fd, short events) {
+        struct pollfd pfd{};
+        pfd.fd = decltype(pfd.fd)(fd);
+        pfd.events = events;
+        fds_.push_back(pfd);
+    }
+#endif
+
+    // gather ready descriptors into ready_, the wake descriptor excluded
+    void collect(int timeout) {
+        ready_.clear();
+#if defined(USE_EPOLL)
+        struct epoll_event events[64];
+        auto count = epoll_wait(queue_, events, 64, timeout);
+        for(auto index = 0; index < count; ++index) {
+            const auto fd = events[index].data.fd;
+            if(fd == wake_[0]) {
+                drain();
+                continue;
+            }
+            const auto flags = events[index].events;
+            unsigned mask = 0;
+            if(flags & EPOLLIN)
+                mask |= readable;
+            if(flags & EPOLLOUT)
+                mask |= writable;
+            if(flags & (EPOLLHUP | EPOLLRDHUP))
+                mask |= hangup;
+            if(flags & EPOLLERR)
+                mask |= failed;
+            ready_.emplace_back(fd, mask);
+        }
+#elif defined(USE_KQUEUE)
+        struct kevent events[64];
+        struct timespec wait{}, *until{nullptr};
+        if(timeout >= 0) {
+            wait.tv_sec = timeout / 1000;
+            wait.tv_nsec = long(timeout % 1000) * 1000000L;
+            until = &wait;
+        }
+        auto count = kevent(queue_, nullptr, 0, events, 64, until);
+        for(auto index = 0; index < count; ++index) {
+            const auto fd = int(events[index].ident);
+            if(fd == wake_[0]) {
+                drain();
+                continue;
+            }
+            unsigned mask = events[index].filter == EVFILT_WRITE ? writable : readable;
+            if(events[index].flags & EV_EOF)
+                mask |= hangup;
+            if(events[index].flags & EV_ERROR)
+                mask = failed;
+            // read and write arrive as separate events, merge them
+            auto merged = std::find_if(ready_.begin(), ready_.end(), [fd](const auto& item) {
+                return item.first == fd;
+            });
+            if(merged != ready_.end())
+                merged->second |= mask;
+            else
+                ready_.emplace_back(fd, mask);
+        }
+#else
+        {
+            const std::lock_guard lock(lock_);
+            if(dirty_) {
+                fds_.clear();
+                if(wake_[0] != -1)
+                    watch(wake_[0], POLLIN);
+                for(const auto& [fd, entry] : entries_) {
+                    short want = 0;
+                    if(entry->events & readable)
+                        want |= POLLIN;
+                    if(entry->events & writable)
+                        want |= POLLOUT;
+                    if(want)
+                        watch(fd, want);
+                }
+                dirty_ = false;
+            }
+        }
+        auto count = Socket::poll(fds_.data(), fds_.size(), timeout);
+        for(auto& pfd : fds_) {
+            if(count <= 0)
+                break;
+            if(!pfd.revents)
+                continue;
+            --count;
+            if(int(pfd.fd) == wake_[0]) {
+                drain();
+                continue;
+            }
+            unsigned mask = 0;
+            if(pfd.revents & POLLIN)
+                mask |= readable;
+            if(pfd.revents & POLLOUT)
+                mask |= writable;
+            if(pfd.revents & POLLHUP)
+                mask |= hangup;
+            if(pfd.revents & (POLLERR | POLLNVAL))
+                mask |= failed;
+            pfd.revents = 0;
+            ready_.emplace_back(int(pfd.fd), mask);
+        }
+#endif
+    }
+
+    template<typename Call>
+    auto fire(int timeout, Call call) -> std::size_t {
+        collect(timeout);
+        std::size_t fired = 0;
+        for(const auto& [fd, events] : ready_) {
+            std::shared_ptr<entry_t> entry;
+            {
+                const std::lock_guard lock(lock_);
+                auto it = entries_.find(fd);
+                if(it == entries_.end())
+                    continue;
+                entry = it->second;
+#if !defined(USE_EPOLL) && !defined(USE_KQUEUE)
+                if(entry->oneshot) {
+                    entry->events = 0;
+                    dirty_ = true;
+                }
+#endif
+            }
+            call(std::move(entry), fd, events);
+            ++fired;
+        }
+        return fired;
+    }
+};
+} // end namespace
+#endif
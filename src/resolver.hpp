@@ -0,0 +1,192 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_RESOLVER_HPP_
+#define TYCHO_RESOLVER_HPP_
+
+#include "socket.hpp"
+#include "hashmap.hpp"
+#include "tasks.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <utility>
+
+namespace tycho {
+// Result of a name lookup, err is a getaddrinfo error code
+struct resolved_t {
+    std::vector<address_t> list;
+    int err{0};
+
+    explicit operator bool() const noexcept {
+        return !list.empty();
+    }
+
+    auto operator!() const noexcept {
+        return list.empty();
+    }
+
+    auto front() const noexcept {
+        return list.empty() ? address_t() : list.front();
+    }
+};
+
+// Asynchronous resolver that runs getaddrinfo on a small worker pool and
+// caches answers. Failures are cached for a shorter time, and concurrent
+// lookups of the same name share a single query. Since getaddrinfo does
+// not report record ttl, the cache lifetime is set for the resolver.
+class resolver final {
+public:
+    using callback_t = std::function<void(const resolved_t&)>;
+    using duration_t = std::chrono::steady_clock::duration;
+
+    explicit resolver(std::size_t workers = 2, duration_t ttl = std::chrono::seconds(60), duration_t negative = std::chrono::seconds(5), std::size_t limit = 256) :
+    ttl_(ttl), negative_(negative), limit_(limit), pool_(workers ? workers : 1) {
+        pool_.startup();
+    }
+
+    resolver(const resolver&) = delete;
+    auto operator=(const resolver&) -> auto& = delete;
+
+    ~resolver() {
+        pool_.shutdown();
+    }
+
+    // callback runs now when cached, otherwise on a resolver worker
+    auto resolve(const std::string& host, const std::string& service, callback_t callback, int family = AF_UNSPEC, int type = SOCK_STREAM, int protocol = 0) -> bool {
+        auto key = make_key(host, service, family, type, protocol);
+        std::unique_lock lock(lock_);
+        auto& entry = cache_[key];
+        if(entry && !entry->pending && entry->expires > clock_t::now()) {
+            auto result = entry->result;
+            ++hits_;
+            lock.unlock();
+            callback(result);
+            return true;
+        }
+
+        if(entry && entry->pending) {
+            entry->waiting.push_back(std::move(callback));
+            ++hits_;
+            return true;
+        }
+
+        if(!entry)
+            entry = std::make_shared<entry_t>();
+        entry->pending = true;
+        entry->waiting.push_back(std::move(callback));
+        ++misses_;
+        if(cache_.size() > limit_)
+            purge(clock_t::now());
+        lock.unlock();
+
+        if(pool_.dispatch([this, key, host, service, family, type, protocol] {
+            const Socket::service list(host, service, family, type, protocol);
+            resolved_t result;
+            result.err = list.err();
+            list.each([&result](const struct addrinfo *addr) {
+                result.list.emplace_back(addr);
+                return true;
+            });
+            if(!result.err && result.list.empty())
+                result.err = EAI_NONAME;
+            complete(key, std::move(result), true);
+        }, limit_))
+            return true;
+
+        resolved_t busy;
+        busy.err = EAI_AGAIN;
+        complete(key, std::move(busy), false);
+        return false;
+    }
+
+    auto resolve(const std::string& host, const std::string& service = "", int family = AF_UNSPEC, int type = SOCK_STREAM, int protocol = 0) {
+        auto promise = std::make_shared<task_promise<resolved_t>>();
+        auto future = promise->get_future();
+        resolve(host, service, [promise](const resolved_t& result) {
+            promise->set_value(resolved_t(result));
+        }, family, type, protocol);
+        return future;
+    }
+
+    // blocking lookup of the first address, served from cache when fresh
+    auto find(const std::string& host, const std::string& service = "", int family = AF_UNSPEC, int type = SOCK_STREAM, int protocol = 0) {
+        return resolve(host, service, family, type, protocol).get().front();
+    }
+
+    void clear() {
+        const std::lock_guard lock(lock_);
+        cache_.erase_if([](const auto& item) {
+            return !item.second->pending;
+        });
+    }
+
+    auto size() const {
+        const std::lock_guard lock(lock_);
+        return cache_.size();
+    }
+
+    auto hits() const {
+        const std::lock_guard lock(lock_);
+        return hits_;
+    }
+
+    auto misses() const {
+        const std::lock_guard lock(lock_);
+        return misses_;
+    }
+
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    struct entry_t {
+        resolved_t result;
+        clock_t::time_point expires{};
+        std::vector<callback_t> waiting;
+        bool pending{false};
+    };
+
+    mutable std::mutex lock_;
+    flat_map<std::string, std::shared_ptr<entry_t>> cache_;
+    duration_t ttl_, negative_;
+    std::size_t limit_;
+    std::size_t hits_{0}, misses_{0};
+    task_pool pool_;
+
+    static auto make_key(const std::string& host, const std::string& service, int family, int type, int protocol) -> std::string {
+        return host + '\0' + service + '\0' + std::to_string(family) + ':' + std::to_string(type) + ':' + std::to_string(protocol);
+    }
+
+    // entries that are still being resolved are kept
+    void purge(clock_t::time_point now) {
+        cache_.erase_if([now](const auto& item) {
+            return !item.second || (!item.second->pending && item.second->expires <= now);
+        });
+    }
+
+    void complete(const std::string& key, resolved_t result, bool cache) {
+        std::vector<callback_t> waiting;
+        std::unique_lock lock(lock_);
+        auto item = cache_.find(key);
+        if(item == cache_.end())
+            return;
+        auto entry = item->second;
+        waiting.swap(entry->waiting);
+        if(cache) {
+            entry->result = result;
+            entry->pending = false;
+            entry->expires = clock_t::now() + (result.err ? negative_ : ttl_);
+        }
+        else
+            cache_.erase(key);
+        lock.unlock();
+        for(auto& callback : waiting)
+            callback(result);
+    }
+};
+} // end namespace
+#endif
@@ -0,0 +1,257 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_RUNNER_HPP_
+#define TYCHO_RUNNER_HPP_
+
+#include "process.hpp"
+#include "reactor.hpp"
+
+#if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__MINGW64__) && !defined(WIN32)
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace tycho {
+// Runs queued commands with at most limit alive at once, without a shell.
+// Output and error lines are handed to a callback from the reactor thread
+// as they arrive, without the newline, and the exit status is reported
+// once the child is reaped. A command that cannot start reports -1.
+class command_runner final {
+public:
+    using lines_t = std::function<void(std::size_t, std::string_view, bool)>;
+    using done_t = std::function<void(std::size_t, int)>;
+
+    static constexpr std::size_t max_line = 65536;
+
+    explicit command_runner(reactor& events, std::size_t limit = 4) noexcept :
+    events_(events), limit_(limit ? limit : 1) {}
+
+    command_runner(const command_runner&) = delete;
+    auto operator=(const command_runner&) -> auto& = delete;
+
+    // children still running are left to finish and are then reaped
+    ~command_runner() {
+        const std::lock_guard lock(lock_);
+        queue_.clear();
+        for(auto& job : active_) {
+            release(*job);
+            if(job->child.pid > 0)
+                process::wait(job->child.pid);
+        }
+        active_.clear();
+    }
+
+    // returns the job number passed to the callbacks
+    auto run(std::vector<std::string> args, lines_t lines, done_t done = {}) -> std::size_t {
+        auto job = std::make_shared<job_t>();
+        job->args = std::move(args);
+        job->lines = std::move(lines);
+        job->done = std::move(done);
+        std::vector<std::shared_ptr<job_t>> failed;
+        std::size_t id{0};
+        {
+            const std::lock_guard lock(lock_);
+            id = job->id = ++sequence_;
+            queue_.push_back(std::move(job));
+            failed = schedule();
+        }
+        report(failed);
+        return id;
+    }
+
+    auto active() const {
+        const std::lock_guard lock(lock_);
+        return active_.size();
+    }
+
+    auto pending() const {
+        const std::lock_guard lock(lock_);
+        return queue_.size();
+    }
+
+    auto idle() const {
+        const std::lock_guard lock(lock_);
+        return active_.empty() && queue_.empty();
+    }
+
+private:
+    struct stream_t final {
+        int fd{-1};
+        std::string partial;
+    };
+
+    struct job_t final {
+        std::size_t id{0};
+        std::vector<std::string> args;
+        lines_t lines;
+        done_t done;
+        process::child_t child;
+        stream_t streams[2];
+        int waiter{-1};
+        int status{-1};
+    };
+
+    reactor& events_;
+    std::size_t limit_;
+    mutable std::mutex lock_;
+    std::deque<std::shared_ptr<job_t>> queue_;
+    std::vector<std::shared_ptr<job_t>> active_;
+    std::size_t sequence_{0};
+
+    // start what fits under the limit, returning jobs that failed to start
+    auto schedule() -> std::vector<std::shared_ptr<job_t>> {
+        std::vector<std::shared_ptr<job_t>> failed;
+        while(!queue_.empty() && active_.size() < limit_) {
+            auto job = std::move(queue_.front());
+            queue_.pop_front();
+            if(!start(job))
+                failed.push_back(std::move(job));
+            else
+                active_.push_back(std::move(job));
+        }
+        return failed;
+    }
+
+    void report(const std::vector<std::shared_ptr<job_t>>& jobs) {
+        for(const auto& job : jobs) {
+            if(job->done)
+                job->done(job->id, job->status);
+        }
+    }
+
+    auto start(const std::shared_ptr<job_t>& job) -> bool {
+        if(job->args.empty())
+            return false;
+
+        std::vector<char *> argv;
+        argv.reserve(job->args.size() + 1);
+        for(auto& arg : job->args)
+            argv.push_back(arg.data());
+        argv.push_back(nullptr);
+
+        job->child = process::launch(job->args.front(), argv.data(), nullptr, process::pipe_output | process::pipe_error);
+        if(!job->child)
+            return false;
+
+        job->streams[0].fd = job->child.output;
+        job->streams[1].fd = job->child.error;
+        for(auto pos = 0U; pos < 2U; ++pos) {
+            auto& stream = job->streams[pos];
+            fcntl(stream.fd, F_SETFL, fcntl(stream.fd, F_GETFL) | O_NONBLOCK);
+            events_.add(stream.fd, reactor::readable, [this, job, pos](int, unsigned) {
+                service(job, pos);
+            });
+        }
+        return true;
+    }
+
+    // every stream closed, stop watching it here so it is only done once
+    void release(job_t& job) {
+        for(auto& stream : job.streams) {
+            if(stream.fd > -1)
+                events_.remove(stream.fd);
+            stream.fd = -1;
+        }
+        if(job.waiter > -1) {
+            events_.remove(job.waiter);
+            ::close(job.waiter);
+            job.waiter = -1;
+        }
+        job.child.close();
+    }
+
+    void service(const std::shared_ptr<job_t>& job, unsigned pos) {
+        auto& stream = job->streams[pos];
+        if(stream.fd < 0)
+            return;
+
+        char buf[8192];
+        for(;;) {
+            const auto count = ::read(stream.fd, buf, sizeof(buf)); // FlawFinder: ignore
+            if(count < 0 && errno == EINTR)
+                continue;
+            if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            if(count <= 0)
+                break;
+            split(*job, stream, std::string_view(buf, std::size_t(count)), pos == 1);
+        }
+
+        if(!stream.partial.empty())
+            job->lines(job->id, stream.partial, pos == 1);
+        stream.partial.clear();
+        events_.remove(stream.fd);
+        stream.fd = -1;
+        if(job->streams[0].fd < 0 && job->streams[1].fd < 0)
+            exited(job);
+    }
+
+    void split(job_t& job, stream_t& stream, std::string_view data, bool error) {
+        while(!data.empty()) {
+            const auto eol = data.find('\n');
+            if(eol == std::string_view::npos) {
+                stream.partial.append(data);
+                if(stream.partial.size() >= max_line) {
+                    job.lines(job.id, stream.partial, error);
+                    stream.partial.clear();
+                }
+                return;
+            }
+            if(stream.partial.empty())
+                job.lines(job.id, data.substr(0, eol), error);
+            else {
+                stream.partial.append(data.substr(0, eol));
+                job.lines(job.id, stream.partial, error);
+                stream.partial.clear();
+            }
+            data.remove_prefix(eol + 1);
+        }
+    }
+
+    // a child closing its output before exit is waited for through a
+    // pidfd where there is one, rather than blocking the reactor
+    void exited(const std::shared_ptr<job_t>& job) {
+        int status{0};
+        const auto pid = waitpid(job->child.pid, &status, WNOHANG);
+        if(pid == 0) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+            job->waiter = int(::syscall(SYS_pidfd_open, job->child.pid, 0));
+            if(job->waiter > -1 && events_.add(job->waiter, reactor::readable, [this, job](int, unsigned) {
+                int code{0};
+                waitpid(job->child.pid, &code, 0);
+                finish(job, code);
+            }))
+                return;
+#endif
+            waitpid(job->child.pid, &status, 0);
+        }
+        finish(job, status);
+    }
+
+    void finish(const std::shared_ptr<job_t>& job, int status) {
+        job->status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        job->child.pid = -1;
+        std::vector<std::shared_ptr<job_t>> failed;
+        {
+            const std::lock_guard lock(lock_);
+            release(*job);
+            active_.erase(std::remove(active_.begin(), active_.end(), job), active_.end());
+            failed = schedule();
+        }
+        if(job->done)
+            job->done(job->id, job->status);
+        report(failed);
+    }
+};
+} // end namespace
+#endif
+#endif
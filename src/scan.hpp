@@ -7,7 +7,14 @@
 #include <string_view>
 #include <string>
 #include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <charconv>
+#include <limits>
 #include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
 #include <cctype>
 
 // low level utility scan functions
@@ -20,7 +27,7 @@ inline auto count(const std::string_view& text, char code) {
     return count;
 }
 
-inline auto pow(long base, long exp) {
+constexpr auto pow(long base, long exp) {
     long result = 1;
     for (;;) {
         if (exp & 1)
@@ -33,6 +40,75 @@ inline auto pow(long base, long exp) {
     return result;
 }
 
+// Eight ascii digits converted at once as a swar word, or -1 if any of
+// them is not a digit. Text must have at least eight chars.
+inline auto digits8(const char *text) noexcept -> int64_t {
+    uint64_t chunk{};
+    memcpy(&chunk, text, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+    if(((chunk & 0xf0f0f0f0f0f0f0f0) | (((chunk + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) != 0x3333333333333333)
+        return -1;
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & 0x000000ff000000ff) * (100 + (1000000ULL << 32))) + (((chunk >> 16) & 0x000000ff000000ff) * (1 + (10000ULL << 32)))) >> 32;
+    return int64_t(uint32_t(chunk));
+}
+
+// digits up to max, leaving the digit that would pass max in the text
+inline auto value64(std::string_view& text, uint64_t max = std::numeric_limits<uint64_t>::max()) -> uint64_t {
+    uint64_t value = 0;
+    while(text.size() >= 8) {
+        const auto chunk = digits8(text.data());
+        if(chunk < 0 || uint64_t(chunk) > max || value > (max - uint64_t(chunk)) / 100000000)
+            break;
+        value = value * 100000000 + uint64_t(chunk);
+        text.remove_prefix(8);
+    }
+    while(!text.empty() && isdigit(text.front())) {
+        const auto digit = uint64_t(text.front() - '0');
+        if(digit > max || value > (max - digit) / 10)
+            break;
+        value = value * 10 + digit;
+        text.remove_prefix(1);
+    }
+    return value;
+}
+
+// from_chars for integer and floating types, consuming what it parsed
+template <typename T>
+inline auto number(std::string_view& text, T& out) -> std::errc {
+    static_assert(std::is_arithmetic_v<T>, "T must be arithmetic");
+
+    const auto begin = text.data(), end = text.data() + text.size();
+#if !defined(__cpp_lib_to_chars)
+    if constexpr(std::is_floating_point_v<T>) {
+        const std::string copy(text.substr(0, 64));
+        if(copy.empty() || isspace(copy.front()) || copy.front() == '+')
+            return std::errc::invalid_argument;
+        char *last = nullptr;
+        errno = 0;
+        const auto value = std::strtold(copy.c_str(), &last);
+        if(last == copy.c_str())
+            return std::errc::invalid_argument;
+        text.remove_prefix(std::size_t(last - copy.c_str()));
+        if(errno == ERANGE || value > std::numeric_limits<T>::max() || value < std::numeric_limits<T>::lowest())
+            return std::errc::result_out_of_range;
+        out = T(value);
+        return {};
+    }
+    else
+#endif
+    {
+        const auto [ptr, ec] = std::from_chars(begin, end, out);
+        if(ec == std::errc::invalid_argument)
+            return ec;
+        text.remove_prefix(std::size_t(ptr - begin));
+        return ec;
+    }
+}
+
 inline auto text(std::string_view& text, bool quoted = false) -> std::string {
     std::string result;
     char quote = 0;
@@ -102,17 +178,7 @@ inline auto text(std::string_view& text, bool quoted = false) -> std::string {
 }
 
 inline auto value(std::string_view& text, uint64_t max = 2147483647) -> uint32_t {
-    uint64_t value = 0;
-    while(!text.empty() && isdigit(text.front())) {
-        value *= 10;
-        value += uint64_t(text.front() - '0');
-        if(value > max) {
-            value /= 10;
-            break;
-        }
-        text.remove_prefix(1);
-    }
-    return value;
+    return uint32_t(value64(text, max));
 }
 
 inline auto match(std::string_view& text, const std::string_view& find, bool insensitive = false) {
@@ -192,44 +258,30 @@ inline auto get_literal(std::string_view text, char quote = '\"') {
 }
 
 inline auto get_value(std::string_view text, int32_t min = 1, int32_t max = 65535) -> int32_t {
-    bool neg = false;
-    if(min < 0 && !text.empty() && text.front() == '-') {
-        neg = true;
-        text.remove_prefix(1);
-    }
-
-    if(text.empty() || !isdigit(text.front()))
+    const auto digits = (min < 0 && text.size() > 1 && text.front() == '-') ? text.substr(1) : text;
+    if(digits.empty() || !isdigit(digits.front()))
         throw std::invalid_argument("Value missing or invalid");
 
-    auto value = scan::value(text, max);
-    if(!text.empty() && isdigit(text.front()))
+    int64_t value{0};
+    if(scan::number(text, value) == std::errc::result_out_of_range || value > max)
         throw std::overflow_error("Value too big");
-
-    if(neg) {
-        auto nv = -int32_t(value);
-        if(nv < min)
-            throw std::out_of_range("value too small");
-        return nv;
-    }
-
-    auto rv = int32_t(value);
-    if(min >= 0 && rv < min)
-            throw std::out_of_range("value too small");
-    return rv;
+    if(value < min)
+        throw std::out_of_range("value too small");
+    return int32_t(value);
 }
 
 inline auto get_duration(std::string_view text, bool ms = false) -> unsigned {
     if(text.empty() || !isdigit(text.front()))
         throw std::invalid_argument("Duration missing or invalid");
 
-    auto value = scan::value(text);
+    uint64_t parsed{0};
+    if(scan::number(text, parsed) == std::errc::result_out_of_range || parsed > 2147483647)
+        throw std::overflow_error("Duration too big");
+    auto value = unsigned(parsed);
     unsigned scale = 1;
     if(ms)
         scale = 1000UL;
 
-    if(!text.empty() && isdigit(text.front()))
-        throw std::overflow_error("Duration too big");
-
     if(text.empty())
         return value;
 
@@ -260,13 +312,67 @@ inline auto get_duration(std::string_view text, bool ms = false) -> unsigned {
     // hour and minute markers...
     auto count = scan::count(text, ':');
     if(text.front() == ':' && !ms && count < 4) {
+        constexpr long scales[] = {scan::pow(60, 0), scan::pow(60, 1), scan::pow(60, 2), scan::pow(60, 3)};
         text.remove_prefix(1);
-        value *= (scan::pow(60UL, long(count)));
+        value *= unsigned(scales[count]);
         return value + get_duration(text);
     }
     throw std::invalid_argument("Duration is invalid");
 }
 
+// whole text as a 64 bit value, by from_chars
+inline auto get_value64(std::string_view text, int64_t min = std::numeric_limits<int64_t>::min(), int64_t max = std::numeric_limits<int64_t>::max()) -> int64_t {
+    int64_t value{0};
+    const auto ec = scan::number(text, value);
+    if(ec == std::errc::invalid_argument || !text.empty())
+        throw std::invalid_argument("Value missing or invalid");
+    if(ec == std::errc::result_out_of_range || value > max)
+        throw std::overflow_error("Value too big");
+    if(value < min)
+        throw std::out_of_range("value too small");
+    return value;
+}
+
+inline auto get_real(std::string_view text, double min = std::numeric_limits<double>::lowest(), double max = std::numeric_limits<double>::max()) -> double {
+    double value{0};
+    const auto ec = scan::number(text, value);
+    if(ec == std::errc::invalid_argument || !text.empty())
+        throw std::invalid_argument("Value missing or invalid");
+    if(ec == std::errc::result_out_of_range || value > max)
+        throw std::overflow_error("Value too big");
+    if(value < min)
+        throw std::out_of_range("value too small");
+    return value;
+}
+
+// Fill out with up to max delimited numbers from a line, blanks around
+// fields allowed, returning the count parsed. A bad field throws.
+template <typename T>
+inline auto get_values(std::string_view line, T *out, std::size_t max, char delim = ',') -> std::size_t {
+    const auto blanks = [](std::string_view& text) {
+        while(!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+    };
+
+    std::size_t count = 0;
+    while(count < max) {
+        blanks(line);
+        const auto ec = scan::number(line, out[count]);
+        if(ec == std::errc::invalid_argument)
+            throw std::invalid_argument("Value missing or invalid");
+        if(ec == std::errc::result_out_of_range)
+            throw std::overflow_error("Value too big");
+        ++count;
+        blanks(line);
+        if(line.empty())
+            break;
+        if(line.front() != delim)
+            throw std::invalid_argument("Value missing or invalid");
+        line.remove_prefix(1);
+    }
+    return count;
+}
+
 inline auto get_bool(std::string_view& text) {
     using namespace scan;
 
@@ -316,6 +422,15 @@ inline auto get_range_or(std::string_view text, uint32_t or_else = 0, uint32_t m
     }
 }
 
+inline auto get_real_or(std::string_view text, double or_else = 0.0) {
+    try {
+        return get_real(text);
+    }
+    catch(const std::exception& e) {
+        return or_else;
+    }
+}
+
 inline auto get_seconds_or(std::string_view text, uint32_t or_else = 0) {
     try {
         return get_duration(text);
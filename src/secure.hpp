@@ -5,8 +5,15 @@
 #define TYCHO_SECURE_HPP_
 
 #include "stream.hpp"
+#include "x509.hpp"
 
 #include <openssl/ssl.h>
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace tycho {
 struct secure_certs {
@@ -15,102 +22,269 @@ struct secure_certs {
     std::string certfile;
 };
 
-template <std::size_t S = 512>
-class secure_stream : public socket_stream<S> {
+// Shared tls setup, holding the SSL_CTX with its loaded certificates and
+// verify store, and a bounded client session cache keyed by peer address.
+// Copies share one context, so every stream made from it can resume
+// sessions.
+class secure_context final {
 public:
-    secure_stream(int from, const struct sockaddr *peer, const secure_certs& certs = secure_certs{}, std::size_t size = S, const SSL_METHOD *method = TLS_server_method()) :
-    socket_stream<S>(from, peer, size), ctx_(SSL_CTX_new(method)) {
-        if(!super::is_open() || !ctx_)
+    explicit secure_context(const secure_certs& certs = secure_certs{}, const SSL_METHOD *method = TLS_method()) :
+    state_(std::make_shared<state_t>(SSL_CTX_new(method))) {
+        auto ctx = state_->ctx;
+        if(!ctx)
             return;
 
         if(!certs.certfile.empty())
-            SSL_CTX_use_certificate_file(ctx_, certs.certfile.c_str(), SSL_FILETYPE_PEM);
+            SSL_CTX_use_certificate_file(ctx, certs.certfile.c_str(), SSL_FILETYPE_PEM);
         if(!certs.keyfile.empty())
-                SSL_CTX_use_PrivateKey_file(ctx_, certs.keyfile.c_str(), SSL_FILETYPE_PEM);
+            SSL_CTX_use_PrivateKey_file(ctx, certs.keyfile.c_str(), SSL_FILETYPE_PEM);
 
-        if(!certs.keyfile.empty() || !SSL_CTX_check_private_key(ctx_)) {
-            SSL_CTX_free(ctx_);
-            ctx_ = nullptr;
+        if(!certs.keyfile.empty() && !SSL_CTX_check_private_key(ctx)) {
+            SSL_CTX_free(ctx);
+            state_->ctx = nullptr;
             return;
         }
 
-        if(!certs.capath.empty() && SSL_CTX_load_verify_locations(ctx_, certs.capath.c_str(), nullptr))
-            SSL_CTX_set_verify(ctx_, SSL_VERIFY_PEER, nullptr);
+        if(!certs.capath.empty() && SSL_CTX_load_verify_locations(ctx, certs.capath.c_str(), nullptr)) {
+            SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+            state_->verify = true;
+        }
 
-        ssl_ = SSL_new(ctx_);
-        if(!ssl_)
-            return;
+        static const unsigned char id[] = "tycho";
+        SSL_CTX_set_session_id_context(ctx, id, sizeof(id) - 1);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+        SSL_CTX_set_ex_data(ctx, ctx_index(), state_.get());
+        SSL_CTX_sess_set_new_cb(ctx, &state_t::saved);
+    }
 
-        SSL_set_fd(ssl_, super::io_socket());
-        if(SSL_accept(ssl_) <= 0)
-            return;
+    operator bool() const noexcept {
+        return state_->ctx != nullptr;
+    }
 
-        bio_ = SSL_get_wbio(ssl_);
-        peer_cert = SSL_get_peer_certificate(ssl_);
-        if(peer_cert && !certs.capath.empty()) {
-            switch(SSL_get_verify_result(ssl_)) {
-            case X509_V_OK:
-                verified = VERIFIED;
-                break;
-            case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
-                verified = SIGNED;
-                break;
-            default:
-                break;
+    auto operator!() const noexcept {
+        return state_->ctx == nullptr;
+    }
+
+    auto operator*() const noexcept {
+        return state_->ctx;
+    }
+
+    auto is_verifying() const noexcept {
+        return state_->verify;
+    }
+
+    // hand bulk record encryption to the kernel after the handshake
+    auto ktls(bool enable) noexcept {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        if(!state_->ctx)
+            return false;
+        if(enable)
+            SSL_CTX_set_options(state_->ctx, SSL_OP_ENABLE_KTLS);
+        else
+            SSL_CTX_clear_options(state_->ctx, SSL_OP_ENABLE_KTLS);
+        return true;
+#else
+        static_cast<void>(enable);
+        return false;
+#endif
+    }
+
+    auto sessions() const {
+        const std::lock_guard lock(state_->lock);
+        return state_->sessions.size();
+    }
+
+    // most peers kept in the session cache, least recently used go first
+    void session_limit(std::size_t count) {
+        const std::lock_guard lock(state_->lock);
+        state_->limit = count ? count : 1;
+        state_->trim(state_->limit);
+    }
+
+    // cache peer chain verification by chain fingerprint, so repeat peers
+    // that do not resume skip chain building until the ttl or an expiry
+    auto cache_verify(std::size_t limit = 256, crypto::x509_verifier::duration_t ttl = std::chrono::minutes(5)) {
+        if(!state_->ctx)
+            return false;
+        state_->verifier = std::make_unique<crypto::x509_verifier>(SSL_CTX_get_cert_store(state_->ctx), limit, ttl);
+        SSL_CTX_set_cert_verify_callback(state_->ctx, &state_t::checked, state_.get());
+        return true;
+    }
+
+    auto verifier() const noexcept {
+        return state_->verifier.get();
+    }
+
+    void clear() {
+        state_->clear();
+    }
+
+private:
+    template <std::size_t> friend class secure_stream;
+
+    struct kept_t final {
+        SSL_SESSION *session{nullptr};
+        uint64_t used{0};
+    };
+
+    struct state_t final {
+        explicit state_t(SSL_CTX *from) noexcept : ctx(from) {}
+        state_t(const state_t&) = delete;
+        auto operator=(const state_t&) -> auto& = delete;
+
+        ~state_t() {
+            clear();
+            if(ctx)
+                SSL_CTX_free(ctx);
+        }
+
+        void clear() {
+            const std::lock_guard guard(lock);
+            for(auto& [key, kept] : sessions)
+                SSL_SESSION_free(kept.session);
+            sessions.clear();
+        }
+
+        // drop sessions that cannot resume, then the least recently used,
+        // until count remain; called with the lock held
+        void trim(std::size_t count) {
+            if(sessions.size() <= count)
+                return;
+            for(auto it = sessions.begin(); it != sessions.end();) {
+                if(SSL_SESSION_is_resumable(it->second.session)) {
+                    ++it;
+                    continue;
+                }
+                SSL_SESSION_free(it->second.session);
+                it = sessions.erase(it);
+            }
+            while(sessions.size() > count) {
+                auto victim = std::min_element(sessions.begin(), sessions.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.second.used < rhs.second.used;
+                });
+                SSL_SESSION_free(victim->second.session);
+                sessions.erase(victim);
             }
         }
+
+        // new tickets replace what was kept for the peer
+        static auto saved(SSL *ssl, SSL_SESSION *session) -> int {
+            auto state = static_cast<state_t *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ctx_index()));
+            auto key = static_cast<const std::string *>(SSL_get_ex_data(ssl, index()));
+            if(!state || !key || key->empty())
+                return 0;
+            const std::lock_guard guard(state->lock);
+            auto it = state->sessions.find(*key);
+            if(it == state->sessions.end()) {
+                state->trim(state->limit - 1);
+                it = state->sessions.try_emplace(*key).first;
+            }
+            else
+                SSL_SESSION_free(it->second.session);
+            it->second = kept_t{session, ++state->uses};
+            return 1;
+        }
+
+        static auto checked(X509_STORE_CTX *store, void *arg) -> int {
+            auto state = static_cast<state_t *>(arg);
+            return state->verifier->verify(store) == X509_V_OK ? 1 : 0;
+        }
+
+        SSL_CTX *ctx{nullptr};
+        std::unique_ptr<crypto::x509_verifier> verifier;
+        bool verify{false};
+        std::mutex lock;
+        std::unordered_map<std::string, kept_t> sessions;
+        std::size_t limit{1024};
+        uint64_t uses{0};
+    };
+
+    std::shared_ptr<state_t> state_;
+
+    static auto index() -> int {
+        static const int id = CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_SSL, 0, nullptr, nullptr, nullptr, nullptr);
+        return id;
     }
 
-    explicit secure_stream(const struct sockaddr *peer, const secure_certs& certs = secure_certs{}, std::size_t size = S, const SSL_METHOD *method = TLS_client_method()) :
-    socket_stream<S>(peer, size), ctx_(SSL_CTX_new(method)) {
-        if(!super::is_open() || !ctx_)
-            return;
+    static auto ctx_index() -> int {
+        static const int id = CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_SSL_CTX, 0, nullptr, nullptr, nullptr, nullptr);
+        return id;
+    }
 
-        if(!certs.certfile.empty())
-            SSL_CTX_use_certificate_file(ctx_, certs.certfile.c_str(), SSL_FILETYPE_PEM);
+    // a session kept for the peer, or nullptr; released by the caller
+    auto session(const std::string& key) const -> SSL_SESSION * {
+        const std::lock_guard lock(state_->lock);
+        auto it = state_->sessions.find(key);
+        if(it == state_->sessions.end())
+            return nullptr;
+        if(!SSL_SESSION_is_resumable(it->second.session)) {
+            SSL_SESSION_free(it->second.session);
+            state_->sessions.erase(it);
+            return nullptr;
+        }
+        it->second.used = ++state_->uses;
+        SSL_SESSION_up_ref(it->second.session);
+        return it->second.session;
+    }
+};
 
-        if(!certs.keyfile.empty())
-            SSL_CTX_use_PrivateKey_file(ctx_, certs.keyfile.c_str(), SSL_FILETYPE_PEM);
+template <std::size_t S = 512>
+class secure_stream : public socket_stream<S> {
+public:
+    secure_stream(int from, const struct sockaddr *peer, const secure_context& context, std::size_t size = S) :
+    socket_stream<S>(from, peer, size), context_(context) {
+        if(!super::is_open() || !context_)
+            return;
 
-        if(!certs.keyfile.empty() && !SSL_CTX_check_private_key(ctx_)) {
-            SSL_CTX_free(ctx_);
-            ctx_ = nullptr;
+        ssl_ = SSL_new(*context_);
+        if(!ssl_)
             return;
-        }
 
-        if(!certs.capath.empty() && SSL_CTX_load_verify_locations(ctx_, certs.capath.c_str(), nullptr))
-            SSL_CTX_set_verify(ctx_, SSL_VERIFY_PEER, nullptr);
+        SSL_set_fd(ssl_, super::io_socket());
+        if(SSL_accept(ssl_) <= 0)
+            return;
 
-        ssl_ = SSL_new(ctx_);
+        accepted = true;
+        handshake();
+    }
+
+    secure_stream(int from, const struct sockaddr *peer, const secure_certs& certs = secure_certs{}, std::size_t size = S, const SSL_METHOD *method = TLS_server_method()) :
+    secure_stream(from, peer, secure_context(certs, method), size) {}
+
+    // sessions offered by the peer are kept in the context for resumption
+    explicit secure_stream(const struct sockaddr *peer, const secure_context& context, std::size_t size = S) :
+    socket_stream<S>(peer, size), context_(context), key_(make_key(peer)) {
+        if(!super::is_open() || !context_)
+            return;
+
+        ssl_ = SSL_new(*context_);
         if(!ssl_)
             return;
 
+        SSL_set_ex_data(ssl_, secure_context::index(), &key_);
+        auto session = key_.empty() ? nullptr : context_.session(key_);
+        if(session) {
+            SSL_set_session(ssl_, session);
+            SSL_SESSION_free(session);
+        }
+
         SSL_set_fd(ssl_, super::io_socket());
         if(SSL_connect(ssl_) <= 0)
             return;
 
-        bio_ = SSL_get_wbio(ssl_);
-        peer_cert = SSL_get_peer_certificate(ssl_);
-        if(peer_cert && !certs.capath.empty()) {
-            switch(SSL_get_verify_result(ssl_)) {
-            case X509_V_OK:
-                verified = VERIFIED;
-                break;
-            case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
-                verified = SIGNED;
-                break;
-            default:
-                break;
-            }
-        }
+        handshake();
     }
 
+    explicit secure_stream(const struct sockaddr *peer, const secure_certs& certs = secure_certs{}, std::size_t size = S, const SSL_METHOD *method = TLS_client_method()) :
+    secure_stream(peer, secure_context(certs, method), size) {}
+
     secure_stream(secure_stream&& from) noexcept :
-    socket_stream<S>(from), peer_cert(from.peer_cert), ctx_(from.ctx_), accepted(from.accepted), verified(from.verified), bio_(from.bio_), ssl_(from.ssl_) {
-        from.ctx_ = nullptr;
+    socket_stream<S>(std::move(from)), peer_cert(from.peer_cert), accepted(from.accepted), verified(from.verified), context_(from.context_), key_(std::move(from.key_)), ssl_(from.ssl_), bio_(from.bio_) {
         from.ssl_ = nullptr;
         from.bio_ = nullptr;
         from.peer_cert = nullptr;
+        if(ssl_)
+            SSL_set_ex_data(ssl_, secure_context::index(), &key_);
     }
 
     ~secure_stream() override {
@@ -120,12 +294,27 @@ public:
             X509_free(peer_cert);
         if(ssl_)
             SSL_free(ssl_);
-        if(ctx_)
-            SSL_CTX_free(ctx_);
         super::stop();
         super::clear();
     }
 
+    auto is_resumed() const noexcept {
+        return ssl_ && SSL_session_reused(ssl_) == 1;
+    }
+
+    // true when the kernel encrypts records sent on this stream
+    auto is_ktls() const noexcept {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        return bio_ && BIO_get_ktls_send(SSL_get_wbio(ssl_)) > 0;
+#else
+        return false;
+#endif
+    }
+
+    auto context() const noexcept -> const secure_context& {
+        return context_;
+    }
+
     auto peer() const noexcept {
         if(peer_cert)
             X509_up_ref(peer_cert);
@@ -148,42 +337,105 @@ public:
         return verified == VERIFIED;
     }
 
-    auto underflow() -> int override {
-        if(!bio_)
-            return super::underflow();
-
-        if(super::gptr() == super::egptr()) {
-            auto len = SSL_read(ssl_, super::gbuf, super::getsize);
-            if(len <= 0)
-                return EOF;
-            super::setg(super::gbuf, super::gbuf, super::gbuf + len);
-        }
-        return super::get_type(*super::gptr());
-    }
-
     auto sync() -> int override {
-        if(!bio_)
-            return super::sync();
-
-        auto len = super::pptr() - super::pbase();
-        if(len && !SSL_write(ssl_, super::pbase(), len))
-            return 0;
-
-        return BIO_flush(bio_);
+        if(super::sync() != 0)
+            return -1;
+        if(bio_ && BIO_flush(bio_) <= 0)
+            return -1;
+        return 0;
     }
 
 protected:
     using verify_t = enum {NONE, SIGNED, VERIFIED};
-    using super = secure_stream<S>;
+    using super = socket_stream<S>;
 
     X509 *peer_cert{nullptr};
     bool accepted{false};
     verify_t verified = NONE;
 
+    auto read_some(char *data, std::size_t size) -> std::size_t override {
+        if(!bio_)
+            return super::read_some(data, size);
+        auto len = SSL_read(ssl_, data, int(std::min(size, std::size_t(INT_MAX))));
+        return len > 0 ? std::size_t(len) : 0;
+    }
+
+    auto write_some(const char *data, std::size_t size) -> std::size_t override {
+        if(!bio_)
+            return super::write_some(data, size);
+        auto len = SSL_write(ssl_, data, int(std::min(size, std::size_t(INT_MAX))));
+        if(len <= 0)
+            errno = EIO;
+        return len > 0 ? std::size_t(len) : 0;
+    }
+
+    // tls records cannot be gathered across parts, write each in turn
+    auto write_parts(const io_part *parts, std::size_t count) -> bool override {
+        if(!bio_)
+            return super::write_parts(parts, count);
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            if(!super::write_all(static_cast<const char *>(parts[pos].data), parts[pos].size))
+                return false;
+        }
+        return true;
+    }
+
+    // file data has to be encrypted, by the kernel when ktls is active,
+    // otherwise it is read and written through ssl
+    auto write_file(int fd, off_t offset, std::size_t count) -> std::size_t override {
+        if(!bio_)
+            return super::write_file(fd, offset, count);
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+        if(is_ktls()) {
+            std::size_t total = 0;
+            while(total < count) {
+                auto sent = SSL_sendfile(ssl_, fd, offset + off_t(total), count - total, 0);
+                if(sent <= 0)
+                    break;
+                total += std::size_t(sent);
+            }
+            return total;
+        }
+#endif
+        return super::copy_file(fd, offset, count);
+    }
+
 private:
-    SSL_CTX *ctx_{nullptr};
+    secure_context context_;
+    std::string key_;
     SSL *ssl_{nullptr};
     BIO *bio_{nullptr};
+
+    // peers of other families are not cached, their length is not known
+    static auto make_key(const struct sockaddr *peer) -> std::string {
+        if(!peer)
+            return {};
+        switch(peer->sa_family) {
+        case AF_INET:
+            return {reinterpret_cast<const char *>(peer), sizeof(struct sockaddr_in)};
+        case AF_INET6:
+            return {reinterpret_cast<const char *>(peer), sizeof(struct sockaddr_in6)};
+        default:
+            return {};
+        }
+    }
+
+    void handshake() {
+        bio_ = SSL_get_wbio(ssl_);
+        peer_cert = SSL_get_peer_certificate(ssl_);
+        if(peer_cert && context_.is_verifying()) {
+            switch(SSL_get_verify_result(ssl_)) {
+            case X509_V_OK:
+                verified = VERIFIED;
+                break;
+            case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+                verified = SIGNED;
+                break;
+            default:
+                break;
+            }
+        }
+    }
 };
 
 // 512 is really more for cipher block alignment and optimized under ipv4
@@ -6,9 +6,14 @@
 
 #include <variant>
 #include <string>
+#include <string_view>
 #include <functional>
-#include <unordered_map>
+#include <type_traits>
+#include <stdexcept>
 #include <utility>
+#include <cstdint>
+
+#include "hashmap.hpp"
 
 namespace tycho {
 template <typename... Ts>
@@ -36,7 +41,7 @@ public:
     }
 
 private:
-    std::unordered_map<variant_type,action_type> cases_;
+    flat_map<variant_type,action_type> cases_;
 };
 
 template <typename T, typename... Ts>
@@ -60,7 +65,254 @@ public:
     }
 
 private:
-    std::unordered_map<variant_type,T> cases_;
+    flat_map<variant_type,T> cases_;
+};
+
+template<typename Key, typename T>
+struct select_entry final {
+    Key key{};
+    T value{};
+};
+
+// Constant selection table of keys sorted when it is built, which can be
+// constexpr. Small tables are scanned and larger ones bisected, and any key
+// with a constexpr less than may be used, including variants of them.
+template<typename Key, typename T, std::size_t N>
+class select_table final {
+public:
+    using key_type = Key;
+    using value_type = T;
+    using entry_t = select_entry<Key, T>;
+
+    constexpr select_table(const entry_t (&list)[N]) {
+        for(std::size_t pos = 0; pos < N; ++pos) {
+            auto item = list[pos];
+            auto to = pos;
+            for(; to > 0 && item.key < entries_[to - 1].key; --to)
+                entries_[to] = entries_[to - 1];
+            if(to > 0 && !(entries_[to - 1].key < item.key))
+                throw std::invalid_argument("Duplicate select key");
+            entries_[to] = item;
+        }
+    }
+
+    constexpr auto find(const Key& key) const noexcept -> const T * {
+        if constexpr(N <= 8) {
+            for(const auto& entry : entries_) {
+                if(!(entry.key < key) && !(key < entry.key))
+                    return &entry.value;
+            }
+            return nullptr;
+        } else {
+            std::size_t low = 0, high = N;
+            while(low < high) {
+                const auto mid = low + ((high - low) / 2);
+                if(entries_[mid].key < key)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            if(low < N && !(key < entries_[low].key))
+                return &entries_[low].value;
+            return nullptr;
+        }
+    }
+
+    constexpr auto operator()(const Key& key, const T& or_value = T{}) const -> T {
+        const auto *value = find(key);
+        return value ? *value : or_value;
+    }
+
+    // run a matching action, like select_when
+    template<typename... Args>
+    constexpr auto call(const Key& key, Args&&... args) const {
+        const auto *action = find(key);
+        if(!action)
+            return false;
+        (*action)(std::forward<Args>(args)...);
+        return true;
+    }
+
+    constexpr auto contains(const Key& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    constexpr auto size() const noexcept {
+        return N;
+    }
+
+    constexpr auto begin() const noexcept {
+        return entries_;
+    }
+
+    constexpr auto end() const noexcept {
+        return entries_ + N;
+    }
+
+private:
+    entry_t entries_[N]{};
+};
+
+template<typename Key>
+struct select_hasher;
+
+template<>
+struct select_hasher<std::string_view> {
+    constexpr auto operator()(std::string_view key) const noexcept {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for(const auto ch : key) {
+            hash ^= uint8_t(ch);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+};
+
+template<typename Key>
+struct select_hasher {
+    static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>, "select_hash needs integer, enum, or string_view keys");
+
+    constexpr auto operator()(Key key) const noexcept {
+        if constexpr(std::is_enum_v<Key>)
+            return uint64_t(std::underlying_type_t<Key>(key));
+        else
+            return uint64_t(key);
+    }
+};
+
+// Constant perfect hash of integer, enum, or string_view keys, built by
+// hash and displace. A lookup is one hash of the key, a seed for its
+// bucket, and a single compare, and a table that cannot be placed fails
+// to compile when it is constexpr.
+template<typename Key, typename T, std::size_t N, typename Hash = select_hasher<Key>>
+class select_hash final {
+public:
+    using key_type = Key;
+    using value_type = T;
+    using entry_t = select_entry<Key, T>;
+
+    static_assert(N > 0 && N < 0x8000, "select_hash size is out of range");
+
+    constexpr select_hash(const entry_t (&list)[N]) {
+        uint64_t hashes[N]{};
+        std::size_t counts[buckets]{};
+        for(std::size_t pos = 0; pos < N; ++pos) {
+            entries_[pos] = list[pos];
+            hashes[pos] = mix(Hash{}(list[pos].key));
+            ++counts[hashes[pos] & (buckets - 1)];
+        }
+        for(auto& slot : index_)
+            slot = empty;
+
+        // largest buckets are placed first, while most slots are free
+        for(std::size_t placed = 0; placed < buckets; ++placed) {
+            std::size_t bucket = 0;
+            for(std::size_t pos = 1; pos < buckets; ++pos) {
+                if(counts[pos] > counts[bucket])
+                    bucket = pos;
+            }
+            if(!counts[bucket])
+                break;
+            counts[bucket] = 0;
+            seeds_[bucket] = place(hashes, bucket);
+        }
+    }
+
+    constexpr auto find(const Key& key) const noexcept -> const T * {
+        const auto hash = mix(Hash{}(key));
+        const auto pos = index_[slot(hash, seeds_[hash & (buckets - 1)])];
+        if(pos == empty || !(entries_[pos].key == key))
+            return nullptr;
+        return &entries_[pos].value;
+    }
+
+    constexpr auto operator()(const Key& key, const T& or_value = T{}) const -> T {
+        const auto *value = find(key);
+        return value ? *value : or_value;
+    }
+
+    template<typename... Args>
+    constexpr auto call(const Key& key, Args&&... args) const {
+        const auto *action = find(key);
+        if(!action)
+            return false;
+        (*action)(std::forward<Args>(args)...);
+        return true;
+    }
+
+    constexpr auto contains(const Key& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    constexpr auto size() const noexcept {
+        return N;
+    }
+
+private:
+    static constexpr auto round(std::size_t count) noexcept {
+        std::size_t size = 1;
+        while(size < count)
+            size <<= 1;
+        return size;
+    }
+
+    static constexpr std::size_t slots = round(N * 2);
+    static constexpr std::size_t buckets = round(N);
+    static constexpr uint16_t empty = 0xffff;
+
+    entry_t entries_[N]{};
+    uint16_t seeds_[buckets]{};
+    uint16_t index_[slots]{};
+
+    static constexpr auto mix(uint64_t hash) noexcept {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static constexpr auto slot(uint64_t hash, uint16_t seed) noexcept {
+        return std::size_t(mix(hash + ((seed + 1ULL) * 0x9e3779b97f4a7c15ULL)) & (slots - 1));
+    }
+
+    constexpr auto place(const uint64_t (&hashes)[N], std::size_t bucket) -> uint16_t {
+        for(uint32_t seed = 0; seed < empty; ++seed) {
+            std::size_t used[N]{};
+            std::size_t count = 0;
+            auto fits = true;
+            for(std::size_t pos = 0; fits && pos < N; ++pos) {
+                if((hashes[pos] & (buckets - 1)) != bucket)
+                    continue;
+                const auto at = slot(hashes[pos], uint16_t(seed));
+                if(index_[at] != empty)
+                    fits = false;
+                for(std::size_t prior = 0; fits && prior < count; ++prior) {
+                    if(slot(hashes[used[prior]], uint16_t(seed)) != at)
+                        continue;
+                    if(entries_[used[prior]].key == entries_[pos].key)
+                        throw std::invalid_argument("Duplicate select key");
+                    fits = false;
+                }
+                used[count++] = pos;
+            }
+            if(!fits)
+                continue;
+            for(std::size_t pos = 0; pos < count; ++pos)
+                index_[slot(hashes[used[pos]], uint16_t(seed))] = uint16_t(used[pos]);
+            return uint16_t(seed);
+        }
+        throw std::invalid_argument("Cannot place select keys");
+    }
 };
+
+template<typename Key, typename T, std::size_t N>
+constexpr auto make_select(const select_entry<Key, T> (&list)[N]) {
+    return select_table<Key, T, N>(list);
+}
+
+template<typename Key, typename T, std::size_t N>
+constexpr auto make_select_hash(const select_entry<Key, T> (&list)[N]) {
+    return select_hash<Key, T, N>(list);
+}
 } // end namespace
 #endif
@@ -28,16 +28,20 @@
 #endif
 
 #include <system_error>
+#include <array>
 #include <string>
 #include <string_view>
 #include <cstring>
 #include <cstdint>
 #include <cerrno>
 
-namespace tycho {
-using crc16_t = uint16_t;
-using crc32_t = uint32_t;
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 
+namespace tycho {
 #if __has_include(<termios.h>)
 class serial_t final {
 public:
@@ -74,6 +78,10 @@ public:
         return err_;
     }
 
+    auto handle() const noexcept {
+        return device_;
+    }
+
     void open(const std::string& fname) {   // FlawFinder: safe
         close();
         device_ = ::open(fname.c_str(), O_RDWR | O_NDELAY); // FlawFinder: safe
@@ -854,35 +862,301 @@ inline auto csum8(const uint8_t *data, std::size_t size) {
     return sum;
 }
 
+// Table driven crc16 in the parameter model of the crc catalogue, with
+// the register reflected as a whole rather than per byte. It holds the
+// finished value at every step so it converts to and from a plain crc.
+template<uint16_t Poly, uint16_t Init, bool Reflect, uint16_t XorOut>
+class crc16_sum final {
+public:
+    constexpr crc16_sum() noexcept = default;
+    constexpr crc16_sum(uint16_t crc) noexcept : reg_(uint16_t(crc ^ XorOut)) {} // NOLINT
+
+    constexpr operator uint16_t() const noexcept {
+        return value();
+    }
+
+    auto update(const void *data, std::size_t size) noexcept -> crc16_sum& {
+        auto bytes = static_cast<const uint8_t *>(data);
+        while(size--)
+            feed(*bytes++);
+        return *this;
+    }
+
+    // constexpr so check values can be asserted at compile time
+    constexpr auto update(std::string_view text) noexcept -> crc16_sum& {
+        for(const auto ch : text)
+            feed(uint8_t(ch));
+        return *this;
+    }
+
+    constexpr auto value() const noexcept {
+        return uint16_t(reg_ ^ XorOut);
+    }
+
+    constexpr void reset() noexcept {
+        reg_ = start;
+    }
+
+    static auto compute(const uint8_t *data, std::size_t size) noexcept {
+        return crc16_sum().update(data, size).value();
+    }
+
+private:
+    static constexpr auto reflect(uint16_t value) {
+        uint16_t result = 0;
+        for(auto bit = 0; bit < 16; ++bit, value >>= 1)
+            result = uint16_t((result << 1) | (value & 1));
+        return result;
+    }
+
+    static constexpr auto make() {
+        std::array<uint16_t, 256> result{};
+        for(uint16_t pos = 0; pos < 256; ++pos) {
+            if constexpr(Reflect) {
+                auto crc = pos;
+                for(auto bit = 0; bit < 8; ++bit)
+                    crc = uint16_t((crc & 1) ? (crc >> 1) ^ reflect(Poly) : crc >> 1);
+                result[pos] = crc;
+            }
+            else {
+                auto crc = uint16_t(pos << 8);
+                for(auto bit = 0; bit < 8; ++bit)
+                    crc = uint16_t((crc & 0x8000) ? (crc << 1) ^ Poly : crc << 1);
+                result[pos] = crc;
+            }
+        }
+        return result;
+    }
+
+    static constexpr auto table = make();
+    static constexpr auto start = Reflect ? reflect(Init) : Init;
+
+    uint16_t reg_{start};
+
+    constexpr void feed(uint8_t byte) noexcept {
+        if constexpr(Reflect)
+            reg_ = uint16_t((reg_ >> 8) ^ table[(reg_ ^ byte) & 0xff]);
+        else
+            reg_ = uint16_t((reg_ << 8) ^ table[((reg_ >> 8) ^ byte) & 0xff]);
+    }
+};
+
+using crc16_t = crc16_sum<0x8005, 0x0000, false, 0x0000>;       // umts
+using crc16_modbus = crc16_sum<0x8005, 0xffff, true, 0x0000>;
+using crc16_ccitt = crc16_sum<0x1021, 0xffff, false, 0x0000>;   // ibm 3740
+using crc16_kermit = crc16_sum<0x1021, 0x0000, true, 0x0000>;
+using crc16_xmodem = crc16_sum<0x1021, 0x0000, false, 0x0000>;
+
 inline auto crc16(const uint8_t *data, std::size_t size) {
-    crc16_t crc = 0x0000;
-    while(size--) {
-        crc ^= *data++ << 8;
-        for(uint8_t i = 0; i < 8; i++) {
-            if(crc & 0x8000)
-                crc = (crc << 1) ^ 0x8005;
-            else
-                crc <<= 1;
+    return crc16_t::compute(data, size);
+}
+
+// Reflected crc32 tables for slice by 8, built at compile time
+template<uint32_t Poly>
+struct crc32_tables final {
+    static constexpr auto make() {
+        std::array<std::array<uint32_t, 256>, 8> result{};
+        for(uint32_t pos = 0; pos < 256; ++pos) {
+            auto crc = pos;
+            for(auto bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? Poly ^ (crc >> 1) : crc >> 1;
+            result[0][pos] = crc;
         }
+        for(std::size_t pos = 0; pos < 256; ++pos) {
+            for(std::size_t slice = 1; slice < 8; ++slice) {
+                const auto prior = result[slice - 1][pos];
+                result[slice][pos] = (prior >> 8) ^ result[0][prior & 0xff];
+            }
+        }
+        return result;
     }
+
+    static constexpr auto table = make();
+};
+
+// crc here is the working register, inverted from the public value
+template<uint32_t Poly>
+inline auto crc32_slice(uint32_t crc, const uint8_t *data, std::size_t size) -> uint32_t {
+    const auto& table = crc32_tables<Poly>::table;
+    for(; size >= 8; size -= 8, data += 8) {
+        const auto lo = crc ^ (uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24));
+        const auto hi = uint32_t(data[4]) | (uint32_t(data[5]) << 8) | (uint32_t(data[6]) << 16) | (uint32_t(data[7]) << 24);
+        crc = table[7][lo & 0xff] ^ table[6][(lo >> 8) & 0xff] ^ table[5][(lo >> 16) & 0xff] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xff] ^ table[2][(hi >> 8) & 0xff] ^ table[1][(hi >> 16) & 0xff] ^ table[0][hi >> 24];
+    }
+    while(size--)
+        crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
     return crc;
 }
 
-inline auto crc32(const uint8_t *data, std::size_t size) {
-    static crc32_t table[256]{0};
-    crc32_t crc = 0xffffffff;
+struct crc32_kernels final {
+    using update_t = uint32_t (*)(uint32_t, const uint8_t *, std::size_t);
 
-    for (std::size_t i = 0; i < 256; i++) {
-        crc32_t c = i;
-        for (std::size_t j = 0; j < 8; j++)
-            c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
-        table[i] = c;
+    update_t crc32{&crc32_slice<0xedb88320>};
+    update_t crc32c{&crc32_slice<0x82f63b78>};
+};
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("sse4.2"))) inline auto crc32c_sse42(uint32_t crc, const uint8_t *data, std::size_t size) -> uint32_t {
+#if defined(__x86_64__)
+    uint64_t wide = crc;
+    for(; size >= 8; size -= 8, data += 8) {
+        uint64_t word{};
+        memcpy(&word, data, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = uint32_t(wide);
+#endif
+    for(; size >= 4; size -= 4, data += 4) {
+        uint32_t word{};
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
     }
+    while(size--)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+
+__attribute__((target("sse4.1,pclmul"))) inline auto crc32_fold(__m128i value, __m128i keys, __m128i next) -> __m128i {
+    const auto lo = _mm_clmulepi64_si128(value, keys, 0x00);
+    const auto hi = _mm_clmulepi64_si128(value, keys, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+// Carry-less multiply folding of 64 byte blocks, reduced to 32 bits by
+// barrett reduction, with the folding constants for the reflected
+// 0x04c11db7 polynomial. Short input and tails use the tables.
+__attribute__((target("sse4.1,pclmul"))) inline auto crc32_pclmul(uint32_t crc, const uint8_t *data, std::size_t size) -> uint32_t {
+    if(size < 64)
+        return crc32_slice<0xedb88320>(crc, data, size);
+
+    const auto load = [](const uint8_t *from) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(from));
+    };
 
-    for(std::size_t i = 0; i < size; i++)
-        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    auto x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(int(crc)));
+    auto x2 = load(data + 16), x3 = load(data + 32), x4 = load(data + 48);
+    auto keys = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    data += 64;
+    size -= 64;
+    for(; size >= 64; size -= 64, data += 64) {
+        x1 = crc32_fold(x1, keys, load(data));
+        x2 = crc32_fold(x2, keys, load(data + 16));
+        x3 = crc32_fold(x3, keys, load(data + 32));
+        x4 = crc32_fold(x4, keys, load(data + 48));
+    }
 
-    return crc ^ 0xffffffff;
+    keys = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    x1 = crc32_fold(x1, keys, x2);
+    x1 = crc32_fold(x1, keys, x3);
+    x1 = crc32_fold(x1, keys, x4);
+    for(; size >= 16; size -= 16, data += 16)
+        x1 = crc32_fold(x1, keys, load(data));
+
+    const auto low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, keys, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), _mm_set_epi64x(0, 0x0163cd6124), 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    const auto poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), poly, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, low32), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return crc32_slice<0xedb88320>(uint32_t(_mm_extract_epi32(x1, 1)), data, size);
 }
+
+inline auto crc32_simd() -> const crc32_kernels& {
+    static const crc32_kernels kernels = [] {
+        crc32_kernels found;
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("sse4.2"))
+            found.crc32c = &crc32c_sse42;
+        if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+            found.crc32 = &crc32_pclmul;
+        return found;
+    }();
+    return kernels;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+inline auto crc32_armv8(uint32_t crc, const uint8_t *data, std::size_t size) -> uint32_t {
+    for(; size >= 8; size -= 8, data += 8) {
+        uint64_t word{};
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32d(crc, word);
+    }
+    while(size--)
+        crc = __crc32b(crc, *data++);
+    return crc;
+}
+
+inline auto crc32c_armv8(uint32_t crc, const uint8_t *data, std::size_t size) -> uint32_t {
+    for(; size >= 8; size -= 8, data += 8) {
+        uint64_t word{};
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    while(size--)
+        crc = __crc32cb(crc, *data++);
+    return crc;
+}
+
+inline auto crc32_simd() -> const crc32_kernels& {
+    static const crc32_kernels kernels{&crc32_armv8, &crc32c_armv8};
+    return kernels;
+}
+#else
+inline auto crc32_simd() -> const crc32_kernels& {
+    static const crc32_kernels kernels{};
+    return kernels;
+}
+#endif
+
+// ieee 802.3 crc, a prior result may be passed to continue a sum
+inline auto crc32(const uint8_t *data, std::size_t size, uint32_t crc = 0) -> uint32_t {
+    return ~crc32_simd().crc32(~crc, data, size);
+}
+
+// castagnoli crc as used by iscsi, sctp, and ext4
+inline auto crc32c(const uint8_t *data, std::size_t size, uint32_t crc = 0) -> uint32_t {
+    return ~crc32_simd().crc32c(~crc, data, size);
+}
+
+// Running crc over partial reads. It holds the finished value at every
+// step, so it converts to and from a plain crc.
+template<uint32_t (*Update)(const uint8_t *, std::size_t, uint32_t)>
+class crc32_sum final {
+public:
+    constexpr crc32_sum() noexcept = default;
+    constexpr crc32_sum(uint32_t crc) noexcept : crc_(crc) {} // NOLINT
+
+    constexpr operator uint32_t() const noexcept {
+        return crc_;
+    }
+
+    auto update(const void *data, std::size_t size) noexcept -> crc32_sum& {
+        crc_ = Update(static_cast<const uint8_t *>(data), size, crc_);
+        return *this;
+    }
+
+    auto update(std::string_view text) noexcept -> crc32_sum& {
+        return update(text.data(), text.size());
+    }
+
+    constexpr auto value() const noexcept {
+        return crc_;
+    }
+
+    constexpr void reset() noexcept {
+        crc_ = 0;
+    }
+
+private:
+    uint32_t crc_{0};
+};
+
+using crc32_t = crc32_sum<&crc32>;
+using crc32c_t = crc32_sum<&crc32c>;
 } // end namespace
 #endif
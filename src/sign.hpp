@@ -7,11 +7,20 @@
 #include <string>
 #include <memory.hpp>
 #include <string_view>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <algorithm>
+#include <atomic>
 #include <openssl/ec.h>
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/core_names.h>
 
+#include "digest.hpp"
+#include "encoding.hpp"
+#include "hashmap.hpp"
+
 namespace tycho::crypto {
 class pubkey_t final {
 public:
@@ -104,6 +113,23 @@ public:
         return key_;
     }
 
+    // borrowed key, not referenced
+    auto get() const noexcept -> EVP_PKEY * {
+        return key_;
+    }
+
+    // sha256 of the der public key, as lowercase hex
+    auto fingerprint() const -> std::string {
+        uint8_t *der{nullptr};
+        auto len = key_ ? i2d_PUBKEY(key_, &der) : 0;
+        if(len <= 0)
+            return {};
+        uint8_t md[EVP_MAX_MD_SIZE];
+        auto size = digest(der, std::size_t(len), md);
+        OPENSSL_free(der);
+        return to_hex(md, size);
+    }
+
 private:
     EVP_PKEY *key_{nullptr};
 };
@@ -171,14 +197,20 @@ public:
     auto finish() noexcept {
         if(!ctx_ || size_ > 0)
             return false;
-        return EVP_DigestSignFinal(ctx_, data_, &size_) > 0;
+        size_ = sizeof(data_);
+        if(EVP_DigestSignFinal(ctx_, data_, &size_) > 0)
+            return true;
+        size_ = 0;
+        return false;
     }
 
 private:
+    static constexpr std::size_t maxsize = 1024;    // der ecdsa or rsa 8192
+
     EVP_MD_CTX *ctx_{nullptr};
     EVP_PKEY *key_{nullptr};
     std::size_t size_{0};
-    uint8_t data_[EVP_MAX_MD_SIZE]{};
+    uint8_t data_[maxsize]{};
 };
 
 class verify_t final {
@@ -237,5 +269,144 @@ private:
     EVP_MD_CTX *ctx_{nullptr};
     EVP_PKEY *key_{nullptr};
 };
+
+// one signature of a batch, id names a key held by the verifier
+struct verify_item {
+    std::string_view id;
+    std::string_view msg;
+    std::string_view sig;
+};
+
+// Verifier with parsed public keys cached by id, typically a fingerprint
+// or key id from the token. Keys are shared read-only across threads, and
+// batches reuse one digest context per worker. Ed25519 and Ed448 keys are
+// verified as one-shot pure signatures, without a digest.
+class verifier final {
+public:
+    explicit verifier(std::size_t limit = 256, const EVP_MD *md = EVP_sha256()) noexcept :
+    limit_(limit ? limit : 1), md_(md) {}
+
+    verifier(const verifier&) = delete;
+    auto operator=(const verifier&) -> auto& = delete;
+
+    // parse and cache a pem key, returns its fingerprint or empty
+    auto insert(const std::string& pem) -> std::string {
+        const pubkey_t key(pem);
+        if(!key)
+            return {};
+        auto id = key.fingerprint();
+        insert(id, key);
+        return id;
+    }
+
+    // the least recently used key makes room once the limit is reached
+    void insert(const std::string& id, const pubkey_t& key) {
+        const std::unique_lock lock(lock_);
+        const auto stamp = uses_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if(keys_.size() >= limit_ && !keys_.contains(id)) {
+            auto victim = std::min_element(keys_.begin(), keys_.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.second.used.load(std::memory_order_relaxed) < rhs.second.used.load(std::memory_order_relaxed);
+            });
+            keys_.erase(victim->first);
+        }
+        keys_.insert_or_assign(id, kept_t{key, stamp});
+    }
+
+    auto erase(const std::string& id) {
+        const std::unique_lock lock(lock_);
+        return keys_.erase(id) > 0;
+    }
+
+    auto contains(std::string_view id) const {
+        const std::shared_lock lock(lock_);
+        return keys_.contains(id);
+    }
+
+    auto size() const {
+        const std::shared_lock lock(lock_);
+        return keys_.size();
+    }
+
+    void clear() {
+        const std::unique_lock lock(lock_);
+        keys_.clear();
+    }
+
+    auto verify(std::string_view id, std::string_view msg, std::string_view sig) const {
+        auto ctx = EVP_MD_CTX_new();
+        if(!ctx)
+            return false;
+        auto result = check(ctx, id, msg, sig);
+        EVP_MD_CTX_free(ctx);
+        return result;
+    }
+
+    // verify count items across threads, results may be null; returns the
+    // number of valid signatures
+    auto verify(const verify_item *list, std::size_t count, bool *results = nullptr, std::size_t threads = 0) const -> std::size_t {
+        constexpr std::size_t batch = 32;
+        std::atomic<std::size_t> valid{0};
+        parallel_jobs((count + batch - 1) / batch, threads, [&](std::size_t index) {
+            auto ctx = EVP_MD_CTX_new();
+            std::size_t passed = 0;
+            const auto last = std::min(count, (index + 1) * batch);
+            for(auto pos = index * batch; pos < last; ++pos) {
+                const auto ok = ctx && check(ctx, list[pos].id, list[pos].msg, list[pos].sig);
+                if(results)
+                    results[pos] = ok;
+                if(ok)
+                    ++passed;
+            }
+            EVP_MD_CTX_free(ctx);
+            valid += passed;
+            return true;
+        });
+        return valid;
+    }
+
+private:
+    // a cached key and its last use, stamped under the shared lock
+    struct kept_t final {
+        pubkey_t key;
+        mutable std::atomic<uint64_t> used{0};
+
+        kept_t(const pubkey_t& from, uint64_t stamp) noexcept : key(from), used(stamp) {}
+        kept_t(const kept_t& other) noexcept : key(other.key), used(other.used.load(std::memory_order_relaxed)) {}
+
+        auto operator=(const kept_t& other) noexcept -> kept_t& {
+            key = other.key;
+            used.store(other.used.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    mutable std::shared_mutex lock_;
+    flat_map<std::string, kept_t> keys_;
+    std::size_t limit_;
+    const EVP_MD *md_;
+    mutable std::atomic<uint64_t> uses_{0};
+
+    auto find(std::string_view id) const -> EVP_PKEY * {
+        const std::shared_lock lock(lock_);
+        auto entry = keys_.find(id);
+        if(entry == keys_.end())
+            return nullptr;
+        entry->second.used.store(uses_.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return entry->second.key.share();
+    }
+
+    auto check(EVP_MD_CTX *ctx, std::string_view id, std::string_view msg, std::string_view sig) const -> bool {
+        auto key = find(id);
+        if(!key)
+            return false;
+        const auto type = EVP_PKEY_get_base_id(key);
+        const auto md = (type == EVP_PKEY_ED25519 || type == EVP_PKEY_ED448) ? nullptr : md_;
+        EVP_MD_CTX_reset(ctx);
+        auto result = EVP_DigestVerifyInit(ctx, nullptr, md, nullptr, key) == 1 &&
+            EVP_DigestVerify(ctx, reinterpret_cast<const uint8_t *>(sig.data()), sig.size(), reinterpret_cast<const uint8_t *>(msg.data()), msg.size()) == 1;
+        EVP_PKEY_free(key);
+        return result;
+    }
+};
 } // end namespace
 #endif
@@ -6,8 +6,11 @@
 
 #include <string>
 #include <ostream>
+#include <algorithm>
 #include <cstring>
 #include <cstdint>
+#include <atomic>
+#include <ctime>
 
 #include <sys/types.h>
 #include <fcntl.h>
@@ -30,6 +33,11 @@ using ssize_t = SSIZE_T;
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <iphlpapi.h>
+#include <mswsock.h>
+#include <io.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "mswsock.lib")
+#endif
 #ifdef AF_UNIX
 #include <afunix.h>
 #endif
@@ -37,12 +45,28 @@ using ssize_t = SSIZE_T;
 #include <sys/socket.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/un.h>
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
 #include <poll.h>
 #include <ifaddrs.h>
+#if __has_include(<netinet/udp.h>)
+#include <netinet/udp.h>
+#endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#if __has_include(<linux/errqueue.h>)
+#include <linux/errqueue.h>
+#endif
+#if __has_include(<linux/net_tstamp.h>)
+#include <linux/net_tstamp.h>
+#endif
+#elif defined(__FreeBSD__) || defined(__DragonFly__) || defined(__APPLE__)
+#include <sys/uio.h>
+#define USE_BSD_SENDFILE
+#endif
 #define SOCKET int
 #endif
 
@@ -50,6 +74,10 @@ using ssize_t = SSIZE_T;
 #define MSG_NOSIGNAL    0   // NOLINT
 #endif
 
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY    0   // NOLINT
+#endif
+
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP     IP_ADD_MEMBERSHIP
 #endif
@@ -365,6 +393,29 @@ private:
     }
 };
 
+// One datagram of a batch; size is the buffer or payload length and used is
+// what the kernel moved. addr is the peer for a receive, the target on send.
+struct datagram_t {
+    void *data{nullptr};
+    std::size_t size{0};
+    std::size_t used{0};
+    address_t addr;
+};
+
+// Socket i/o counters, shared by any sockets they are attached to. Calls
+// are syscalls, again is would-block results and errors all other errors.
+struct socket_counters {
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_out{0};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> again{0};
+    std::atomic<uint64_t> errors{0};
+
+    void clear() noexcept {
+        bytes_in = bytes_out = calls = again = errors = 0;
+    }
+};
+
 #ifndef EAI_ADDRFAMILY
 #define EAI_ADDRFAMILY EAI_NODATA + 2000    // NOLINT
 #endif
@@ -800,7 +851,7 @@ public:
     Socket(const Socket& from) = delete;
     auto operator=(const Socket& from) = delete;
 
-    Socket(Socket&& from) noexcept : so_(from.so_), err_(from.err_) {
+    Socket(Socket&& from) noexcept : so_(from.so_), err_(from.err_), counters_(from.counters_) {
         from.so_ = -1;
     }
 
@@ -831,6 +882,7 @@ public:
         release();
         so_ = from.so_;
         err_ = from.err_;
+        counters_ = from.counters_;
         from.so_ = -1;
         return *this;
     }
@@ -885,15 +937,17 @@ public:
     void bind(const Socket::service& list) noexcept {
         auto addr = *list;
         release();
-        while(addr) {
+        for(; addr; addr = addr->ai_next) {
             so_ = set_error(make_socket(::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol)));
             if(so_ == -1)
                 continue;
 
-            if(set_error(::bind(so_, addr->ai_addr, make_socklen(addr->ai_addrlen)) == -1)) {
+            reuse(true);
+            if(set_error(::bind(so_, addr->ai_addr, make_socklen(addr->ai_addrlen))) == -1) {
                 release();
                 continue;
             }
+            break;
         }
     }
 
@@ -906,7 +960,7 @@ public:
     void connect(const Socket::service& list) noexcept {
         auto addr = *list;
         release();
-        while(addr) {
+        for(; addr; addr = addr->ai_next) {
             so_ = set_error(make_socket(::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol)));
             if(so_ == -1)
                 continue;
@@ -915,6 +969,7 @@ public:
                 release();
                 continue;
             }
+            break;
         }
     }
 
@@ -1016,6 +1071,67 @@ public:
 #endif
     }
 
+    auto blocking(bool flag) noexcept {
+#ifdef USE_CLOSESOCKET
+        u_long opt = flag ? 0 : 1;
+        return set_error(ioctlsocket(SOCKET(so_), FIONBIO, &opt)) == 0;
+#else
+        auto flags = fcntl(so_, F_GETFL, 0);
+        if(flags == -1)
+            return set_error(-1) == 0;
+        return set_error(fcntl(so_, F_SETFL, flag ? flags & ~O_NONBLOCK : flags | O_NONBLOCK)) == 0;
+#endif
+    }
+
+    auto nodelay(bool flag) noexcept {
+        int opt = flag ? 1 : 0;
+        return set_error(setsockopt(so_, IPPROTO_TCP, TCP_NODELAY, opt_cast(&opt), sizeof(opt))) == 0;
+    }
+
+    // wake accept only once the client has sent data, up to seconds
+    auto defer_accept(int seconds) noexcept {
+#if defined(TCP_DEFER_ACCEPT)
+        return set_error(setsockopt(so_, IPPROTO_TCP, TCP_DEFER_ACCEPT, opt_cast(&seconds), sizeof(seconds))) == 0;
+#else
+        static_cast<void>(seconds);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // accept data in the syn from clients that hold a fastopen cookie
+    auto fastopen(int pending) noexcept {
+#if defined(TCP_FASTOPEN)
+        return set_error(setsockopt(so_, IPPROTO_TCP, TCP_FASTOPEN, opt_cast(&pending), sizeof(pending))) == 0;
+#else
+        static_cast<void>(pending);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // spin on the device queue for up to usecs before sleeping in recv
+    auto busy_poll(int usecs) noexcept {
+#if defined(SO_BUSY_POLL)
+        return set_error(setsockopt(so_, SOL_SOCKET, SO_BUSY_POLL, opt_cast(&usecs), sizeof(usecs))) == 0;
+#else
+        static_cast<void>(usecs);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // steer a reuseport listener to connections handled on cpu
+    auto incoming_cpu(int cpu) noexcept {
+#if defined(SO_INCOMING_CPU)
+        return set_error(setsockopt(so_, SOL_SOCKET, SO_INCOMING_CPU, opt_cast(&cpu), sizeof(cpu))) == 0;
+#else
+        static_cast<void>(cpu);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
     void listen(int backlog = 5) noexcept {
         if(so_ != -1 && set_error(::listen(so_, backlog)) == -1)
             release();
@@ -1078,20 +1194,20 @@ public:
     auto send(const void *from, std::size_t size, int flags = 0) const noexcept {
         if(so_ == -1)
             return io_error(-EBADF);
-        return io_error(::send(so_, static_cast<const char *>(from), int(size), flags));
+        return io_count(::send(so_, static_cast<const char *>(from), int(size), flags), true);
     }
 
     auto recv(void *to, std::size_t size, int flags = 0) const noexcept {
         if(so_ == -1)
             return io_error(-EBADF);
-        return io_error(::recv(so_, static_cast<char *>(to), int(size), flags));
+        return io_count(::recv(so_, static_cast<char *>(to), int(size), flags), false);
     }
 
     auto send(const void *from, std::size_t size, const address_t addr, int flags = 0) const noexcept {
         if(so_ == -1)
             return io_error(-EBADF);
 
-        return io_error(::sendto(so_, static_cast<const char *>(from), int(size), flags, addr.data(), addr.size()));
+        return io_count(::sendto(so_, static_cast<const char *>(from), int(size), flags, addr.data(), addr.size()), true);
     }
 
     auto recv(void *to, std::size_t size, address_t& addr, int flags = 0) const noexcept {
@@ -1099,7 +1215,319 @@ public:
         if(so_ == -1)
             return io_error(-EBADF);
 
-        return io_error(::recvfrom(so_, static_cast<char *>(to), int(size), flags, addr.data(), &len));
+        return io_count(::recvfrom(so_, static_cast<char *>(to), int(size), flags, addr.data(), &len), false);
+    }
+
+    // receive with the kernel arrival time when timestamps are enabled,
+    // stamp is left zero when none was delivered with the packet
+    auto recv(void *to, std::size_t size, address_t& addr, struct timespec& stamp, int flags = 0) const noexcept -> std::size_t {
+        stamp = {};
+#ifdef USE_CLOSESOCKET
+        return recv(to, size, addr, flags);
+#else
+        if(so_ == -1)
+            return io_error(-EBADF);
+
+        alignas(struct cmsghdr) char control[256];
+        struct iovec iov{to, size};
+        struct msghdr msg{};
+        msg.msg_name = addr.data();
+        msg.msg_namelen = address_t::maxsize;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        auto result = ::recvmsg(so_, &msg, flags);
+        if(result >= 0)
+            arrival(msg, stamp);
+        return io_count(result, false);
+#endif
+    }
+
+    // receive up to count datagrams, waiting only for the first one
+    auto recv(datagram_t *list, std::size_t count, int flags = 0) const noexcept -> std::size_t {
+        if(so_ == -1) {
+            err_ = EBADF;
+            return 0;
+        }
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+        std::size_t total = 0;
+        while(total < count) {
+            struct mmsghdr msgs[batch_size]{};
+            struct iovec iov[batch_size]{};
+            const auto chunk = std::min(count - total, batch_size);
+            for(std::size_t pos = 0; pos < chunk; ++pos) {
+                auto& item = list[total + pos];
+                iov[pos].iov_base = item.data;
+                iov[pos].iov_len = item.size;
+                msgs[pos].msg_hdr.msg_iov = &iov[pos];
+                msgs[pos].msg_hdr.msg_iovlen = 1;
+                msgs[pos].msg_hdr.msg_name = item.addr.data();
+                msgs[pos].msg_hdr.msg_namelen = address_t::maxsize;
+            }
+            auto result = ::recvmmsg(so_, msgs, unsigned(chunk), flags | (total ? MSG_DONTWAIT : MSG_WAITFORONE), nullptr);
+            if(result <= 0) {
+                tally(0, false, result < 0 ? errno : 0);
+                if(!total)
+                    set_error(result);
+                break;
+            }
+            std::size_t bytes = 0;
+            for(auto pos = 0; pos < result; ++pos)
+                bytes += list[total + std::size_t(pos)].used = msgs[pos].msg_len;
+            tally(bytes, false, 0);
+            total += std::size_t(result);
+            if(std::size_t(result) < chunk)
+                break;
+        }
+        return total;
+#else
+        std::size_t total = 0;
+        while(total < count) {
+            auto& item = list[total];
+            auto again = flags;
+#ifdef MSG_DONTWAIT
+            if(total)
+                again |= MSG_DONTWAIT;
+#endif
+            auto len = address_t::maxsize;
+            auto result = ::recvfrom(so_, static_cast<char *>(item.data), int(item.size), again, item.addr.data(), &len);
+            if(result < 0) {
+                tally(0, false, errno);
+                if(!total)
+                    set_error(-1);
+                break;
+            }
+            item.used = std::size_t(result);
+            tally(item.used, false, 0);
+            ++total;
+        }
+        return total;
+#endif
+    }
+
+    // send datagrams in order, returns how many were accepted
+    auto send(datagram_t *list, std::size_t count, int flags = 0) const noexcept -> std::size_t {
+        if(so_ == -1) {
+            err_ = EBADF;
+            return 0;
+        }
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+        std::size_t total = 0;
+        while(total < count) {
+            struct mmsghdr msgs[batch_size]{};
+            struct iovec iov[batch_size]{};
+            const auto chunk = std::min(count - total, batch_size);
+            for(std::size_t pos = 0; pos < chunk; ++pos) {
+                auto& item = list[total + pos];
+                iov[pos].iov_base = item.data;
+                iov[pos].iov_len = item.size;
+                msgs[pos].msg_hdr.msg_iov = &iov[pos];
+                msgs[pos].msg_hdr.msg_iovlen = 1;
+                if(!item.addr.empty()) {
+                    msgs[pos].msg_hdr.msg_name = item.addr.data();
+                    msgs[pos].msg_hdr.msg_namelen = item.addr.size();
+                }
+            }
+            auto result = ::sendmmsg(so_, msgs, unsigned(chunk), flags);
+            if(result <= 0) {
+                tally(0, true, result < 0 ? errno : 0);
+                set_error(result);
+                break;
+            }
+            std::size_t bytes = 0;
+            for(auto pos = 0; pos < result; ++pos)
+                bytes += list[total + std::size_t(pos)].used = msgs[pos].msg_len;
+            tally(bytes, true, 0);
+            total += std::size_t(result);
+            if(std::size_t(result) < chunk)
+                break;
+        }
+        return total;
+#else
+        std::size_t total = 0;
+        while(total < count) {
+            auto& item = list[total];
+            auto result = item.addr.empty() ?
+                ::send(so_, static_cast<const char *>(item.data), int(item.size), flags) :
+                ::sendto(so_, static_cast<const char *>(item.data), int(item.size), flags, item.addr.data(), item.addr.size());
+            if(result < 0) {
+                tally(0, true, errno);
+                set_error(-1);
+                break;
+            }
+            item.used = std::size_t(result);
+            tally(item.used, true, 0);
+            ++total;
+        }
+        return total;
+#endif
+    }
+
+    // kernel receive timestamps for recv with a stamp, hardware requests
+    // nic stamps where supported and falls back to software ones
+    auto timestamps(bool flag, bool hardware = false) noexcept {
+#if defined(SO_TIMESTAMPING) && defined(SOF_TIMESTAMPING_RX_HARDWARE)
+        if(hardware) {
+            int opt = flag ? int(SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE) : 0;
+            return set_error(setsockopt(so_, SOL_SOCKET, SO_TIMESTAMPING, opt_cast(&opt), sizeof(opt))) == 0;
+        }
+#else
+        if(hardware) {
+            err_ = ENOTSUP;
+            return false;
+        }
+#endif
+        int opt = flag ? 1 : 0;
+#if defined(SO_TIMESTAMPNS)
+        return set_error(setsockopt(so_, SOL_SOCKET, SO_TIMESTAMPNS, opt_cast(&opt), sizeof(opt))) == 0;
+#elif defined(SO_TIMESTAMP) && !defined(USE_CLOSESOCKET)
+        return set_error(setsockopt(so_, SOL_SOCKET, SO_TIMESTAMP, opt_cast(&opt), sizeof(opt))) == 0;
+#else
+        static_cast<void>(opt);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // counters are not owned and must outlive the socket, nullptr detaches
+    void counters(socket_counters *to) noexcept {
+        counters_ = to;
+    }
+
+    auto counters() const noexcept {
+        return counters_;
+    }
+
+    // udp segmentation offload, one send of size bytes leaves as segments
+    auto gso(uint16_t segment) noexcept {
+#if defined(UDP_SEGMENT)
+        int opt = segment;
+        return set_error(setsockopt(so_, IPPROTO_UDP, UDP_SEGMENT, opt_cast(&opt), sizeof(opt))) == 0;
+#else
+        static_cast<void>(segment);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // udp receive offload, back to back datagrams may be coalesced
+    auto gro(bool flag) noexcept {
+#if defined(UDP_GRO)
+        int opt = flag ? 1 : 0;
+        return set_error(setsockopt(so_, IPPROTO_UDP, UDP_GRO, opt_cast(&opt), sizeof(opt))) == 0;
+#else
+        static_cast<void>(flag);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // kernel copy of count bytes of a file from offset, returns bytes sent
+    auto send_file(int fd, off_t offset, std::size_t count) const noexcept -> std::size_t {
+        if(so_ == -1 || fd < 0) {
+            err_ = EBADF;
+            return 0;
+        }
+        std::size_t total = 0;
+        err_ = 0;
+#if defined(__linux__)
+        while(total < count) {
+            auto result = ::sendfile(so_, fd, &offset, count - total);
+            if(result == -1 && errno == EINTR)
+                continue;
+            if(result == -1 && !total && (errno == EINVAL || errno == ENOSYS))
+                return copy_file(fd, offset, count);
+            if(result <= 0) {
+                if(result == -1)
+                    err_ = errno;
+                break;
+            }
+            total += std::size_t(result);
+        }
+#elif defined(USE_BSD_SENDFILE)
+        while(total < count) {
+            off_t sent = 0;
+#if defined(__APPLE__)
+            sent = off_t(count - total);
+            auto result = ::sendfile(fd, so_, offset, &sent, nullptr, 0);
+#else
+            auto result = ::sendfile(fd, so_, offset, count - total, nullptr, &sent, 0);
+#endif
+            total += std::size_t(sent);
+            offset += sent;
+            if(result == -1 && errno == EINTR)
+                continue;
+            if(result == -1 && !total && (errno == ENOTSOCK || errno == EOPNOTSUPP))
+                return copy_file(fd, offset, count);
+            if(result == -1) {
+                err_ = errno;
+                break;
+            }
+            if(!sent)
+                break;
+        }
+#elif defined(USE_CLOSESOCKET)
+        auto file = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+        while(total < count) {
+            OVERLAPPED ov{};
+            auto pos = uint64_t(offset) + total;
+            ov.Offset = DWORD(pos & 0xffffffff);
+            ov.OffsetHigh = DWORD(pos >> 32);
+            auto chunk = DWORD(std::min(count - total, std::size_t(0x7fffffff)));
+            if(!TransmitFile(SOCKET(so_), file, chunk, 0, &ov, nullptr, 0)) {
+                if(WSAGetLastError() != ERROR_IO_PENDING) {
+                    err_ = WSAGetLastError();
+                    break;
+                }
+                DWORD sent = 0, flags = 0;
+                if(!WSAGetOverlappedResult(SOCKET(so_), &ov, &sent, TRUE, &flags)) {
+                    err_ = WSAGetLastError();
+                    break;
+                }
+                chunk = sent;
+            }
+            if(!chunk)
+                break;
+            total += chunk;
+        }
+#else
+        return copy_file(fd, offset, count);
+#endif
+        return total;
+    }
+
+    // allow MSG_ZEROCOPY sends from pinned user pages, such as a map_t
+    auto zerocopy(bool flag) noexcept {
+#if defined(SO_ZEROCOPY)
+        int opt = flag ? 1 : 0;
+        return set_error(setsockopt(so_, SOL_SOCKET, SO_ZEROCOPY, opt_cast(&opt), sizeof(opt))) == 0;
+#else
+        static_cast<void>(flag);
+        err_ = ENOTSUP;
+        return false;
+#endif
+    }
+
+    // drain zerocopy completions, returns sends whose pages may be reused
+    auto zerocopy_done() const noexcept -> std::size_t {
+        std::size_t done = 0;
+#if defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+        for(;;) {
+            char control[128];
+            struct msghdr msg{};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if(::recvmsg(so_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+                break;
+            for(auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                const auto err = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cmsg));
+                if(err->ee_errno == 0 && err->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+                    done += std::size_t(err->ee_data - err->ee_info) + 1;
+            }
+        }
+#endif
+        return done;
     }
 
 #ifdef USE_CLOSESOCKET
@@ -1144,8 +1572,61 @@ public:
 #endif
 
 protected:
+    static constexpr std::size_t batch_size = 64;
+
     volatile int so_{-1};
     mutable int err_{0};
+    socket_counters *counters_{nullptr};
+
+    void tally(std::size_t bytes, bool out, int error) const noexcept {
+        if(!counters_)
+            return;
+        counters_->calls.fetch_add(1, std::memory_order_relaxed);
+        if(bytes)
+            (out ? counters_->bytes_out : counters_->bytes_in).fetch_add(bytes, std::memory_order_relaxed);
+        if(error == EAGAIN || error == EWOULDBLOCK)
+            counters_->again.fetch_add(1, std::memory_order_relaxed);
+        else if(error)
+            counters_->errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto io_count(ssize_t size, bool out) const noexcept -> std::size_t {
+        auto result = io_error(size);
+        tally(result, out, err_);
+        return result;
+    }
+
+#ifndef USE_CLOSESOCKET
+    static void arrival(struct msghdr& msg, struct timespec& stamp) noexcept {
+        for(auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(cmsg->cmsg_level != SOL_SOCKET)
+                continue;
+#if defined(SCM_TIMESTAMPING)
+            if(cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                struct timespec list[3]{};
+                memcpy(list, CMSG_DATA(cmsg), sizeof(list));
+                stamp = (list[2].tv_sec || list[2].tv_nsec) ? list[2] : list[0];
+                return;
+            }
+#endif
+#if defined(SCM_TIMESTAMPNS)
+            if(cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+                return;
+            }
+#endif
+#if defined(SCM_TIMESTAMP)
+            if(cmsg->cmsg_type == SCM_TIMESTAMP) {
+                struct timeval tv{};
+                memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+                stamp.tv_sec = tv.tv_sec;
+                stamp.tv_nsec = long(tv.tv_usec) * 1000L;
+                return;
+            }
+#endif
+        }
+    }
+#endif
 
     auto io_error(ssize_t size) const noexcept -> std::size_t {
         if(size == -1) {
@@ -1173,6 +1654,38 @@ protected:
         return static_cast<const char *>(from);
     }
 
+#ifndef USE_CLOSESOCKET
+    auto copy_file(int fd, off_t offset, std::size_t count) const noexcept -> std::size_t {
+        char buf[16384];
+        std::size_t total = 0;
+        err_ = 0;
+        while(total < count) {
+            auto result = ::pread(fd, buf, std::min(count - total, sizeof(buf)), offset);
+            if(result == -1 && errno == EINTR)
+                continue;
+            if(result <= 0) {
+                if(result == -1)
+                    err_ = errno;
+                break;
+            }
+            std::size_t used = 0;
+            while(used < std::size_t(result)) {
+                auto sent = ::send(so_, buf + used, std::size_t(result) - used, MSG_NOSIGNAL);
+                if(sent == -1 && errno == EINTR)
+                    continue;
+                if(sent <= 0) {
+                    err_ = errno;
+                    return total + used;
+                }
+                used += std::size_t(sent);
+            }
+            total += used;
+            offset += off_t(used);
+        }
+        return total;
+    }
+#endif
+
 private:
 #ifdef USE_CLOSESOCKET
     static auto make_socket(SOCKET so) noexcept -> int {
@@ -1223,6 +1736,10 @@ inline auto recv(const Socket& sock, T& msg, address_t& addr, int flags = 0) {
     return sock.recv(&msg, sizeof(msg), addr, flags);
 }
 
+inline auto send_file(const Socket& sock, int fd, off_t offset, std::size_t count) {
+    return sock.send_file(fd, offset, count);
+}
+
 // internet helper utils...
 
 inline auto inet_size(const struct sockaddr *addr) noexcept -> socklen_t {
@@ -4,9 +4,17 @@
 #ifndef TYCHO_STREAM_HPP_
 #define TYCHO_STREAM_HPP_
 
+#include "metrics.hpp"
+
 #include <system_error>
 #include <iostream>
+#include <memory>
+#include <algorithm>
+#include <initializer_list>
+#include <chrono>
+#include <cstring>
 #include <cerrno>
+#include <cstdint>
 
 #include <sys/types.h>
 #include <fcntl.h>
@@ -27,8 +35,10 @@ using ssize_t = SSIZE_T;
 #include <windows.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <io.h>
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -36,6 +46,9 @@ using ssize_t = SSIZE_T;
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
 #include <poll.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 #endif
 
 #ifndef MSG_NOSIGNAL
@@ -43,11 +56,19 @@ using ssize_t = SSIZE_T;
 #endif
 
 namespace tycho {
+// one piece of a gathered write
+struct io_part {
+    const void *data{nullptr};
+    std::size_t size{0};
+};
+
+// Unsharded latency histogram a stream may record sends or receives into
+using io_latency = metrics::latency_t<1>;
+
+// S is the default buffer size, streams may be sized larger at runtime
 template <std::size_t S = 536>
 class socket_stream : protected std::streambuf, public std::iostream {
 public:
-    inline static const auto maxsize = S;
-
     // typically used to accept a tcp session from a listener socket
     socket_stream(int from, const struct sockaddr *peer, std::size_t size = S) :
     std::iostream(static_cast<std::streambuf *>(this)), so_(from), family_(peer ? peer->sa_family : AF_UNSPEC) {
@@ -84,10 +105,15 @@ public:
         allocate(size);
     }
 
-    socket_stream(socket_stream&& from) noexcept : std::iostream(static_cast<std::streambuf *>(this)), so_(from.so_), family_(from.family_) {
+    socket_stream(socket_stream&& from) noexcept :
+    std::iostream(static_cast<std::streambuf *>(this)), gbuf(std::move(from.gbuf)), pbuf(std::move(from.pbuf)), bufsize(from.bufsize), getsize(from.getsize), so_(from.so_), family_(from.family_), send_latency_(from.send_latency_), recv_latency_(from.recv_latency_) {
+        setg(from.eback(), from.gptr(), from.egptr());
+        setp(from.pbase(), from.epptr());
+        pbump(int(from.pptr() - from.pbase()));
         from.so_ = -1;
-        from.allocate(0);
-        allocate(S);
+        from.setg(nullptr, nullptr, nullptr);
+        from.setp(nullptr, nullptr);
+        from.bufsize = from.getsize = 0;
     }
 
     ~socket_stream() override {
@@ -103,13 +129,66 @@ public:
         if(!len)
             return 0;
 
-        if(send_socket(pbase(), len)) {
-            setp(pbuf, pbuf + bufsize);
+        metrics::count(&metrics::library_t::stream_sync);
+        const auto start = send_latency_ ? metrics::now() : 0;
+        const auto result = write_all(pbase(), std::size_t(len));
+        if(send_latency_)
+            send_latency_->record(metrics::now() - start);
+        if(result) {
+            setp(pbuf.get(), pbuf.get() + bufsize);
             return 0;
         }
         return -1;
     }
 
+    using std::ostream::flush;
+
+    // send pending output followed by parts in one gathered write, so a
+    // header and body go out together without being copied into one buffer
+    auto flush(std::initializer_list<io_part> parts) -> bool {
+        io_part list[max_parts];
+        std::size_t count = 0;
+        list[count++] = io_part{pbase(), std::size_t(pptr() - pbase())};
+        for(const auto& part : parts) {
+            if(count == max_parts) {
+                if(!write_parts(list, count))
+                    return false;
+                count = 0;
+            }
+            list[count++] = part;
+        }
+        if(!write_parts(list, count))
+            return false;
+        setp(pbuf.get(), pbuf.get() + bufsize);
+        return true;
+    }
+
+    auto flush(const void *data, std::size_t size) -> bool {
+        return flush({io_part{data, size}});
+    }
+
+    // send part of a file after pending output, kernel copied when the
+    // stream writes straight to the socket
+    auto send_file(int fd, off_t offset, std::size_t count) -> std::size_t {
+        if(so_ == -1 || fd < 0 || sync() != 0)
+            return 0;
+        return write_file(fd, offset, count);
+    }
+
+    // resize buffers, pending output is flushed and unread input kept
+    void buffer_size(std::size_t size) {
+        if(sync() != 0)
+            return;
+        const auto unread = std::size_t(egptr() - gptr());
+        auto keep = std::move(gbuf);
+        auto from = gptr();
+        allocate(std::max(size, unread));
+        if(unread) {
+            memcpy(gbuf.get(), from, unread); // FlawFinder: ignore
+            setg(gbuf.get(), gbuf.get(), gbuf.get() + unread);
+        }
+    }
+
     auto is_open() const noexcept {
         return so_ != -1;
     }
@@ -130,6 +209,13 @@ public:
         return bufsize;
     }
 
+    // time buffer flushes and refills, histograms must outlive the stream
+    // and may be shared; nullptr leaves that direction untimed
+    void latency(io_latency *send, io_latency *recv) noexcept {
+        send_latency_ = send;
+        recv_latency_ = recv;
+    }
+
     void stop() {                       // may be called from another thread
         auto so = so_;
         so_ = -1;
@@ -167,7 +253,9 @@ public:
     }
 
 protected:
-    char gbuf[S]{}, pbuf[S]{};
+    static constexpr std::size_t max_parts = 16;
+
+    std::unique_ptr<char[]> gbuf, pbuf;
     // cppcheck-suppress unusedStructMember
     std::size_t bufsize{0}, getsize{0};
 
@@ -205,24 +293,144 @@ protected:
         if(!size)
             ++size;
 
-        if(size > maxsize)
-            size = maxsize;
-
-        setg(gbuf, gbuf, gbuf);
-        setp(pbuf, pbuf + size);
+        gbuf.reset(new char[size]);
+        pbuf.reset(new char[size]);
+        setg(gbuf.get(), gbuf.get(), gbuf.get());
+        setp(pbuf.get(), pbuf.get() + size);
         bufsize = getsize = size;
     }
 
+    // transport hooks, overridden by streams that wrap the socket
+    virtual auto read_some(char *data, std::size_t size) -> std::size_t {
+        return recv_socket(data, size);
+    }
+
+    virtual auto write_some(const char *data, std::size_t size) -> std::size_t {
+        return send_socket(data, size);
+    }
+
+    virtual auto write_parts(const io_part *parts, std::size_t count) -> bool {
+        io_part list[max_parts];
+        count = std::min(count, max_parts);
+        std::copy(parts, parts + count, list);
+        std::size_t first = 0;
+        while(first < count) {
+            if(!list[first].size) {
+                ++first;
+                continue;
+            }
+            auto sent = gather_socket(list + first, count - first);
+            if(!sent) {
+                if(errno == EINTR)
+                    continue;
+                return false;
+            }
+            while(sent && first < count) {
+                auto used = std::min(sent, list[first].size);
+                list[first].data = static_cast<const char *>(list[first].data) + used;
+                list[first].size -= used;
+                sent -= used;
+                if(!list[first].size)
+                    ++first;
+            }
+        }
+        return true;
+    }
+
+    virtual auto write_file(int fd, off_t offset, std::size_t count) -> std::size_t {
+        return file_socket(fd, offset, count);
+    }
+
+    // portable file copy through write_all for streams that transform data
+    auto copy_file(int fd, off_t offset, std::size_t count) -> std::size_t {
+        char buf[16384];
+        std::size_t total = 0;
+        while(total < count) {
+            auto len = read_file(fd, buf, std::min(count - total, sizeof(buf)), offset);
+            if(len <= 0 || !write_all(buf, std::size_t(len)))
+                break;
+            total += std::size_t(len);
+            offset += off_t(len);
+        }
+        return total;
+    }
+
+    auto write_all(const char *data, std::size_t size) -> bool {
+        while(size) {
+            auto sent = write_some(data, size);
+            if(!sent) {
+                if(errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
     auto underflow() -> int override {
         if(gptr() == egptr()) {
-            auto len = recv_socket(gbuf, getsize);
+            metrics::count(&metrics::library_t::stream_underflow);
+            const auto start = recv_latency_ ? metrics::now() : 0;
+            auto len = read_some(gbuf.get(), getsize);
+            if(recv_latency_)
+                recv_latency_->record(metrics::now() - start);
             if(!len)
                 return EOF;
-            setg(gbuf, gbuf, gbuf + len);
+            setg(gbuf.get(), gbuf.get(), gbuf.get() + len);
         }
         return get_type(*gptr());
     }
 
+    // large reads bypass the buffer and land in the caller's memory
+    auto xsgetn(char *data, std::streamsize size) -> std::streamsize override {
+        std::streamsize total = 0;
+        while(total < size) {
+            const auto avail = egptr() - gptr();
+            if(avail > 0) {
+                const auto len = std::min(std::streamsize(avail), size - total);
+                memcpy(data + total, gptr(), std::size_t(len)); // FlawFinder: ignore
+                gbump(int(len));
+                total += len;
+                continue;
+            }
+            const auto remains = std::size_t(size - total);
+            if(remains >= getsize) {
+                const auto len = read_some(data + total, remains);
+                if(!len)
+                    break;
+                total += std::streamsize(len);
+                continue;
+            }
+            if(underflow() == EOF)
+                break;
+        }
+        return total;
+    }
+
+    // large writes are gathered with pending output instead of copied
+    auto xsputn(const char *data, std::streamsize size) -> std::streamsize override {
+        if(size <= 0)
+            return 0;
+        const auto room = epptr() - pptr();
+        if(size <= room) {
+            memcpy(pptr(), data, std::size_t(size)); // FlawFinder: ignore
+            pbump(int(size));
+            return size;
+        }
+        if(std::size_t(size) < bufsize) {
+            memcpy(pptr(), data, std::size_t(room)); // FlawFinder: ignore
+            pbump(int(room));
+            if(sync() != 0)
+                return room;
+            memcpy(pptr(), data + room, std::size_t(size - room)); // FlawFinder: ignore
+            pbump(int(size - room));
+            return size;
+        }
+        return flush(data, std::size_t(size)) ? size : 0;
+    }
+
     auto overflow(int c) -> int override {
         if(c == EOF) {
             if(sync() == 0)
@@ -257,6 +465,7 @@ protected:
 private:
     volatile int so_{-1};
     int family_{AF_UNSPEC};
+    io_latency *send_latency_{nullptr}, *recv_latency_{nullptr};
 
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__MINGW64__) || defined(WIN32)
     static auto make_socket(SOCKET so) noexcept {
@@ -292,6 +501,28 @@ private:
     auto recv_socket(void *buffer, std::size_t size) {
         return io_err(::recv(so_, static_cast<char *>(buffer), int(size), 0));
     }
+
+    auto gather_socket(const io_part *parts, std::size_t count) {
+        WSABUF list[max_parts];
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            list[pos].buf = static_cast<char *>(const_cast<void *>(parts[pos].data));
+            list[pos].len = ULONG(parts[pos].size);
+        }
+        DWORD sent{0};
+        if(WSASend(so_, list, DWORD(count), &sent, 0, nullptr, nullptr) != 0)
+            return io_err(-1);
+        return std::size_t(sent);
+    }
+
+    static auto read_file(int fd, char *data, std::size_t size, off_t offset) noexcept -> ssize_t {
+        if(_lseeki64(fd, offset, SEEK_SET) < 0)
+            return -1;
+        return _read(fd, data, unsigned(size));
+    }
+
+    auto file_socket(int fd, off_t offset, std::size_t count) {
+        return copy_file(fd, offset, count);
+    }
 #else
     static auto make_socket(int so) noexcept {
         return so;
@@ -329,6 +560,47 @@ private:
     auto recv_socket(void *buffer, std::size_t size) {
         return io_err(::recv(so_, buffer, size, 0));
     }
+
+    auto gather_socket(const io_part *parts, std::size_t count) {
+        struct iovec list[max_parts];
+        for(std::size_t pos = 0; pos < count; ++pos) {
+            list[pos].iov_base = const_cast<void *>(parts[pos].data);
+            list[pos].iov_len = parts[pos].size;
+        }
+        struct msghdr msg{};
+        msg.msg_iov = list;
+        msg.msg_iovlen = decltype(msg.msg_iovlen)(count);
+        return io_err(::sendmsg(so_, &msg, MSG_NOSIGNAL));
+    }
+
+    static auto read_file(int fd, char *data, std::size_t size, off_t offset) noexcept -> ssize_t {
+        ssize_t result{-1};
+        do {
+            result = ::pread(fd, data, size, offset);
+        } while(result == -1 && errno == EINTR);
+        return result;
+    }
+
+    auto file_socket(int fd, off_t offset, std::size_t count) -> std::size_t {
+#if defined(__linux__)
+        std::size_t total = 0;
+        while(total < count) {
+            auto result = ::sendfile(so_, fd, &offset, count - total);
+            if(result == -1 && errno == EINTR)
+                continue;
+            if(result == -1 && !total && (errno == EINVAL || errno == ENOSYS))
+                return copy_file(fd, offset, count);
+            if(result <= 0) {
+                io_err(result);
+                break;
+            }
+            total += std::size_t(result);
+        }
+        return total;
+#else
+        return copy_file(fd, offset, count);
+#endif
+    }
 #endif
 };
 
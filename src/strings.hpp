@@ -13,6 +13,7 @@
 #include <cstdarg>
 #include <cstdint>
 #include <vector>
+#include <iterator>
 #include <algorithm>
 #include <set>
 #include <sstream>
@@ -108,21 +109,197 @@ constexpr auto join(const std::vector<S>& list, const std::string_view& delim =
     return result;
 }
 
+// Lazy split yielding views into the text, giving the same pieces as
+// split() including empty ones, without storing them. The text must
+// outlive the view and its iterators.
+class split_view final {
+public:
+    class iterator final {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view&;
+
+        iterator() noexcept = default;
+
+        auto operator*() const noexcept -> reference {
+            return piece_;
+        }
+
+        auto operator->() const noexcept -> pointer {
+            return &piece_;
+        }
+
+        auto operator++() noexcept -> iterator& {
+            if(last_)
+                view_ = nullptr;
+            else
+                next(std::size_t(piece_.data() - view_->text_.data()) + piece_.size() + 1);
+            return *this;
+        }
+
+        auto operator++(int) noexcept {
+            auto prior = *this;
+            ++*this;
+            return prior;
+        }
+
+        auto operator==(const iterator& other) const noexcept {
+            return view_ == other.view_ && (!view_ || piece_.data() == other.piece_.data());
+        }
+
+        auto operator!=(const iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+    private:
+        friend class split_view;
+
+        const split_view *view_{nullptr};
+        std::string_view piece_;
+        unsigned count_{0};
+        bool last_{false};
+
+        explicit iterator(const split_view *view) noexcept : view_(view) {
+            next(0);
+        }
+
+        // a one char delimiter is found with memchr
+        void next(std::size_t from) noexcept {
+            const auto text = view_->text_;
+            const auto delim = view_->delim_;
+            auto found = std::string_view::npos;
+            if(!view_->max_ || ++count_ < view_->max_) {
+                if(delim.size() == 1) {
+                    const auto ptr = from < text.size() ? std::memchr(text.data() + from, delim[0], text.size() - from) : nullptr;
+                    if(ptr)
+                        found = std::size_t(static_cast<const char *>(ptr) - text.data());
+                }
+                else
+                    found = text.find_first_of(delim, from);
+            }
+            last_ = found == std::string_view::npos;
+            piece_ = text.substr(from, last_ ? std::string_view::npos : found - from);
+        }
+    };
+
+    split_view(std::string_view text, std::string_view delim = " ", unsigned max = 0) noexcept :
+    text_(text), delim_(delim), max_(max) {}
+
+    auto begin() const noexcept {
+        return iterator(this);
+    }
+
+    auto end() const noexcept {
+        return iterator();
+    }
+
+private:
+    std::string_view text_, delim_;
+    unsigned max_{0};
+};
+
+// Lazy tokenize yielding views into the text. Runs of delimiters are
+// skipped, and a token opening with one of the quote pairs runs through
+// its closing quote, which is kept in the token.
+class token_view final {
+public:
+    class iterator final {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view *;
+        using reference = const std::string_view&;
+
+        iterator() noexcept = default;
+
+        auto operator*() const noexcept -> reference {
+            return token_;
+        }
+
+        auto operator->() const noexcept -> pointer {
+            return &token_;
+        }
+
+        auto operator++() noexcept -> iterator& {
+            next(std::size_t(token_.data() - view_->text_.data()) + token_.size());
+            return *this;
+        }
+
+        auto operator++(int) noexcept {
+            auto prior = *this;
+            ++*this;
+            return prior;
+        }
+
+        auto operator==(const iterator& other) const noexcept {
+            return view_ == other.view_ && (!view_ || token_.data() == other.token_.data());
+        }
+
+        auto operator!=(const iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+    private:
+        friend class token_view;
+
+        const token_view *view_{nullptr};
+        std::string_view token_;
+
+        explicit iterator(const token_view *view) noexcept : view_(view) {
+            next(0);
+        }
+
+        void next(std::size_t from) noexcept {
+            const auto text = view_->text_;
+            const auto delim = view_->delim_;
+            const auto quotes = view_->quotes_;
+            from = delim.size() == 1 ? text.find_first_not_of(delim[0], from) : text.find_first_not_of(delim, from);
+            if(from == std::string_view::npos) {
+                view_ = nullptr;
+                return;
+            }
+
+            const auto lead = quotes.find(text[from]);
+            if(lead != std::string_view::npos && !(lead & 1) && lead + 1 < quotes.size()) {
+                const auto tail = text.find(quotes[lead + 1], from + 1);
+                if(tail != std::string_view::npos) {
+                    token_ = text.substr(from, tail - from + 1);
+                    return;
+                }
+            }
+
+            const auto found = delim.size() == 1 ? text.find(delim[0], from) : text.find_first_of(delim, from);
+            token_ = text.substr(from, found == std::string_view::npos ? found : found - from);
+        }
+    };
+
+    token_view(std::string_view text, std::string_view delim = " ", std::string_view quotes = R"(""''{})") noexcept :
+    text_(text), delim_(delim), quotes_(quotes) {}
+
+    auto begin() const noexcept {
+        return iterator(this);
+    }
+
+    auto end() const noexcept {
+        return iterator();
+    }
+
+private:
+    std::string_view text_, delim_, quotes_;
+};
+
 template<typename S = std::string>
 inline auto split(const S& str, std::string_view delim = " ", unsigned max = 0)
 {
     static_assert(is_string_type_v<S>, "S must be a string type");
 
     std::vector<S> result;
-    std::size_t current{}, prev{};
-    unsigned count = 0;
-    current = str.find_first_of(delim);
-    while((!max || ++count < max) && current != S::npos) {
-        result.emplace_back(str.substr(prev, current - prev));
-        prev = current + 1;
-        current = str.find_first_of(delim, prev);
-    }
-    result.emplace_back(str.substr(prev));
+    for(const auto piece : split_view(str, delim, max))
+        result.emplace_back(piece);
     return result;
 }
 
@@ -142,30 +319,8 @@ inline auto tokenize(const S& str, std::string_view delim = " ", std::string_vie
     static_assert(is_string_type_v<S>, "S must be a string type");
 
     std::vector<S> result;
-    auto current = str.find_first_of(delim);
-    auto prev = str.find_first_not_of(delim);
-    if(prev == S::npos)
-        prev = 0;
-
-    while(current != S::npos) {
-        auto lead = quotes.find_first_of(str[prev]);
-        if(lead != S::npos) {
-            auto tail = str.find_first_of(quotes[lead + 1], prev + 1);
-            if(tail != S::npos) {
-                current = tail;
-                result.emplace_back(str.substr(prev, current - prev + 1));
-                goto finish; // NOLINT
-            }
-        }
-        result.emplace_back(str.substr(prev, current - prev));
-finish:
-        prev = str.find_first_not_of(delim, ++current);
-        if(prev == S::npos)
-            prev = current;
-        current = str.find_first_of(delim, prev);
-    }
-    if(prev < str.length())
-        result.emplace_back(str.substr(prev));
+    for(const auto token : token_view(str, delim, quotes))
+        result.emplace_back(token);
     return result;
 }
 
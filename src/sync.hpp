@@ -5,11 +5,27 @@
 #define TYCHO_SYNC_HPP_
 
 #include <mutex>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <shared_mutex>
 #include <condition_variable>
 #include <stdexcept>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
 
 namespace tycho {
 using sync_timepoint = std::chrono::steady_clock::time_point;
@@ -43,7 +59,73 @@ inline auto sync_remains(const sync_timepoint& end) {
     return std::chrono::duration_cast<sync_millisecs>(end - sync_clock());
 }
 
-template <typename T>
+inline void sync_pause() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// spin briefly, pausing and then yielding, until pred is true
+template <typename Pred>
+inline auto sync_spin(Pred pred, unsigned spins = 128) {
+    for(unsigned count = 0; count < spins; ++count) {
+        if(pred())
+            return true;
+        if(count < spins / 2)
+            sync_pause();
+        else
+            std::this_thread::yield();
+    }
+    return pred();
+}
+
+// park while word still holds expected, futex based where we have it
+inline void sync_park(std::atomic<uint32_t>& word, uint32_t expected) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    word.wait(expected, std::memory_order_acquire);
+#else
+    if(word.load(std::memory_order_acquire) == expected)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+inline void sync_park(std::atomic<uint32_t>& word, uint32_t expected, const sync_timepoint& time_point) noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    if(now >= time_point)
+        return;
+#if defined(__linux__)
+    const auto remains = std::chrono::duration_cast<std::chrono::nanoseconds>(time_point - now).count();
+    struct timespec ts{};
+    ts.tv_sec = time_t(remains / 1000000000L);
+    ts.tv_nsec = long(remains % 1000000000L);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+#else
+    if(word.load(std::memory_order_acquire) == expected)
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(time_point - now, std::chrono::microseconds(50)));
+#endif
+}
+
+inline void sync_unpark(std::atomic<uint32_t>& word, bool all = false) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if(all)
+        word.notify_all();
+    else
+        word.notify_one();
+#else
+    (void)word;
+    (void)all;
+#endif
+}
+
+template <typename T, typename Lock = std::mutex>
 class unique_sync final {
 public:
     template <typename... Args>
@@ -51,10 +133,10 @@ public:
     data(std::forward<Args>(args)...) {}
 
 private:
-    template <typename U> friend class sync_ptr;
-    template <typename U> friend class guard_ptr;
+    template <typename U, typename L> friend class sync_ptr;
+    template <typename U, typename L> friend class guard_ptr;
     T data{};
-    std::mutex lock;
+    Lock lock;
 };
 
 template <typename T>
@@ -71,42 +153,42 @@ private:
     std::shared_mutex lock;
 };
 
-template <typename U>
-class sync_ptr final : public std::unique_lock<std::mutex> {
+template <typename U, typename Lock = std::mutex>
+class sync_ptr final : public std::unique_lock<Lock> {
 public:
     sync_ptr() = delete;
     sync_ptr(const sync_ptr&) = delete;
     auto operator=(const sync_ptr&) = delete;
 
-    explicit sync_ptr(unique_sync<U>& obj) :
-    unique_lock(obj.lock), sync_(obj), ptr_(&obj.data) {}
+    explicit sync_ptr(unique_sync<U, Lock>& obj) :
+    std::unique_lock<Lock>(obj.lock), sync_(obj), ptr_(&obj.data) {}
     ~sync_ptr() = default;
 
     auto operator->() {
-        if (!owns_lock())
+        if (!this->owns_lock())
             throw std::runtime_error("unique lock error");
         return ptr_;
     }
 
     auto operator*() -> U& {
-        if (!owns_lock())
+        if (!this->owns_lock())
             throw std::runtime_error("unique lock error");
         return *ptr_;
     }
 
 private:
-    unique_sync<U> &sync_;  // NOLINT
+    unique_sync<U, Lock> &sync_;  // NOLINT
     U* ptr_;
 };
 
-template <typename U>
+template <typename U, typename Lock = std::mutex>
 class guard_ptr final {
 public:
     guard_ptr() = delete;
     guard_ptr(const guard_ptr&) = delete;
     auto operator=(const guard_ptr&) = delete;
 
-    explicit guard_ptr(unique_sync<U>& obj) :
+    explicit guard_ptr(unique_sync<U, Lock>& obj) :
     sync_(obj), ptr_(&obj.data) {
         sync_.lock.lock();
     }
@@ -124,7 +206,7 @@ public:
     }
 
 private:
-    unique_sync<U> &sync_;  // NOLINT
+    unique_sync<U, Lock> &sync_;  // NOLINT
     U* ptr_;
 };
 
@@ -398,5 +480,428 @@ private:
     mutable std::mutex lock_;
     std::condition_variable cond_;
 };
+
+// Test and test-and-set spin lock for very short critical sections
+class spin_lock final {
+public:
+    spin_lock() noexcept = default;
+    spin_lock(const spin_lock&) = delete;
+    auto operator=(const spin_lock&) = delete;
+
+    void lock() noexcept {
+        unsigned spins = 0;
+        while(locked_.exchange(true, std::memory_order_acquire)) {
+            while(locked_.load(std::memory_order_relaxed)) {
+                if(++spins < 64)
+                    sync_pause();
+                else
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    auto try_lock() noexcept {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        locked_.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> locked_{false};
+};
+
+class spin_semaphore final {
+public:
+    explicit spin_semaphore(unsigned count = 0) noexcept : count_(count) {}
+    spin_semaphore(const spin_semaphore&) = delete;
+    auto operator=(const spin_semaphore&) = delete;
+
+    void post() noexcept {
+        count_.fetch_add(1);
+        if(waiters_.load())
+            sync_unpark(count_);
+    }
+
+    void wait() noexcept {
+        if(sync_spin([this]{return acquire();}))
+            return;
+        waiters_.fetch_add(1);
+        while(!acquire())
+            sync_park(count_, 0);
+        waiters_.fetch_sub(1);
+    }
+
+    auto wait_for(const sync_millisecs& timeout) noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    auto wait_until(const sync_timepoint& time_point) noexcept -> bool {
+        if(sync_spin([this]{return acquire();}))
+            return true;
+        waiters_.fetch_add(1);
+        auto result = true;
+        while(!acquire()) {
+            if(std::chrono::steady_clock::now() >= time_point) {
+                result = false;
+                break;
+            }
+            sync_park(count_, 0, time_point);
+        }
+        waiters_.fetch_sub(1);
+        return result;
+    }
+
+    auto count() const noexcept {
+        return unsigned(count_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint32_t> count_{0}, waiters_{0};
+
+    auto acquire() noexcept -> bool {
+        auto count = count_.load(std::memory_order_relaxed);
+        while(count > 0) {
+            if(count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+};
+
+class spin_barrier final {
+public:
+    explicit spin_barrier(unsigned limit) noexcept : count_(limit), limit_(limit) {}
+    spin_barrier(const spin_barrier&) = delete;
+    auto operator=(const spin_barrier&) = delete;
+
+    void wait() noexcept {
+        const auto sequence = sequence_.load(std::memory_order_acquire);
+        if(arrive())
+            return;
+        if(sync_spin([this, sequence]{return sequence_.load(std::memory_order_acquire) != sequence;}))
+            return;
+        while(sequence_.load(std::memory_order_acquire) == sequence)
+            sync_park(sequence_, sequence);
+    }
+
+    auto wait_for(const sync_millisecs& timeout) noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    auto wait_until(const sync_timepoint& time_point) noexcept -> bool {
+        const auto sequence = sequence_.load(std::memory_order_acquire);
+        if(arrive())
+            return true;
+        if(sync_spin([this, sequence]{return sequence_.load(std::memory_order_acquire) != sequence;}))
+            return true;
+        while(sequence_.load(std::memory_order_acquire) == sequence) {
+            if(std::chrono::steady_clock::now() >= time_point)
+                return false;
+            sync_park(sequence_, sequence, time_point);
+        }
+        return true;
+    }
+
+    auto count() const noexcept {
+        return unsigned(count_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint32_t> count_{0}, sequence_{0};
+    uint32_t limit_{0};
+
+    auto arrive() noexcept -> bool {
+        if(count_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return false;
+        count_.store(limit_, std::memory_order_relaxed);
+        sequence_.fetch_add(1, std::memory_order_release);
+        sync_unpark(sequence_, true);
+        return true;
+    }
+};
+
+class spin_event final {
+public:
+    explicit spin_event(bool reset = true) noexcept : auto_reset_(reset) {}
+    spin_event(const spin_event&) = delete;
+    auto operator=(const spin_event&) noexcept -> auto& = delete;
+
+    void notify() noexcept {
+        signaled_.store(1);
+        if(waiters_.load())
+            sync_unpark(signaled_, !auto_reset_);
+    }
+
+    void reset() noexcept {
+        signaled_.store(0, std::memory_order_release);
+    }
+
+    void wait() noexcept {
+        if(sync_spin([this]{return acquire();}))
+            return;
+        waiters_.fetch_add(1);
+        while(!acquire())
+            sync_park(signaled_, 0);
+        waiters_.fetch_sub(1);
+    }
+
+    auto wait_for(const sync_millisecs& timeout) noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    auto wait_until(const sync_timepoint& time_point) noexcept -> bool {
+        if(sync_spin([this]{return acquire();}))
+            return true;
+        waiters_.fetch_add(1);
+        auto result = true;
+        while(!acquire()) {
+            if(std::chrono::steady_clock::now() >= time_point) {
+                result = false;
+                break;
+            }
+            sync_park(signaled_, 0, time_point);
+        }
+        waiters_.fetch_sub(1);
+        return result;
+    }
+
+private:
+    std::atomic<uint32_t> signaled_{0}, waiters_{0};
+    bool auto_reset_{true};
+
+    auto acquire() noexcept -> bool {
+        if(!auto_reset_)
+            return signaled_.load(std::memory_order_acquire) != 0;
+        uint32_t expected = 1;
+        return signaled_.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+};
+
+class spin_group final {
+public:
+    explicit spin_group(unsigned init) noexcept : count_(init) {}
+    spin_group(const spin_group&) = delete;
+    spin_group() = default;
+    auto operator=(const spin_group&) noexcept -> auto& = delete;
+
+    auto operator++() noexcept -> auto& {
+        add(1);
+        return *this;
+    }
+
+    auto operator+=(unsigned count) noexcept -> auto& {
+        add(count);
+        return *this;
+    }
+
+    void add(unsigned count) noexcept {
+        count_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    auto done() noexcept {
+        auto count = count_.load(std::memory_order_relaxed);
+        while(count > 0) {
+            if(count_.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                if(count > 1)
+                    return false;
+                sync_unpark(count_, true);
+                return true;
+            }
+        }
+        return true;
+    }
+
+    void wait() noexcept {
+        if(sync_spin([this]{return !count_.load(std::memory_order_acquire);}))
+            return;
+        for(;;) {
+            const auto count = count_.load(std::memory_order_acquire);
+            if(!count)
+                return;
+            sync_park(count_, count);
+        }
+    }
+
+    auto wait_for(const sync_millisecs& timeout) noexcept {
+        return wait_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    auto wait_until(const sync_timepoint& time_point) noexcept -> bool {
+        if(sync_spin([this]{return !count_.load(std::memory_order_acquire);}))
+            return true;
+        for(;;) {
+            const auto count = count_.load(std::memory_order_acquire);
+            if(!count)
+                return true;
+            if(std::chrono::steady_clock::now() >= time_point)
+                return false;
+            sync_park(count_, count, time_point);
+        }
+    }
+
+    auto count() const noexcept {
+        return unsigned(count_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::atomic<uint32_t> count_{0};
+};
+
+// Read-copy-update container, readers never block or write shared lines
+template <typename T, std::size_t N = 32>
+class rcu_sync final {
+public:
+    template <typename... Args>
+    explicit rcu_sync(Args&&... args) :
+    current_(new T(std::forward<Args>(args)...)) {}
+
+    rcu_sync(const rcu_sync&) = delete;
+    auto operator=(const rcu_sync&) = delete;
+
+    ~rcu_sync() {
+        delete current_.load();
+    }
+
+    // copy current, modify, publish, and reclaim the old version
+    template <typename Func>
+    void update(Func func) {
+        const std::lock_guard lock(writer_);
+        auto next = std::make_unique<T>(*current_.load());
+        func(*next);
+        retire(current_.exchange(next.release()));
+    }
+
+    void store(T value) {
+        const std::lock_guard lock(writer_);
+        retire(current_.exchange(new T(std::move(value))));
+    }
+
+    auto load() const {
+        auto& slot = enter();
+        T copy(*current_.load());
+        leave(slot);
+        return copy;
+    }
+
+private:
+    template <typename U, std::size_t S> friend class rcu_ptr;
+
+    struct alignas(64) slot_t final {
+        std::atomic<uint32_t> count[2]{};
+    };
+
+    std::atomic<T *> current_{nullptr};
+    mutable slot_t slots_[N];
+    std::atomic<uint32_t> epoch_{0};
+    std::mutex writer_;
+
+    static auto reader() noexcept -> std::size_t {
+        static std::atomic<std::size_t> next{0};
+        thread_local const auto self = next.fetch_add(1, std::memory_order_relaxed);
+        return self % N;
+    }
+
+    auto enter() const noexcept -> std::atomic<uint32_t>& {
+        auto& count = slots_[reader()].count[epoch_.load() & 1];
+        count.fetch_add(1);
+        return count;
+    }
+
+    static void leave(std::atomic<uint32_t>& count) noexcept {
+        count.fetch_sub(1, std::memory_order_release);
+    }
+
+    // grace period, drain readers of both epochs before reclaiming
+    void retire(T *old) noexcept {
+        for(auto pass = 0; pass < 2; ++pass) {
+            const auto prior = epoch_.fetch_add(1) & 1;
+            for(auto& slot : slots_) {
+                sync_spin([&slot, prior]{return !slot.count[prior].load(std::memory_order_acquire);}, 64);
+                while(slot.count[prior].load(std::memory_order_acquire))
+                    std::this_thread::yield();
+            }
+        }
+        delete old;
+    }
+};
+
+template <typename U, std::size_t N = 32>
+class rcu_ptr final {
+public:
+    rcu_ptr() = delete;
+    rcu_ptr(const rcu_ptr&) = delete;
+    auto operator=(const rcu_ptr&) = delete;
+
+    explicit rcu_ptr(const rcu_sync<U, N>& obj) noexcept :
+    count_(obj.enter()), ptr_(obj.current_.load()) {}
+
+    ~rcu_ptr() {
+        rcu_sync<U, N>::leave(count_);
+    }
+
+    auto operator->() const noexcept {
+        return ptr_;
+    }
+
+    auto operator*() const noexcept -> const U& {
+        return *ptr_;
+    }
+
+private:
+    std::atomic<uint32_t>& count_;  // NOLINT
+    const U* ptr_;
+};
+
+// Sequence lock for small trivial data, readers retry if a write overlaps
+template <typename T>
+class seq_sync final {
+public:
+    seq_sync() noexcept = default;
+    explicit seq_sync(const T& value) noexcept : data_(value) {}
+    seq_sync(const seq_sync&) = delete;
+    auto operator=(const seq_sync&) = delete;
+
+    auto operator=(const T& value) noexcept -> auto& {
+        store(value);
+        return *this;
+    }
+
+    operator T() const noexcept {
+        return load();
+    }
+
+    auto load() const noexcept {
+        T copy{};
+        for(;;) {
+            const auto sequence = sequence_.load(std::memory_order_acquire);
+            if(sequence & 1) {
+                sync_pause();
+                continue;
+            }
+            memcpy(&copy, &data_, sizeof(T)); // FlawFinder: ignore
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence_.load(std::memory_order_relaxed) == sequence)
+                return copy;
+        }
+    }
+
+    void store(const T& value) noexcept {
+        const std::lock_guard lock(writer_);
+        const auto sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&data_, &value, sizeof(T)); // FlawFinder: ignore
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+private:
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+    std::atomic<uint32_t> sequence_{0};
+    T data_{};
+    spin_lock writer_;
+};
 } // end namespace
 #endif
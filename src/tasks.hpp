@@ -4,6 +4,9 @@
 #ifndef TYCHO_TASKS_HPP_
 #define TYCHO_TASKS_HPP_
 
+#include "metrics.hpp"
+
+#include <algorithm>
 #include <queue>
 #include <utility>
 #include <thread>
@@ -14,7 +17,15 @@
 #include <stdexcept>
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <vector>
+#include <mutex>
 #include <map>
+#include <optional>
+#include <exception>
+#include <new>
+#include <cstddef>
+#include <unordered_map>
 
 namespace tycho {
 // can be nullptr...
@@ -26,21 +37,137 @@ inline auto await(Func&& func, Args&&... args) -> std::future<typename std::invo
     return std::async(std::launch::async, std::forward<Func>(func), std::forward<Args>(args)...);
 }
 
-template<typename Func, typename... Args>
+// anything with a dispatch method, such as a task queue or task pool
+template<typename T, typename = void>
+struct is_executor : std::false_type {};
+
+template<typename T>
+struct is_executor<T, std::void_t<decltype(std::declval<T&>().dispatch(std::declval<void (*)()>()))>> : std::true_type {};
+
+template<typename T>
+constexpr bool is_executor_v = is_executor<T>::value;
+
+template<typename Func, typename... Args, std::enable_if_t<!is_executor_v<std::decay_t<Func>>, int> = 0>
 inline void detach(Func&& func, Args&&... args) {
     std::thread([func = std::forward<Func>(func), tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
         std::apply(func, std::move(tuple));
     }).detach();
 }
 
+// Move-only task, stores captures up to S bytes inline without allocating
+template<std::size_t S = 64>
+class unique_task final {
+public:
+    unique_task() noexcept = default;
+    unique_task(std::nullptr_t) noexcept {} // NOLINT
+
+    template<typename Func, typename F = std::decay_t<Func>, std::enable_if_t<!std::is_same_v<F, unique_task> && std::is_invocable_v<F&>, int> = 0>
+    unique_task(Func&& func) { // NOLINT
+        if constexpr (is_inline<F>()) {
+            ::new(static_cast<void *>(data_)) F(std::forward<Func>(func));
+            ops_ = &inline_ops<F>;
+        }
+        else {
+            *reinterpret_cast<F **>(data_) = new F(std::forward<Func>(func));
+            ops_ = &heap_ops<F>;
+        }
+    }
+
+    unique_task(const unique_task&) = delete;
+    auto operator=(const unique_task&) -> auto& = delete;
+
+    unique_task(unique_task&& other) noexcept {
+        move(other);
+    }
+
+    ~unique_task() {
+        reset();
+    }
+
+    auto operator=(unique_task&& other) noexcept -> auto& {
+        if(&other != this) {
+            reset();
+            move(other);
+        }
+        return *this;
+    }
+
+    auto operator=(std::nullptr_t) noexcept -> auto& {
+        reset();
+        return *this;
+    }
+
+    operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return ops_ == nullptr;
+    }
+
+    void operator()() {
+        if(!ops_)
+            throw std::bad_function_call();
+        ops_->invoke(data_);
+    }
+
+    void reset() noexcept {
+        if(ops_)
+            ops_->destroy(data_);
+        ops_ = nullptr;
+    }
+
+    template<typename Func>
+    static constexpr auto is_inline() {
+        return sizeof(Func) <= S && alignof(Func) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Func>;
+    }
+
+private:
+    static_assert(S >= sizeof(void *), "Task buffer must hold a pointer");
+
+    struct ops_t final {
+        void (*invoke)(void *);
+        void (*move)(void *, void *) noexcept;
+        void (*destroy)(void *) noexcept;
+    };
+
+    template<typename F>
+    static constexpr ops_t inline_ops{
+        [](void *data) {(*static_cast<F *>(data))();},
+        [](void *to, void *from) noexcept {
+            ::new(to) F(std::move(*static_cast<F *>(from)));
+            static_cast<F *>(from)->~F();
+        },
+        [](void *data) noexcept {static_cast<F *>(data)->~F();}
+    };
+
+    template<typename F>
+    static constexpr ops_t heap_ops{
+        [](void *data) {(**static_cast<F **>(data))();},
+        [](void *to, void *from) noexcept {*static_cast<F **>(to) = *static_cast<F **>(from);},
+        [](void *data) noexcept {delete *static_cast<F **>(data);}
+    };
+
+    alignas(std::max_align_t) unsigned char data_[S]{};
+    const ops_t *ops_{nullptr};
+
+    void move(unique_task& other) noexcept {
+        if(!other.ops_)
+            return;
+        other.ops_->move(data_, other.data_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+    }
+};
+
 // We may derive a timer subsystem from a protected timer queue
 class timer_queue {
 public:
-    using task_t = std::function<void()>;
+    using task_t = unique_task<>;
     using period_t = std::chrono::milliseconds;
     using timepoint_t = std::chrono::steady_clock::time_point;
 
-    explicit timer_queue(error_t handler = [](const std::exception& e){}) noexcept : errors_(std::move(handler)), thread_(std::thread(&timer_queue::run, this)) {}
+    explicit timer_queue(error_t handler = [](const std::exception& e){}, const period_t& slack = period_t(0)) noexcept : errors_(std::move(handler)), slack_(slack), thread_(std::thread(&timer_queue::run, this)) {}
     timer_queue(const timer_queue&) = delete;
     auto operator=(const timer_queue&) -> auto& = delete;
 
@@ -59,20 +186,21 @@ public:
     }
 
     void shutdown() noexcept {
+        std::unique_lock lock(lock_);
         if(stop_)
             return;
 
-        const std::lock_guard lock(lock_);
         stop_ = true;
         cond_.notify_all();
-        thread_.join();
+        lock.unlock();
+        if(thread_.joinable())
+            thread_.join();
     }
 
     auto at(const timepoint_t& expires, task_t task) {
         const std::lock_guard lock(lock_);
         const auto id = next_++;
-        timers_.emplace(expires, std::make_tuple(id, period_t(0), task));
-        cond_.notify_all();
+        arm(expires, std::make_tuple(id, period_t(0), std::move(task)));
         return id;
     }
 
@@ -80,35 +208,58 @@ public:
         const auto expires = std::chrono::steady_clock::now() + period;
         const std::lock_guard lock(lock_);
         const auto id = next_++;
-        timers_.emplace(expires, std::make_tuple(id, period, task));
-        cond_.notify_all();
+        arm(expires, std::make_tuple(id, period, std::move(task)));
         return id;
     }
 
-    auto cancel(uint64_t id) {
+    // re-arm a pending timer without re-allocating it
+    auto reset(uint64_t id, const timepoint_t& expires) {
         const std::lock_guard lock(lock_);
-        for(auto it = timers_.begin(); it != timers_.end(); ++it) {
-            if(std::get<0>(it->second) == id) {
-                timers_.erase(it);
-                cond_.notify_all();
-                return true;
-            }
+        auto pos = index_.find(id);
+        if(pos == index_.end())
+            return false;
+
+        auto node = timers_.extract(pos->second);
+        node.key() = expires;
+        pos->second = timers_.insert(std::move(node));
+        cond_.notify_all();
+        return true;
+    }
+
+    // a timer that is running is not re-armed, and other threads wait
+    // for it to finish so its captures may be released safely
+    auto cancel(uint64_t id) {
+        std::unique_lock lock(lock_);
+        auto pos = index_.find(id);
+        if(pos == index_.end()) {
+            if(!firing_ || std::none_of(expired_.begin(), expired_.end(), [id](const auto& node) {
+                return std::get<0>(node.mapped()) == id;
+            }))
+                return false;
+            cancelled_.push_back(id);
+            if(std::this_thread::get_id() != thread_.get_id())
+                cond_.wait(lock, [this]{return !firing_;});
+            return true;
         }
-        return false;
+
+        timers_.erase(pos->second);
+        index_.erase(pos);
+        cond_.notify_all();
+        return true;
     }
 
     auto find(uint64_t id) const noexcept {
         const std::lock_guard lock(lock_);
-        for(const auto& [expires, item] : timers_) {
-            if(std::get<0>(item) == id)
-                return expires;
-        }
-        return timepoint_t::min();
+        auto pos = index_.find(id);
+        if(pos == index_.end())
+            return timepoint_t::min();
+        return pos->second->first;
     }
 
     void clear() noexcept {
         const std::lock_guard lock(lock_);
         timers_.clear();
+        index_.clear();
     }
 
     auto empty() const noexcept {
@@ -118,20 +269,37 @@ public:
         return timers_.empty();
     }
 
+    auto size() const noexcept {
+        const std::lock_guard lock(lock_);
+        return timers_.size();
+    }
+
 private:
     using timer_t = std::tuple<uint64_t, period_t, task_t>;
+    using timers_t = std::multimap<timepoint_t, timer_t>;
     error_t errors_{[](const std::exception& e) {}};
-    std::multimap<timepoint_t, timer_t> timers_;
+    timers_t timers_;
+    std::unordered_map<uint64_t, timers_t::iterator> index_;
+    std::vector<timers_t::node_type> expired_;
+    std::vector<uint64_t> cancelled_;
     mutable std::mutex lock_;
     std::condition_variable cond_;
-    std::thread thread_;
+    period_t slack_{0};
     bool stop_{false};
+    bool firing_{false};
     uint64_t next_{0};
+    std::thread thread_;    // started last, once the rest is initialized
+
+    void arm(const timepoint_t& expires, timer_t&& timer) {
+        const auto id = std::get<0>(timer);
+        index_.emplace(id, timers_.emplace(expires, std::move(timer)));
+        cond_.notify_all();
+    }
 
     void run() noexcept {
         for(;;) {
             std::unique_lock lock(lock_);
-            if (stop_ && timers_.empty())
+            if(stop_)
                 return;
             if(timers_.empty()) {
                 cond_.wait(lock);
@@ -139,28 +307,43 @@ private:
                 continue;
             }
             auto it = timers_.begin();
-            auto expires = it->first;
             const auto now = std::chrono::steady_clock::now();
-            if(expires <= now) {
-                const auto item(std::move(it->second));
-                timers_.erase(it);
+            if(it->first > now) {
+                const auto expires = it->first;
+                cond_.wait_until(lock, expires);
                 lock.unlock();
-                const auto& [id, period, task] = item;
+                continue;
+            }
+
+            // fire everything due, or within slack, as one batch
+            const auto limit = now + slack_;
+            while(it != timers_.end() && it->first <= limit) {
+                index_.erase(std::get<0>(it->second));
+                expired_.emplace_back(timers_.extract(it++));
+            }
+            firing_ = true;
+            lock.unlock();
+            for(auto& node : expired_) {
                 try {
-                    task();
+                    metrics::fire(std::get<2>(node.mapped()), node.key());
                 }
                 catch(const std::exception& e) {
                     errors_(e);
                 }
-                lock.lock();
-                if(period != period_t(0)) {
-                    expires += period;
-                    timers_.emplace(expires, std::make_tuple(id, period, task));
-                    cond_.notify_all();
-                }
             }
-            else
-                cond_.wait_until(lock, expires);
+            lock.lock();
+            for(auto& node : expired_) {
+                const auto id = std::get<0>(node.mapped());
+                const auto period = std::get<1>(node.mapped());
+                if(period == period_t(0) || std::find(cancelled_.begin(), cancelled_.end(), id) != cancelled_.end())
+                    continue;
+                node.key() += period;
+                index_.emplace(id, timers_.insert(std::move(node)));
+            }
+            expired_.clear();
+            cancelled_.clear();
+            firing_ = false;
+            cond_.notify_all();
             lock.unlock();
         }
     }
@@ -171,7 +354,7 @@ class task_queue {
 public:
     using timeout_strategy = std::function<std::chrono::milliseconds()>;
     using shutdown_strategy = std::function<void()>;
-    using task_t = std::function<void()>;
+    using task_t = unique_task<>;
 
     explicit task_queue(timeout_strategy timeout = &default_timeout, shutdown_strategy shutdown = [](){}) noexcept :
     timeout_(std::move(timeout)), shutdown_(std::move(shutdown)) {}
@@ -218,6 +401,29 @@ public:
         return true;
     }
 
+    // queue many tasks under one lock and a single wakeup
+    template<typename Range>
+    auto dispatch_bulk(Range&& tasks, size_t max = 0) -> std::size_t {
+        std::unique_lock lock(mutex_);
+        if(!running_)
+            return 0;
+
+        std::size_t count = 0;
+        for(auto& task : tasks) {
+            if(max && tasks_.size() >= max)
+                break;
+            if constexpr (std::is_rvalue_reference_v<Range&&>)
+                tasks_.emplace_back(std::move(task));
+            else
+                tasks_.emplace_back(task);
+            ++count;
+        }
+        lock.unlock();
+        if(count)
+            cvar_.notify_one();
+        return count;
+    }
+
     void notify() {
         const std::unique_lock lock(mutex_);
         if(running_)
@@ -272,6 +478,16 @@ public:
         return *this;
     }
 
+    // worker takes all pending tasks at once rather than one per lock
+    auto batch(bool flag) -> auto& {
+        const std::lock_guard lock(mutex_);
+        if(running_)
+            throw std::runtime_error("cannot modify running task queue");
+
+        batch_ = flag;
+        return *this;
+    }
+
     void clear() noexcept {
         const std::lock_guard lock(mutex_);
         tasks_.clear();
@@ -293,11 +509,12 @@ private:
     timeout_strategy timeout_{default_timeout};
     shutdown_strategy shutdown_{[](){}};
     error_t errors_{[](const std::exception& e) {}};
-    std::deque<task_t> tasks_;
+    std::deque<metrics::queued_t<task_t>> tasks_, batch_tasks_;
     mutable std::mutex mutex_;
     std::condition_variable cvar_;
     std::thread thread_;
     bool running_{false};
+    bool batch_{false};
 
     static auto default_timeout() -> std::chrono::milliseconds {
         return std::chrono::minutes(1);
@@ -315,13 +532,28 @@ private:
             if(tasks_.empty())
                 continue;
 
+            if(batch_) {
+                tasks_.swap(batch_tasks_);
+                lock.unlock();
+                for(auto& func : batch_tasks_) {
+                    try {
+                        metrics::run(func, &metrics::library_t::queue);
+                    }
+                    catch(const std::exception& e) {
+                        errors_(e);
+                    }
+                }
+                batch_tasks_.clear();
+                continue;
+            }
+
             try {
                 auto func(std::move(tasks_.front()));
                 tasks_.pop_front();
 
                 // unlock before running task
                 lock.unlock();
-                func();
+                metrics::run(func, &metrics::library_t::queue);
             }
             catch(const std::exception& e) {
                 errors_(e);
@@ -333,6 +565,684 @@ private:
     }
 };
 
+// Multi-worker task pool, each worker has its own deque and steals work
+class task_pool {
+public:
+    using timeout_strategy = std::function<std::chrono::milliseconds()>;
+    using shutdown_strategy = std::function<void()>;
+    using task_t = unique_task<>;
+
+    explicit task_pool(std::size_t count = 0, timeout_strategy timeout = &default_timeout, shutdown_strategy shutdown = [](){}) noexcept :
+    timeout_(std::move(timeout)), shutdown_(std::move(shutdown)), count_(count ? count : default_count()) {}
+
+    task_pool(const task_pool&) = delete;
+    auto operator=(const task_pool&) -> auto& = delete;
+
+    ~task_pool() {
+        shutdown();
+    }
+
+    operator bool() const noexcept {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    auto operator!() const noexcept {
+        return !running_.load(std::memory_order_acquire);
+    }
+
+    auto priority(task_t task) {
+        if(!running_.load(std::memory_order_acquire))
+            return false;
+
+        pending_.fetch_add(1);
+        auto& worker = select();
+        std::unique_lock lock(worker.lock);
+        worker.tasks.push_front(std::move(task));
+        lock.unlock();
+        wakeup();
+        return true;
+    }
+
+    auto dispatch(task_t task, size_t max = 0) {
+        if(!running_.load(std::memory_order_acquire))
+            return false;
+
+        if(max && pending_.load(std::memory_order_relaxed) >= max)
+            return false;
+
+        pending_.fetch_add(1);
+        auto& worker = select();
+        std::unique_lock lock(worker.lock);
+        worker.tasks.push_back(std::move(task));
+        lock.unlock();
+        wakeup();
+        return true;
+    }
+
+    // queue many tasks on one worker, idle workers will steal from it
+    template<typename Range>
+    auto dispatch_bulk(Range&& tasks, size_t max = 0) -> std::size_t {
+        if(!running_.load(std::memory_order_acquire))
+            return 0;
+
+        std::size_t count = 0;
+        auto& worker = select();
+        std::unique_lock lock(worker.lock);
+        for(auto& task : tasks) {
+            if(max && pending_.load(std::memory_order_relaxed) >= max)
+                break;
+            pending_.fetch_add(1);
+            if constexpr (std::is_rvalue_reference_v<Range&&>)
+                worker.tasks.emplace_back(std::move(task));
+            else
+                worker.tasks.emplace_back(task);
+            ++count;
+        }
+        lock.unlock();
+        if(count > 1 && idle_.load() > 0) {
+            { const std::lock_guard sync(sleep_); }
+            cvar_.notify_all();
+        }
+        else if(count)
+            wakeup();
+        return count;
+    }
+
+    void notify() {
+        const std::lock_guard lock(sleep_);
+        if(running_)
+            cvar_.notify_all();
+    }
+
+    void startup() {
+        const std::lock_guard lock(control_);
+        if(running_)
+            return;
+
+        discard();
+        workers_.clear();
+        for(std::size_t pos = 0; pos < count_; ++pos)
+            workers_.emplace_back(std::make_unique<worker_t>());
+
+        running_ = true;
+        for(std::size_t pos = 0; pos < count_; ++pos)
+            workers_[pos]->thread = std::thread(&task_pool::process, this, pos);
+    }
+
+    void shutdown() {
+        const std::lock_guard lock(control_);
+        if(!running_)
+            return;
+
+        std::unique_lock sleep(sleep_);
+        running_ = false;
+        sleep.unlock();
+        cvar_.notify_all();
+        for(auto& worker : workers_) {
+            if(worker->thread.joinable())
+                worker->thread.join();
+        }
+        discard();
+    }
+
+    auto shutdown(shutdown_strategy handler) -> auto& {
+        const std::lock_guard lock(control_);
+        if(running_)
+            throw std::runtime_error("cannot modify running task pool");
+        shutdown_ = handler;
+        return *this;
+    }
+
+    auto timeout(timeout_strategy handler) -> auto& {
+        const std::lock_guard lock(control_);
+        if(running_)
+            throw std::runtime_error("cannot modify running task pool");
+
+        timeout_ = handler;
+        return *this;
+    }
+
+    auto errors(error_t handler) -> auto& {
+        const std::lock_guard lock(control_);
+        if(running_)
+            throw std::runtime_error("cannot modify running task pool");
+
+        errors_ = std::move(handler);
+        return *this;
+    }
+
+    auto workers(std::size_t count) -> auto& {
+        const std::lock_guard lock(control_);
+        if(running_)
+            throw std::runtime_error("cannot modify running task pool");
+
+        count_ = count ? count : default_count();
+        return *this;
+    }
+
+    void clear() noexcept {
+        const std::lock_guard lock(control_);
+        discard();
+    }
+
+    auto empty() const noexcept {
+        if(!running_.load(std::memory_order_acquire))
+            return true;
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+    auto size() const noexcept {
+        return pending_.load(std::memory_order_acquire);
+    }
+
+    auto workers() const noexcept {
+        return count_;
+    }
+
+private:
+    using queued_t = metrics::queued_t<task_t>;
+
+    struct alignas(64) worker_t final {
+        std::deque<queued_t> tasks;
+        std::mutex lock;
+        std::thread thread;
+    };
+
+    timeout_strategy timeout_{default_timeout};
+    shutdown_strategy shutdown_{[](){}};
+    error_t errors_{[](const std::exception& e) {}};
+    std::vector<std::unique_ptr<worker_t>> workers_;
+    std::size_t count_{1};
+    mutable std::mutex control_, sleep_;
+    std::condition_variable cvar_;
+    std::atomic<bool> running_{false};
+    alignas(64) std::atomic<std::size_t> pending_{0}, next_{0};
+    std::atomic<unsigned> idle_{0};
+
+    // worker identity of the current thread, so nested dispatch stays local
+    static inline thread_local const task_pool *owner_{nullptr};
+    static inline thread_local std::size_t self_{0};
+
+    static auto default_timeout() -> std::chrono::milliseconds {
+        return std::chrono::minutes(1);
+    }
+
+    static auto default_count() -> std::size_t {
+        const auto count = std::thread::hardware_concurrency();
+        return count ? count : 1;
+    }
+
+    // drop queued tasks with their share of pending, control_ must be held
+    void discard() noexcept {
+        for(auto& worker : workers_) {
+            const std::lock_guard clear(worker->lock);
+            pending_.fetch_sub(worker->tasks.size());
+            worker->tasks.clear();
+        }
+    }
+
+    auto select() -> worker_t& {
+        if(owner_ == this)
+            return *workers_[self_];
+        return *workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+    }
+
+    void wakeup() {
+        if(idle_.load() == 0)
+            return;
+
+        // sync with a worker that may be about to sleep...
+        { const std::lock_guard lock(sleep_); }
+        cvar_.notify_one();
+    }
+
+    auto take(std::size_t self, queued_t& task) -> bool {
+        auto& worker = *workers_[self];
+        std::unique_lock lock(worker.lock);
+        if(!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            pending_.fetch_sub(1);
+            return true;
+        }
+        lock.unlock();
+
+        // steal from the back of other workers
+        const auto count = workers_.size();
+        for(std::size_t pos = 1; pos < count; ++pos) {
+            auto& victim = *workers_[(self + pos) % count];
+            const std::unique_lock steal(victim.lock, std::try_to_lock);
+            if(!steal.owns_lock() || victim.tasks.empty())
+                continue;
+
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void process(std::size_t self) noexcept {
+        owner_ = this;
+        self_ = self;
+        queued_t task;
+        for(;;) {
+            if(!running_.load(std::memory_order_acquire))
+                break;
+
+            if(!take(self, task)) {
+                std::unique_lock lock(sleep_);
+                idle_.fetch_add(1);
+                cvar_.wait_for(lock, timeout_(), [this] {
+                    return !running_ || pending_.load() > 0;
+                });
+                idle_.fetch_sub(1);
+                continue;
+            }
+
+            try {
+                metrics::run(task, &metrics::library_t::pool);
+            }
+            catch(const std::exception& e) {
+                errors_(e);
+            }
+            task = nullptr;
+        }
+
+        // run shutdown strategy in each worker context before joining...
+        shutdown_();
+        owner_ = nullptr;
+    }
+};
+
+// Process wide pool for helpers that split work, started on first use
+inline auto shared_pool() -> task_pool& {
+    static task_pool pool;
+    static const auto started = [] {
+        pool.startup();
+        return true;
+    }();
+    static_cast<void>(started);
+    return pool;
+}
+
+// run job(index) for every index below count on up to threads workers of
+// the shared pool, the caller being one of them. Indexes are claimed as
+// workers free up, so the caller finishes alone when the pool is busy and
+// may itself be a pool worker. job returns false to give up.
+template<typename Job>
+inline auto parallel_jobs(std::size_t count, std::size_t threads, Job job) {
+    struct state_t final {
+        std::mutex lock;
+        std::condition_variable done;
+        std::atomic<std::size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::size_t active{0};
+        bool closed{false};
+    };
+
+    if(!threads)
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    threads = std::min(threads, count);
+    auto state = std::make_shared<state_t>();
+    const auto claim = [&job, count](state_t& run) {
+        for(;;) {
+            const auto index = run.next.fetch_add(1, std::memory_order_relaxed);
+            if(index >= count || run.failed.load(std::memory_order_relaxed))
+                return;
+            if(!job(index))
+                run.failed = true;
+        }
+    };
+
+    // helpers that start after the caller is done leave job untouched
+    const auto helper = [state, &claim] {
+        {
+            const std::lock_guard guard(state->lock);
+            if(state->closed)
+                return;
+            ++state->active;
+        }
+        try {
+            claim(*state);
+        }
+        catch(...) {
+            const std::lock_guard guard(state->lock);
+            if(!state->error)
+                state->error = std::current_exception();
+            state->failed = true;
+        }
+        const std::lock_guard guard(state->lock);
+        if(--state->active == 0)
+            state->done.notify_all();
+    };
+
+    if(threads > 1) {
+        auto& pool = shared_pool();
+        for(std::size_t thread = 1; thread < threads; ++thread) {
+            if(!pool.dispatch(helper))
+                break;
+        }
+    }
+
+    std::exception_ptr error;
+    try {
+        claim(*state);
+    }
+    catch(...) {
+        error = std::current_exception();
+        state->failed = true;
+    }
+    std::unique_lock guard(state->lock);
+    state->closed = true;
+    state->done.wait(guard, [&state] {
+        return !state->active;
+    });
+    if(!error)
+        error = state->error;
+    guard.unlock();
+    if(error)
+        std::rethrow_exception(error);
+    return !state->failed;
+}
+
+// Promise side of a lightweight future that supports continuations
+template<typename T>
+class task_promise;
+
+template<typename T>
+class task_future final {
+public:
+    using value_type = T;
+
+    template<typename Func>
+    using result_t = typename std::conditional_t<std::is_void_v<T>, std::invoke_result<std::decay_t<Func>&>, std::invoke_result<std::decay_t<Func>&, std::conditional_t<std::is_void_v<T>, bool, T>>>::type;
+
+    task_future() noexcept = default;
+
+    operator bool() const noexcept {
+        return state_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return state_ == nullptr;
+    }
+
+    auto ready() const {
+        const std::lock_guard lock(valid().lock);
+        return state_->done;
+    }
+
+    void wait() const {
+        std::unique_lock lock(valid().lock);
+        state_->cond.wait(lock, [this]{return state_->done;});
+    }
+
+    template<typename Rep, typename Period>
+    auto wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        std::unique_lock lock(valid().lock);
+        return state_->cond.wait_for(lock, timeout, [this]{return state_->done;});
+    }
+
+    // value is moved out, so only one get per completed future
+    auto get() -> T {
+        wait();
+        if(state_->error)
+            std::rethrow_exception(state_->error);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*state_->value);
+    }
+
+    // run func once ready, on the completing thread or right now
+    template<typename Func>
+    void finally(Func&& func) {
+        std::unique_lock lock(valid().lock);
+        if(!state_->done) {
+            if(state_->next)
+                throw std::runtime_error("future already has continuation");
+            state_->next = std::forward<Func>(func);
+            return;
+        }
+        lock.unlock();
+        func();
+    }
+
+    template<typename Func>
+    auto then(Func&& func) {
+        task_promise<result_t<Func>> promise;
+        auto future = promise.get_future();
+        finally([self = *this, func = std::forward<Func>(func), promise = std::move(promise)]() mutable {
+            self.chain(func, promise);
+        });
+        return future;
+    }
+
+    // continuation is dispatched to an executor instead of run inline
+    template<typename Executor, typename Func, std::enable_if_t<is_executor_v<Executor>, int> = 0>
+    auto then(Executor& exec, Func&& func) {
+        task_promise<result_t<Func>> promise;
+        auto future = promise.get_future();
+        finally([self = *this, &exec, func = std::forward<Func>(func), promise = std::move(promise)]() mutable {
+            exec.dispatch([self = std::move(self), func = std::move(func), promise = std::move(promise)]() mutable {
+                self.chain(func, promise);
+            });
+        });
+        return future;
+    }
+
+private:
+    friend class task_promise<T>;
+
+    using store_t = std::conditional_t<std::is_void_v<T>, bool, T>;
+
+    struct state_t final {
+        std::mutex lock;
+        std::condition_variable cond;
+        std::optional<store_t> value;
+        std::exception_ptr error;
+        unique_task<> next;
+        bool done{false};
+    };
+
+    std::shared_ptr<state_t> state_;
+
+    explicit task_future(std::shared_ptr<state_t> state) noexcept : state_(std::move(state)) {}
+
+    auto valid() const -> state_t& {
+        if(!state_)
+            throw std::runtime_error("future has no state");
+        return *state_;
+    }
+
+    template<typename Func, typename R>
+    void chain(Func& func, task_promise<R>& promise) {
+        promise.fulfill([&]() -> R {
+            if constexpr (std::is_void_v<T>) {
+                get();
+                return func();
+            }
+            else
+                return func(get());
+        });
+    }
+};
+
+template<typename T>
+class task_promise final {
+public:
+    task_promise() : state_(std::make_shared<state_t>()) {}
+    task_promise(const task_promise&) = delete;
+    task_promise(task_promise&&) noexcept = default;
+    auto operator=(const task_promise&) -> auto& = delete;
+
+    auto operator=(task_promise&& other) noexcept -> auto& {
+        if(&other != this) {
+            abandon();
+            state_ = std::move(other.state_);
+        }
+        return *this;
+    }
+
+    ~task_promise() {
+        abandon();
+    }
+
+    auto get_future() const {
+        return task_future<T>(state_);
+    }
+
+    template<typename U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    void set_value(U&& value) {
+        complete([&](state_t& state) {
+            state.value.emplace(std::forward<U>(value));
+        });
+    }
+
+    template<typename U = T, std::enable_if_t<std::is_void_v<U>, int> = 0>
+    void set_value() {
+        complete([](state_t& state) {
+            state.value.emplace(true);
+        });
+    }
+
+    void set_exception(std::exception_ptr error) {
+        complete([&](state_t& state) {
+            state.error = std::move(error);
+        });
+    }
+
+    // complete with the result of func, or with what it throws
+    template<typename Func>
+    void fulfill(Func&& func) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                func();
+                set_value();
+            }
+            else
+                set_value(func());
+        }
+        catch(...) {
+            set_exception(std::current_exception());
+        }
+    }
+
+private:
+    using state_t = typename task_future<T>::state_t;
+
+    std::shared_ptr<state_t> state_;
+
+    template<typename Func>
+    void complete(Func func) {
+        if(!state_)
+            throw std::runtime_error("promise has no state");
+
+        std::unique_lock lock(state_->lock);
+        if(state_->done)
+            throw std::runtime_error("promise already satisfied");
+        func(*state_);
+        state_->done = true;
+        auto next = std::move(state_->next);
+        lock.unlock();
+        state_->cond.notify_all();
+        state_.reset();
+        if(next)
+            next();
+    }
+
+    void abandon() noexcept {
+        if(!state_)
+            return;
+        try {
+            set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+        catch(...) {
+            state_.reset();
+        }
+    }
+};
+
+template<typename Executor, typename Func, typename... Args, std::enable_if_t<is_executor_v<Executor>, int> = 0>
+inline auto await(Executor& exec, Func&& func, Args&&... args) {
+    using result_t = std::invoke_result_t<std::decay_t<Func>&, std::decay_t<Args>...>;
+    task_promise<result_t> promise;
+    auto future = promise.get_future();
+    exec.dispatch([promise = std::move(promise), func = std::forward<Func>(func), tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        promise.fulfill([&]() -> result_t {
+            return std::apply(func, std::move(tuple));
+        });
+    });
+    return future;
+}
+
+template<typename Executor, typename Func, typename... Args, std::enable_if_t<is_executor_v<Executor>, int> = 0>
+inline auto detach(Executor& exec, Func&& func, Args&&... args) {
+    return exec.dispatch([func = std::forward<Func>(func), tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        std::apply(func, std::move(tuple));
+    });
+}
+
+// completes when every future has, or with the first error seen
+template<typename T>
+inline auto when_all(std::vector<task_future<T>> futures) {
+    using result_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+    using store_t = std::conditional_t<std::is_void_v<T>, bool, T>;
+    struct join_t final {
+        std::vector<std::optional<store_t>> values;
+        std::atomic<std::size_t> remaining{0};
+        std::exception_ptr error;
+        std::mutex lock;
+        task_promise<result_t> promise;
+    };
+
+    auto join = std::make_shared<join_t>();
+    auto result = join->promise.get_future();
+    join->values.resize(futures.size());
+    join->remaining = futures.size();
+    auto finish = [](join_t& state) {
+        if(state.error)
+            state.promise.set_exception(state.error);
+        else if constexpr (std::is_void_v<T>)
+            state.promise.set_value();
+        else {
+            std::vector<T> values;
+            values.reserve(state.values.size());
+            for(auto& value : state.values)
+                values.emplace_back(std::move(*value));
+            state.promise.set_value(std::move(values));
+        }
+    };
+
+    if(futures.empty()) {
+        finish(*join);
+        return result;
+    }
+
+    for(std::size_t pos = 0; pos < futures.size(); ++pos) {
+        futures[pos].finally([join, future = futures[pos], pos, finish]() mutable {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    future.get();
+                    join->values[pos] = true;
+                }
+                else
+                    join->values[pos] = future.get();
+            }
+            catch(...) {
+                const std::lock_guard lock(join->lock);
+                if(!join->error)
+                    join->error = std::current_exception();
+            }
+            future = task_future<T>();
+            if(join->remaining.fetch_sub(1) == 1)
+                finish(*join);
+        });
+    }
+    return result;
+}
+
 inline void invoke(action_t action) {
     if(action != nullptr)
         action();
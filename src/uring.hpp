@@ -0,0 +1,472 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#ifndef TYCHO_URING_HPP_
+#define TYCHO_URING_HPP_
+
+#include "socket.hpp"
+#include "hashmap.hpp"
+
+#include <functional>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <system_error>
+#include <type_traits>
+#include <cerrno>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// getevents_arg waits need the names from linux 5.11 or later headers
+#if defined(IORING_FEAT_EXT_ARG) && defined(IORING_ENTER_EXT_ARG)
+#define USE_URING
+#include <linux/time_types.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#endif
+#endif
+
+#ifdef USE_URING
+namespace tycho {
+// Completion based i/o over a Linux io_uring, set up with the raw system
+// calls so no liburing is needed. Operations are queued, then submitted
+// together by submit or wait, and each handler gets the result, which is
+// a byte count or new descriptor, or a negative errno. Any thread may
+// queue operations; one thread at a time should wait for completions.
+class uring final {
+public:
+    using handler_t = std::function<void(int)>;
+
+    explicit uring(unsigned entries = 256) {
+        struct io_uring_params params{};
+        ring_ = int(::syscall(__NR_io_uring_setup, entries, &params));
+        if(ring_ == -1)
+            fail();
+
+        features_ = params.features;
+        sq_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if(features_ & IORING_FEAT_SINGLE_MMAP)
+            sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+
+        sq_ring_ = map(sq_bytes_, IORING_OFF_SQ_RING);
+        cq_ring_ = (features_ & IORING_FEAT_SINGLE_MMAP) ? sq_ring_ : map(cq_bytes_, IORING_OFF_CQ_RING);
+        sqes_bytes_ = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes_ = static_cast<struct io_uring_sqe *>(map(sqes_bytes_, IORING_OFF_SQES));
+
+        auto sq = static_cast<char *>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        auto cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+        sq_entries_ = params.sq_entries;
+        cq_entries_ = params.cq_entries;
+        tail_ = *sq_tail_;
+
+        wake_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if(wake_ == -1)
+            fail();
+        arm();
+    }
+
+    uring(const uring&) = delete;
+    auto operator=(const uring&) -> auto& = delete;
+
+    ~uring() {
+        release();
+    }
+
+    auto accept(int fd, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_ACCEPT, fd, std::move(handler));
+        if(sqe)
+            sqe->accept_flags = SOCK_CLOEXEC;
+        return sqe != nullptr;
+    }
+
+    auto accept(const Socket& sock, handler_t handler) {
+        return accept(int(*sock), std::move(handler));
+    }
+
+    // the address is kept with the operation until it completes
+    auto connect(int fd, const address_t& addr, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_CONNECT, fd, std::move(handler));
+        if(!sqe)
+            return false;
+        auto& op = ops_[sqe->user_data];
+        op.addr = addr;
+        sqe->addr = uint64_t(uintptr_t(op.addr.data()));
+        sqe->off = op.addr.size();
+        return true;
+    }
+
+    auto connect(const Socket& sock, const address_t& addr, handler_t handler) {
+        return connect(int(*sock), addr, std::move(handler));
+    }
+
+    auto recv(int fd, void *data, std::size_t size, handler_t handler, int flags = 0) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_RECV, fd, std::move(handler), data, size);
+        if(sqe)
+            sqe->msg_flags = unsigned(flags);
+        return sqe != nullptr;
+    }
+
+    auto recv(const Socket& sock, void *data, std::size_t size, handler_t handler, int flags = 0) {
+        return recv(int(*sock), data, size, std::move(handler), flags);
+    }
+
+    auto send(int fd, const void *data, std::size_t size, handler_t handler, int flags = MSG_NOSIGNAL) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_SEND, fd, std::move(handler), data, size);
+        if(sqe)
+            sqe->msg_flags = unsigned(flags);
+        return sqe != nullptr;
+    }
+
+    auto send(const Socket& sock, const void *data, std::size_t size, handler_t handler, int flags = MSG_NOSIGNAL) {
+        return send(int(*sock), data, size, std::move(handler), flags);
+    }
+
+    // an offset of -1 uses and advances the file position
+    auto read(int fd, void *data, std::size_t size, off_t offset, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_READ, fd, std::move(handler), data, size);
+        if(sqe)
+            sqe->off = uint64_t(offset);
+        return sqe != nullptr;
+    }
+
+    auto write(int fd, const void *data, std::size_t size, off_t offset, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_WRITE, fd, std::move(handler), data, size);
+        if(sqe)
+            sqe->off = uint64_t(offset);
+        return sqe != nullptr;
+    }
+
+    // data must lie inside registered buffer index
+    auto read_fixed(int fd, unsigned index, void *data, std::size_t size, off_t offset, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_READ_FIXED, fd, std::move(handler), data, size);
+        if(!sqe)
+            return false;
+        sqe->off = uint64_t(offset);
+        sqe->buf_index = uint16_t(index);
+        return true;
+    }
+
+    auto write_fixed(int fd, unsigned index, const void *data, std::size_t size, off_t offset, handler_t handler) -> bool {
+        const std::lock_guard lock(lock_);
+        auto sqe = prepare(IORING_OP_WRITE_FIXED, fd, std::move(handler), data, size);
+        if(!sqe)
+            return false;
+        sqe->off = uint64_t(offset);
+        sqe->buf_index = uint16_t(index);
+        return true;
+    }
+
+    // pin buffers once so fixed reads and writes skip page mapping
+    auto register_buffers(const struct iovec *list, unsigned count) -> bool {
+        return enroll(IORING_REGISTER_BUFFERS, list, count);
+    }
+
+    auto unregister_buffers() -> bool {
+        return enroll(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    }
+
+    // registered descriptors are used as fixed files by later operations
+    auto register_files(const int *list, unsigned count) -> bool {
+        const std::lock_guard lock(lock_);
+        if(!fixed_.empty())
+            enroll(IORING_UNREGISTER_FILES, nullptr, 0);
+        fixed_.clear();
+        if(!enroll(IORING_REGISTER_FILES, list, count))
+            return false;
+        for(unsigned index = 0; index < count; ++index)
+            fixed_.try_emplace(list[index], index);
+        return true;
+    }
+
+    auto unregister_files() -> bool {
+        const std::lock_guard lock(lock_);
+        fixed_.clear();
+        return enroll(IORING_UNREGISTER_FILES, nullptr, 0);
+    }
+
+    // submit queued operations, returns how many the kernel took
+    auto submit() -> int {
+        const std::lock_guard lock(lock_);
+        return enter();
+    }
+
+    // submit, wait up to timeout ms, and call handlers inline
+    auto wait(int timeout = -1) -> std::size_t {
+        return fire(timeout, [](handler_t& handler, int result) {
+            handler(result);
+        });
+    }
+
+    // submit, wait, and post each handler to exec.dispatch
+    template<typename Exec, std::enable_if_t<!std::is_arithmetic_v<Exec>, int> = 0>
+    auto wait(Exec& exec, int timeout = -1) -> std::size_t {
+        return fire(timeout, [&exec](handler_t& handler, int result) {
+            exec.dispatch([handler = std::move(handler), result] {
+                handler(result);
+            });
+        });
+    }
+
+    void run() {
+        stop_ = false;
+        while(!stop_)
+            wait();
+    }
+
+    template<typename Exec>
+    void run(Exec& exec) {
+        stop_ = false;
+        while(!stop_)
+            wait(exec);
+    }
+
+    // may be called from any thread, including a handler. The wakeup is an
+    // eventfd the ring already polls, so it needs no free submission entry.
+    void stop() {
+        stop_ = true;
+        const uint64_t one = 1;
+        static_cast<void>(::write(wake_, &one, sizeof(one)));
+        const std::lock_guard lock(lock_);
+        if(queued_)
+            enter();
+    }
+
+    auto stopped() const noexcept {
+        return stop_.load();
+    }
+
+    auto pending() const {
+        const std::lock_guard lock(lock_);
+        return pending_;
+    }
+
+    auto entries() const noexcept {
+        return sq_entries_;
+    }
+
+private:
+    static constexpr uint64_t timeout_tag = ~uint64_t(0);
+    static constexpr uint64_t wakeup_tag = ~uint64_t(1);
+
+    struct op_t final {
+        handler_t handler;
+        address_t addr;
+    };
+
+    mutable std::mutex lock_;
+    std::deque<op_t> ops_;
+    std::vector<uint64_t> free_;
+    std::vector<std::pair<handler_t, int>> ready_;
+    flat_map<int, unsigned> fixed_;
+    std::atomic<bool> stop_{false};
+    int ring_{-1};
+    unsigned features_{0};
+    std::size_t sq_bytes_{0}, cq_bytes_{0}, sqes_bytes_{0};
+    void *sq_ring_{nullptr}, *cq_ring_{nullptr};
+    struct io_uring_sqe *sqes_{nullptr};
+    struct io_uring_cqe *cqes_{nullptr};
+    unsigned *sq_head_{nullptr}, *sq_tail_{nullptr}, *sq_array_{nullptr};
+    unsigned *cq_head_{nullptr}, *cq_tail_{nullptr};
+    unsigned sq_mask_{0}, cq_mask_{0}, sq_entries_{0}, cq_entries_{0};
+    unsigned tail_{0}, queued_{0};
+    std::size_t pending_{0};
+    int wake_{-1};
+    bool armed_{false};
+    struct __kernel_timespec until_{};
+
+    [[noreturn]] void fail() {
+        auto error = errno;
+        release();
+        throw std::system_error(error, std::generic_category(), "Uring cannot create queue");
+    }
+
+    void release() noexcept {
+        if(sqes_)
+            ::munmap(sqes_, sqes_bytes_);
+        if(cq_ring_ && cq_ring_ != sq_ring_)
+            ::munmap(cq_ring_, cq_bytes_);
+        if(sq_ring_)
+            ::munmap(sq_ring_, sq_bytes_);
+        if(ring_ != -1)
+            ::close(ring_);
+        if(wake_ != -1)
+            ::close(wake_);
+        sqes_ = nullptr;
+        sq_ring_ = cq_ring_ = nullptr;
+        ring_ = wake_ = -1;
+    }
+
+    auto map(std::size_t size, off_t offset) -> void * {
+        auto ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, offset);
+        if(ptr == MAP_FAILED)
+            fail();
+        return ptr;
+    }
+
+    auto enroll(unsigned opcode, const void *arg, unsigned count) const noexcept -> bool {
+        return ::syscall(__NR_io_uring_register, ring_, opcode, arg, count) == 0;
+    }
+
+    // next free submission entry, submitting queued work if the ring is full
+    auto next() -> struct io_uring_sqe * {
+        if(tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            enter();
+            if(tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)
+                return nullptr;
+        }
+        const auto index = tail_ & sq_mask_;
+        auto sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        ++tail_;
+        ++queued_;
+        return sqe;
+    }
+
+    // poll the wakeup eventfd, which holds one completion slot
+    void arm() {
+        if(armed_)
+            return;
+        auto sqe = next();
+        if(!sqe)
+            return;
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = wake_;
+        sqe->poll_events = POLLIN;
+        sqe->user_data = wakeup_tag;
+        armed_ = true;
+    }
+
+    // completions are bounded by the cq ring, so in flight work is too
+    auto prepare(uint8_t opcode, int fd, handler_t handler, const void *data = nullptr, std::size_t size = 0) -> struct io_uring_sqe * {
+        if(fd < 0 || !handler || pending_ + 1 >= cq_entries_)
+            return nullptr;
+        auto sqe = next();
+        if(!sqe)
+            return nullptr;
+
+        uint64_t slot{};
+        if(free_.empty()) {
+            slot = ops_.size();
+            ops_.emplace_back();
+        }
+        else {
+            slot = free_.back();
+            free_.pop_back();
+        }
+        ops_[slot].handler = std::move(handler);
+        ++pending_;
+
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        auto fixed = fixed_.find(fd);
+        if(fixed != fixed_.end()) {
+            sqe->fd = int(fixed->second);
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        sqe->addr = uint64_t(uintptr_t(data));
+        sqe->len = unsigned(size);
+        sqe->user_data = slot;
+        return sqe;
+    }
+
+    auto enter() -> int {
+        __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+        int result{-1};
+        do {
+            result = int(::syscall(__NR_io_uring_enter, ring_, queued_, 0, 0, nullptr, 0));
+        } while(result == -1 && errno == EINTR);
+        if(result > 0)
+            queued_ -= std::min(queued_, unsigned(result));
+        return result;
+    }
+
+    // submit queued work, then block for a completion unless one is ready
+    void collect(int timeout) {
+        std::unique_lock lock(lock_);
+        struct io_uring_getevents_arg arg{};
+        struct __kernel_timespec wait{};
+        auto flags = IORING_ENTER_GETEVENTS;
+        if(timeout > 0) {
+            wait.tv_sec = timeout / 1000;
+            wait.tv_nsec = (timeout % 1000) * 1000000L;
+            if(features_ & IORING_FEAT_EXT_ARG) {
+                arg.ts = uint64_t(uintptr_t(&wait));
+                flags |= IORING_ENTER_EXT_ARG;
+            }
+            else if(auto sqe = next(); sqe != nullptr) {
+                until_ = wait;
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->addr = uint64_t(uintptr_t(&until_));
+                sqe->len = 1;
+                sqe->off = 1;
+                sqe->user_data = timeout_tag;
+            }
+        }
+        if(queued_)
+            enter();
+        if(!timeout || __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) != *cq_head_)
+            return;
+        lock.unlock();
+        const auto ext = (flags & IORING_ENTER_EXT_ARG) != 0;
+        static_cast<void>(::syscall(__NR_io_uring_enter, ring_, 0, 1, flags, ext ? &arg : nullptr, ext ? sizeof(arg) : 0));
+    }
+
+    template<typename Call>
+    auto fire(int timeout, Call call) -> std::size_t {
+        collect(timeout);
+        ready_.clear();
+        {
+            const std::lock_guard lock(lock_);
+            auto head = *cq_head_;
+            const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            while(head != tail) {
+                const auto& cqe = cqes_[head & cq_mask_];
+                ++head;
+                if(cqe.user_data == wakeup_tag) {
+                    uint64_t count{0};
+                    static_cast<void>(::read(wake_, &count, sizeof(count)));
+                    armed_ = false;
+                    continue;
+                }
+                if(cqe.user_data == timeout_tag || cqe.user_data >= ops_.size())
+                    continue;
+                auto& op = ops_[cqe.user_data];
+                ready_.emplace_back(std::move(op.handler), cqe.res);
+                op.handler = nullptr;
+                free_.push_back(cqe.user_data);
+                --pending_;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            arm();
+        }
+        for(auto& [handler, result] : ready_)
+            call(handler, result);
+        return ready_.size();
+    }
+};
+} // end namespace
+#endif
+#endif
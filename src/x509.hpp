@@ -8,9 +8,14 @@
 #include <utility>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <cstdint>
 #include <ctime>
+#include <chrono>
+#include <mutex>
+#include <memory>
 #include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
 #include <openssl/evp.h>
 #include <openssl/bio.h>
 #include <openssl/pem.h>
@@ -18,6 +23,9 @@
 #include <openssl/obj_mac.h>
 #include <openssl/core_names.h>
 
+#include "encoding.hpp"
+#include "hashmap.hpp"
+
 namespace tycho::crypto {
 class x509_t final {
 public:
@@ -119,6 +127,20 @@ public:
         return cert_;
     }
 
+    // borrowed certificate, not referenced
+    auto get() const noexcept -> X509 * {
+        return cert_;
+    }
+
+    // digest of the der certificate, as lowercase hex
+    auto fingerprint(const EVP_MD *md = EVP_sha256()) const -> std::string {
+        uint8_t data[EVP_MAX_MD_SIZE];
+        unsigned size{0};
+        if(!cert_ || X509_digest(cert_, md, data, &size) != 1)
+            return {};
+        return to_hex(data, size);
+    }
+
 private:
     constexpr static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 
@@ -180,5 +202,177 @@ inline auto load_X509(const std::string& path) {
     fclose(fp);
     return x509_t(cert);
 }
+
+// Chain verification with results cached by the fingerprints of the leaf
+// and untrusted chain together with the trust store. Entries expire after
+// the ttl or when a certificate in the chain does, and refresh drops them
+// all, as after reloading crls. Peer host checks are not part of the key,
+// so a store whose verify params name a host should not be shared.
+class x509_verifier final {
+public:
+    using duration_t = std::chrono::steady_clock::duration;
+
+    explicit x509_verifier(X509_STORE *store = nullptr, std::size_t limit = 256, duration_t ttl = std::chrono::minutes(5)) noexcept :
+    store_(store ? store : X509_STORE_new()), limit_(limit ? limit : 1), ttl_(ttl) {
+        if(store)
+            X509_STORE_up_ref(store);
+    }
+
+    x509_verifier(const x509_verifier&) = delete;
+    auto operator=(const x509_verifier&) -> auto& = delete;
+
+    ~x509_verifier() {
+        X509_STORE_free(store_);
+    }
+
+    operator bool() const noexcept {
+        return store_ != nullptr;
+    }
+
+    auto operator!() const noexcept {
+        return store_ == nullptr;
+    }
+
+    auto store() const noexcept {
+        return store_;
+    }
+
+    // add trusted certificates from a pem file and or hashed directory
+    auto locations(const std::string& file, const std::string& path = "") noexcept {
+        return store_ && X509_STORE_load_locations(store_, file.empty() ? nullptr : file.c_str(), path.empty() ? nullptr : path.c_str()) == 1;
+    }
+
+    // returns X509_V_OK or the verify error for the chain
+    auto verify(const x509_t& cert, STACK_OF(X509) *untrusted = nullptr) -> int {
+        auto ctx = X509_STORE_CTX_new();
+        if(!ctx || !store_ || !cert || X509_STORE_CTX_init(ctx, store_, cert.get(), untrusted) != 1) {
+            X509_STORE_CTX_free(ctx);
+            return X509_V_ERR_UNSPECIFIED;
+        }
+        auto result = verify(ctx);
+        X509_STORE_CTX_free(ctx);
+        return result;
+    }
+
+    // verify an initialized store context, usable as a tls verify callback
+    auto verify(X509_STORE_CTX *ctx) -> int {
+        auto key = make_key(ctx);
+        const auto now = clock_t::now();
+        if(!key.empty()) {
+            const std::lock_guard lock(lock_);
+            auto entry = cache_.find(key);
+            if(entry != cache_.end() && entry->second.expires > now) {
+                ++hits_;
+                if(entry->second.chain)
+                    X509_STORE_CTX_set0_verified_chain(ctx, X509_chain_up_ref(entry->second.chain.get()));
+                X509_STORE_CTX_set_error(ctx, entry->second.result);
+                return entry->second.result;
+            }
+            ++misses_;
+        }
+
+        auto result = X509_verify_cert(ctx) == 1 ? X509_V_OK : X509_STORE_CTX_get_error(ctx);
+        if(result == X509_V_OK)
+            X509_STORE_CTX_set_error(ctx, X509_V_OK);
+        if(key.empty())
+            return result;
+
+        const std::lock_guard lock(lock_);
+        if(cache_.size() >= limit_) {
+            cache_.erase_if([now](const auto& item) {
+                return item.second.expires <= now;
+            });
+            if(cache_.size() >= limit_) {
+                const auto victim = cache_.begin()->first;
+                cache_.erase(victim);
+            }
+        }
+        cache_.insert_or_assign(std::move(key), entry_t{result, now + lifetime(ctx), chain_t(X509_STORE_CTX_get1_chain(ctx), &free_chain)});
+        return result;
+    }
+
+    void refresh() {
+        const std::lock_guard lock(lock_);
+        cache_.clear();
+    }
+
+    auto size() const {
+        const std::lock_guard lock(lock_);
+        return cache_.size();
+    }
+
+    auto hits() const {
+        const std::lock_guard lock(lock_);
+        return hits_;
+    }
+
+    auto misses() const {
+        const std::lock_guard lock(lock_);
+        return misses_;
+    }
+
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    using chain_t = std::shared_ptr<STACK_OF(X509)>;
+
+    // the built chain is kept so a hit can hand it back to the context
+    struct entry_t {
+        int result{X509_V_OK};
+        clock_t::time_point expires{};
+        chain_t chain;
+    };
+
+    static void free_chain(STACK_OF(X509) *chain) noexcept {
+        sk_X509_pop_free(chain, X509_free);
+    }
+
+    X509_STORE *store_{nullptr};
+    std::size_t limit_;
+    duration_t ttl_;
+    mutable std::mutex lock_;
+    flat_map<std::string, entry_t> cache_;
+    std::size_t hits_{0}, misses_{0};
+
+    static auto make_key(X509_STORE_CTX *ctx) -> std::string {
+        auto store = X509_STORE_CTX_get0_store(ctx);
+        std::string key(reinterpret_cast<const char *>(&store), sizeof(store));
+        if(!append(key, X509_STORE_CTX_get0_cert(ctx)))
+            return {};
+        auto chain = X509_STORE_CTX_get0_untrusted(ctx);
+        for(auto pos = 0; chain && pos < sk_X509_num(chain); ++pos) {
+            if(!append(key, sk_X509_value(chain, pos)))
+                return {};
+        }
+        return key;
+    }
+
+    static auto append(std::string& key, X509 *cert) -> bool {
+        uint8_t data[EVP_MAX_MD_SIZE];
+        unsigned size{0};
+        if(!cert || X509_digest(cert, EVP_sha256(), data, &size) != 1)
+            return false;
+        key.append(reinterpret_cast<const char *>(data), size);
+        return true;
+    }
+
+    // no longer than the ttl, nor past the first expiry in the chain
+    auto lifetime(X509_STORE_CTX *ctx) const -> duration_t {
+        auto earliest = X509_get0_notAfter(X509_STORE_CTX_get0_cert(ctx));
+        auto chain = X509_STORE_CTX_get0_chain(ctx);
+        for(auto pos = 0; chain && pos < sk_X509_num(chain); ++pos) {
+            auto expires = X509_get0_notAfter(sk_X509_value(chain, pos));
+            if(ASN1_TIME_compare(expires, earliest) < 0)
+                earliest = expires;
+        }
+        int days{0}, secs{0};
+        if(!earliest || ASN1_TIME_diff(&days, &secs, nullptr, earliest) != 1)
+            return duration_t::zero();
+        const auto remains = std::chrono::seconds(std::int64_t(days) * 86400 + secs);
+        if(remains <= std::chrono::seconds(0))
+            return duration_t::zero();
+        return std::min(ttl_, std::chrono::duration_cast<duration_t>(remains));
+    }
+};
 } // end namespace
 #endif
@@ -6,6 +6,8 @@
 #include "array.hpp"
 #include "memory.hpp"
 #include <string>
+#include <vector>
+#include <thread>
 #include <cstdlib>
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
@@ -51,6 +53,51 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
         assert(spanner.front() == "first");
         assert(spanner.size() == 20);
 
+        tycho::small_slice<std::string, 3> small{"one", "two"};
+        small.push_back("three");
+        assert(small.is_inline());
+        small.emplace_back("four");
+        assert(!small.is_inline() && small.back() == "four");
+        auto moved = std::move(small);
+        assert(moved.size() == 4 && small.empty());
+
+        // growing with an element of the slice itself copies it first
+        tycho::small_slice<std::string, 2> grown{"a long string that is not short", "b"};
+        while(grown.size() < 20) {
+            grown.push_back(grown[0]);
+            assert(grown.back() == grown[0]);
+        }
+        assert(grown[19] == "a long string that is not short");
+        grown.resize(64, grown[1]);
+        assert(grown.size() == 64 && grown[63] == "b");
+
+        tycho::small_slice<uint8_t, 16> inbound;
+        auto fill = inbound.append_uninit(64);
+        memset(fill, 5, 64);
+        assert(inbound.size() == 64 && inbound[63] == 5);
+        inbound.resize_uninitialized(8);
+        assert(inbound.size() == 8);
+
+        bytebuffer_t buffer;
+        buffer.resize(32);
+        assert(buffer.size() == 32);
+
+        aligned_buffer<uint8_t, 32> block(45);
+        assert(reinterpret_cast<uintptr_t>(block.data()) % 32 == 0);
+        assert(block.capacity() == 64);
+        block.zero_tail();
+        const aligned_span<const uint8_t, 32> window(std::as_const(block));
+        assert(window.size() == 45 && window.padded() == 64);
+        assert(window.data()[63] == 0);
+        bool misaligned = false;
+        try {
+            const aligned_span<uint8_t, 32> bad(block.data() + 1, 4);
+        }
+        catch(const std::invalid_argument&) {
+            misaligned = true;
+        }
+        assert(misaligned);
+
         auto shared = bytearray_t(3, 7);
         auto shared1(shared);
         {
@@ -60,6 +107,57 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
         assert(shared1.count() == 2);
         assert(shared1[2] == 7);
         assert(shared1[0] == 9);
+
+        const auto packet = bytearray_t(64, 3);
+        auto header = packet.slice(0, 16);
+        auto body = packet.slice(16);
+        assert(header.size() == 16 && body.size() == 48);
+        assert(body.get() == packet.get() + 16);
+        assert(packet.count() == 3);
+        assert(reinterpret_cast<uintptr_t>(packet.get()) % 64 == 0);
+        assert(header.to_hex().substr(0, 4) == "0303");
+
+        mempager pager(1024);
+        const mempager_allocator<int> alloc(pager);
+        tycho::slice<int, mempager_allocator<int>> arena(alloc);
+        for(auto count = 0; count < 1000; ++count)
+            arena.push_back(count);
+        assert(arena[999] == 999);
+        assert(pager.pages() > 1);
+        auto aligned = pager.allocate(64, 64);
+        assert(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+
+        mempager_resource resource(pager);
+        std::pmr::vector<std::pmr::string> names(&resource);
+        names.emplace_back("a string that is too long for small buffers");
+        assert(names[0].get_allocator().resource() == &resource);
+
+        object_pool<std::string> pool;
+        auto first = pool.make("first");
+        auto second = pool.make_unique("second");
+        assert(*first == "first" && *second == "second");
+        pool.free(first);
+        assert(pool.stats().live == 1 && pool.stats().free == 1);
+        assert(pool.make("reused") == first);
+
+        object_pool<uint64_t, 4> striped;
+        std::vector<std::thread> threads;
+        for(auto count = 0; count < 4; ++count) {
+            threads.emplace_back([&striped] {
+                std::vector<uint64_t *> items;
+                for(auto loop = 0; loop < 100; ++loop) {
+                    for(auto item = 0; item < 50; ++item)
+                        items.push_back(striped.make(item));
+                    for(auto item : items)
+                        striped.free(item);
+                    items.clear();
+                }
+            });
+        }
+        for(auto& thread : threads)
+            thread.join();
+        assert(striped.stats().live == 0);
+        assert(striped.stats().free >= 50);
     }
     catch(...) {
         ::exit(-1);
@@ -6,6 +6,8 @@
 #include "atomics.hpp"
 #include "templates.hpp"
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const atomics::once_t once;
@@ -16,6 +18,171 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     atomics::sequence_t<uint8_t> bytes(3);
     assert(*bytes == 3);
     assert(static_cast<uint8_t>(bytes) == 4);
+    assert(static_cast<uint8_t>(bytes) == 4);
+
+    atomics::counter_t<> hits;
+    std::vector<std::thread> counting;
+    for(unsigned id = 0; id < 4; ++id) {
+        counting.emplace_back([&hits] {
+            for(auto count = 0; count < 1000; ++count)
+                ++hits;
+        });
+    }
+    for(auto& thread : counting)
+        thread.join();
+    hits += 10;
+    assert(hits.load() == 4010);
+    assert(hits.exchange() == 4010);
+    assert(hits == 0U);
+
+    atomics::ring_t<int, 8> ring;
+    assert(ring.empty() && !ring.full() && !ring);
+    for(auto value = 0; value < 8; ++value)
+        assert(ring.push(value));
+    assert(ring.full() && ring.size() == 8);
+    assert(!ring.push(8));
+    int popped{-1};
+    for(auto value = 0; value < 8; ++value) {
+        assert(ring.pull(popped));
+        assert(popped == value);
+    }
+    assert(ring.empty() && !ring.pop());
+
+    // bulk moves that wrap past the end of the slots a few times
+    int batch[10]{}, drained[10]{};
+    auto next = 0, expect = 0;
+    for(auto round = 0; round < 5; ++round) {
+        for(auto& value : batch)
+            value = next++;
+        assert(ring.try_push_n(batch, 5) == 5);
+        assert(ring.size() == 5);
+        assert(ring.try_pop_n(drained, 10) == 5);
+        for(auto pos = 0; pos < 5; ++pos)
+            assert(drained[pos] == expect++);
+        next = expect;
+    }
+    for(auto& value : batch)
+        value = next++;
+    assert(ring.try_push_n(batch, 10) == 8);
+    assert(ring.full() && ring.try_push_n(batch, 1) == 0);
+    assert(ring.try_pop_n(drained, 10) == 8);
+    for(auto pos = 0; pos < 8; ++pos)
+        assert(drained[pos] == expect++);
+    assert(ring.empty() && ring.try_pop_n(drained, 1) == 0);
+
+    atomics::buffer_t<int, 4> buffer;
+    assert(buffer.empty() && !buffer);
+    for(auto round = 0; round < 4; ++round) {
+        for(auto value = 0; value < 3; ++value)
+            assert(buffer.push(round * 3 + value));
+        assert(buffer.full() && !buffer.push(-1));
+        for(auto value = 0; value < 3; ++value) {
+            assert(buffer.pull(popped));
+            assert(popped == round * 3 + value);
+        }
+        assert(buffer.empty() && !buffer.pop());
+    }
+
+    // single producer and consumer keep strict order thru the buffer
+    constexpr unsigned items = 100000;
+    atomics::buffer_t<unsigned, 16> channel;
+    std::thread feeder([&channel] {
+        for(unsigned value = 0; value < items; ++value) {
+            while(!channel.push(value))
+                std::this_thread::yield();
+        }
+    });
+    for(unsigned value = 0; value < items; ++value) {
+        unsigned item{0};
+        while(!channel.pull(item))
+            std::this_thread::yield();
+        assert(item == value);
+    }
+    feeder.join();
+    assert(channel.empty());
+
+    // many producers and consumers, each producer's items seen in order
+    constexpr unsigned producers = 4, consumers = 4, per = 20000;
+    atomics::ring_t<unsigned, 64> shared;
+    std::atomic<unsigned> taken{0};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> workers;
+    for(unsigned id = 0; id < producers; ++id) {
+        workers.emplace_back([&shared, id] {
+            for(unsigned seq = 0; seq < per; ++seq) {
+                while(!shared.push((id << 24) | seq))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for(unsigned id = 0; id < consumers; ++id) {
+        workers.emplace_back([&] {
+            unsigned last[producers]{}, seen[producers]{};
+            unsigned items[8]{};
+            while(taken.load() < producers * per) {
+                const auto count = shared.try_pop_n(items, 8);
+                if(!count) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for(std::size_t pos = 0; pos < count; ++pos) {
+                    const auto from = items[pos] >> 24, seq = items[pos] & 0xffffffU;
+                    assert(from < producers);
+                    assert(!seen[from] || seq > last[from]);
+                    last[from] = seq;
+                    ++seen[from];
+                    total += seq;
+                }
+                taken += unsigned(count);
+            }
+        });
+    }
+    for(auto& thread : workers)
+        thread.join();
+    assert(taken == producers * per);
+    assert(total == uint64_t(producers) * (uint64_t(per) * (per - 1) / 2));
+    assert(shared.empty());
+
+    atomics::linked_stack_t<int> stack(4);
+    assert(stack.empty() && !stack && !stack.pop());
+    popped = -1;
+    assert(!stack.pull(popped) && popped == -1);
+    for(auto value = 0; value < 100; ++value)
+        assert(stack.push(value));
+    assert(stack.size() == 100 && stack.capacity() >= 100);
+    for(auto value = 99; value >= 0; --value) {
+        auto item = stack.pop();
+        assert(item && *item == value);
+    }
+    assert(stack.empty() && stack.size() == 0 && !stack.pop());
+
+    // concurrent push and pop, nodes recycle thru the freelist
+    constexpr unsigned pushers = 4, rounds = 20000;
+    atomics::linked_stack_t<unsigned> pile;
+    std::atomic<unsigned> pulled{0};
+    std::atomic<uint64_t> summed{0};
+    std::vector<std::thread> users;
+    for(unsigned id = 0; id < pushers; ++id) {
+        users.emplace_back([&pile, &pulled, &summed] {
+            for(unsigned seq = 0; seq < rounds; ++seq) {
+                assert(pile.push(seq));
+                unsigned item{0};
+                if(pile.pull(item)) {
+                    summed += item;
+                    ++pulled;
+                }
+            }
+        });
+    }
+    for(auto& thread : users)
+        thread.join();
+    while(auto item = pile.pop()) {
+        summed += *item;
+        ++pulled;
+    }
+    assert(pulled == pushers * rounds);
+    assert(summed == uint64_t(pushers) * (uint64_t(rounds) * (rounds - 1) / 2));
+    assert(pile.empty() && pile.size() == 0);
 }
 
 
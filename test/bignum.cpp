@@ -24,6 +24,36 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     auto a = abs(v1);
     assert(*a == "23451234567864");
 
+    // compound operators work in place
+    bignum_t v3(1000);
+    v3 *= bignum_t(3);
+    v3 -= bignum_t(1);
+    v3 /= bignum_t(7);
+    assert(*v3 == "428");
+    v3 %= bignum_t(100);
+    assert(*v3 == "28");
+    v3 = 12;
+    assert(*v3 == "12");
+
+    // modular exponentiation with a cached montgomery setup
+    const bignum_t mod("1000000007"), base("12345"), exp("67890");
+    const montgomery_t mont(mod);
+    assert(!!mont);
+    const bignum_t expect("510481435");
+    assert(mont.pow(base, exp) == expect);
+    assert(mod_exp(base, exp, mod) == expect);
+    assert(mod_exp(base, exp, mod) == expect);
+    bignum_t secret(exp);
+    assert(secret.consttime().is_consttime());
+    assert(mont.pow(base, secret) == expect);
+    assert(mod_exp(base, exp, bignum_t(1000)) == bignum_t(625));
+
+    // a hot modulus stays cached while more moduli than fit pass thru
+    for(auto odd = 1001; odd < 1041; odd += 2) {
+        const bignum_t other(odd);
+        assert(mod_exp(base, bignum_t(1), other) == bignum_t(12345 % odd));
+        assert(mod_exp(base, exp, mod) == expect);
+    }
 }
 
 
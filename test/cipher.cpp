@@ -6,9 +6,85 @@
 #include "cipher.hpp"
 #include "encoding.hpp"
 
+#include <string_view>
+#include <string>
+#include <vector>
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const crypto::keyphrase_t key("hello there");
     assert(key.size() == 32);
     const auto pair = crypto::key_t(key);
     assert(to_b64(pair.first, pair.second) == "EpmMAXBm6w0qcLlObtMZKYWFXOOQ8yG724MgIoiL0lE=");
+
+    // one gcm context per direction reused across records with new nonces
+    const crypto::keyphrase_t gcm("record key", crypto::nosalt, EVP_aes_256_gcm());
+    crypto::encrypt_t sealer(gcm);
+    crypto::decrypt_t opener(gcm);
+    assert(sealer && opener && sealer.ivsize() == 12 && sealer.tagsize() == 16);
+    const std::string_view header("hdr"), body(" and body");
+    const std::string_view plain("record one");
+    for(uint8_t record = 0; record < 3; ++record) {
+        const uint8_t iv[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, record};
+        uint8_t tag[16]{}, text[64]{}, tail[16]{};
+        assert(sealer.reset(iv) && sealer);
+        assert(sealer.aad(reinterpret_cast<const uint8_t *>("aad"), 3));
+        const crypto::cipher_part parts[2] = {{header.data(), header.size()}, {body.data(), body.size()}};
+        const auto used = sealer.update(parts, 2, text);
+        assert(used == header.size() + body.size());
+        assert(sealer.finish(tail, tag) == 0 && !sealer);
+
+        assert(opener.reset(iv));
+        assert(opener.aad(reinterpret_cast<const uint8_t *>("aad"), 3));
+        assert(opener.update(text, used) == used);
+        opener.finish(tail, tag);
+        assert(opener.verified());
+        assert(std::string_view(reinterpret_cast<const char *>(text), used) == "hdr and body");
+
+        // in place with a corrupted tag fails verification
+        memcpy(text, plain.data(), plain.size());
+        assert(sealer.reset(iv) && sealer.update(text, plain.size()) == plain.size());
+        sealer.finish(tail, tag);
+        tag[0] ^= 1;
+        assert(opener.reset(iv) && opener.update(text, plain.size()) == plain.size());
+        opener.finish(tail, tag);
+        assert(!opener.verified());
+    }
+
+    // chunked payloads match for any thread count and open chunks alone
+    std::string payload(100000, 0);
+    for(std::size_t pos = 0; pos < payload.size(); ++pos)
+        payload[pos] = char(pos * 7);
+    const uint8_t base[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    const auto input = reinterpret_cast<const uint8_t *>(payload.data());
+    const auto sealed = crypto::gcm_chunks::sealed_size(payload.size(), 4096);
+    assert(sealed == 28 + 100000 + 25 * 16);
+    std::vector<uint8_t> one(sealed), many(sealed), output(payload.size());
+    assert(crypto::gcm_chunks::seal(gcm, base, input, payload.size(), one.data(), 4096, 1) == sealed);
+    assert(crypto::gcm_chunks::seal(gcm, base, input, payload.size(), many.data(), 4096, 4) == sealed);
+    assert(one == many);
+    assert(crypto::gcm_chunks::plain_size(one.data(), one.size()) == payload.size());
+    assert(crypto::gcm_chunks::chunks(one.data(), one.size()) == 25);
+    assert(crypto::gcm_chunks::open(gcm, one.data(), one.size(), output.data(), 4));
+    assert(memcmp(output.data(), input, payload.size()) == 0);
+
+    uint8_t part[4096]{};
+    assert(crypto::gcm_chunks::open_chunk(gcm, one.data(), one.size(), 24, part) == 100000 - 24 * 4096);
+    assert(memcmp(part, input + 24 * 4096, 100000 - 24 * 4096) == 0);
+    assert(crypto::gcm_chunks::open_chunk(gcm, one.data(), one.size(), 25, part) == 0);
+    many[28 + 5 * (4096 + 16) + 10] ^= 1;
+    assert(crypto::gcm_chunks::open_chunk(gcm, many.data(), many.size(), 5, part) == 0);
+    assert(crypto::gcm_chunks::open_chunk(gcm, many.data(), many.size(), 6, part) == 4096);
+    assert(!crypto::gcm_chunks::open(gcm, many.data(), many.size(), output.data()));
+    one[8] ^= 1;
+    assert(!crypto::gcm_chunks::open(gcm, one.data(), one.size(), output.data()));
+
+    // an empty payload still carries one tag, so a bare header is refused
+    assert(crypto::gcm_chunks::sealed_size(0, 4096) == 28 + 16);
+    std::vector<uint8_t> empty(crypto::gcm_chunks::sealed_size(0, 4096));
+    assert(crypto::gcm_chunks::seal(gcm, base, input, 0, empty.data(), 4096) == empty.size());
+    assert(crypto::gcm_chunks::chunks(empty.data(), empty.size()) == 1);
+    assert(crypto::gcm_chunks::open(gcm, empty.data(), empty.size(), output.data()));
+    assert(!crypto::gcm_chunks::open(gcm, empty.data(), 28, output.data()));
+    empty[30] ^= 1;
+    assert(!crypto::gcm_chunks::open(gcm, empty.data(), empty.size(), output.data()));
 }
@@ -8,6 +8,10 @@
 #include "encoding.hpp"
 #include "templates.hpp"
 
+#include <cstdio>
+#include <thread>
+#include <vector>
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     crypto::digest_t digest(EVP_sha256());
     assert(is(digest) == true);
@@ -16,6 +20,124 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     digest.finish();
     assert(digest.size() == 32);
     assert(to_hex(digest.view()) == "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9");
+
+    // batched small messages match one at a time digests
+    const std::string_view msgs[3] = {"hello world", "", "abc"};
+    uint8_t many[3 * 32]{}, one[32]{};
+    assert(crypto::digest(msgs, 3, many, EVP_sha256(), 2) == 3);
+    assert(to_hex(many, 32) == to_hex(digest.view()));
+    assert(crypto::digest(msgs[2], one) == 32 && memcmp(one, many + 64, 32) == 0);
+
+    // tree hash is the same for any thread count and differs by chunk size
+    const std::string large(100000, 'x');
+    uint8_t serial[32]{}, parallel[32]{}, other[32]{};
+    std::vector<uint8_t> leaves;
+    assert(crypto::tree_digest(reinterpret_cast<const uint8_t *>(large.data()), large.size(), serial, EVP_sha256(), 4096, 1, &leaves) == 32);
+    assert(leaves.size() == 25 * 32);
+    assert(crypto::tree_digest(large, parallel, EVP_sha256(), 4096, 4) == 32);
+    assert(memcmp(serial, parallel, 32) == 0);
+    assert(crypto::tree_digest(large, other, EVP_sha256(), 8192, 4) == 32);
+    assert(memcmp(serial, other, 32) != 0);
+    const std::string copy(large);
+    assert(crypto::tree_digest(copy, other, EVP_sha256(), 4096) == 32);
+    assert(memcmp(serial, other, 32) == 0);
+    assert(crypto::tree_digest(std::string_view(), other) == 32);
+
+    // descriptors hash from their position, mapped or read by chunks
+    auto tree_file = std::tmpfile();
+    assert(tree_file != nullptr);
+    assert(std::fwrite(large.data(), 1, large.size(), tree_file) == large.size());
+    assert(std::fflush(tree_file) == 0);
+    const fsys::fd_t tree_fd(::dup(fileno(tree_file)));
+    std::fclose(tree_file);
+    std::vector<uint8_t> file_leaves;
+    assert(tree_fd.seek(0) == 0);
+    assert(crypto::tree_digest(tree_fd, other, EVP_sha256(), 4096, 4, &file_leaves) == 32);
+    assert(memcmp(serial, other, 32) == 0 && file_leaves == leaves);
+    assert(tree_fd.tell() == off_t(large.size()));
+    assert(tree_fd.seek(4096) == 4096);
+    uint8_t tail[32]{};
+    assert(crypto::tree_digest(reinterpret_cast<const uint8_t *>(large.data()) + 4096, large.size() - 4096, tail, EVP_sha256(), 4096) == 32);
+    assert(crypto::tree_digest(tree_fd, other, EVP_sha256(), 4096) == 32);
+    assert(memcmp(tail, other, 32) == 0);
+
+    int tree_pipe[2]{-1, -1};
+    assert(::pipe(tree_pipe) == 0);
+    std::thread feeder([&] {
+        std::size_t pos = 0;
+        while(pos < large.size()) {
+            auto result = ::write(tree_pipe[1], large.data() + pos, std::min(std::size_t(3000), large.size() - pos));
+            assert(result > 0);
+            pos += std::size_t(result);
+        }
+        ::close(tree_pipe[1]);
+    });
+    const fsys::fd_t tree_read(tree_pipe[0]);
+    file_leaves.clear();
+    assert(crypto::tree_digest(tree_read, other, EVP_sha256(), 4096, 0, &file_leaves) == 32);
+    feeder.join();
+    assert(memcmp(serial, other, 32) == 0 && file_leaves == leaves);
+
+    // keyed contexts reuse the key schedule and match one-shot hmac
+    crypto::hmac_t keyed_mac("secret");
+    assert(is(keyed_mac));
+    uint8_t expect[32]{}, result[32]{}, batch[3 * 32]{};
+    assert(crypto::hmac("secret", "hello world", expect) == 32);
+    assert(keyed_mac.update("hello ") && keyed_mac.update("world") && keyed_mac.finish());
+    assert(keyed_mac.size() == 32 && memcmp(keyed_mac.data(), expect, 32) == 0);
+    assert(!keyed_mac.update("more"));
+    assert(keyed_mac.reset() && keyed_mac.size() == 0);
+    assert(keyed_mac.mac("hello world", result) == 32 && memcmp(result, expect, 32) == 0);
+    auto cloned = keyed_mac;
+    assert(cloned.mac("hello world", result) == 32 && memcmp(result, expect, 32) == 0);
+    assert(keyed_mac.mac(msgs, 3, batch) == 3 && memcmp(batch, expect, 32) == 0);
+    assert(crypto::hmac("secret", "abc", result) == 32 && memcmp(batch + 64, result, 32) == 0);
+
+    // file digests match the in memory digest, mapped or from a pipe
+    auto file = std::tmpfile();
+    assert(file != nullptr);
+    assert(std::fwrite(large.data(), 1, large.size(), file) == large.size());
+    assert(std::fflush(file) == 0);
+    uint8_t direct[32]{}, mapped[32]{}, piped[32]{};
+    assert(crypto::digest(large, direct) == 32);
+    std::rewind(file);
+    assert(crypto::digest_file(fileno(file), mapped) == 32);
+    assert(memcmp(direct, mapped, 32) == 0);
+    assert(::lseek(fileno(file), 0, SEEK_CUR) == off_t(large.size()));
+    uint8_t keyed[32]{}, keyed_file[32]{};
+    assert(crypto::hmac("secret", large, keyed) == 32);
+    std::rewind(file);
+    assert(crypto::hmac_file("secret", fileno(file), keyed_file) == 32);
+    assert(memcmp(keyed, keyed_file, 32) == 0);
+
+    // mapped and read input both start at the current position
+    const fsys::fd_t file_fd(::dup(fileno(file)));
+    std::fclose(file);
+    assert(file_fd.seek(1000) == 1000);
+    assert(crypto::digest(std::string_view(large).substr(1000), direct) == 32);
+    assert(crypto::digest_file(file_fd, mapped) == 32);
+    assert(memcmp(direct, mapped, 32) == 0);
+    assert(crypto::digest_file(file_fd, mapped) == 32);
+    assert(crypto::digest(std::string_view(), direct) == 32);
+    assert(memcmp(direct, mapped, 32) == 0);
+    assert(crypto::digest(large, direct) == 32);
+
+    int fds[2]{-1, -1};
+    assert(::pipe(fds) == 0);
+    std::thread writer([&] {
+        std::size_t pos = 0;
+        while(pos < large.size()) {
+            auto result = ::write(fds[1], large.data() + pos, std::min(std::size_t(7000), large.size() - pos));
+            assert(result > 0);
+            pos += std::size_t(result);
+        }
+        ::close(fds[1]);
+    });
+    assert(crypto::digest_file(fds[0], piped) == 32);
+    writer.join();
+    ::close(fds[0]);
+    assert(memcmp(direct, piped, 32) == 0);
+    assert(crypto::digest_file(std::string("/nonexistent/file"), piped) == 0);
 }
 
 
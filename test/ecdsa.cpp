@@ -8,7 +8,84 @@
 #include "sign.hpp"
 #include "x509.hpp"
 
+#include <string>
+#include <vector>
+
+namespace {
+auto pem_of(EVP_PKEY *key) {
+    std::string pem;
+    auto bp = BIO_new(BIO_s_mem());
+    if(bp && PEM_write_bio_PUBKEY(bp, key) == 1) {
+        BUF_MEM *buf{};
+        BIO_get_mem_ptr(bp, &buf);
+        pem = std::string(buf->data, buf->length);
+    }
+    BIO_free(bp);
+    return pem;
+}
+
+auto sign_with(EVP_PKEY *key, const EVP_MD *md, const std::string& msg) {
+    std::string sig(512, 0);
+    auto size = sig.size();
+    auto ctx = EVP_MD_CTX_new();
+    assert(EVP_DigestSignInit(ctx, nullptr, md, nullptr, key) == 1);
+    assert(EVP_DigestSign(ctx, reinterpret_cast<uint8_t *>(sig.data()), &size, reinterpret_cast<const uint8_t *>(msg.data()), msg.size()) == 1);
+    EVP_MD_CTX_free(ctx);
+    sig.resize(size);
+    return sig;
+}
+} // end anon namespace
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const crypto::eckey_t keypair;
     assert(is(keypair));
+
+    // cached keys by fingerprint verify batches of ecdsa and ed25519
+    auto edkey = EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519");
+    assert(edkey != nullptr);
+    auto eckey = keypair.share();
+    crypto::verifier cache(8);
+    const auto ec_id = cache.insert(keypair.pub());
+    const auto ed_id = cache.insert(pem_of(edkey));
+    assert(ec_id.size() == 64 && ed_id.size() == 64 && ec_id != ed_id);
+    assert(cache.size() == 2 && cache.contains(ed_id));
+
+    std::vector<std::string> msgs, sigs;
+    std::vector<std::string> ids;
+    for(auto pos = 0; pos < 100; ++pos) {
+        msgs.push_back("token " + std::to_string(pos));
+        const auto ed = (pos % 2) != 0;
+        sigs.push_back(sign_with(ed ? edkey : eckey, ed ? nullptr : EVP_sha256(), msgs.back()));
+        ids.push_back(ed ? ed_id : ec_id);
+    }
+    assert(cache.verify(ids[0], msgs[0], sigs[0]));
+    assert(cache.verify(ids[1], msgs[1], sigs[1]));
+    assert(!cache.verify(ids[1], msgs[0], sigs[1]));
+
+    sigs[7][10] ^= 1;
+    ids[8] = "unknown";
+    std::vector<crypto::verify_item> list;
+    for(std::size_t pos = 0; pos < msgs.size(); ++pos)
+        list.push_back({ids[pos], msgs[pos], sigs[pos]});
+    bool results[100]{};
+    assert(cache.verify(list.data(), list.size(), results, 4) == 98);
+    assert(results[0] && results[1] && !results[7] && !results[8] && results[99]);
+
+    crypto::sign_t signer(keypair.share());
+    assert(signer.update(msgs[0]) && signer.finish() && signer.size() > 64);
+    assert(cache.verify(ec_id, msgs[0], signer.view()));
+
+    // a full cache evicts the key least recently inserted or verified
+    auto other = EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519");
+    assert(other != nullptr);
+    crypto::verifier small(2);
+    assert(small.insert(keypair.pub()) == ec_id && small.insert(pem_of(edkey)) == ed_id);
+    assert(small.verify(ec_id, msgs[0], sigs[0]));
+    const auto other_id = small.insert(pem_of(other));
+    assert(small.size() == 2 && small.contains(ec_id) && small.contains(other_id) && !small.contains(ed_id));
+    EVP_PKEY_free(other);
+
+    assert(cache.erase(ed_id) && !cache.verify(ids[1], msgs[1], sigs[1]));
+    EVP_PKEY_free(eckey);
+    EVP_PKEY_free(edkey);
 }
@@ -0,0 +1,54 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "hashmap.hpp"
+#include <string>
+#include <cstdlib>
+
+using namespace tycho;
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    try {
+        const std::string text(100, 'a');
+        assert(mem_hash(text) == mem_hash(text.data(), text.size()));
+        assert(mem_hash(text) != mem_hash(text, 1));
+        assert(mem_hash("abc") != mem_hash("abd"));
+        assert(mem_hash("") != mem_hash("a"));
+
+        flat_map<std::string, int> names{{"one", 1}, {"two", 2}};
+        names["three"] = 3;
+        assert(names.size() == 3);
+        assert(names.at(std::string_view("two")) == 2);
+        assert(names.contains("one") && !names.contains("four"));
+        assert(!names.try_emplace("one", 9).second);
+        names.insert_or_assign("one", 11);
+        assert(names.find("one")->second == 11);
+
+        flat_map<int, int> numbers;
+        for(auto count = 0; count < 1000; ++count)
+            numbers[count] = count * 2;
+        assert(numbers.size() == 1000 && numbers.load_factor() <= 0.875F);
+        for(auto count = 0; count < 1000; count += 2)
+            assert(numbers.erase(count) == 1);
+        assert(numbers.size() == 500);
+        for(auto count = 1; count < 1000; count += 2)
+            assert(numbers.at(count) == count * 2);
+        assert(numbers.erase_if([](const auto& item) {
+            return item.first < 500;
+        }) == 250);
+        auto total = 0;
+        for(const auto& [key, value] : numbers)
+            total += key > 500 ? 1 : 0;
+        assert(total == 250);
+
+        auto copy = numbers;
+        assert(copy.size() == 250 && copy.at(999) == 1998);
+        numbers.clear();
+        assert(numbers.empty() && !numbers.contains(999));
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "journal.hpp"
+
+#include <thread>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace tycho;
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    const std::string path = "/tmp/tycho-journal-" + std::to_string(getpid());
+    ::remove(path.c_str());
+
+    // growing, advising, and syncing a plain map
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0640);   // FlawFinder: ignore
+    assert(fd > -1 && ::ftruncate(fd, 8192) == 0);
+    process::map_t map(fd, 4096, true, false, 0, true);
+    assert(map && map.size() == 4096);
+    map[100] = 42;
+    assert(map.advise(process::advice_t::sequential));
+    assert(map.advise(process::advice_t::random, 100, 10));
+    assert(map.prefetch());
+    assert(map.sync(100, 10, true));
+    assert(!map.sync(5000, 10));
+    assert(map.resize(8192) && map.size() == 8192);
+    assert(map[100] == 42);
+    map[8000] = 7;
+    assert(map.sync(true));
+    ::close(fd);
+    ::remove(path.c_str());
+
+    {
+        mapped_log log(path, true, 4 * 1024 * 1024);
+        assert(log && log.committed() == 0);
+        assert(!mapped_log(path));      // one writer at a time
+        mapped_log reader(path, false, 4 * 1024 * 1024);
+        assert(reader && reader.committed() == 0);
+
+        std::thread scanner([&reader] {
+            uint64_t offset = 0;
+            std::size_t seen = 0;
+            while(seen < 2000) {
+                offset = reader.scan([&seen](std::string_view record) {
+                    assert(record == "record " + std::to_string(seen));
+                    ++seen;
+                    return true;
+                }, offset);
+            }
+        });
+        for(auto count = 0; count < 2000; ++count)
+            assert(log.append("record " + std::to_string(count)));
+        scanner.join();
+
+        // large records grow the file past its first extent
+        const std::string big(300000, 'b');
+        for(auto count = 0; count < 6; ++count)
+            assert(log.append(big));
+        assert(log.sync());
+
+        auto to = static_cast<char *>(log.reserve(64));
+        assert(to != nullptr);
+        memcpy(to, "lost", 4);      // reserved, never committed
+    }
+
+    {
+        mapped_log log(path, true, 4 * 1024 * 1024);
+        assert(log);
+        std::size_t records = 0, large = 0;
+        const auto end = log.scan([&](std::string_view record) {
+            ++records;
+            if(record.size() == 300000)
+                ++large;
+            return record != "lost";
+        });
+        assert(records == 2006 && large == 6 && end == log.committed());
+        assert(log.append("after"));
+        std::string last;
+        log.scan([&last](std::string_view record) {
+            last = record;
+            return true;
+        }, end);
+        assert(last == "after");
+        assert(!log.reserve(8 * 1024 * 1024));
+    }
+
+    // a length prefix running past the committed range stops the scan
+    ::remove(path.c_str());
+    {
+        mapped_log log(path);
+        assert(log.append("one") && log.append("two"));
+        const uint64_t bogus = uint64_t(1) << 40;
+        auto file = ::open(path.c_str(), O_RDWR);   // FlawFinder: ignore
+        assert(file > -1 && ::pwrite(file, &bogus, sizeof(bogus), mapped_log::header_size + 16) == ssize_t(sizeof(bogus)));
+        ::close(file);
+        std::size_t records = 0;
+        assert(log.scan([&records](std::string_view) {
+            ++records;
+            return true;
+        }) == 16 && records == 1);
+    }
+
+    mapped_log missing("/tmp/no-such-dir/journal");
+    assert(!missing);
+    ::remove(path.c_str());
+}
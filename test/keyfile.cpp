@@ -5,6 +5,17 @@
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "keyfile.hpp"
 #include "scan.hpp"
+#include "filesystem.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+#ifdef  _MSC_VER
+#include <process.h>
+#endif
 
 #ifndef TEST_DATA
 #define TEST_DATA "."   // NOLINT
@@ -35,6 +46,53 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     keys = test_keys["more"];
     assert(keys["hello"] == "world");
     assert(get_lower(keys["mixed"]) == "case");
-}
 
+    // compiled snapshot lookups by string_view
+    const keyfile_snapshot snap(test_keys);
+    assert(snap.size() == 7);
+    assert(snap.contains("server") && !snap.contains("missing"));
+    assert(snap.get("test", "test1") == "hello");
+    assert(snap.get("test", "test2").empty());
+    assert(snap.get("more", "nothing", "fallback") == "fallback");
+    const auto server = snap["server"];
+    assert(server && server.size() == 1 && server.key(0) == "priority" && server.value(0) == "2");
+    assert(!snap["[missing]"]);
+    const auto copied = snap;
+    assert(copied.get("common", "password") == "test" && copied.bytes() == snap.bytes());
+    for(std::size_t pos = 1; pos < snap.size(); ++pos)
+        assert(snap.at(pos - 1).name() < snap.at(pos).name());
 
+    // readers keep a consistent snapshot while reloads publish new ones
+    const auto path = (fsys::temp_directory_path() / ("tycho-reload-" + std::to_string(getpid()) + ".conf")).string();
+    const auto write = [&path](int value) {
+        std::ofstream out(path);
+        out << "[live]\nfirst = " << value << "\nsecond = " << value << "\n";
+    };
+    write(0);
+    keyfile_config config({path});
+    assert(config.generation() == 1 && config.get()->get("live", "first") == "0");
+    std::atomic<bool> done{false};
+    std::atomic<unsigned> reads{0};
+    std::vector<std::thread> readers;
+    for(auto count = 0; count < 4; ++count) {
+        readers.emplace_back([&] {
+            while(!done) {
+                const auto current = config.get();
+                const auto live = current->section("live");
+                assert(live.get("first") == live.get("second"));
+                ++reads;
+            }
+        });
+    }
+    for(auto value = 1; value <= 20; ++value) {
+        write(value);
+        assert(config.reload());
+    }
+    done = true;
+    for(auto& reader : readers)
+        reader.join();
+    assert(reads > 0 && config.generation() == 21);
+    assert(config.get()->get("live", "first") == "20");
+    std::remove(path.c_str());
+    assert(!config.reload() && config.get()->get("live", "second") == "20");
+}
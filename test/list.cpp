@@ -4,8 +4,17 @@
 #undef  NDEBUG
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "list.hpp"
+#include "memory.hpp"
 #include <cstdlib>
 
+namespace {
+struct work_t {
+    int id{0};
+    tycho::slist_hook<work_t> hook;
+    explicit work_t(int value) : id(value) {}
+};
+} // end namespace
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     try {
         tycho::slist<int> list{1, 2, 3, 4, 5};
@@ -15,9 +24,36 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
             return v < 3;
         });
         assert(list.front() == 3);
+
+        tycho::slist<int> more{6, 7};
+        list.splice(more);
+        assert(more.empty() && list.size() == 5 && list.back() == 7);
+        static_assert(std::is_nothrow_move_assignable_v<tycho::slist<int>>);
+        more = std::move(list);
+        assert(list.empty() && more.size() == 5 && more.front() == 3);
+
+        tycho::mempager pager(1024);
+        tycho::slist<int, tycho::mempager_allocator<int>> arena(tycho::mempager_allocator<int>{pager});
+        for(auto count = 0; count < 100; ++count)
+            arena.emplace_back(count);
+        assert(arena.size() == 100 && arena.back() == 99);
+        assert(arena.pop() == 0);
+        tycho::slist<int, tycho::mempager_allocator<int>> other(tycho::mempager_allocator<int>{pager});
+        other = std::move(arena);
+        assert(arena.empty() && other.size() == 99 && other.front() == 1);
+
+        tycho::object_pool<work_t> pool;
+        tycho::intrusive_slist<work_t> pending, ready;
+        for(auto count = 0; count < 4; ++count)
+            pending.push_back(*pool.make(count));
+        assert(pending.remove(pending.back()));
+        ready.splice(pending);
+        assert(pending.empty() && ready.size() == 3);
+        while(auto work = ready.pop())
+            pool.free(work);
+        assert(pool.stats().live == 1);
     }
     catch(...) {
         ::exit(-1);
     }
 }
-
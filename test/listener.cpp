@@ -0,0 +1,57 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "listener.hpp"
+#include "stream.hpp"
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace tycho;
+
+namespace {
+address_t local_host("127.0.0.1", 9793);
+} // end anon namespace
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    assert(Socket::startup());
+    try {
+        listener::options_t options;
+        options.backlog = 64;
+        options.defer_accept = 1;
+        options.affinity = true;
+        listener edge(local_host, 2, options);
+        assert(edge.shards() == 2 && edge.size() >= 1);
+        assert(edge[0].local().port() == 9793);
+
+        std::atomic<unsigned> served{0};
+        edge.start([&served](int so, const struct sockaddr *peer) {
+            tcpstream tcp(so, peer);
+            char buf[4]{};
+            tcp.read(buf, 4);
+            if(std::string(buf, 4) == "ping")
+                ++served;
+            return true;
+        });
+        assert(edge.running());
+
+        for(auto count = 0; count < 8; ++count) {
+            tcpstream tcp(local_host);
+            tcp << "ping";
+            tcp.flush();
+        }
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(served < 8 && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        assert(served == 8 && edge.accepted() == 8);
+        edge.stop();
+        assert(!edge.running());
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+    Socket::shutdown();
+}
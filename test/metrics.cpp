@@ -0,0 +1,110 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "metrics.hpp"
+#include "tasks.hpp"
+#include "stream.hpp"
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace {
+auto find(const std::vector<metrics::sample_t>& list, const std::string& name) {
+    for(const auto& item : list) {
+        if(item.name == name)
+            return item;
+    }
+    return metrics::sample_t{};
+}
+} // end namespace
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    static_assert(metrics::enabled);
+
+    // counters and histograms summed over thread shards
+    metrics::counter_t hits("test.hits");
+    metrics::histogram_t spans("test.spans");
+    std::vector<std::thread> threads;
+    for(auto thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&hits, &spans] {
+            for(uint64_t count = 1; count <= 1000; ++count) {
+                ++hits;
+                spans.record(count);
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    assert(hits.value() == 4000);
+    assert(spans.count() == 4000 && spans.max() == 1000);
+    assert(spans.total() == 4 * 500500);
+    assert(spans.percentile(0.5) == 511 && spans.percentile(1.0) == 1023);
+
+    {
+        const metrics::counter_t unlisted;
+        const metrics::counter_t scoped("test.scoped");
+        assert(find(metrics::snapshot(), "test.scoped").name == "test.scoped");
+    }
+    assert(find(metrics::snapshot(), "test.scoped").name.empty());
+
+    // hooks in the task queue, task pool, and timer queue
+    metrics::tracer().start();
+    std::atomic<int> ran{0};
+    task_queue queue;
+    queue.startup();
+    task_pool pool(2);
+    pool.startup();
+    for(auto count = 0; count < 8; ++count) {
+        queue.dispatch([&ran] { ++ran; });
+        pool.dispatch([&ran] { ++ran; });
+    }
+    timer_queue timers;
+    timers.at(std::chrono::steady_clock::now(), [&ran] { ++ran; });
+    while(ran < 17)
+        std::this_thread::yield();
+    timers.shutdown();
+    queue.shutdown();
+    pool.shutdown();
+    metrics::tracer().stop();
+
+    auto &library = metrics::library();
+    assert(library.queue.wait.count() == 8 && library.queue.run.count() == 8);
+    assert(library.pool.run.count() == 8);
+    assert(library.timer_late.count() == 1 && library.timer_run.count() == 1);
+
+    std::stringstream trace;
+    assert(metrics::tracer().write(trace) == 17);
+    assert(trace.str().find("\"ph\":\"X\"") != std::string::npos);
+    assert(trace.str().find("\"name\":\"timer_queue\"") != std::string::npos);
+
+    // socket stream flushes and refills over a socket pair
+    int pair[2];
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    {
+        socket_stream<> left(pair[0], nullptr), right(pair[1], nullptr);
+        left << "ping\n" << std::flush;
+        std::string text;
+        std::getline(right, text);
+        assert(text == "ping");
+    }
+    assert(library.stream_sync.value() == 1);
+    assert(library.stream_underflow.value() >= 1);
+
+    const auto list = metrics::snapshot();
+    assert(find(list, "task_queue.wait").count == 8);
+    assert(find(list, "test.hits").count == 4000);
+    std::stringstream json;
+    metrics::report(json, list);
+    assert(json.str().find("\"test.hits\":4000") != std::string::npos);
+    assert(json.str().find("\"task_pool.run\":{\"count\":8") != std::string::npos);
+
+    metrics::registry().clear();
+    assert(hits.value() == 0 && library.queue.run.count() == 0);
+}
@@ -5,12 +5,80 @@
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "output.hpp"
 #include "datetime.hpp"
+#include "print.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
 
 using namespace tycho;
 
+namespace {
+std::atomic<int> logged{0};
+} // end namespace
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     auto now = gmt_time(time(nullptr));
     output() << "hello " << "world, " << to_string(now, GENERIC_DATETIME);
+
+    auto fp = tmpfile();
+    assert(fp != nullptr);
+    std::string expect;
+    {
+        fd_sink sink(fileno(fp), 256);
+        assert(sink.capacity() == 256);
+        for(auto line = 0; line < 1000; ++line) {
+            println(sink, "line {} of {}", line, "output");
+            expect += format("line {} of {}\n", line, "output");
+        }
+        const std::string large(1000, 'x');
+        print(sink, "{}", large);
+        sink.write("tail");
+        expect += large + "tail";
+        assert(sink.size() == 4);
+    }
+    assert(std::fseek(fp, 0, SEEK_END) == 0);
+    const auto size = std::size_t(std::ftell(fp));
+    assert(size == expect.size());
+    std::string text(size, 0);
+    std::rewind(fp);
+    assert(std::fread(text.data(), 1, size, fp) == size);
+    assert(text == expect);
+    fclose(fp);
+
+    fd_sink bad(-1);
+    print(bad, "{}", 1);
+    assert(!bad.flush());
+    assert(!bad && bad.err() == EBADF);
+
+    // cached iso stamps and the system logger's background writer
+    const auto stamp = std::time(nullptr);
+    assert(iso_cached(stamp) == iso_string(stamp));
+    assert(&iso_cached(stamp) == &iso_cached(stamp));
+
+    system_logger logger;
+    logger.set(0, [](const std::string& msg, const char *type) {
+        ++logged;
+    });
+    logger.notice("sync {}", 1);
+    assert(logged == 1);
+    logger.start(log_policy::block);
+    std::vector<std::thread> writers;
+    for(auto thread = 0; thread < 4; ++thread) {
+        writers.emplace_back([&logger, thread] {
+            for(auto msg = 0; msg < 5000; ++msg)
+                logger.warn("thread {} msg {}", thread, msg);
+        });
+    }
+    for(auto& writer : writers)
+        writer.join();
+    logger.stop();
+    assert(logged == 20001);
+    assert(logger.dropped() == 0);
+    logger.error("after {}", "stop");
+    assert(logged == 20002);
 }
 
 
@@ -0,0 +1,74 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "pool.hpp"
+#include <cstdlib>
+#include <thread>
+
+using namespace tycho;
+
+namespace {
+const uint16_t port = 9791;
+address_t local_host("127.0.0.1", port);
+} // end anon namespace
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    assert(Socket::startup());
+    try {
+        Socket listener(local_host, SOCK_STREAM);
+        listener.reuse(true);
+        listener.listen();
+        assert(listener.err() == 0);
+
+        timer_queue timers;
+        connection_pool<tcpstream>::limits_t limits;
+        limits.max_active = 2;
+        limits.idle_timeout = std::chrono::milliseconds(40);
+        connection_pool<tcpstream> pool(timers, limits);
+        {
+            auto first = pool.lease(local_host);
+            assert(first && first->is_open());
+            assert(pool.active(local_host) == 1 && pool.connected() == 1);
+            auto second = pool.lease(local_host);
+            assert(second);
+            assert(!pool.lease(local_host));
+        }
+        assert(pool.idle(local_host) == 2 && pool.active(local_host) == 0);
+
+        auto peer = listener.accept();
+        auto other = listener.accept();
+        {
+            auto again = pool.lease(local_host);
+            assert(again && pool.reused() == 1 && pool.connected() == 2);
+            *again << "ping";
+        }
+        char buf[8]{};
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        assert(peer.recv(buf, 4, MSG_DONTWAIT) + other.recv(buf, 4, MSG_DONTWAIT) == 4);
+
+        // a peer that closes leaves an idle stream that fails its check
+        peer.release();
+        other.release();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        {
+            auto fresh = pool.lease(local_host);
+            assert(fresh && pool.connected() == 3 && pool.reused() == 1);
+            fresh.discard();
+        }
+        assert(pool.idle(local_host) == 0 && pool.active(local_host) == 0);
+
+        {
+            auto last = pool.lease(local_host);
+            assert(last);
+        }
+        assert(pool.idle(local_host) == 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        assert(pool.idle(local_host) == 0);
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+    Socket::shutdown();
+}
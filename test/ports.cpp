@@ -0,0 +1,81 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "ports.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace tycho;
+
+namespace {
+auto open_pty(int& master) -> std::string {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) || unlockpt(master))
+        return {};
+    return ptsname(master);
+}
+} // end namespace
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    int master[2]{-1, -1};
+    const auto first = open_pty(master[0]), second = open_pty(master[1]);
+    if(first.empty() || second.empty())
+        return 0;   // no pty support in this environment
+
+    const serial_t lines(first), packets(second);
+    assert(lines && packets);
+
+    reactor events;
+    serial_ports ports(events, 64);
+    std::vector<std::string> framed, raw;
+    auto closed = 0;
+    const auto line_port = ports.attach(lines, [&](int, std::string_view frame, serial_ports::time_point when) {
+        assert(when <= serial_ports::clock_t::now());
+        if(frame.empty())
+            ++closed;
+        else
+            framed.emplace_back(frame);
+    }, serial_ports::line_framer());
+    const auto raw_port = ports.attach(packets, [&](int, std::string_view frame, serial_ports::time_point) {
+        raw.emplace_back(frame);
+    });
+    assert(line_port == lines.handle() && raw_port == packets.handle());
+    assert(ports.size() == 2);
+    assert(ports.attach(serial_t(), [](int, std::string_view, serial_ports::time_point) {}) == -1);
+
+    assert(::write(master[0], "one\ntwo\nthr", 11) == 11);
+    while(framed.size() < 2)
+        events.wait(1000);
+    assert(framed[0] == "one\n" && framed[1] == "two\n");
+    assert(::write(master[0], "ee\n", 3) == 3);
+    while(framed.size() < 3)
+        events.wait(1000);
+    assert(framed[2] == "three\n");
+
+    // a buffer filled without a delimiter is passed on whole
+    const std::string longer(100, 'x');
+    assert(::write(master[0], longer.data(), longer.size()) == ssize_t(longer.size()));
+    while(framed.size() < 4)
+        events.wait(1000);
+    assert(framed[3] == std::string(64, 'x'));
+
+    assert(::write(master[1], "packet", 6) == 6);
+    while(raw.empty())
+        events.wait(1000);
+    assert(raw[0] == "packet");
+    assert(ports.frames() >= 5);
+
+    assert(ports.detach(raw_port));
+    assert(!ports.detach(raw_port));
+    assert(ports.size() == 1);
+
+    ::close(master[0]);
+    while(!closed)
+        events.wait(1000);
+    assert(ports.size() == 0);
+    ::close(master[1]);
+}
@@ -4,6 +4,121 @@
 #undef  NDEBUG
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "process.hpp"
+#include "runner.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <thread>
+
+using namespace tycho;
+
+namespace {
+struct message_t {
+    int sender;
+    int sequence;
+};
+} // end namespace
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+#if !defined(_WIN32)
+    char *truth[] = {const_cast<char *>("true"), nullptr};
+    char *lies[] = {const_cast<char *>("false"), nullptr};
+    assert(process::spawn("true", truth) == 0);
+    assert(process::spawn("false", lies) == 1);
+
+    char *missing[] = {const_cast<char *>("no-such-command-here"), nullptr};
+    auto none = process::launch(missing[0], missing);
+    assert(!none && none.err == ENOENT);
+
+    char *echo[] = {const_cast<char *>("echo"), const_cast<char *>("hello"), nullptr};
+    auto child = process::launch("echo", echo, nullptr, process::pipe_output);
+    assert(child && child.output > -1 && child.input == -1 && child.error == -1);
+    char buf[16]{};
+    assert(::read(child.output, buf, sizeof(buf)) == 6);
+    assert(std::string(buf) == "hello\n");
+    assert(process::wait(child.pid) == 0);
+    child.close();
+    assert(child.output == -1);
+
+    reactor events;
+    std::map<std::size_t, std::vector<std::string>> out, err;
+    std::map<std::size_t, int> status;
+    std::size_t peak = 0;
+    {
+        command_runner runner(events, 2);
+        const auto record = [&](std::size_t job, std::string_view line, bool error) {
+            (error ? err : out)[job].emplace_back(line);
+            peak = std::max(peak, runner.active());
+        };
+        const auto done = [&](std::size_t job, int code) {
+            status[job] = code;
+        };
+        std::vector<std::size_t> jobs;
+        for(auto count = 0; count < 4; ++count) {
+            const auto num = std::to_string(count);
+            jobs.push_back(runner.run({"sh", "-c", "echo out" + num + "; echo err" + num + " >&2; printf tail; exit " + num}, record, done));
+        }
+        jobs.push_back(runner.run({"no-such-command-here"}, record, done));
+        jobs.push_back(runner.run({"sh", "-c", "exec >&- 2>&-; sleep 0.1; exit 7"}, record, done));
+        assert(runner.active() == 2 && runner.pending() == 4);
+        while(!runner.idle())
+            events.wait(1000);
+
+        assert(status.size() == 6 && peak <= 2);
+        for(auto count = 0; count < 4; ++count) {
+            const auto job = jobs[std::size_t(count)];
+            assert(status[job] == count);
+            assert(out[job] == std::vector<std::string>({"out" + std::to_string(count), "tail"}));
+            assert(err[job] == std::vector<std::string>({"err" + std::to_string(count)}));
+        }
+        assert(status[jobs[4]] == -1);
+        assert(status[jobs[5]] == 7 && out[jobs[5]].empty());
+    }
+    assert(events.size() == 0);
+
+    const auto name = "tycho-test-" + std::to_string(getpid());
+    assert(!process::channel_t<message_t>(name));
+    {
+        process::channel_t<message_t, 64> channel(name, true);
+        assert(channel && channel.size() == 0);
+        message_t msg{};
+        assert(!channel.receive(msg, 10));
+
+        // one sender is a child process, the rest are threads
+        const auto child_pid = fork();
+        if(!child_pid) {
+            process::channel_t<message_t, 64> sender(name);
+            for(auto seq = 0; seq < 5000; ++seq) {
+                while(!sender.send({0, seq}))
+                    std::this_thread::yield();
+            }
+            ::_exit(0);
+        }
+
+        std::vector<std::thread> senders;
+        for(auto id = 1; id < 3; ++id) {
+            senders.emplace_back([&name, id] {
+                process::channel_t<message_t, 64> sender(name);
+                assert(sender);
+                for(auto seq = 0; seq < 5000; ++seq) {
+                    while(!sender.send({id, seq}))
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        int next[3]{0, 0, 0};
+        for(auto count = 0; count < 15000; ++count) {
+            assert(channel.receive(msg, 5000));
+            assert(msg.sender >= 0 && msg.sender < 3 && next[msg.sender] == msg.sequence);
+            ++next[msg.sender];
+        }
+        for(auto& sender : senders)
+            sender.join();
+        assert(process::wait(child_pid) == 0);
+        assert(!channel.receive(msg, 0));
+    }
+    assert((!process::channel_t<message_t, 64>(name)));
+#endif
 }
@@ -6,6 +6,34 @@
 #include "random.hpp"
 #include "strings.hpp"
 #include "encoding.hpp"
+#include "memory.hpp"
+
+#include <string>
+#include <vector>
+
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace {
+// bit at a time reference for checking the block kernels
+auto b64_reference(const uint8_t *data, std::size_t size, const char *chars) {
+    std::string out;
+    uint32_t val = 0;
+    std::size_t bits = 0;
+    for(std::size_t pos = 0; pos < size; ++pos) {
+        val = (val << 8) | data[pos];
+        bits += 8;
+        while(bits >= 6) {
+            out += chars[(val >> (bits - 6)) & 0x3f];
+            bits -= 6;
+        }
+    }
+    if(bits)
+        out += chars[(val << (6 - bits)) & 0x3f];
+    return out;
+}
+} // end namespace
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const crypto::random_t<crypto::sha512_key> key1, key2;
@@ -15,6 +43,41 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const crypto::key_t raw = key1;
     assert(raw.second == 64);
 
+    // small requests come from the thread buffer, large ones go direct
+    uint64_t first{0}, second{0};
+    assert(crypto::rand(first) && crypto::rand(second) && first != second);
+    uint8_t large[1024]{}, zeros[1024]{};
+    assert(crypto::rand(large, sizeof(large)) && memcmp(large, zeros, sizeof(large)) != 0);
+    std::size_t seen = 0;
+    for(auto count = 0; count < 1000; ++count) {
+        uint8_t nonce[12]{};
+        assert(crypto::rand(nonce, sizeof(nonce)));
+        if(memcmp(nonce, zeros, sizeof(nonce)) != 0)
+            ++seen;
+    }
+    assert(seen == 1000);
+    crypto::rand_buffer::local().discard();
+
+    // a forked child must not repeat the parent's buffered bytes
+    int fds[2]{-1, -1};
+    assert(::pipe(fds) == 0);
+    assert(crypto::rand(first));
+    auto pid = ::fork();
+    assert(pid >= 0);
+    if(pid == 0) {
+        uint64_t child{0};
+        crypto::rand(child);
+        [[maybe_unused]] auto written = ::write(fds[1], &child, sizeof(child));
+        ::_exit(0);
+    }
+    uint64_t parent{0}, child{0};
+    assert(crypto::rand(parent));
+    assert(::read(fds[0], &child, sizeof(child)) == sizeof(child));
+    ::waitpid(pid, nullptr, 0);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    assert(parent != child);
+
     const uint8_t txt[7] = {'A', 'B', 'C', 'D', 'Z', '1', '2'};
     uint8_t msg[8];
     msg[7] = 0;
@@ -26,6 +89,45 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     assert(from_b64("QUJDRFoxMg==", msg, sizeof(msg)) == 7);
     // cspell:disable-next-line
     assert(eq("ABCDZ12", reinterpret_cast<const char *>(msg)));
-}
 
+    // block kernels against the reference at every tail length
+    std::vector<uint8_t> blob(4099), back(4200);
+    assert(crypto::rand(blob.data(), blob.size()));
+    for(std::size_t size = 0; size < 300; ++size) {
+        const auto plain = b64_reference(blob.data(), size, base64_chars);
+        auto padded = plain;
+        padded.append((4 - plain.size() % 4) % 4, '=');
+        assert(to_b64(blob.data(), size) == padded);
+        assert(from_b64(padded, back.data(), back.size()) == size);
+        assert(memcmp(back.data(), blob.data(), size) == 0);
+        const auto url = to_b64url(blob.data(), size);
+        assert(url == b64_reference(blob.data(), size, base64url_chars));
+        assert(from_b64url(url, back.data(), back.size()) == size);
+        assert(memcmp(back.data(), blob.data(), size) == 0);
+    }
+    const auto encoded = to_b64(blob.data(), blob.size());
+    assert(encoded.size() == encoded_b64(blob.size()));
+    assert(from_b64(encoded, back.data(), back.size()) == blob.size());
+    assert(memcmp(back.data(), blob.data(), blob.size()) == 0);
 
+    // line breaks and url chars in standard input are skipped
+    std::string wrapped;
+    for(std::size_t pos = 0; pos < encoded.size(); pos += 64)
+        wrapped += encoded.substr(pos, 64) + "\n";
+    assert(from_b64(wrapped, back.data(), back.size()) == blob.size());
+    assert(memcmp(back.data(), blob.data(), blob.size()) == 0);
+    assert(from_b64url(encoded, back.data(), back.size()) < blob.size());
+
+    // caller buffers and streams
+    char out[16]{};
+    assert(to_b64(txt, sizeof(txt), out, 11) == 0);
+    assert(to_b64(txt, sizeof(txt), out, sizeof(out)) == 12);
+    assert(std::string(out, 12) == "QUJDRFoxMg==");     // cspell:disable-line
+    assert(to_b64url(txt, 2, out, sizeof(out)) == 3 && std::string(out, 3) == "QUI");
+    const uint8_t marks[3] = {0xfb, 0xff, 0xfe};
+    assert(to_b64(marks, 3) == "+//+" && to_b64url(marks, 3) == "-__-");
+    std::vector<uint8_t> vec;
+    omemstream stream(vec);
+    to_b64(blob.data(), blob.size(), stream);
+    assert(std::string(reinterpret_cast<const char *>(vec.data()), vec.size()) == encoded);
+}
@@ -4,7 +4,10 @@
 #undef  NDEBUG
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "ranges.hpp"
+#include "tasks.hpp"
 #include <vector>
+#include <list>
+#include <string>
 #include <cstdlib>
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
@@ -24,6 +27,70 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
         assert(made.size() == 3);
         assert(made[0] == -1);
 
+        auto calls = 0;
+        auto lazy = numbers |
+            views::filter([&calls](const int& n) { ++calls; return n % 2 == 0; }) |
+            views::transform([](const int& n) { return n * n; });
+        assert(calls == 0);
+        auto squares = lazy | collect<>();
+        assert(squares == std::vector<int>({4, 16, 36, 64, 100}));
+        assert(calls == 10);
+
+        auto sized = numbers | views::transform([](const int& n) { return std::to_string(n); }) | collect<>();
+        assert(sized.size() == 10 && sized.capacity() == 10);
+        assert(sized[9] == "10");
+
+        auto middle = numbers | views::drop(2) | views::take(3) | collect<std::list<int>>();
+        assert(middle == std::list<int>({3, 4, 5}));
+        assert((numbers | views::slice(8, 5) | collect<>()).size() == 2);
+        assert((numbers | views::take(20)).size() == 10);
+        assert((numbers | views::drop(20) | collect<>()).empty());
+
+        const std::vector<int> more = {11, 12};
+        auto joined = numbers | views::take(2) | views::join(more) | collect<>();
+        assert(joined == std::vector<int>({1, 2, 11, 12}));
+
+        auto total = 0;
+        for(auto n : numbers | views::filter([](const int& n) { return n > 8; }))
+            total += n;
+        assert(total == 19);
+
+        assert(copy(numbers, 8, 5) == std::vector<int>({9, 10}));
+
+        tycho::task_pool pool(4);
+        pool.startup();
+        std::vector<long> big(10007);
+        std::iota(big.begin(), big.end(), 1L);
+        assert(parallel_fold(pool, big, 0L, std::plus<>()) == 10007L * 10008L / 2);
+        assert(parallel_fold(pool, big, 5L, std::plus<>(), std::plus<>(), 3) == 10007L * 10008L / 2 + 5);
+
+        const std::vector<long> eight{1, 2, 3, 4, 5, 6, 7, 8};
+        assert(parallel_fold(pool, eight, 0L, [](long sum, long x) {
+            return sum + x * x;
+        }, std::plus<>(), 3) == 204);
+        assert(parallel_fold(pool, eight, 1L, std::multiplies<>(), std::multiplies<>(), 4, 1L) == 40320);
+
+        const std::vector<std::string> words{"one", "three", "five", "", "eleven"};
+        assert(parallel_fold(pool, words, std::size_t(0), [](std::size_t total, const std::string& word) {
+            return total + word.size();
+        }, std::plus<>(), 2) == 18);
+        parallel_each(pool, big, [](long& n) { n *= 2; });
+        assert(big[10006] == 20014);
+        auto ones = parallel_make<std::vector<int>>(pool, 1000, [] { return 1; });
+        assert(fold(ones, 0, std::plus<>()) == 1000);
+
+        auto threw = false;
+        try {
+            parallel_each(pool, big, [](long& n) {
+                if(n == 100)
+                    throw std::runtime_error("stop");
+            });
+        }
+        catch(const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        pool.shutdown();
     }
     catch(...) {
         ::exit(-1);
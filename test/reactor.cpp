@@ -0,0 +1,60 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "reactor.hpp"
+#include "tasks.hpp"
+#include <thread>
+#include <cstdlib>
+
+using namespace tycho;
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    try {
+        reactor events;
+        int fds[2]{-1, -1};
+        assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        Socket left(fds[0]), right(fds[1]);
+
+        unsigned seen = 0;
+        assert(events.add(right, reactor::readable, [&seen](int fd, unsigned mask) {
+            char buf[16];
+            if(mask & reactor::readable)
+                seen += unsigned(::recv(fd, buf, sizeof(buf), 0));
+        }));
+        assert(!events.add(right, reactor::readable, [](int, unsigned) {}));
+        assert(events.size() == 1);
+        assert(events.wait(0) == 0);
+
+        assert(left.send("hello", 5) == 5);
+        assert(events.wait(1000) == 1 && seen == 5);
+
+        // oneshot handlers posted to a queue, re-armed from the handler
+        task_queue queue;
+        queue.startup();
+        std::atomic<unsigned> posted{0};
+        assert(events.remove(right));
+        assert(events.add(right, reactor::readable, [&](int fd, unsigned) {
+            char buf[16];
+            posted += unsigned(::recv(fd, buf, sizeof(buf), 0));
+            events.modify(fd, reactor::readable);
+        }, true));
+        std::thread loop([&] {
+            events.run(queue);
+        });
+        assert(left.send("abc", 3) == 3);
+        while(posted < 3)
+            std::this_thread::yield();
+        assert(left.send("de", 2) == 2);
+        while(posted < 5)
+            std::this_thread::yield();
+        events.stop();
+        loop.join();
+        queue.shutdown();
+        assert(events.stopped());
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+}
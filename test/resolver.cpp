@@ -0,0 +1,53 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "resolver.hpp"
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+
+using namespace tycho;
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    assert(Socket::startup());
+    try {
+        resolver dns(2, std::chrono::seconds(30), std::chrono::milliseconds(50));
+        auto first = dns.resolve("127.0.0.1", "80", AF_INET).get();
+        assert(first && first.err == 0);
+        assert(first.front().port() == 80);
+        assert(dns.misses() == 1 && dns.size() == 1);
+
+        std::atomic<unsigned> calls{0};
+        assert(dns.resolve("127.0.0.1", "80", [&calls](const resolved_t& result) {
+            if(result && result.front().port() == 80)
+                ++calls;
+        }, AF_INET));
+        assert(calls == 1);
+        assert(dns.hits() == 1 && dns.misses() == 1);
+        assert(dns.find("127.0.0.1", "80", AF_INET).port() == 80);
+
+        std::vector<task_future<resolved_t>> pending;
+        for(auto count = 0; count < 8; ++count)
+            pending.push_back(dns.resolve("127.0.0.2", "8080", AF_INET));
+        for(auto& future : pending)
+            assert(future.get().front().port() == 8080);
+        assert(dns.misses() == 2 && dns.size() == 2);
+
+        auto failed = dns.resolve("127.0.0.1", "no-such-service-here", AF_INET).get();
+        assert(!failed && failed.err != 0);
+        assert(!dns.resolve("127.0.0.1", "no-such-service-here", AF_INET).get());
+        assert(dns.misses() == 3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        assert(!dns.resolve("127.0.0.1", "no-such-service-here", AF_INET).get());
+        assert(dns.misses() == 4);
+
+        dns.clear();
+        assert(dns.size() == 0);
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+    Socket::shutdown();
+}
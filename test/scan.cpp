@@ -34,6 +34,97 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
 
         text = "\"hello\\nworld\""; // NOLINT
         assert(get_string(text) == "hello\nworld");
+
+        text = "1234567890123456789xyz";
+        assert(scan::value64(text) == 1234567890123456789ULL);
+        assert(text == "xyz");
+
+        text = "12345678901";
+        assert(scan::value(text, 1234567890) == 1234567890);
+        assert(text == "1");
+
+        text = "4294967296";
+        assert(scan::value(text, 4294967295ULL) == 429496729);
+        assert(text == "6");
+
+        text = "18446744073709551615";
+        assert(scan::value64(text) == 18446744073709551615ULL);
+        assert(text.empty());
+
+        text = "1234567a";
+        assert(scan::value(text) == 1234567);
+        assert(text == "a");
+
+        assert(get_value64("-9000000000") == -9000000000LL);
+        assert(get_real("2.5e3") == 2500.0);
+        assert(get_real_or("2.5x", -1.0) == -1.0);
+
+        auto failed = false;
+        try {
+            get_value64("12z");
+        }
+        catch(const std::invalid_argument&) {
+            failed = true;
+        }
+        assert(failed);
+
+        failed = false;
+        try {
+            get_value64("99999999999999999999");
+        }
+        catch(const std::overflow_error&) {
+            failed = true;
+        }
+        assert(failed);
+
+        text = "9";
+        assert(scan::value64(text, 5) == 0);
+        assert(text == "9");
+
+        text = "39";
+        assert(scan::value(text, 5) == 3);
+        assert(text == "9");
+
+        assert(get_value("-12", -20, 20) == -12);
+        assert(get_range_or("9", 3, 1, 5) == 3);
+        assert(get_range_or("4", 3, 1, 5) == 4);
+
+        failed = false;
+        try {
+            get_value("9", 0, 5);
+        }
+        catch(const std::overflow_error&) {
+            failed = true;
+        }
+        assert(failed);
+
+        failed = false;
+        try {
+            get_duration("99999999999");
+        }
+        catch(const std::overflow_error&) {
+            failed = true;
+        }
+        assert(failed);
+
+        int fields[4]{};
+        assert(get_values("10, -20,\t30 ", fields, 4) == 3);
+        assert(fields[0] == 10 && fields[1] == -20 && fields[2] == 30);
+        assert(get_values("1;2;3;4;5", fields, 4, ';') == 4);
+        assert(fields[3] == 4);
+
+        double reals[2]{};
+        assert(get_values("0.5,1e-2", reals, 2) == 2);
+        assert(reals[0] == 0.5 && reals[1] == 0.01);
+
+        failed = false;
+        try {
+            get_values("1,,3", fields, 4);
+        }
+        catch(const std::invalid_argument&) {
+            failed = true;
+        }
+        assert(failed);
     }
     catch(std::exception& e) {
         printf("Error: %s\n", e.what());
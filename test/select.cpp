@@ -6,6 +6,33 @@
 #include "select.hpp"
 #include <cstdlib>
 #include <iostream>
+#include <string_view>
+#include <variant>
+
+namespace {
+using namespace std::literals;
+
+int calls = 0;
+
+constexpr auto commands = make_select_hash<std::string_view, int>({
+    {"open", 1}, {"close", 2}, {"read", 3}, {"write", 4},
+    {"seek", 5}, {"stat", 6}, {"sync", 7}, {"lock", 8},
+    {"unlock", 9}, {"list", 10}, {"quit", 11}
+});
+
+constexpr auto codes = make_select<int, std::string_view>({
+    {404, "not found"}, {200, "ok"}, {500, "error"}, {301, "moved"},
+    {403, "forbidden"}, {201, "created"}, {204, "no content"},
+    {400, "bad request"}, {503, "unavailable"}, {302, "found"}
+});
+
+static_assert(commands("sync") == 7);
+static_assert(commands("") == 0);
+static_assert(!commands.contains("syncs"));
+static_assert(codes(403) == "forbidden");
+static_assert(codes(999, "unknown") == "unknown");
+static_assert(codes.begin()->key == 200);
+} // end namespace
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     enum class selects : int {
@@ -31,6 +58,36 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
         assert(selector("apple"));
         assert(!selector(42));
         assert(mapped("five") == selects::Five);
+
+        // runtime keys against the constant tables
+        const std::string verb = "unlock";
+        assert(commands(verb) == 9);
+        for(const auto& [code, text] : codes)
+            assert(codes(code) == text);
+
+        constexpr auto states = make_select_hash<selects, int>({
+            {selects::Five, 50}, {selects::Six, 60}, {selects::Seven, 70}
+        });
+        static_assert(states(selects::Six) == 60);
+
+        using key_t = std::variant<int, std::string_view>;
+        constexpr auto actions = make_select<key_t, void(*)()>({
+            {1, []{ ++calls; }}, {"apple"sv, []{ calls += 10; }}, {2, []{ calls += 100; }}
+        });
+        assert(actions.call(1));
+        assert(actions.call("apple"sv));
+        assert(!actions.call(42));
+        assert(calls == 11);
+
+        auto dup = false;
+        try {
+            const auto bad = make_select_hash<int, int>({{1, 1}, {2, 2}, {1, 3}});
+            (void)bad;
+        }
+        catch(const std::invalid_argument&) {
+            dup = true;
+        }
+        assert(dup);
     }
     catch(...) {
         ::exit(-1);
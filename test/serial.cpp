@@ -6,11 +6,65 @@
 #include "print.hpp"        // IWYU pragma: keep
 #include "serial.hpp"
 
+#include <string_view>
+#include <vector>
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
 // This is so we can lint serial on non-termios systems without errors...
 #ifdef SERIAL_HPP_
     const serial_t serial;
     assert(is(serial) == false);
 #endif
-}
 
+    // check values from the crc catalogue
+    const std::string_view check = "123456789";
+    const auto digits = reinterpret_cast<const uint8_t *>(check.data());
+    assert(crc32(digits, check.size()) == 0xcbf43926);
+    assert(crc32c(digits, check.size()) == 0xe3069283);
+    assert(crc32(digits, 0) == 0);
+
+    // accelerated paths against the tables at every tail and offset
+    std::vector<uint8_t> frame(4099);
+    for(std::size_t pos = 0; pos < frame.size(); ++pos)
+        frame[pos] = uint8_t(pos * 37 + (pos >> 7));
+    for(std::size_t size = 0; size < 300; size += 7) {
+        for(std::size_t offset = 0; offset < 4; ++offset) {
+            const auto data = frame.data() + offset;
+            assert(crc32(data, size) == ~crc32_slice<0xedb88320>(~0U, data, size));
+            assert(crc32c(data, size) == ~crc32_slice<0x82f63b78>(~0U, data, size));
+        }
+    }
+
+    // partial reads sum to the whole
+    crc32_t sum;
+    crc32c_t sumc;
+    for(std::size_t pos = 0; pos < frame.size(); pos += 100) {
+        const auto count = std::min<std::size_t>(100, frame.size() - pos);
+        sum.update(frame.data() + pos, count);
+        sumc.update(frame.data() + pos, count);
+    }
+    assert(sum == crc32(frame.data(), frame.size()));
+    assert(sumc.value() == crc32c(frame.data(), frame.size()));
+    const crc32_t resumed = crc32(digits, 4);
+    assert(crc32_t(resumed).update(check.substr(4)) == 0xcbf43926);
+    sum.reset();
+    assert(sum == 0);
+
+    // crc16 family check values
+    assert(crc16(digits, check.size()) == 0xfee8);
+    assert(crc16_modbus::compute(digits, check.size()) == 0x4b37);
+    assert(crc16_ccitt::compute(digits, check.size()) == 0x29b1);
+    assert(crc16_kermit::compute(digits, check.size()) == 0x2189);
+    assert(crc16_xmodem::compute(digits, check.size()) == 0x31c3);
+    static_assert(crc16_sum<0x1021, 0x1d0f, false, 0x0000>().update("123456789").value() == 0xe5cc);
+    static_assert(crc16_sum<0x3d65, 0x0000, true, 0xffff>().update("123456789").value() == 0xea82);
+
+    // a modbus frame checked as it arrives, then resumed from its value
+    crc16_modbus frame16;
+    frame16.update(check.substr(0, 2)).update(check.substr(2, 5));
+    const crc16_modbus resumed16 = frame16.value();
+    assert(crc16_modbus(resumed16).update(check.substr(7)) == 0x4b37);
+    assert(frame16.update(check.substr(7)) == 0x4b37);
+    frame16.reset();
+    assert(frame16.update(check) == 0x4b37);
+}
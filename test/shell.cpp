@@ -9,6 +9,9 @@
 #include "templates.hpp"
 #include "output.hpp"       // IWYU pragma: keep
 
+#include <atomic>
+#include <string>
+
 // cspell:disable-next-line
 // Test of init trick, a "kind of" atinit() function or golang init().
 namespace {
@@ -52,5 +55,86 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
 
     caller();
     assert(value == 2);
-}
 
+    // zero copy line scans agree with getline
+    const fsys::path lines = "/tmp/tycho_scan.txt";
+    {
+        auto file = make_output(lines);
+        for(auto count = 0; count < 200000; ++count)
+            file << "line " << count << (count % 7 ? "" : "\n") << "\n";
+        file << "last";
+    }
+    std::size_t chars{0};
+    auto seen = scan_file(lines, [&chars](const std::string& line) {
+        chars += line.size();
+        return true;
+    });
+    std::atomic<std::size_t> total{0};
+    assert(scan_lines(lines, [&total](std::string_view line) {
+        total += line.size();
+        return true;
+    }) == seen);
+    assert(total == chars);
+    total = 0;
+    assert(scan_lines(lines, [&total](std::string_view line) {
+        total += line.size();
+        return true;
+    }, 4) == seen);
+    assert(total == chars);
+    assert(scan_lines(lines, [](std::string_view line) {
+        return line != "line 10";
+    }) == 12);
+    assert(scan_view("a\n\nb", [](std::string_view) {
+        return true;
+    }) == 3);
+    fsys::remove(lines);
+
+    const fsys::path status = "/proc/self/status";
+    if(fsys::exists(status)) {
+        auto named = 0;
+        assert(scan_lines(status, [&named](std::string_view line) {
+            if(line.substr(0, 5) == "Name:")
+                ++named;
+            return true;
+        }) > 1);
+        assert(named == 1);
+    }
+
+    // parallel tree walk against the recursive iterator
+    const fsys::path tree = "/tmp/tycho_tree";
+    fsys::remove_all(tree);
+    for(auto top = 0; top < 6; ++top) {
+        for(auto sub = 0; sub < 5; ++sub) {
+            const auto dir = tree / to_string(top) / to_string(sub);
+            fsys::create_directories(dir);
+            for(auto file = 0; file < 20; ++file)
+                make_output(dir / (to_string(file) + ".txt")) << file;
+        }
+    }
+    fsys::create_directory_symlink(tree / "0", tree / "loop");
+    const auto expected = std::size_t(std::distance(fsys::recursive_directory_iterator(tree), fsys::recursive_directory_iterator()));
+    for(const std::size_t threads : {1, 4}) {
+        for(const std::size_t limit : {1, 4096}) {
+            std::atomic<std::size_t> files{0}, links{0};
+            assert(scan_tree(tree, [&](const walk_entry& entry) {
+                if(entry.type == fsys::file_type::regular) {
+                    assert(entry.depth == 2 && entry.path().extension() == ".txt");
+                    ++files;
+                }
+                if(entry.type == fsys::file_type::symlink)
+                    ++links;
+                return walk_t::next;
+            }, threads, limit) == expected);
+            assert(files == 600 && links == 1);
+        }
+    }
+    assert(scan_tree(tree, [](const walk_entry& entry) {
+        return entry.is_dir() && entry.name != "3" ? walk_t::next : walk_t::prune;
+    }, 4) == 7 + 5 * 5 + 5 * 4 * 20);
+    std::atomic<std::size_t> calls{0};
+    scan_tree(tree, [&calls](const walk_entry&) {
+        return ++calls == 10 ? walk_t::stop : walk_t::next;
+    }, 4);
+    assert(calls >= 10 && calls < expected);
+    fsys::remove_all(tree);
+}
@@ -29,6 +29,44 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     assert(local_host.is_any() == false);
     assert(local_host.port() == port);
     assert(local_bind.port() == port);
+
+    // batched datagrams over loopback
+    Socket rx(address_t("127.0.0.1", 0), SOCK_DGRAM);
+    Socket tx(address_t("127.0.0.1", 0), SOCK_DGRAM);
+    auto target = rx.local();
+    char out[4][8] = {"one", "two", "three", "four"};
+    datagram_t sends[4];
+    for(auto pos = 0; pos < 4; ++pos)
+        sends[pos] = datagram_t{out[pos], strlen(out[pos]), 0, target};
+    assert(tx.send(sends, 4) == 4);
+    assert(sends[2].used == 5);
+    char in[4][16]{};
+    datagram_t recvs[4];
+    for(auto pos = 0; pos < 4; ++pos)
+        recvs[pos] = datagram_t{in[pos], sizeof(in[pos]), 0, address_t()};
+    std::size_t got = 0;
+    while(got < 4)
+        got += rx.recv(recvs + got, 4 - got);
+    assert(recvs[3].used == 4 && std::string_view(in[3], 4) == "four");
+    assert(recvs[0].addr.port() == tx.local().port());
+
+    // counters and kernel receive timestamps
+    socket_counters stats;
+    rx.counters(&stats);
+    tx.counters(&stats);
+    assert(rx.counters() == &stats);
+    const auto stamped = rx.timestamps(true);
+    assert(tx.send(out[0], 3, target) == 3);
+    struct timespec stamp{};
+    assert(rx.recv(in[0], sizeof(in[0]), addr, stamp) == 3);
+    if(stamped)
+        assert(stamp.tv_sec > 0);
+    assert(stats.bytes_out == 3 && stats.bytes_in == 3 && stats.calls == 2);
+    assert(rx.recv(in[0], sizeof(in[0]), MSG_DONTWAIT) == 0);
+    assert(stats.again == 1 && stats.errors == 0);
+    stats.clear();
+    rx.counters(nullptr);
+    assert(stats.calls == 0);
     Socket::shutdown();
 }
 
@@ -8,14 +8,217 @@
 #include "secure.hpp"
 #include "socket.hpp"
 #include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+template class tycho::secure_stream<512>;
 
 namespace {
 const uint16_t port = 9789;
 address_t local_host("127.0.0.1", port);
+
+void bulk_io() {
+    int fds[2]{-1, -1};
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    tcpstream writer(fds[0], nullptr), reader(fds[1], nullptr, 4096);
+    assert(reader.buffer_size() == 4096 && writer.buffer_size() == 536);
+
+    const std::string header("HEAD"), body(60000, 'b');
+    writer << "x";
+    assert(writer.flush({io_part{header.data(), header.size()}, io_part{body.data(), body.size()}}));
+    assert(writer.out_pending() == 0);
+
+    std::string input(60005, 0);
+    reader.read(input.data(), std::streamsize(input.size()));
+    assert(reader.gcount() == 60005);
+    assert(input.substr(0, 5) == "xHEAD" && input.back() == 'b');
+
+    writer.buffer_size(8192);
+    writer.write(body.data(), 1000);
+    assert(writer.out_pending() == 1000);
+    writer.flush();
+    reader.read(input.data(), 1000);
+    assert(reader.gcount() == 1000);
+}
+
+void file_io() {
+    int fds[2]{-1, -1};
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    tcpstream writer(fds[0], nullptr), reader(fds[1], nullptr, 4096);
+    auto file = std::tmpfile();
+    assert(file != nullptr);
+    const std::string body(20000, 'f');
+    assert(std::fwrite(body.data(), 1, body.size(), file) == body.size());
+    assert(std::fflush(file) == 0);
+    auto fd = fileno(file);
+
+    writer << "[";
+    assert(writer.send_file(fd, 10, 5000) == 5000);
+    assert(writer.out_pending() == 0);
+    std::string input(5001, 0);
+    reader.read(input.data(), std::streamsize(input.size()));
+    assert(reader.gcount() == 5001);
+    assert(input.front() == '[' && input.back() == 'f');
+
+    const Socket sender(::dup(fds[0]));
+    assert(send_file(sender, fd, 19000, 5000) == 1000);
+    reader.read(input.data(), 1000);
+    assert(reader.gcount() == 1000);
+    std::fclose(file);
+}
+
+void latency_io() {
+    int fds[2]{-1, -1};
+    assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    tcpstream writer(fds[0], nullptr), reader(fds[1], nullptr);
+    io_latency sends, recvs;
+    writer.latency(&sends, nullptr);
+    reader.latency(nullptr, &recvs);
+    for(auto count = 0; count < 10; ++count) {
+        writer << "ping" << std::flush;
+        std::string input(4, 0);
+        reader.read(input.data(), 4);
+        assert(input == "ping");
+    }
+    assert(sends.count() == 10 && recvs.count() >= 1);
+    assert(sends.percentile(0.5) <= sends.percentile(1.0));
+    assert(sends.mean() <= sends.percentile(1.0));
+
+    io_latency fixed;
+    fixed.record(0);
+    fixed.record(1000);
+    fixed.record(std::chrono::microseconds(2));
+    assert(fixed.count() == 3 && fixed[0] == 1 && fixed[10] == 1 && fixed[11] == 1);
+    assert(fixed.percentile(0.5) == io_latency::upper(10));
+    assert(fixed.total() == 3000 && fixed.mean() == 1000);
+    fixed.clear();
+    assert(fixed.count() == 0 && fixed.percentile(0.99) == 0);
+}
+
+void make_cert(const char *keyfile, const char *certfile) {
+    auto key = EVP_EC_gen("P-256");
+    auto cert = X509_new();
+    assert(key != nullptr && cert != nullptr);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    auto name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    assert(X509_sign(cert, key, EVP_sha256()) > 0);
+    auto fp = std::fopen(keyfile, "w");
+    PEM_write_PrivateKey(fp, key, nullptr, nullptr, 0, nullptr, nullptr);
+    std::fclose(fp);
+    fp = std::fopen(certfile, "w");
+    PEM_write_X509(fp, cert);
+    std::fclose(fp);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+void tls_resume() {
+    make_cert("test-tls.key", "test-tls.pem");
+    const secure_context server(secure_certs{"", "test-tls.key", "test-tls.pem"}, TLS_server_method());
+    const secure_context client(secure_certs{}, TLS_client_method());
+    secure_context trusting(secure_certs{"test-tls.pem", "", ""}, TLS_client_method());
+    assert(trusting.is_verifying() && trusting.cache_verify(8));
+    std::remove("test-tls.key");
+    std::remove("test-tls.pem");
+    assert(server && client);
+
+    address_t tls_host("127.0.0.1", 9792);
+    Socket listener(tls_host, SOCK_STREAM);
+    listener.reuse(true);
+    listener.listen();
+    assert(listener.err() == 0);
+    std::thread serve([&listener, &server] {
+        for(auto count = 0; count < 5; ++count) {
+            listener.accept([&server](int so, const struct sockaddr *peer) {
+                sslstream tls(so, peer, server);
+                assert(tls.is_secure() && tls.is_accepted());
+                tls << "hello";
+                tls.flush();
+                char ack{0};
+                tls.read(&ack, 1);
+                return true;
+            });
+        }
+    });
+
+    for(auto count = 0; count < 2; ++count) {
+        sslstream tls(tls_host.data(), client);
+        assert(tls.is_secure());
+        std::string msg(5, 0);
+        tls.read(msg.data(), 5);
+        assert(msg == "hello");
+        assert(tls.is_resumed() == (count > 0));
+        tls << "x";
+        tls.flush();
+        assert(client.sessions() == 1);
+    }
+
+    // a peer past the session limit evicts the least recently used one
+    address_t other_host("127.0.0.1", 9793);
+    Socket other_listener(other_host, SOCK_STREAM);
+    other_listener.reuse(true);
+    other_listener.listen();
+    std::thread other([&other_listener, &server] {
+        other_listener.accept([&server](int so, const struct sockaddr *peer) {
+            sslstream tls(so, peer, server);
+            tls << "hello";
+            tls.flush();
+            char ack{0};
+            tls.read(&ack, 1);
+            return true;
+        });
+    });
+    secure_context limited(client);
+    limited.session_limit(1);
+    {
+        sslstream tls(other_host.data(), limited);
+        std::string msg(5, 0);
+        tls.read(msg.data(), 5);
+        tls << "x";
+        tls.flush();
+    }
+    other.join();
+    assert(client.sessions() == 1);
+    {
+        sslstream tls(tls_host.data(), client);
+        std::string msg(5, 0);
+        tls.read(msg.data(), 5);
+        assert(!tls.is_resumed());
+        tls << "x";
+        tls.flush();
+    }
+
+    // full handshakes without resumption reuse the cached chain result
+    for(auto count = 0; count < 2; ++count) {
+        sslstream tls(tls_host.data(), trusting);
+        assert(tls.is_secure() && tls.is_verified());
+        std::string msg(5, 0);
+        tls.read(msg.data(), 5);
+        tls << "x";
+        tls.flush();
+        trusting.clear();
+    }
+    assert(trusting.verifier()->misses() == 1 && trusting.verifier()->hits() == 1);
+    serve.join();
+}
 } // end anon namespace
 
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     assert(Socket::startup());
+    bulk_io();
+    file_io();
+    latency_io();
+    tls_resume();
     const Socket unset;
     try {
         assert(!unset.accept([](int so, const struct sockaddr *peer) {
@@ -8,6 +8,11 @@
 #include "encoding.hpp"
 #include "memory.hpp"
 
+#include <string>
+#include <vector>
+#include <iterator>
+#include <cstring>
+
 auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     const std::string text = "hi,bye,gone";
     const uint8_t buf[2] = {0x03, 0xff};
@@ -21,6 +26,27 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     assert(list[1] == "bye");
     assert(list[2] == "gone");
 
+    // lazy views agree with the vectors and stop early
+    std::vector<std::string_view> pieces;
+    for(const auto piece : split_view("a,,b,", ","))
+        pieces.push_back(piece);
+    assert(pieces.size() == 4 && pieces[1].empty() && pieces[2] == "b" && pieces[3].empty());
+    assert(split<std::string>("a,,b,", ",").size() == 4);
+    assert(split<std::string>("a;b.c;d", ";.", 2)[1] == "b.c;d");
+    assert(std::distance(split_view("").begin(), split_view("").end()) == 1);
+    const std::string_view request = R"(  GET "/a b" {x y} end)";
+    pieces.clear();
+    for(const auto token : token_view(request)) {
+        if(token == "end")
+            break;
+        pieces.push_back(token);
+    }
+    assert(pieces.size() == 3 && pieces[1] == R"("/a b")" && pieces[2] == "{x y}");
+    assert(tokenize<std::string_view>(request).size() == 4);
+    assert(tokenize<std::string>(" a").size() == 1);
+    assert(tokenize<std::string>("   ").empty());
+    assert(tokenize<std::string>(R"(a "open)").back() == R"("open)");
+
     assert(upper_case("Hi There") == "HI THERE");
     assert(lower_case<std::string>("Hi There") == "hi there");
     assert(strip("   testing ") == "testing");
@@ -36,9 +62,108 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     hex[2] = 'z';
     assert(from_hex(hex, tmp, sizeof(tmp)) == 1);
 
+    // block kernels and tails against per byte formatting
+    std::vector<uint8_t> bytes(1031), back(1031);
+    for(std::size_t pos = 0; pos < bytes.size(); ++pos)
+        bytes[pos] = uint8_t(pos * 131 + (pos >> 8));
+    std::string expect;
+    for(const auto byte : bytes) {
+        expect += hex_chars[byte >> 4];
+        expect += hex_chars[byte & 0x0f];
+    }
+    for(std::size_t size = 0; size < 100; ++size) {
+        assert(to_hex(bytes.data(), size) == expect.substr(0, size * 2));
+        assert(from_hex(expect.substr(0, size * 2), back.data(), size) == size);
+        assert(memcmp(back.data(), bytes.data(), size) == 0);
+    }
+    const auto dump = to_hex(bytes.data(), bytes.size());
+    assert(dump == expect);
+    assert(from_hex(upper_case(dump), back.data(), back.size()) == back.size());
+    assert(back == bytes);
+    assert(to_hex(bytes.data(), bytes.size(), true) == upper_case(dump));
+    auto broken = dump;
+    broken[700] = 'g';
+    assert(from_hex(broken, back.data(), back.size()) == 350);
+
+    // digest sized output without allocating, and streamed dumps
+    char line[65]{};
+    assert(to_hex(bytes.data(), 32, line, 63) == 0);
+    assert(to_hex(bytes.data(), 32, line, 64) == 64);
+    assert(std::string_view(line) == dump.substr(0, 64));
+    std::vector<uint8_t> sink;
+    omemstream hexout(sink);
+    to_hex(bytes.data(), bytes.size(), hexout);
+    assert(std::string_view(reinterpret_cast<const char *>(sink.data()), sink.size()) == dump);
+
+    uint8_t secret[4]{};
+    assert(from_hex_consttime("0aF9c3e1", secret, sizeof(secret)) == 4);
+    assert(secret[0] == 0x0a && secret[1] == 0xf9 && secret[3] == 0xe1);
+    assert(from_hex_consttime("0aF9c3e", secret, sizeof(secret)) == 0);
+    assert(from_hex_consttime("0aF9c3eG", secret, sizeof(secret)) == 0);
+    assert(secret[0] == 0 && secret[3] == 0);
+    for(auto code = 0; code < 256; ++code) {
+        const char pair[2] = {'0', char(code)};
+        const auto valid = hex_index(char(code)) >= 0;
+        assert((from_hex_consttime(std::string_view(pair, 2), secret, 1) == 1) == valid);
+        if(valid)
+            assert(secret[0] == hex_index(char(code)));
+    }
+
     assert(!eq("yes", "no"));
     assert(eq("yes", "yes"));
 
+    auto& pager = local_pager();
+    const auto base = pager.mark();
+    auto first = pager.dup("first");
+    assert(std::string_view(first) == "first");
+    {
+        const mempager_scope scope(pager);
+        for(auto count = 0; count < 100; ++count)
+            assert(scope->alloc(1000));
+        assert(pager.pages() > 1);
+    }
+    assert(pager.pages() == 1);
+    assert(std::string_view(first) == "first");
+    auto reused = pager.alloc(1000);
+    assert(reused != nullptr);
+
+    char block[8]{};
+    imemstream input("hello world");
+    input.read(block, 5);
+    assert(input.gcount() == 5 && std::string_view(block, 5) == "hello");
+    assert(input.tellg() == 5 && input.size() == 6);
+    input.seekg(-5, std::ios::end);
+    assert(input.peek() == 'w');
+
+    uint8_t fixed[6]{};
+    omemstream output(fixed, sizeof(fixed), true);
+    output << "abcdefgh";
+    assert(output.size() == 5 && std::string_view(output.c_char()) == "abcde");
+
+    std::vector<uint8_t> vector;
+    omemstream appender(vector);
+    const std::string record(65536, 'x');
+    appender.write(record.data(), std::streamsize(record.size()));
+    assert(vector.size() == 65536 && appender.tellp() == 65536);
+
+    {
+        omemstream growing(pager, 64, true);
+        growing << record << "end";
+        assert(growing.size() == 65539);
+        assert(std::string_view(growing.c_char()).substr(65536) == "end");
+        growing.seekp(3);
+        assert(std::string_view(growing.c_char()) == "xxx");
+    }
+    pager.rewind(base);
+    assert(pager.empty());
+
+    mempager huge(0, mempager::policy_t{true, false, 1});
+    assert(huge.prefault(2) == 2);
+    assert(huge.empty());
+    auto chunk = static_cast<uint8_t *>(huge.allocate(1024 * 1024));
+    chunk[1024 * 1024 - 1] = 1;
+    assert(huge.pages() == 1 && huge.size() == mempager::huge_size);
+
     static_assert(u8verify("\xc3\xb1"));
     static_assert(!u8verify("\xa0\xa1"));
 }
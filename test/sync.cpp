@@ -5,6 +5,8 @@
 #include "compiler.hpp"     // IWYU pragma: keep
 #include "sync.hpp"
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 struct test {
     int v1{2};
@@ -13,6 +15,7 @@ struct test {
 
 namespace {
 unique_sync<int> counter(3);
+unique_sync<int, spin_lock> spinning(0);
 shared_sync<struct test> testing;
 } // end namespace
 
@@ -29,6 +32,60 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
 
         const reader_ptr<struct test> tester(testing);
         assert(tester->v1 == 2);
+
+        spin_group group(4);
+        spin_barrier barrier(4);
+        spin_semaphore ready;
+        std::vector<std::thread> threads;
+        for(auto id = 0; id < 4; ++id) {
+            threads.emplace_back([&group, &barrier, &ready] {
+                for(auto count = 0; count < 1000; ++count) {
+                    guard_ptr<int, spin_lock> value(spinning);
+                    ++*value;
+                }
+                barrier.wait();
+                ready.post();
+                group.done();
+            });
+        }
+        group.wait();
+        for(auto id = 0; id < 4; ++id)
+            ready.wait();
+        for(auto& thread : threads)
+            thread.join();
+        assert(!ready.wait_for(sync_millisecs(1)));
+        assert((*sync_ptr<int, spin_lock>(spinning) == 4000));
+
+        rcu_sync<std::vector<int>> routes(2, 1);
+        assert(rcu_ptr<std::vector<int>>(routes)->size() == 2);
+        std::atomic<bool> reading{true};
+        std::thread reader([&routes, &reading] {
+            while(reading) {
+                const rcu_ptr<std::vector<int>> table(routes);
+                assert(table->size() >= 2 && (*table)[0] == 1);
+            }
+        });
+        for(auto count = 0; count < 100; ++count) {
+            routes.update([](std::vector<int>& table) {
+                table.push_back(1);
+            });
+        }
+        reading = false;
+        reader.join();
+        assert(routes.load().size() == 102);
+
+        struct point {
+            int x{0}, y{0};
+        };
+        seq_sync<point> location;
+        location = point{3, 4};
+        assert(location.load().y == 4);
+
+        spin_event event;
+        assert(!event.wait_for(sync_millisecs(1)));
+        event.notify();
+        assert(event.wait_for(sync_millisecs(1)));
+        assert(!event.wait_for(sync_millisecs(1)));
     }
     catch(...) {
         ::exit(1);
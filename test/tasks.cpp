@@ -10,6 +10,7 @@
 #include <string>
 #include <tuple>
 #include <memory>
+#include <vector>
 
 using namespace tycho;
 
@@ -57,7 +58,107 @@ auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
     assert(count == 53);
     assert(use == 2);
 
+    auto owned = std::make_unique<int>(7);
+    int value = 0;
+    task_queue::task_t task([owned = std::move(owned), &value] {
+        value = *owned;
+    });
+    static_assert(task_queue::task_t::is_inline<std::function<void()>>());
+    auto moved = std::move(task);
+    assert(!task);  // NOLINT
+    moved();
+    assert(value == 7);
+
+    timer_queue timers;     // NOLINT
+    std::atomic<int> fired{0};
+    const auto later = timers.at(std::chrono::steady_clock::now() + std::chrono::hours(1), [&fired]{++fired;});
+    const auto never = timers.at(std::chrono::steady_clock::now() + std::chrono::hours(1), [&fired]{fired += 100;});
+    assert(timers.size() == 2);
+    assert(timers.find(later) != timer_queue::timepoint_t::min());
+    assert(timers.cancel(never));
+    assert(!timers.cancel(never));
+    assert(timers.find(never) == timer_queue::timepoint_t::min());
+    assert(timers.reset(later, std::chrono::steady_clock::now()));
+    while(!timers.empty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    timers.shutdown();
+    assert(fired == 1);
+
     auto future = tycho::await(test_async, 42);
     assert(future.get() == 42);
-}
 
+    task_queue tq2;     // NOLINT
+    std::vector<std::function<void()>> bulk(10, [] {++count;});
+    tq2.batch(true).startup();
+    assert(tq2.dispatch_bulk(bulk) == 10);
+    const auto accepted = tq2.dispatch_bulk(std::move(bulk), 15);
+    assert(accepted <= 10);
+    while(!tq2.empty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    tq2.shutdown();
+    assert(count == 63 + int(accepted));
+
+    task_pool pool(4);  // NOLINT
+    std::atomic<int> total{0};
+    wait_group pending(100);
+    pool.startup();
+    assert(pool.workers() == 4);
+    for(auto pos = 0; pos < 100; ++pos) {
+        assert(pool.dispatch([&total, &pending, &pool] {
+            if(total.fetch_add(1) % 10 == 0)
+                pool.priority([]{});
+            pending.done();
+        }));
+    }
+    pending.wait();
+    auto answer = await(pool, test_async, 21).then([](int x) {
+        return x * 2;
+    });
+    assert(answer.get() == 42);
+    std::vector<task_future<int>> parts;
+    for(auto part = 1; part <= 4; ++part)
+        parts.push_back(await(pool, [part] {return part;}));
+    auto joined = when_all(std::move(parts)).then(pool, [](std::vector<int> list) {
+        return list[0] + list[1] + list[2] + list[3];
+    });
+    assert(joined.get() == 10);
+    auto failed = await(pool, []() -> int {throw std::runtime_error("fail");});
+    auto skipped = failed.then([](int x) {return x;});
+    try {
+        skipped.get();
+        assert(false);
+    }
+    catch(const std::runtime_error&) {}
+    event_sync detached;    // NOLINT
+    assert(tycho::detach(pool, [&detached] {detached.notify();}));
+    detached.wait();
+    std::vector<std::function<void()>> jobs(20, [&total]{++total;});
+    assert(pool.dispatch_bulk(jobs) == 20);
+    while(!pool.empty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pool.shutdown();
+    assert(total == 120);
+    assert(!pool.dispatch([]{}));
+
+    // tasks left queued at shutdown are dropped with their pending count
+    task_pool single(1);    // NOLINT
+    event_sync release;     // NOLINT
+    single.startup();
+    assert(single.dispatch([&release] {release.wait();}));
+    for(auto pos = 0; pos < 5; ++pos)
+        assert(single.dispatch([&total] {++total;}));
+    std::thread opener([&release] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release.notify();
+    });
+    single.shutdown();
+    opener.join();
+    single.clear();
+    assert(single.size() == 0);
+    single.startup();
+    assert(single.size() == 0 && single.dispatch([&total] {++total;}));
+    while(!single.empty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    single.shutdown();
+    assert(single.size() == 0);
+}
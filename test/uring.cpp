@@ -0,0 +1,100 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "uring.hpp"
+#include "tasks.hpp"
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <future>
+
+using namespace tycho;
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+#ifdef USE_URING
+    try {
+        std::unique_ptr<uring> ring;
+        try {
+            ring = std::make_unique<uring>(64);
+        }
+        catch(const std::system_error& err) {
+            return 0;   // kernel without io_uring, or disabled
+        }
+
+        int fds[2]{-1, -1};
+        assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        Socket left(fds[0]), right(fds[1]);
+        char buf[32]{};
+        int sent = 0, got = 0;
+        assert(ring->recv(right, buf, sizeof(buf), [&got](int result) {
+            got = result;
+        }));
+        assert(ring->send(left, "hello", 5, [&sent](int result) {
+            sent = result;
+        }));
+        assert(ring->pending() == 2);
+        std::size_t fired = 0;
+        while(fired < 2)
+            fired += ring->wait(1000);
+        assert(sent == 5 && got == 5);
+        assert(std::string(buf, 5) == "hello");
+        assert(ring->pending() == 0);
+        assert(ring->wait(0) == 0);
+        assert(ring->wait(10) == 0);
+
+        auto file = std::tmpfile();
+        assert(file != nullptr);
+        const auto fd = fileno(file);
+        assert(ring->register_files(&fd, 1));
+        std::string data(4096, 'u');
+        struct iovec iov{data.data(), data.size()};
+        assert(ring->register_buffers(&iov, 1));
+        int wrote = 0, read = 0;
+        assert(ring->write_fixed(fd, 0, data.data(), data.size(), 0, [&wrote](int result) {
+            wrote = result;
+        }));
+        while(!ring->wait(1000)) {}
+        assert(wrote == 4096);
+        std::string back(100, 0);
+        assert(ring->read(fd, back.data(), back.size(), 4000, [&read](int result) {
+            read = result;
+        }));
+        while(!ring->wait(1000)) {}
+        assert(read == 96 && back[95] == 'u');
+        assert(ring->unregister_buffers() && ring->unregister_files());
+        std::fclose(file);
+
+        task_queue queue;
+        queue.startup();
+        std::promise<int> done;
+        assert(ring->send(left, "x", 1, [&done](int result) {
+            done.set_value(result);
+        }));
+        while(!ring->wait(queue, 1000)) {}
+        assert(done.get_future().get() == 1);
+        std::thread stopper([&ring] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ring->stop();
+        });
+        ring->run();
+        stopper.join();
+        assert(ring->stopped());
+
+        // the wakeup poll is rearmed, so a later run can be stopped too
+        std::thread again([&ring] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ring->stop();
+        });
+        ring->run();
+        again.join();
+        assert(ring->stopped() && ring->pending() == 0);
+        queue.shutdown();
+    }
+    catch(...) {
+        ::exit(-1);
+    }
+#endif
+}
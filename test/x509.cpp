@@ -0,0 +1,75 @@
+// Copyright (C) 2025 Tycho Softworks.
+// This code is licensed under MIT license.
+
+#undef  NDEBUG
+#include "compiler.hpp"     // IWYU pragma: keep
+#include "x509.hpp"
+
+#include <openssl/x509v3.h>
+
+namespace {
+auto make_cert(EVP_PKEY *key, const char *cn, X509 *issuer, EVP_PKEY *signer, long lifetime, bool ca) {
+    auto cert = X509_new();
+    assert(cert != nullptr);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), ca ? 1 : 2);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), lifetime);
+    X509_set_pubkey(cert, key);
+    auto name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>(cn), -1, -1, 0);
+    X509_set_issuer_name(cert, issuer ? X509_get_subject_name(issuer) : name);
+    X509V3_CTX v3;
+    X509V3_set_ctx_nodb(&v3);
+    X509V3_set_ctx(&v3, issuer ? issuer : cert, cert, nullptr, nullptr, 0);
+    auto ext = X509V3_EXT_conf_nid(nullptr, &v3, NID_basic_constraints, ca ? "critical,CA:TRUE" : "CA:FALSE");
+    X509_add_ext(cert, ext, -1);
+    X509_EXTENSION_free(ext);
+    assert(X509_sign(cert, signer, EVP_sha256()) > 0);
+    return crypto::x509_t(cert);
+}
+} // end anon namespace
+
+auto main([[maybe_unused]] int argc, [[maybe_unused]] char **argv) -> int {
+    auto ca_key = EVP_EC_gen("P-256");
+    auto leaf_key = EVP_EC_gen("P-256");
+    auto other_key = EVP_EC_gen("P-256");
+    const auto ca = make_cert(ca_key, "test ca", nullptr, ca_key, 3600, true);
+    const auto leaf = make_cert(leaf_key, "client", ca.get(), ca_key, 600, false);
+    const auto stranger = make_cert(other_key, "stranger", nullptr, other_key, 600, false);
+    assert(leaf.fingerprint().size() == 64 && leaf.fingerprint() != ca.fingerprint());
+    assert(leaf.cn() == "client");
+
+    crypto::x509_verifier verifier(nullptr, 4, std::chrono::minutes(10));
+    assert(verifier);
+    assert(X509_STORE_add_cert(verifier.store(), ca.get()) == 1);
+    assert(verifier.verify(leaf) == X509_V_OK);
+    assert(verifier.misses() == 1 && verifier.hits() == 0);
+    assert(verifier.verify(leaf) == X509_V_OK);
+    assert(verifier.hits() == 1 && verifier.size() == 1);
+
+    // a cached result still hands the built chain to the store context
+    auto store_ctx = X509_STORE_CTX_new();
+    assert(X509_STORE_CTX_init(store_ctx, verifier.store(), leaf.get(), nullptr) == 1);
+    assert(verifier.verify(store_ctx) == X509_V_OK && verifier.hits() == 2);
+    const auto chain = X509_STORE_CTX_get0_chain(store_ctx);
+    assert(chain && sk_X509_num(chain) == 2);
+    assert(X509_cmp(sk_X509_value(chain, 0), leaf.get()) == 0 && X509_cmp(sk_X509_value(chain, 1), ca.get()) == 0);
+    X509_STORE_CTX_free(store_ctx);
+
+    assert(verifier.verify(stranger) != X509_V_OK);
+    assert(verifier.verify(stranger) != X509_V_OK);
+    assert(verifier.hits() == 3 && verifier.size() == 2);
+
+    verifier.refresh();
+    assert(verifier.size() == 0);
+    assert(verifier.verify(leaf) == X509_V_OK && verifier.misses() == 3);
+
+    // an expired entry is verified again
+    crypto::x509_verifier brief(verifier.store(), 4, std::chrono::seconds(0));
+    assert(brief.verify(leaf) == X509_V_OK && brief.verify(leaf) == X509_V_OK);
+    assert(brief.hits() == 0 && brief.misses() == 2);
+
+    EVP_PKEY_free(ca_key);
+    EVP_PKEY_free(leaf_key);
+    EVP_PKEY_free(other_key);
+}